@@ -51,6 +51,8 @@ enum class Verbose{
  *  - vlog: (enum VERBOSE) type of message verbosity returned by mimmo++ on log file.
  *  - optres: (bool) if true, return partial results of mimmo++ execution, i.e. all optional results of every block involved in the execution
  *  - optres_path: (string) specify path to save optional results of execution. Meaningful only if optres is active
+ *  - parallel: (bool) if true, execute concurrently the independent blocks of each execution chain
+ *  - compact: (bool) if true, set in compact mode the geometries read by the workflow
  */
 struct InfoMimmoPP{
 
@@ -60,6 +62,8 @@ struct InfoMimmoPP{
     bool optres;                /**< boolean to activate writing of execution optional results */
     bool expert;                /**< boolean to override mandatory ports checking */
     std::string optres_path;    /**< path to store optional results */
+    bool parallel;              /**< boolean to activate parallel execution of chains */
+    bool compact;               /**< boolean to activate compact mode of the geometries read */
     
     /*! Base constructor*/
     InfoMimmoPP(){
@@ -69,6 +73,8 @@ struct InfoMimmoPP{
         optres      = false;
         optres_path = ".";
         expert      = false;
+        parallel    = false;
+        compact     = false;
     }
     /*! Destructor */
     ~InfoMimmoPP(){};
@@ -86,6 +92,8 @@ struct InfoMimmoPP{
         optres = other.optres;
         optres_path = other.optres_path;
         expert = other.expert;
+        parallel = other.parallel;
+        compact = other.compact;
         return *this;
     }
 };
@@ -144,6 +152,12 @@ InfoMimmoPP readArguments(int argc, char*argv[] ){
         std::cout<<" "<<std::endl;
         std::cout<<"    --expert=yes                   : override mandatory ports connection checking.              "<<std::endl;
         std::cout<<" "<<std::endl;
+        std::cout<<"    --parallel=yes                 : execute concurrently independent blocks of the workflow.   "<<std::endl;
+        std::cout<<"                                     Meaningful only if mimmo is compiled with OpenMP.          "<<std::endl;
+        std::cout<<" "<<std::endl;
+        std::cout<<"    --compact=yes                  : set in compact mode the geometries read by the workflow,   "<<std::endl;
+        std::cout<<"                                     building their index maps only on demand.                  "<<std::endl;
+        std::cout<<" "<<std::endl;
         std::cout<<" "<<std::endl;
         std::cout<<" "<<std::endl;
         std::cout<<"    For any problem, bug and malfunction please contact mimmo developers.                       "<<std::endl;
@@ -158,6 +172,8 @@ InfoMimmoPP readArguments(int argc, char*argv[] ){
     keymap[3] = "opt-res=";
     keymap[4] = "opt-res-path=";
     keymap[5] = "expert=";
+    keymap[6] = "parallel=";
+    keymap[7] = "compact=";
     
     std::map<int, std::string> final_map;
     //visit input list and search for each key string  in key map. If an input string positively match a key, 
@@ -166,7 +182,7 @@ InfoMimmoPP readArguments(int argc, char*argv[] ){
     for(auto val: input){
         std::size_t pos = std::string::npos;
         int counter=0;
-        while (pos == std::string::npos && counter <6){
+        while (pos == std::string::npos && counter <8){
             pos = val.find(keymap[counter]);
             ++counter;
         }  
@@ -187,6 +203,8 @@ InfoMimmoPP readArguments(int argc, char*argv[] ){
     if(final_map.count(4)) result.optres_path = final_map[4];
     if(final_map.count(3)) result.optres = (final_map[3]=="yes");
     if(final_map.count(5)) result.expert = (final_map[5]=="yes");
+    if(final_map.count(6)) result.parallel = (final_map[6]=="yes");
+    if(final_map.count(7)) result.compact = (final_map[7]=="yes");
     
     if(final_map.count(1)){
         int check = -1 + int(final_map[1]=="quiet") + 2*int(final_map[1]=="normal") + 3*int(final_map[1]=="full");
@@ -348,6 +366,8 @@ int main( int argc, char *argv[] ) {
             (*m_log)<< "debug results:      "<<yesno[int(info.optres)]<<std::endl;
             (*m_log)<< "debug results path: "<<info.optres_path<<std::endl;
             (*m_log)<< "expert mode:        "<<yesno[int(info.expert)]<<std::endl;
+            (*m_log)<< "parallel execution: "<<yesno[int(info.parallel)]<<std::endl;
+            (*m_log)<< "compact geometries: "<<yesno[int(info.compact)]<<std::endl;
             (*m_log)<< " "<<std::endl;
             (*m_log)<< " "<<std::endl;
         }
@@ -364,6 +384,16 @@ int main( int argc, char *argv[] ) {
 		auto &factory = Factory<BaseManipulation>::instance();
 		read_Dictionary(mapInst, mapConn, factory);
         
+        //set compact mode on the geometry readers
+        if(info.compact){
+            for(auto & val : mapInst){
+                MimmoGeometry * geo = dynamic_cast<MimmoGeometry*>(val.second.get());
+                if(geo != NULL)     geo->setCompact(true);
+                MultipleMimmoGeometries * multigeo = dynamic_cast<MultipleMimmoGeometries*>(val.second.get());
+                if(multigeo != NULL)    multigeo->setCompact(true);
+            }
+        }
+        
         m_log->setPriority(bitpit::log::NORMAL);
 		(*m_log)<<"Creating Execution chains... ";
         
@@ -389,6 +419,7 @@ int main( int argc, char *argv[] ) {
                 m_log->setPriority(bitpit::log::DEBUG);
                 val.second.setPlotDebugResults(info.optres);
                 val.second.setOutputDebugResults(info.optres_path);
+                val.second.setParallel(info.parallel);
 				val.second.exec(false);
 			}
 		}
@@ -83,6 +83,7 @@ BaseManipulation & BaseManipulation::operator=(const BaseManipulation & other){
     m_counter       = other.m_counter;
     m_priority      = other.m_priority;
     m_apply         = other.m_apply;
+    m_requiredStructures = other.m_requiredStructures;
     m_log           = &bitpit::log::cout(MIMMO_LOG_FILE);
     return (*this);
 };
@@ -287,6 +288,15 @@ BaseManipulation::isApply(){
     return (m_apply);
 }
 
+/*!
+ * \return acceleration structures of the linked geometry needed by the block in execution
+ * (see requireStructure).
+ */
+const std::set<GeometryStructure> &
+BaseManipulation::getRequiredStructures(){
+    return m_requiredStructures;
+}
+
 /*!
  * It gets if the object is activates or disable during the execution.
  * \return True/false if the object is activates or disable during the execution.
@@ -378,6 +388,17 @@ BaseManipulation::setApply( bool flag){
     m_apply = flag;
 }
 
+/*!
+ * Declares an acceleration structure of the linked geometry as needed by the block in execution.
+ * When the block is executed in a Chain, the structure is built on the geometry before
+ * the execution of the block, at most once for each modification of the geometry.
+ * \param[in] structure type of acceleration structure, see GeometryStructure enum.
+ */
+void
+BaseManipulation::requireStructure(GeometryStructure structure){
+    m_requiredStructures.insert(structure);
+}
+
 /*!
  * Set (force) integer identifier of the object
  * \param[in] id integer identifier
@@ -507,10 +528,17 @@ BaseManipulation::exec(){
 
     if (m_active) execute();
 
-    for (map<PortID, PortOut*>::iterator i=m_portOut.begin(); i!=m_portOut.end(); i++){
-        std::vector<BaseManipulation*>	linked = i->second->getLink();
-        if (linked.size() > 0){
-            i->second->exec();
+    //data transfer to children is serialized, since a child can be fed
+    //by parents concurrently executed in a parallel chain.
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_pins)
+#endif
+    {
+        for (map<PortID, PortOut*>::iterator i=m_portOut.begin(); i!=m_portOut.end(); i++){
+            std::vector<BaseManipulation*>	linked = i->second->getLink();
+            if (linked.size() > 0){
+                i->second->exec();
+            }
         }
     }
 
@@ -622,6 +650,28 @@ BaseManipulation::setBufferIn(PortID port, bitpit::IBinaryStream& input){
     m_portIn[port]->m_ibuffer = input;
 }
 
+/*!
+ * It sets the shared data stored in an input port of the object (zero-copy transport).
+ * \param[in] port ID of the input port.
+ * \param[in] data shared data to store in m_shared member of the port.
+ * \param[in] owned true if data are owned by the sender port and can be moved by the last receiver.
+ */
+void
+BaseManipulation::setSharedIn(PortID port, std::shared_ptr<void> data, bool owned){
+    m_portIn[port]->m_shared = std::move(data);
+    m_portIn[port]->m_sharedOwned = owned;
+}
+
+/*!
+ * It gets the hash code of the C++ type of data received by an input port of the object.
+ * \param[in] port ID of the input port.
+ * \return hash code of the data type.
+ */
+std::size_t
+BaseManipulation::getTypeHashIn(PortID port){
+    return(m_portIn[port]->getTypeHash());
+}
+
 /*!
  * It reads the buffer stored in an input port of the object.
  * \param[in] port ID of the port that reads the buffer and stores the
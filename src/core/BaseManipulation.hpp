@@ -112,6 +112,10 @@ class BaseManipulation{
      * see mimmo::setLogger
      */
     friend void mimmo::setLogger(std::string log);
+    /*!
+     * see Chain::execParallel
+     */
+    friend class Chain;
 
 public:
     //type definitions
@@ -139,6 +143,7 @@ protected:
     bool                        m_execPlot;         /**<Activate plotting of optional result directly in execution.*/
     bool                        m_apply;           /**<Activate apply result directly in execution.*/
     std::string                 m_outputPlot;        /**<Define path for plotting optional results in execution.*/
+    std::set<GeometryStructure> m_requiredStructures; /**<Acceleration structures of the linked geometry needed in execution.*/
 
     bitpit::Logger*             m_log;             /**<Pointer to logger.*/
 
@@ -175,6 +180,7 @@ public:
     bool    isPlotInExecution();
     bool    isActive();
     bool    isApply();
+    const std::set<GeometryStructure> & getRequiredStructures();
     int     getClassCounter();
     int     getId();
 
@@ -186,6 +192,7 @@ public:
     void    setClassCounter(int );
     void    setId(int );
     void    setApply(bool flag = true);
+    void    requireStructure(GeometryStructure structure);
 
     void    activate();
     void    disable();
@@ -226,6 +233,8 @@ protected:
     bool    createPortIn(O* obj, void (O::*setVar_)(T), PortID portR, containerTAG conType, dataTAG dataType, bool mandatory = false, int family = 0);
 
     void    setBufferIn(PortID port, bitpit::IBinaryStream& input);
+    void    setSharedIn(PortID port, std::shared_ptr<void> data, bool owned);
+    std::size_t getTypeHashIn(PortID port);
     void    readBufferIn(PortID port);
     void    cleanBufferIn(PortID port);
 
@@ -24,6 +24,7 @@
 #include "BasicShapes.hpp"
 #include "customOperators.hpp"
 #include <algorithm>
+#include <limits>
 
 using namespace bitpit;
 
@@ -259,7 +260,7 @@ livector1D BasicShape::includeGeometry(mimmo::MimmoObject * geo ){
 	if(!(geo->isBvTreeSupported()))	return livector1D(0);
 	
 	//create BvTree and fill it w/ cell list
-	if(!(geo->isBvTreeBuilt()))	geo->buildBvTree();
+	geo->buildStructure(GeometryStructure::BVTREE);
 	//get recursively all the list element in the shape
 	livector1D elements(geo->getNCells());
 	int countElements = 0;
@@ -361,15 +362,23 @@ livector1D BasicShape::excludeGeometry(bitpit::PatchKernel * tri){
 livector1D BasicShape::includeCloudPoints(dvecarr3E & list){
 
 	if(list.empty())	return livector1D(0);
-	livector1D result(list.size());
+	int nP = list.size();
+	ivector1D included(nP);
+	const int chunk = 1024;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for(int start=0; start<nP; start+=chunk){
+		arePointsIncluded(list[start].data(), std::min(chunk, nP-start), included.data()+start);
+	}
+	
+	livector1D result(nP);
 	int counter = 0;
-	long real = 0;
-	for(auto & vert : list){
-		if(isPointIncluded(vert)){
-			result[counter] = real;
+	for(int i=0; i<nP; ++i){
+		if(included[i]){
+			result[counter] = i;
 			++counter;
 		}
-		++real;	
 	}	
 	result.resize(counter);
 	return(result);
@@ -383,15 +392,23 @@ livector1D BasicShape::includeCloudPoints(dvecarr3E & list){
  */
 livector1D BasicShape::excludeCloudPoints(dvecarr3E & list){
 	if(list.empty())	return livector1D(0);
-	livector1D result(list.size());
-	long real = 0;
+	int nP = list.size();
+	ivector1D included(nP);
+	const int chunk = 1024;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for(int start=0; start<nP; start+=chunk){
+		arePointsIncluded(list[start].data(), std::min(chunk, nP-start), included.data()+start);
+	}
+	
+	livector1D result(nP);
 	int counter = 0;
-	for(auto & vert : list){
-		if(!isPointIncluded(vert)){
-			result[counter] = real;
+	for(int i=0; i<nP; ++i){
+		if(!included[i]){
+			result[counter] = i;
 			++counter;
 		}
-		++real;	
 	}	
 	result.resize(counter);
 	return(result);
@@ -457,12 +474,12 @@ livector1D BasicShape::includeCloudPoints(mimmo::MimmoObject * geo ){
 	
 	livector1D elements(geo->getNVertex()); 
 	//create BvTree and fill it w/ cell list
-	if(!(geo->isKdTreeBuilt()))	geo->buildKdTree();
+	geo->buildStructure(GeometryStructure::KDTREE);
 	
 	getTempBBox();
 	int countVertex = 0;
 	//get recursively all the list element in the shape
-	searchKdTreeMatches(*(geo->getKdTree()), 0, 0, elements, countVertex);
+	searchKdTreeMatches(*(geo->getKdTree()), 0, elements, countVertex);
 	elements.resize(countVertex);
 	
 	return(elements);
@@ -559,6 +576,53 @@ bool BasicShape::isPointIncluded(bitpit::PatchKernel * tri, long int indexV){
 	return(isPointIncluded(coords));  
 };
 
+/*!
+ * Check if a list of points is included in the volume of the shape.
+ * The points are transformed in basic shape coordinates in chunks, by the
+ * toBasicCoords kernel of the current shape, and then checked all together.
+ * It does not modify the shape, so it can be called concurrently.
+ * \param[in] coords coordinates of the points (x,y,z of each point)
+ * \param[in] npoints number of points
+ * \param[out] included 1 if the point is included, 0 otherwise, for each point
+ */
+void BasicShape::arePointsIncluded(const double * coords, int npoints, int * included){
+	
+	const int chunk = 64;
+	double basic[3*chunk];
+	double tol = 1.0E-12;
+	
+	for(int start=0; start<npoints; start+=chunk){
+		int n = std::min(chunk, npoints-start);
+		toBasicCoords(coords + 3*start, n, basic);
+		for(int i=0; i<n; ++i){
+			const double * b = basic + 3*i;
+			included[start+i] = int((b[0] >= -1.0*tol) && (b[0] <= (1.0+tol))
+								 && (b[1] >= -1.0*tol) && (b[1] <= (1.0+tol))
+								 && (b[2] >= -1.0*tol) && (b[2] <= (1.0+tol)));
+		}
+	}
+};
+
+/*!
+ * Transform a list of 3D points from world coordinates to basic elemental shape ones,
+ * i.e. the batch version of localToBasic(toLocalCoord(point)).
+ * The default implementation transforms the points one by one; shapes can
+ * override it with a faster kernel.
+ * \param[in] coords coordinates of the points (x,y,z of each point)
+ * \param[in] npoints number of points
+ * \param[out] basic coordinates of the points in basic elemental shape reference system
+ */
+void BasicShape::toBasicCoords(const double * coords, int npoints, double * basic){
+	
+	for(int i=0; i<npoints; ++i){
+		darray3E point = {{coords[3*i], coords[3*i+1], coords[3*i+2]}};
+		darray3E temp = localToBasic(toLocalCoord(point));
+		for(int j=0; j<3; ++j){
+			basic[3*i+j] = temp[j];
+		}
+	}
+};
+
 /*!
  * Check if current shape totally contains the given Axis Aligned Bounding Box
  * \param[in]	bMin	inferior extremal point of the AABB	
@@ -577,11 +641,11 @@ bool BasicShape::containShapeAABBox(darray3E bMin,darray3E bMax){
 	points[6] = bMin; points[6][1] = bMax[1];
 	points[7] = bMax; points[7][1] = bMin[1];
 	
-	int counter=0;
-	while (check && counter<8)	{
-		check = check && isPointIncluded(points[counter]);	
-		++counter;
-	}	
+	int included[8];
+	arePointsIncluded(points[0].data(), 8, included);
+	for(int i=0; i<8; ++i){
+		check = check && (included[i] == 1);
+	}
 	return check;
 };
 
@@ -605,49 +669,125 @@ darray3E BasicShape::checkNearestPointToAABBox(darray3E point, darray3E bMin, da
 };
 
 /*!
- * Visit recursively KdTree relative to a cloud points and extract possible vertex candidates included in the current shape.
- * Identifiers of extracted matches are collected in result structure
+ * Depth of the tree nodes whose subtrees are visited concurrently by the shape-inclusion searches.
+ */
+static const int SEARCH_FRONTIERDEPTH = 6;
+
+/*!
+ * Visit a tree (BvTree or KdTree) from a root node, depth-first, and collect the nodes
+ * relevant for the shape inclusion, in visiting order. Each entry of the visited list
+ * is marked with:
+ *  - 0 : internal node intersecting the shape at maximum depth, whose subtree is not visited;
+ *  - 1 : node whose bounding box is contained in the shape;
+ *  - 2 : leaf node whose bounding box is partially overlapped by the shape.
+ *
+ * The root node is not checked against the shape, while children are visited only
+ * if their bounding box intersects the shape.
+ *\param[in] nodes			nodes of the tree
+ *\param[in] root			index of the root node
+ *\param[in] maxDepth		maximum depth of the visit, relative to the root
+ *\param[in,out] visited	list of pairs node index/mark
+ */
+template<class Node>
+void	BasicShape::visitTreeNodes(const std::vector<Node> & nodes, int root, int maxDepth, std::vector<std::pair<int,int> > & visited){
+	
+	std::vector<std::pair<int,int> > stack;
+	stack.push_back(std::make_pair(root, 0));
+	while(!stack.empty()){
+		int inode = stack.back().first;
+		int depth = stack.back().second;
+		stack.pop_back();
+		const Node & node = nodes[inode];
+		
+		if(containShapeAABBox(node.getMinPoint(), node.getMaxPoint())){
+			visited.push_back(std::make_pair(inode, 1));
+			continue;
+		}
+		if(node.isLeaf()){
+			visited.push_back(std::make_pair(inode, 2));
+			continue;
+		}
+		if(depth == maxDepth){
+			visited.push_back(std::make_pair(inode, 0));
+			continue;
+		}
+		
+		int lchild = inode + 1;
+		int rchild = node.m_rchild;
+		if( intersectShapeAABBox(nodes[rchild].getMinPoint(), nodes[rchild].getMaxPoint()) )
+			stack.push_back(std::make_pair(rchild, depth+1));
+		if( intersectShapeAABBox(nodes[lchild].getMinPoint(), nodes[lchild].getMaxPoint()) )
+			stack.push_back(std::make_pair(lchild, depth+1));
+	}
+};
+
+/*!
+ * Visit KdTree relative to a cloud points and extract possible vertex candidates included in the current shape.
+ * The upper levels of the tree are visited first; the subtrees found at the frontier depth are then
+ * visited concurrently, collecting the nodes contained in the shape and the leaves partially overlapped.
+ * The points of the latter are finally classified in parallel by the inclusion kernel of the shape.
+ * Identifiers of extracted matches are collected in result structure, in depth-first order of the tree.
  *\param[in] tree			KdTree of cloud points
- *\param[in] indexKdNode	KdNode index of tree, which start seaching from  
- *\param[in] level 			leaf level of indexKdNode in the tree
- *\param[in,out] result		list of KdNode labels, which are included in the shape.
+ *\param[in] indexKdNode	KdTree node index of tree, which start seaching from  
+ *\param[in,out] result		list of point labels, which are included in the shape.
  *\param[in,out] counter	last filled position of result vector. 
  * 
  */
-void	BasicShape::searchKdTreeMatches(bitpit::KdTree<3,bitpit::Vertex,long> & tree, int indexKdNode, int level, livector1D & result, int &counter ){
+void	BasicShape::searchKdTreeMatches(mimmo::KdTree & tree, int indexKdNode, livector1D & result, int &counter ){
 	
 	//check indexKdNode admissible.
-	if(indexKdNode <0 || indexKdNode > tree.n_nodes)	return;
-	
-	//1st step get data
-	bitpit::KdNode<bitpit::Vertex, long> & target = tree.nodes[indexKdNode];
-	//check target point is in the shape
-	if (bitpit::CGElem::intersectPointBox(target.object_->getCoords(), m_bbox[0], m_bbox[1], 3)){
-		if(isPointIncluded(target.object_->getCoords())){
-			result[counter] = target.label;
-			++counter;
-		}
-		searchKdTreeMatches(tree, target.lchild_, level+1, result, counter);
-		searchKdTreeMatches(tree, target.rchild_, level+1, result, counter);
-	}else{
-		
-		uint32_t check = intersectShapePlane(level%3, target.object_->getCoords());
-		bool right = (check > 0);
-		bool left = (check%2 == 0);
-		if (left && target.lchild_ >= 0){
-			searchKdTreeMatches(tree, target.lchild_, level+1, result, counter);
-		}
-		if (right && target.rchild_ >= 0){
-			searchKdTreeMatches(tree, target.rchild_, level+1, result, counter);
+	if(indexKdNode <0 || indexKdNode >= tree.m_nnodes)	return;
+	
+	//collect candidate nodes
+	std::vector<std::pair<int,int> > visited;
+	visitTreeNodes(tree.m_nodes, indexKdNode, SEARCH_FRONTIERDEPTH, visited);
+	int nvisited = visited.size();
+	std::vector<std::vector<std::pair<int,int> > > subvisited(nvisited);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for(int i=0; i<nvisited; ++i){
+		if(visited[i].second == 0)	visitTreeNodes(tree.m_nodes, visited[i].first, std::numeric_limits<int>::max(), subvisited[i]);
+	}
+	std::vector<std::pair<int,int> > candidates;
+	for(int i=0; i<nvisited; ++i){
+		if(visited[i].second == 0)	candidates.insert(candidates.end(), subvisited[i].begin(), subvisited[i].end());
+		else						candidates.push_back(visited[i]);
+	}
+	
+	//classify points of partially overlapped leaves
+	int ncandidates = candidates.size();
+	ivector1D included(tree.m_npoints, 0);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for(int i=0; i<ncandidates; ++i){
+		if(candidates[i].second != 2)	continue;
+		const KdNode & node = tree.m_nodes[candidates[i].first];
+		arePointsIncluded(tree.getPointCoords(node.m_element[0]), node.getNRange(), included.data()+node.m_element[0]);
+	}
+	
+	//gather results
+	for(const auto & candidate : candidates){
+		const KdNode & node = tree.m_nodes[candidate.first];
+		for(int i = node.m_element[0]; i<node.m_element[1]; ++i){
+			if(candidate.second == 1 || included[i]){
+				result[counter] = tree.m_labels[i];
+				++counter;
+			}
 		}
-	}	
+	}
 	
 	return;
 };
 
 /*!
- * Visit recursively BvTree relative to a PatchKernel structure and extract possible simplex candidates included in the current shape.
- * Identifiers of extracted matches are collected in result structure
+ * Visit BvTree relative to a PatchKernel structure and extract possible simplex candidates included in the current shape.
+ * The upper levels of the tree are visited first; the subtrees found at the frontier depth are then
+ * visited concurrently, collecting the nodes contained in the shape and the leaves partially overlapped.
+ * The vertices of the simplices of the latter, packed in the tree, are finally classified in parallel by the
+ * inclusion kernel of the shape; a simplex is included if all its vertices are included.
+ * Identifiers of extracted matches are collected in result structure, in depth-first order of the tree.
  *\param[in] tree			BvTree of PatchKernel simplicies
  *\param[in] geo            pointer to tessellation the tree refers to. 
  *\param[in] indexBvNode	BvTree node index of tree, which start seaching from  
@@ -657,37 +797,59 @@ void	BasicShape::searchKdTreeMatches(bitpit::KdTree<3,bitpit::Vertex,long> & tre
  */
 void	BasicShape::searchBvTreeMatches(mimmo::BvTree & tree,  bitpit::PatchKernel * geo, int indexBvNode, livector1D & result, int &counter ){
 	
-	//check indexBvNode admissible.
-	if(indexBvNode <0 || indexBvNode > tree.m_nnodes)	return;
-	   
-	//1st step get data and control if it's leaf or if shape contain bounding box
-	if(containShapeAABBox(tree.m_nodes[indexBvNode].m_minPoint, tree.m_nodes[indexBvNode].m_maxPoint)){
+	BITPIT_UNUSED(geo);
 	
-		for(int i = tree.m_nodes[indexBvNode].m_element[0]; i<tree.m_nodes[indexBvNode].m_element[1]; ++i){
-			result[counter] = tree.m_elements[i].m_label;
-			++counter;
-		}	
-		return;
-	};
-	
-	if(tree.m_nodes[indexBvNode].m_leaf){
-		for(int i = tree.m_nodes[indexBvNode].m_element[0]; i<tree.m_nodes[indexBvNode].m_element[1]; ++i){
-			if(isSimplexIncluded(geo, tree.m_elements[i].m_label)){
-				result[counter] = tree.m_elements[i].m_label;		
-				++counter;
-			}					
-		}
-		return;
+	//check indexBvNode admissible.
+	if(indexBvNode <0 || indexBvNode >= tree.m_nnodes)	return;
+	
+	//collect candidate nodes
+	std::vector<std::pair<int,int> > visited;
+	visitTreeNodes(tree.m_nodes, indexBvNode, SEARCH_FRONTIERDEPTH, visited);
+	int nvisited = visited.size();
+	std::vector<std::vector<std::pair<int,int> > > subvisited(nvisited);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for(int i=0; i<nvisited; ++i){
+		if(visited[i].second == 0)	visitTreeNodes(tree.m_nodes, visited[i].first, std::numeric_limits<int>::max(), subvisited[i]);
+	}
+	std::vector<std::pair<int,int> > candidates;
+	for(int i=0; i<nvisited; ++i){
+		if(visited[i].second == 0)	candidates.insert(candidates.end(), subvisited[i].begin(), subvisited[i].end());
+		else						candidates.push_back(visited[i]);
 	}
 	
-	if(tree.m_nodes[indexBvNode].m_lchild >= 0)	{
-		if( intersectShapeAABBox(tree.m_nodes[tree.m_nodes[indexBvNode].m_lchild].m_minPoint, tree.m_nodes[tree.m_nodes[indexBvNode].m_lchild].m_maxPoint) )
-			searchBvTreeMatches(tree, geo, tree.m_nodes[indexBvNode].m_lchild, result, counter);
+	//classify simplices of partially overlapped leaves
+	int ncandidates = candidates.size();
+	ivector1D included(tree.m_nelements, 0);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for(int i=0; i<ncandidates; ++i){
+		if(candidates[i].second != 2)	continue;
+		const BvNode & node = tree.m_nodes[candidates[i].first];
+		int first = tree.m_coordsPtr[node.m_element[0]];
+		int nvert = tree.m_coordsPtr[node.m_element[1]] - first;
+		ivector1D vincluded(nvert);
+		arePointsIncluded(tree.getElementCoords(node.m_element[0]), nvert, vincluded.data());
+		for(int iel = node.m_element[0]; iel<node.m_element[1]; ++iel){
+			int check = 1;
+			for(int iv = tree.m_coordsPtr[iel]; iv<tree.m_coordsPtr[iel+1]; ++iv){
+				check = check * vincluded[iv-first];
+			}
+			included[iel] = check;
+		}
 	}
 	
-	if(tree.m_nodes[indexBvNode].m_rchild >= 0)	{
-		if( intersectShapeAABBox(tree.m_nodes[tree.m_nodes[indexBvNode].m_rchild].m_minPoint, tree.m_nodes[tree.m_nodes[indexBvNode].m_rchild].m_maxPoint) )
-			searchBvTreeMatches(tree, geo, tree.m_nodes[indexBvNode].m_rchild, result,counter);
+	//gather results
+	for(const auto & candidate : candidates){
+		const BvNode & node = tree.m_nodes[candidate.first];
+		for(int i = node.m_element[0]; i<node.m_element[1]; ++i){
+			if(candidate.second == 1 || included[i]){
+				result[counter] = tree.m_elements[i].m_label;
+				++counter;
+			}
+		}
 	}
 	
 	return;
@@ -710,7 +872,7 @@ void	BasicShape::searchBvTreeNotMatches(mimmo::BvTree & tree,  bitpit::PatchKern
 	if(indexBvNode <0 || indexBvNode > tree.m_nnodes)	return;
 	
 	//1st step get data and control if it's leaf or if shape contain bounding box
-	if(containShapeAABBox(tree.m_nodes[indexBvNode].m_minPoint, tree.m_nodes[indexBvNode].m_maxPoint)){
+	if(containShapeAABBox(tree.m_nodes[indexBvNode].getMinPoint(), tree.m_nodes[indexBvNode].getMaxPoint())){
 		
 		for(int i = tree.m_nodes[indexBvNode].m_element[0]; i<tree.m_nodes[indexBvNode].m_element[1]; ++i){
 			result[counter] = tree.m_elements[i].m_label;
@@ -719,7 +881,7 @@ void	BasicShape::searchBvTreeNotMatches(mimmo::BvTree & tree,  bitpit::PatchKern
 		return;
 	};
 	
-	if(tree.m_nodes[indexBvNode].m_leaf){
+	if(tree.m_nodes[indexBvNode].isLeaf()){
 		for(int i = tree.m_nodes[indexBvNode].m_element[0]; i<tree.m_nodes[indexBvNode].m_element[1]; ++i){
 			if(isSimplexIncluded(geo, tree.m_elements[i].m_label)){
 				result[counter] = tree.m_elements[i].m_label;		
@@ -729,15 +891,13 @@ void	BasicShape::searchBvTreeNotMatches(mimmo::BvTree & tree,  bitpit::PatchKern
 		return;
 	}
 	
-	if(tree.m_nodes[indexBvNode].m_lchild >= 0)	{
-		if( intersectShapeAABBox(tree.m_nodes[tree.m_nodes[indexBvNode].m_lchild].m_minPoint, tree.m_nodes[tree.m_nodes[indexBvNode].m_lchild].m_maxPoint) )
-			searchBvTreeMatches(tree, geo, tree.m_nodes[indexBvNode].m_lchild, result, counter);
-	}
+	int lchild = indexBvNode + 1;
+	if( intersectShapeAABBox(tree.m_nodes[lchild].getMinPoint(), tree.m_nodes[lchild].getMaxPoint()) )
+		searchBvTreeMatches(tree, geo, lchild, result, counter);
 	
-	if(tree.m_nodes[indexBvNode].m_rchild >= 0)	{
-		if( intersectShapeAABBox(tree.m_nodes[tree.m_nodes[indexBvNode].m_rchild].m_minPoint, tree.m_nodes[tree.m_nodes[indexBvNode].m_rchild].m_maxPoint) )
-			searchBvTreeMatches(tree, geo, tree.m_nodes[indexBvNode].m_rchild, result,counter);
-	}
+	int rchild = tree.m_nodes[indexBvNode].m_rchild;
+	if( intersectShapeAABBox(tree.m_nodes[rchild].getMinPoint(), tree.m_nodes[rchild].getMaxPoint()) )
+		searchBvTreeMatches(tree, geo, rchild, result,counter);
 	
 	return;
 };
@@ -899,6 +1059,28 @@ darray3E	Cube::localToBasic(darray3E point){
 	return(point - getLocalOrigin());
 };
 
+/*!
+ * Transform a list of points from world coordinate system to unitary cube
+ * reference system, as localToBasic(toLocalCoord(point)) does for a single point.
+ * \param[in] coords coordinates of the points (x,y,z of each point)
+ * \param[in] npoints number of points
+ * \param[out] basic coordinates of the points in unitary cube reference system
+ */
+void	Cube::toBasicCoords(const double * coords, int npoints, double * basic){
+	
+	const darray3E & o = m_origin;
+	const dmatrix33E & A = m_sdr;
+	
+	for(int i=0; i<npoints; ++i){
+		const double * p = coords + 3*i;
+		double * b = basic + 3*i;
+		double w0 = p[0] - o[0], w1 = p[1] - o[1], w2 = p[2] - o[2];
+		for(int j=0; j<3; ++j){
+			b[j] = (w0*A[j][0] + w1*A[j][1] + w2*A[j][2])/m_scaling[j] + 0.5;
+		}
+	}
+};
+
 /*! 
  * Check if your new span values fit your current shape set up
  * and eventually return correct values.
@@ -1162,6 +1344,44 @@ darray3E	Cylinder::localToBasic(darray3E  point){
 	return(point);
 };
 
+/*!
+ * Transform a list of points from world coordinate system to unitary cube
+ * reference system, as localToBasic(toLocalCoord(point)) does for a single point.
+ * \param[in] coords coordinates of the points (x,y,z of each point)
+ * \param[in] npoints number of points
+ * \param[out] basic coordinates of the points in unitary cube reference system
+ */
+void	Cylinder::toBasicCoords(const double * coords, int npoints, double * basic){
+	
+	const darray3E & o = m_origin;
+	const dmatrix33E & A = m_sdr;
+	double quarter = std::atan(1.0);
+	double param = 8*quarter;
+	
+	for(int i=0; i<npoints; ++i){
+		const double * p = coords + 3*i;
+		double * b = basic + 3*i;
+		double w0 = p[0] - o[0], w1 = p[1] - o[1], w2 = p[2] - o[2];
+		double x = w0*A[0][0] + w1*A[0][1] + w2*A[0][2];
+		double y = w0*A[1][0] + w1*A[1][1] + w2*A[1][2];
+		double z = w0*A[2][0] + w1*A[2][1] + w2*A[2][2];
+		
+		double r = 0.0, theta = 0.0;
+		if(x != 0.0 || y != 0.0){
+			r = pow(x*x + y*y,0.5);
+			double pdum = std::atan2(y,x);
+			theta = pdum - 4.0*(getSign(pdum)-1.0)*quarter;
+		}
+		theta = theta - m_infLimits[1];
+		if(theta < 0) 		theta = param + theta;
+		if(theta > param) 	theta = theta - param;
+		
+		b[0] = r/m_scaling[0];
+		b[1] = (theta/m_scaling[1])/m_span[1];
+		b[2] = z/m_scaling[2] + 0.5;
+	}
+};
+
 /*!
  * Check if your new span values fit your current shape set up
  * and eventually return correct values.
@@ -1457,6 +1677,49 @@ darray3E	Sphere::localToBasic(darray3E  point){
 	return(point);
 };
 
+/*!
+ * Transform a list of points from world coordinate system to unitary cube
+ * reference system, as localToBasic(toLocalCoord(point)) does for a single point.
+ * The angular coordinates of the center of the sphere are set to zero.
+ * \param[in] coords coordinates of the points (x,y,z of each point)
+ * \param[in] npoints number of points
+ * \param[out] basic coordinates of the points in unitary cube reference system
+ */
+void	Sphere::toBasicCoords(const double * coords, int npoints, double * basic){
+	
+	const darray3E & o = m_origin;
+	const dmatrix33E & A = m_sdr;
+	double quarter = std::atan(1.0);
+	double param = 8*quarter;
+	
+	for(int i=0; i<npoints; ++i){
+		const double * p = coords + 3*i;
+		double * b = basic + 3*i;
+		double w0 = p[0] - o[0], w1 = p[1] - o[1], w2 = p[2] - o[2];
+		double x = w0*A[0][0] + w1*A[0][1] + w2*A[0][2];
+		double y = w0*A[1][0] + w1*A[1][1] + w2*A[1][2];
+		double z = w0*A[2][0] + w1*A[2][1] + w2*A[2][2];
+		
+		double r = std::sqrt(x*x + y*y + z*z);
+		double theta = 0.0, phi = 0.0;
+		if(r > 0.0){
+			if(x != 0.0 || y != 0.0){
+				double pdum = std::atan2(y,x);
+				theta = pdum - 4.0*(getSign(pdum)-1.0)*quarter;
+			}
+			theta = theta - m_infLimits[1];
+			if(theta < 0) 		theta = param + theta;
+			if(theta > param) 	theta = theta - param;
+			
+			phi = std::acos(z/r) - m_infLimits[2];
+		}
+		
+		b[0] = r/m_scaling[0];
+		b[1] = (theta/m_scaling[1])/m_span[1];
+		b[2] = (phi/m_scaling[2])/m_span[2];
+	}
+};
+
 /*! 
  * Check if your new span values fit your current shape set up
  * and eventually return correct values.
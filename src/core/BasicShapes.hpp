@@ -136,6 +136,7 @@ public:
     bool		isSimplexIncluded(bitpit::PatchKernel * , long int indexT);
     bool		isPointIncluded(darray3E);
     bool		isPointIncluded(bitpit::PatchKernel * , long int indexV);
+    void		arePointsIncluded(const double * coords, int npoints, int * included);
 
     /*!
      * Pure virtual method to get if the current shape an a given Axis Aligned Bounding Box intersects
@@ -186,6 +187,8 @@ private:
      */
     virtual	darray3E	localToBasic(darray3E  point)=0;
 
+    virtual	void		toBasicCoords(const double * coords, int npoints, double * basic);
+
     /*! 
      * Pure virtual method to check if your new span values fit your current shape set up
      * and eventually return correct values.
@@ -212,9 +215,11 @@ private:
      */
     virtual void		setScaling(double &s0, double &s1, double &s2)=0;
 
-    void				searchKdTreeMatches(bitpit::KdTree<3,bitpit::Vertex,long> & tree,  int indexKdNode, int level, livector1D & result, int &counter );
+    void				searchKdTreeMatches(mimmo::KdTree & tree,  int indexKdNode, livector1D & result, int &counter );
     void				searchBvTreeMatches(mimmo::BvTree & tree, bitpit::PatchKernel * geo, int indexBvNode, livector1D & result, int &counter);
     void				searchBvTreeNotMatches(mimmo::BvTree & tree, bitpit::PatchKernel * geo, int indexBvNode, livector1D & result, int &counter);
+    template<class Node>
+    void				visitTreeNodes(const std::vector<Node> & nodes, int root, int maxDepth, std::vector<std::pair<int,int> > & visited);
 
     /*!
      * Pure virtual method to get the Axis Aligned Bounding Box of the current shape
@@ -253,6 +258,7 @@ public:
 private:	
     darray3E	basicToLocal(darray3E  point);
     darray3E	localToBasic(darray3E  point);
+    void		toBasicCoords(const double * coords, int npoints, double * basic);
     void 		checkSpan(double &, double &, double &);
     bool 		checkInfLimits(double &, int & dir);
     void 		setScaling(double &, double &, double &);
@@ -288,6 +294,7 @@ public:
 private:	
     darray3E	basicToLocal(darray3E  point);
     darray3E	localToBasic(darray3E  point);
+    void		toBasicCoords(const double * coords, int npoints, double * basic);
     void 		checkSpan(double &, double &, double &);
     bool 		checkInfLimits(double &, int &);
     void 		setScaling(double &, double &, double &);
@@ -324,6 +331,7 @@ public:
 private:	
     darray3E	basicToLocal(darray3E  point);
     darray3E	localToBasic(darray3E  point);
+    void		toBasicCoords(const double * coords, int npoints, double * basic);
     void 		checkSpan(double &, double &, double &);
     bool 		checkInfLimits(double &, int &);
     void 		setScaling(double &, double &, double &);
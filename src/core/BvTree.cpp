@@ -26,9 +26,82 @@
 # include "CG.hpp"
 # include "mimmoTypeDef.hpp"
 # include <cmath>
+# include <algorithm>
+# include <cstdint>
 
 namespace mimmo{
 
+/*!
+ * Maximum size of the stack used in the traversal of a BvTree (greater than the maximum depth of the tree).
+ */
+static const int BVTREE_STACKSIZE = 128;
+
+/*!
+ * Write a vector of trivially copyable items in binary form, preceded by its size.
+ * \param[in] out output stream
+ * \param[in] data vector to be written
+ */
+template<typename T>
+static void bvWriteVector(std::ostream & out, const std::vector<T> & data)
+{
+    uint64_t size = data.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char *>(data.data()), size*sizeof(T));
+}
+
+/*!
+ * Read a vector of trivially copyable items written by bvWriteVector.
+ * \param[in] in input stream
+ * \param[out] data vector read
+ * \param[in] maxSize maximum number of items accepted
+ * \return false if the stream is not readable or the vector is larger than maxSize
+ */
+template<typename T>
+static bool bvReadVector(std::istream & in, std::vector<T> & data, std::size_t maxSize)
+{
+    uint64_t size = 0;
+    in.read(reinterpret_cast<char *>(&size), sizeof(size));
+    if (!in.good() || size > uint64_t(maxSize)) return false;
+    data.resize(size);
+    in.read(reinterpret_cast<char *>(data.data()), size*sizeof(T));
+    return in.good();
+}
+
+/*!
+ * Check recursively the consistency of a subtree of nodes read from a stream:
+ * each node has to cover the expected range of elements, the left child of an internal node
+ * follows its parent, the right child follows the whole left subtree and the ranges of the
+ * children split the range of the parent. The depth is bounded by the traversal stack size.
+ * \param[in] nodes list of nodes
+ * \param[in] nnodes number of nodes of the tree
+ * \param[in] inode index of the root of the subtree
+ * \param[in] begin index of the first element expected in the subtree
+ * \param[in] end index next to the last element expected in the subtree
+ * \param[in] depth depth of the root of the subtree
+ * \param[in,out] nleaf number of leaves found
+ * \return number of nodes of the subtree, -1 if the subtree is not consistent
+ */
+static int bvCheckNodes(const std::vector<BvNode> & nodes, int nnodes, int inode, int begin, int end, int depth, int & nleaf)
+{
+    if (inode < 0 || inode >= nnodes || depth >= BVTREE_STACKSIZE - 1) return -1;
+    const BvNode & node = nodes[inode];
+    if (node.m_element[0] != begin || node.m_element[1] != end || begin >= end) return -1;
+    if (node.isLeaf())
+    {
+        nleaf++;
+        return 1;
+    }
+    int lchild = inode + 1;
+    if (lchild >= nnodes) return -1;
+    int mid = nodes[lchild].m_element[1];
+    if (mid <= begin || mid >= end) return -1;
+    int nl = bvCheckNodes(nodes, nnodes, lchild, begin, mid, depth+1, nleaf);
+    if (nl < 0 || node.m_rchild != lchild + nl) return -1;
+    int nr = bvCheckNodes(nodes, nnodes, node.m_rchild, mid, end, depth+1, nleaf);
+    if (nr < 0) return -1;
+    return (1 + nl + nr);
+}
+
 /*!
  * Default constructor for class BvElement.
  * Initialize an empty element of the bv-tree.
@@ -87,14 +160,11 @@ public:
  */
 BvNode::BvNode()
 {
-    m_lchild        = -1;
-    m_rchild         = -1;
     m_element[0]    = -1;
     m_element[1]    = -1;
-    m_nrange        = 0;
-    m_leaf            = false;
-    m_minPoint        = {{m_MAXLIMIT, m_MAXLIMIT, m_MAXLIMIT}};
-    m_maxPoint        = {{-m_MAXLIMIT, -m_MAXLIMIT, -m_MAXLIMIT}};
+    m_rchild        = -1;
+    m_minPoint      = {{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()}};
+    m_maxPoint      = {{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()}};
 }
 
 /*!
@@ -107,20 +177,269 @@ BvNode::~BvNode(){}
  */
 BvNode & BvNode::operator=(const BvNode & other)
 {
-    m_lchild        = other.m_lchild;
-    m_rchild         = other.m_rchild;
-    m_element        = other.m_element;
-    m_nrange        = other.m_nrange;
-    m_leaf            = other.m_leaf;
-    m_minPoint        = other.m_minPoint;
-    m_maxPoint        = other.m_maxPoint;
+    m_element       = other.m_element;
+    m_rchild        = other.m_rchild;
+    m_minPoint      = other.m_minPoint;
+    m_maxPoint      = other.m_maxPoint;
     return *this;
 }
 
+/*!
+ * It sets the bounding box of the node. The coordinates are converted
+ * in single precision rounding them outward, so that the stored box
+ * always contains the original one.
+ * \param[in] pmin Minimum coordinates of the bounding box.
+ * \param[in] pmax Maximum coordinates of the bounding box.
+ */
+void BvNode::setBoundingBox(const darray3E & pmin, const darray3E & pmax)
+{
+    for (int j=0; j<3; ++j)
+    {
+        float lo = float(pmin[j]);
+        if (double(lo) > pmin[j]) lo = std::nextafter(lo, -std::numeric_limits<float>::max());
+        float hi = float(pmax[j]);
+        if (double(hi) < pmax[j]) hi = std::nextafter(hi, std::numeric_limits<float>::max());
+        m_minPoint[j] = lo;
+        m_maxPoint[j] = hi;
+    }
+}
+
+/*!
+ * \return Minimum coordinates of the bounding box of the node.
+ */
+darray3E BvNode::getMinPoint() const
+{
+    return darray3E({{double(m_minPoint[0]), double(m_minPoint[1]), double(m_minPoint[2])}});
+}
+
+/*!
+ * \return Maximum coordinates of the bounding box of the node.
+ */
+darray3E BvNode::getMaxPoint() const
+{
+    return darray3E({{double(m_maxPoint[0]), double(m_maxPoint[1]), double(m_maxPoint[2])}});
+}
+
+/*!
+ * \class BvBuilder
+ * \ingroup core
+ * \brief BvBuilder is an ad-hoc class used to build the nodes of a Bv-Tree
+ * by binned Surface Area Heuristic splits.
+ *
+ * The elements are referred by their index in the bounding boxes and
+ * centroids structures; the construction reorders the list of the
+ * indices so that the elements of each node are contiguous.
+ * The nodes of a subtree are appended to a target list in depth-first order.
+ *
+ */
+class BvBuilder{
+public:
+    const dvecarr3E     & minP;         /**< minimum point of bounding box of the elements */
+    const dvecarr3E     & maxP;         /**< maximum point of bounding box of the elements */
+    const dvecarr3E     & centroid;     /**< centroid of the elements */
+    ivector1D           & order;        /**< indices of the elements, reordered during the construction */
+    int                 maxsize;        /**< maximum number of elements of a leaf node */
+
+    static const int    NBINS = 16;         /**< number of bins used in SAH evaluation */
+    static const int    MAXDEPTH = 64;      /**< depth after which the median split is forced */
+    static const int    TASKSIZE = 8192;    /**< minimum number of elements of a node built in a separate task */
+
+public:
+    /*!Custom constructor for class BvBuilder.
+     * \param[in] minP_ minimum point of bounding box of the elements.
+     * \param[in] maxP_ maximum point of bounding box of the elements.
+     * \param[in] centroid_ centroid of the elements.
+     * \param[in] order_ indices of the elements to be reordered.
+     * \param[in] maxsize_ maximum number of elements of a leaf node.
+     */
+    BvBuilder(const dvecarr3E & minP_, const dvecarr3E & maxP_, const dvecarr3E & centroid_, ivector1D & order_, int maxsize_) :
+        minP(minP_), maxP(maxP_), centroid(centroid_), order(order_), maxsize(std::max(1, maxsize_)){}
+
+    /*!
+     * \param[in] pmin minimum point of a box.
+     * \param[in] pmax maximum point of a box.
+     * \return half of the surface area of the box.
+     */
+    static double area(const darray3E & pmin, const darray3E & pmax)
+    {
+        darray3E d = pmax - pmin;
+        if (d[0] < 0.0) return 0.0;
+        return (d[0]*d[1] + d[1]*d[2] + d[2]*d[0]);
+    }
+
+    /*!
+     * It builds the subtree of a range of elements and appends its nodes to a list.
+     * A node is created as leaf if it is not split.
+     * Right child indices are referred to the position in the list.
+     * \param[in] begin index of the first element of the range in order list.
+     * \param[in] end index next to the last element of the range in order list.
+     * \param[in] depth depth of the subtree root.
+     * \param[in,out] nodes list of nodes.
+     */
+    void build(int begin, int end, int depth, std::vector<BvNode> & nodes)
+    {
+        const double maxl = std::numeric_limits<double>::max();
+        int inode = nodes.size();
+        nodes.emplace_back();
+
+        darray3E bmin({{maxl, maxl, maxl}}), bmax({{-maxl, -maxl, -maxl}});
+        darray3E cmin({{maxl, maxl, maxl}}), cmax({{-maxl, -maxl, -maxl}});
+        for (int i=begin; i<end; ++i)
+        {
+            int e = order[i];
+            for (int j=0; j<3; ++j)
+            {
+                bmin[j] = std::min(bmin[j], minP[e][j]);
+                bmax[j] = std::max(bmax[j], maxP[e][j]);
+                cmin[j] = std::min(cmin[j], centroid[e][j]);
+                cmax[j] = std::max(cmax[j], centroid[e][j]);
+            }
+        }
+        nodes[inode].setBoundingBox(bmin, bmax);
+        nodes[inode].m_element[0] = begin;
+        nodes[inode].m_element[1] = end;
+
+        int n = end - begin;
+        if (n == 1) return;
+
+        //search best split by binned SAH
+        int bestDir = -1, bestBin = -1;
+        double bestCost = maxl;
+        if (depth < MAXDEPTH)
+        {
+            double parea = std::max(area(bmin, bmax), std::numeric_limits<double>::min());
+            for (int dir=0; dir<3; ++dir)
+            {
+                double ext = cmax[dir] - cmin[dir];
+                if (ext <= 0.0) continue;
+                double scale = NBINS / ext;
+
+                std::array<int, NBINS> count;
+                std::array<darray3E, NBINS> binmin, binmax;
+                count.fill(0);
+                binmin.fill(darray3E({{maxl, maxl, maxl}}));
+                binmax.fill(darray3E({{-maxl, -maxl, -maxl}}));
+                for (int i=begin; i<end; ++i)
+                {
+                    int e = order[i];
+                    int k = std::min(NBINS-1, int(scale * (centroid[e][dir] - cmin[dir])));
+                    count[k]++;
+                    for (int j=0; j<3; ++j)
+                    {
+                        binmin[k][j] = std::min(binmin[k][j], minP[e][j]);
+                        binmax[k][j] = std::max(binmax[k][j], maxP[e][j]);
+                    }
+                }
+
+                //sweep from right to collect right side costs
+                std::array<double, NBINS> rcost;
+                darray3E rmin({{maxl, maxl, maxl}}), rmax({{-maxl, -maxl, -maxl}});
+                int nr = 0;
+                for (int k=NBINS-1; k>0; --k)
+                {
+                    nr += count[k];
+                    for (int j=0; j<3; ++j)
+                    {
+                        rmin[j] = std::min(rmin[j], binmin[k][j]);
+                        rmax[j] = std::max(rmax[j], binmax[k][j]);
+                    }
+                    rcost[k] = nr * area(rmin, rmax);
+                }
+
+                //sweep from left and evaluate the split after each bin
+                darray3E lmin({{maxl, maxl, maxl}}), lmax({{-maxl, -maxl, -maxl}});
+                int nl = 0;
+                for (int k=0; k<NBINS-1; ++k)
+                {
+                    nl += count[k];
+                    for (int j=0; j<3; ++j)
+                    {
+                        lmin[j] = std::min(lmin[j], binmin[k][j]);
+                        lmax[j] = std::max(lmax[j], binmax[k][j]);
+                    }
+                    if (nl == 0 || nl == n) continue;
+                    double cost = 1.0 + (nl * area(lmin, lmax) + rcost[k+1]) / parea;
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestDir = dir;
+                        bestBin = k;
+                    }
+                }
+            }
+        }
+
+        if (n <= maxsize && (bestDir < 0 || double(n) <= bestCost)) return;
+
+        int mid;
+        if (bestDir >= 0)
+        {
+            int dir = bestDir;
+            double scale = NBINS / (cmax[dir] - cmin[dir]);
+            double cmindir = cmin[dir];
+            const dvecarr3E & cent = centroid;
+            mid = int(std::partition(order.begin()+begin, order.begin()+end,
+                    [&cent, dir, scale, cmindir, bestBin](int e){
+                        return (std::min(NBINS-1, int(scale * (cent[e][dir] - cmindir))) <= bestBin);
+                    }) - order.begin());
+        }
+        else
+        {
+            //no SAH split available (coincident centroids or maximum depth): median split
+            int dir = 0;
+            for (int j=1; j<3; ++j)
+            {
+                if ((cmax[j] - cmin[j]) > (cmax[dir] - cmin[dir])) dir = j;
+            }
+            mid = begin + n/2;
+            const dvecarr3E & cent = centroid;
+            std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end,
+                    [&cent, dir](int a, int b){ return (cent[a][dir] < cent[b][dir]); });
+        }
+        if (mid == begin || mid == end) mid = begin + n/2;
+
+#if MIMMO_ENABLE_OPENMP
+        if (n >= TASKSIZE)
+        {
+            std::vector<BvNode> lnodes, rnodes;
+#pragma omp task shared(lnodes)
+            build(begin, mid, depth+1, lnodes);
+#pragma omp task shared(rnodes)
+            build(mid, end, depth+1, rnodes);
+#pragma omp taskwait
+
+            append(nodes, lnodes);
+            nodes[inode].m_rchild = nodes.size();
+            append(nodes, rnodes);
+            return;
+        }
+#endif
+        build(begin, mid, depth+1, nodes);
+        nodes[inode].m_rchild = nodes.size();
+        build(mid, end, depth+1, nodes);
+    }
+
+private:
+    /*!
+     * It appends a list of nodes of a subtree to a target list,
+     * shifting the internal right child indices.
+     * \param[in,out] nodes target list of nodes.
+     * \param[in] subtree list of nodes of the subtree.
+     */
+    void append(std::vector<BvNode> & nodes, const std::vector<BvNode> & subtree)
+    {
+        int offset = nodes.size();
+        nodes.insert(nodes.end(), subtree.begin(), subtree.end());
+        for (std::size_t i=offset; i<nodes.size(); ++i)
+        {
+            if (!nodes[i].isLeaf()) nodes[i].m_rchild += offset;
+        }
+    }
+};
+
 /*!
  * Default constructor for class BvTree.
- * Initialize an empty bv-tree structure and reserve memory for the insertion
- * of maxstack nodes.
+ * Initialize an empty bv-tree structure.
  * If a linked patch is passed by argument, the contained information are used
  * to initialize the member of the tree.
  *
@@ -135,19 +454,19 @@ BvTree::BvTree(bitpit::PatchKernel *patch_)
     m_nleaf        = 0;
     if (patch_ != NULL)
     {
-        m_maxstk    = std::max(10, int(m_patch->getVertexCount()));
         m_nelements = m_patch->getCellCount();
     }
     else
     {
-        m_maxstk    = 10;
         m_nelements = 0;
     }
     m_elements.resize(m_nelements);
-    increaseStack();
+    m_nVertexElement = -1;
 
     m_tol             = 1.0e-08;
-    m_maxsize    = 1;
+    m_maxsize    = 4;
+    m_buildCost  = 0.0;
+    m_refitTol   = 2.0;
 }
 
 /*!
@@ -169,14 +488,18 @@ BvTree & BvTree::operator=(const BvTree & other)
     m_patch        = other.m_patch;
     setup();
     m_dim             = other.m_dim;
-    m_maxstk        = other.m_maxstk;
     m_nodes            = other.m_nodes;
     m_nnodes        = other.m_nnodes;
     m_nleaf            = other.m_nleaf;
     m_maxsize        = other.m_maxsize;
     m_nelements        = other.m_nelements;
     m_elements        = other.m_elements;
+    m_coords          = other.m_coords;
+    m_coordsPtr       = other.m_coordsPtr;
+    m_nVertexElement  = other.m_nVertexElement;
     m_tol             = other.m_tol;
+    m_buildCost       = other.m_buildCost;
+    m_refitTol        = other.m_refitTol;
     return *this;
 }
 
@@ -190,18 +513,22 @@ void BvTree::setPatch(bitpit::PatchKernel *patch_)
     m_patch     = NULL;
     m_patch     = patch_;
     m_dim         = 3;
-    if (patch_ != NULL) m_maxstk = std::max(10, int(m_patch->getVertexCount()));
     m_nelements = 0;
     m_nnodes     = 0;
     m_nleaf        = 0;
     m_nodes.clear();
     m_elements.clear();
-    increaseStack();
+    m_coords.clear();
+    m_coordsPtr.clear();
+    m_nVertexElement = -1;
+    m_buildCost = 0.0;
 }
 
 /*! 
  * It sets the maximum number of elements in the leaf nodes of the tree.
- *  \param[in] maxsize Maximum number of elements in a leaf node (default =1).
+ * Nodes with a greater number of elements are always split; nodes with at most
+ * maxsize elements are split only if convenient in terms of Surface Area Heuristic.
+ *  \param[in] maxsize Maximum number of elements in a leaf node (default = 4).
  */
 void BvTree::setMaxLeafSize(int maxsize){
     m_maxsize = maxsize;
@@ -215,281 +542,263 @@ void BvTree::buildTree()
 {
     if (m_patch == NULL) return;
 
-    if (m_nelements == 0 || m_nodes.size() == 0) setup();
+    if (m_nelements == 0 || (int)m_elements.size() != m_nelements) setup();
     if (m_nelements == 0) return;
 
-    int iel = 0;
-    long id;
+    m_nodes.clear();
+    m_nnodes = 0;
+    m_nleaf = 0;
 
-    //fill ids and centroid
+    //fill ids
+    int iel = 0;
     for ( auto & cell : m_patch->getCells() )
     {
-        id = cell.getId();
-        m_elements[iel].m_label = id;
-        m_elements[iel].m_centroid = m_patch->evalCellCentroid(id);
+        m_elements[iel].m_label = cell.getId();
         iel++;
     }
 
-    //node root
-    BvNode node;
-    node.m_element[0] = 0;
-    node.m_element[1] = m_nelements;
-    node.m_nrange = m_nelements;
-    m_nodes[m_nnodes] = node;
-    if ( m_nelements == 1 )
+    //compute centroids and bounding boxes of the elements
+    dvecarr3E minP(m_nelements), maxP(m_nelements), centroid(m_nelements);
+    ivector1D order(m_nelements);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i=0; i<m_nelements; ++i)
     {
-        m_nodes[m_nnodes].m_leaf = true;
-        computeBoundingBox(0);
-        m_nleaf++;
-        m_nnodes++;
+        long id = m_elements[i].m_label;
+        m_elements[i].m_centroid = m_patch->evalCellCentroid(id);
+        centroid[i] = m_elements[i].m_centroid;
+        getElementBoundingBox(i, minP[i], maxP[i]);
+        order[i] = i;
     }
-    else
+
+    //build nodes
+    BvBuilder builder(minP, maxP, centroid, order, m_maxsize);
+    m_nodes.reserve(2*(m_nelements/std::max(1, m_maxsize)) + 1);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+    {
+#pragma omp single
+        builder.build(0, m_nelements, 0, m_nodes);
+    }
+#else
+    builder.build(0, m_nelements, 0, m_nodes);
+#endif
+    m_nodes.shrink_to_fit();
+    m_nnodes = m_nodes.size();
+    for (const BvNode & node : m_nodes)
     {
-        m_nnodes++;
-        fillTree(0);
+        if (node.isLeaf()) m_nleaf++;
     }
-    decreaseStack();
+
+    //reorder elements
+    std::vector<BvElement> elements(m_nelements);
+    for (int i=0; i<m_nelements; ++i)
+    {
+        elements[i] = m_elements[order[i]];
+    }
+    m_elements.swap(elements);
+
+    fillCoords();
+    m_buildCost = evalCost();
 }
 
 /*!
- * It fills the bv-tree starting from an existing node.
- * \param[in] iparent Index of the node used to start the fill procedure.
+ * It refits the bv-tree to the current coordinates of the vertices of the patch.
+ * The structure of the tree (elements of each node) is preserved, while the packed
+ * coordinates, the centroids of the elements and the bounding boxes of the nodes are
+ * recomputed; leaf nodes are updated in parallel and internal nodes are updated
+ * bottom-up as union of the bounding boxes of their children.
+ * It is meant to be used when the vertices of the patch are moved, without changes
+ * of its cells. After the refit, the SAH cost of the tree is compared with its cost at
+ * the time of construction: if the ratio is greater than the refit tolerance the tree
+ * is considered degraded and it should be built again.
+ * \return false if the tree cannot be refitted (no tree or changed number of elements)
+ * or if it is degraded beyond the refit tolerance, true otherwise.
  */
-void BvTree::fillTree(int iparent)
+bool BvTree::refitTree()
 {
-
-
-    //compute Bounding Box of node
-    computeBoundingBox(iparent);
-
-
-    if ( m_nodes[iparent].m_nrange > m_maxsize )
+    if (m_patch == NULL || m_nnodes == 0) return false;
+    if (m_nelements != (int)m_patch->getCellCount()) return false;
+
+    //update elements centroids and packed coordinates
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i=0; i<m_nelements; ++i)
     {
-
-        //split parent by mean of centroid in node
-        darray3E meanC = computeMeanPoint(m_nodes[iparent].m_element[0], m_nodes[iparent].m_element[1]);
-
-        //split by plane normal to maximum dimension of the centroid box
-        darray3E minPC{{m_MAXLIMIT, m_MAXLIMIT, m_MAXLIMIT}};
-        darray3E maxPC{{-m_MAXLIMIT, -m_MAXLIMIT, -m_MAXLIMIT}};
-        int ics = m_nodes[iparent].m_element[0], ice = m_nodes[iparent].m_element[1];
-        for (int ic=ics; ic<ice; ++ic )
+        long id = m_elements[i].m_label;
+        m_elements[i].m_centroid = m_patch->evalCellCentroid(id);
+        const bitpit::Cell & cell = m_patch->getCell(id);
+        double * coords = m_coords.data() + 3*m_coordsPtr[i];
+        int nV = getElementVertexCount(i);
+        for (int iV=0; iV<nV; ++iV)
         {
-            for (int j=0; j<m_dim; ++j )
-            {
-                minPC[j] = std::min(minPC[j], m_elements[ic].m_centroid[j]);
-                maxPC[j] = std::max(maxPC[j], m_elements[ic].m_centroid[j]);
-            }
-        }
-
-        int dir = 0;
-        double maxRange = maxPC[dir] - minPC[dir];
-        for ( int idim=1; idim<m_dim; ++idim )
-        {
-            if ((maxPC[idim] - minPC[idim]) > maxRange)
-            {
-                dir = idim;
-                maxRange = maxPC[dir] - minPC[dir];
-            }
+            const darray3E & vertex = m_patch->getVertexCoords(cell.getVertex(iV));
+            coords[3*iV]   = vertex[0];
+            coords[3*iV+1] = vertex[1];
+            coords[3*iV+2] = vertex[2];
         }
+    }
 
-        //Sort elements by coordinate dir.
-        std::vector<BvElement>::iterator itstart = m_elements.begin()+m_nodes[iparent].m_element[0];
-        std::vector<BvElement>::iterator itend = m_elements.begin()+(m_nodes[iparent].m_element[1]);
-
-        //Old algorithm
-        //        sort( itstart, itend, compareElements(dir) );
-        //        //find first element with coords[dir] > of meanC[dir]
-        //        int firstRight = findFirstGreater(iparent, meanC, dir);
-
-
-        int firstRight = pseudoSort( itstart, itend, meanC, dir );
-
-        //insert lchild
-        if ( firstRight > m_nodes[iparent].m_element[0]  )
+    //update leaf nodes
+    const double maxl = std::numeric_limits<double>::max();
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+    for (int inode=0; inode<m_nnodes; ++inode)
+    {
+        BvNode & node = m_nodes[inode];
+        if (!node.isLeaf()) continue;
+        darray3E pmin({{maxl, maxl, maxl}}), pmax({{-maxl, -maxl, -maxl}});
+        const double * coords = getElementCoords(node.m_element[0]);
+        int ncoords = m_coordsPtr[node.m_element[1]] - m_coordsPtr[node.m_element[0]];
+        for (int iV=0; iV<ncoords; ++iV)
         {
-            m_nodes[iparent].m_lchild = m_nnodes;
-            if ( (int)m_nodes.size() <= m_nnodes+1) increaseStack();
-            BvNode node;
-            node.m_element[0] = m_nodes[iparent].m_element[0];
-            node.m_element[1] = firstRight;
-            node.m_nrange = node.m_element[1] - node.m_element[0];
-            m_nodes[m_nnodes] = node;
-            if ( node.m_nrange == 1 )
-            {
-                m_nodes[m_nnodes].m_leaf = true;
-                computeBoundingBox(m_nnodes);
-                m_nnodes++;
-                m_nleaf++;
-            }
-            else
+            for (int j=0; j<3; ++j)
             {
-                m_nnodes++;
-                fillTree(m_nnodes-1);
+                pmin[j] = std::min(pmin[j], coords[3*iV+j]);
+                pmax[j] = std::max(pmax[j], coords[3*iV+j]);
             }
         }
+        pmin -= m_tol;
+        pmax += m_tol;
+        node.setBoundingBox(pmin, pmax);
+    }
 
-        //insert rchild
-        if ( firstRight < m_nodes[iparent].m_element[1] )
+    //update internal nodes bottom-up (children follow their parent in depth-first order)
+    for (int inode=m_nnodes-1; inode>=0; --inode)
+    {
+        BvNode & node = m_nodes[inode];
+        if (node.isLeaf()) continue;
+        const BvNode & lchild = m_nodes[inode+1];
+        const BvNode & rchild = m_nodes[node.m_rchild];
+        for (int j=0; j<3; ++j)
         {
-            m_nodes[iparent].m_rchild = m_nnodes;
-            if ( (int)m_nodes.size() <= m_nnodes+1) increaseStack();
-            BvNode node;
-            node.m_element[0] = firstRight;
-            node.m_element[1] = m_nodes[iparent].m_element[1];
-            node.m_nrange = node.m_element[1] - node.m_element[0];
-            m_nodes[m_nnodes] = node;
-            if (node.m_nrange == 1){
-                m_nodes[m_nnodes].m_leaf = true;
-                computeBoundingBox(m_nnodes);
-                m_nnodes++;
-                m_nleaf++;
-            }
-            else{
-                m_nnodes++;
-                fillTree(m_nnodes-1);
-            }
+            node.m_minPoint[j] = std::min(lchild.m_minPoint[j], rchild.m_minPoint[j]);
+            node.m_maxPoint[j] = std::max(lchild.m_maxPoint[j], rchild.m_maxPoint[j]);
         }
-
     }
-    else
-    {
-        //insert this node as leaf
-        m_nodes[iparent].m_leaf = true;
-        m_nleaf++;
 
-    }
+    if (m_refitTol > 0.0 && m_buildCost > 0.0 && evalCost() > m_refitTol * m_buildCost) return false;
 
+    return true;
 }
 
 /*!
- * It computes the mean centroid of a set of elements given the starting index and
- * the final index of the elements in the m_elements structure.
- * \param[in] istart Index of the first element to be used.
- * \param[in] iend Index of the last element to be used.
- * \return Coordinates of the mean centroid.
+ * It evaluates the Surface Area Heuristic cost of the tree, i.e. the sum of the
+ * areas of the internal nodes plus the areas of the leaf nodes weighted by their
+ * number of elements, normalized by the area of the root node.
+ * \return SAH cost of the tree, 0 if the tree is empty.
  */
-darray3E BvTree::computeMeanPoint(int istart, int iend)
+double BvTree::evalCost()
 {
-
-    long id;
-    darray3E meanC({{0.0, 0.0, 0.0}});
-    for ( int i=istart; i<iend; ++i )
+    if (m_nnodes == 0) return 0.0;
+
+    auto area = [](const BvNode & node){
+        double dx = double(node.m_maxPoint[0]) - double(node.m_minPoint[0]);
+        double dy = double(node.m_maxPoint[1]) - double(node.m_minPoint[1]);
+        double dz = double(node.m_maxPoint[2]) - double(node.m_minPoint[2]);
+        return (dx*dy + dy*dz + dz*dx);
+    };
+
+    double rootArea = area(m_nodes[0]);
+    if (rootArea <= 0.0) return 0.0;
+
+    double cost = 0.0;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static) reduction(+:cost)
+#endif
+    for (int inode=0; inode<m_nnodes; ++inode)
     {
-        id = m_elements[i].m_label;
-        meanC += m_patch->evalCellCentroid(id);
+        const BvNode & node = m_nodes[inode];
+        cost += area(node) * (node.isLeaf() ? double(node.getNRange()) : 1.0);
     }
-    meanC /= double(iend-istart);
-    return meanC;
+    return (cost / rootArea);
 }
 
 /*!
- * Find the index of the first BvElement in a given list, whose "dir" centroid coordinate is 
- * immediately at right of a a target mean centroid "dir "coordinate.
- * \param[in] itstart begin iterator of the target list
- * \param[in] itend end iterator of a target list
- * \param[in] meanC mean centroid
- * \param[in] dir centroid coordinate (0-x,1-y, 2-z)
+ * It sets the tolerance used to check the quality of a refitted tree.
+ * A refitted tree is considered degraded if its SAH cost is greater
+ * than its cost at the time of construction multiplied by the tolerance.
+ * \param[in] tol Refit tolerance (default 2.0). A value <= 0 disables the check.
  */
-int    BvTree::pseudoSort(std::vector<BvElement>::iterator itstart,
-        std::vector<BvElement>::iterator itend, darray3E meanC, int dir){
-
-    double thres = meanC[dir];
-
-    itend--;
-    while(itstart != itend){
-
-        while (itstart->m_centroid[dir] <= thres && itstart != itend){
-            itstart++;
-        }
-        while (itend->m_centroid[dir] > thres && itend != itstart){
-            itend--;
-        }
-
-        if (itstart != itend){
-            std::iter_swap(itstart, itend);
-        }
-    }
-
-    return (std::max(0, int(distance(m_elements.begin(), itend))));
+void BvTree::setRefitTolerance(double tol)
+{
+    m_refitTol = tol;
 }
 
 /*!
- * It finds the first element, contained din a target node, with a coordinate
- * of its centroid greater than a reference point (the mean centroid in the
- * bv-tree construction).
- * \param[in] inode Node index used to search.
- * \param[in] meanC Reference point coordinates (mean centroid in bv-tree fill procedure).
- * \param[in] dir Coordinate used to search the first greater point.
- * \return Index of the first element in the bounding volume
- * of the inode-th node with dir-th coordinate greater than meanC[dir].
- *
+ * \return tolerance used to check the quality of a refitted tree.
  */
-int BvTree::findFirstGreater(int inode, darray3E meanC, int dir)
+double BvTree::getRefitTolerance()
 {
-    double mean = meanC[dir];
-    int guess = (m_nodes[inode].m_element[1] - m_nodes[inode].m_element[0])/2;
-    int step = guess;
+    return m_refitTol;
+}
 
-    while( step > 0 )
+/*!
+ * It packs the vertex coordinates of the elements in the order of the tree,
+ * so that the coordinates of the elements of each leaf node are contiguous.
+ */
+void BvTree::fillCoords()
+{
+    m_coordsPtr.resize(m_nelements+1);
+    m_coordsPtr[0] = 0;
+    m_nVertexElement = -1;
+    for (int i=0; i<m_nelements; ++i)
     {
-        step /= 2;
-        guess += step * int(sign(mean - m_elements[guess].m_centroid[dir]));
-        guess = std::max(m_nodes[inode].m_element[0], guess);
-        guess = std::min(m_nodes[inode].m_element[1]-1, guess);
+        int nV = m_patch->getCell(m_elements[i].m_label).getVertexCount();
+        m_coordsPtr[i+1] = m_coordsPtr[i] + nV;
+        if (i == 0) m_nVertexElement = nV;
+        else if (nV != m_nVertexElement) m_nVertexElement = 0;
     }
+    if (m_nVertexElement == 0) m_nVertexElement = -1;
 
-    while ( mean < m_elements[guess].m_centroid[dir] && guess > m_nodes[inode].m_element[0] )
+    std::vector<double>(3*std::size_t(m_coordsPtr[m_nelements])).swap(m_coords);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i=0; i<m_nelements; ++i)
     {
-        guess--;
-    }
-    while ( mean > m_elements[guess].m_centroid[dir] && guess < m_nodes[inode].m_element[1]-1 )
-    {
-        guess++;
+        const bitpit::Cell & cell = m_patch->getCell(m_elements[i].m_label);
+        double * coords = m_coords.data() + 3*m_coordsPtr[i];
+        int nV = cell.getVertexCount();
+        for (int iV=0; iV<nV; ++iV)
+        {
+            const darray3E & vertex = m_patch->getVertexCoords(cell.getVertex(iV));
+            coords[3*iV]   = vertex[0];
+            coords[3*iV+1] = vertex[1];
+            coords[3*iV+2] = vertex[2];
+        }
     }
-    return guess;
 }
 
 /*!
- * It computes the bounding box coordinate of a given node.
- * \param[in] inode Index of the target node.
- *
- * After the call of the method the member m_minPpoint and m_maxPoint
- * of the inode.th node are filled by the coordinates of the extrema
- * points of the bounding volume that contains the elements
- * of the node.
+ * It computes the bounding box of an element of the tree, enlarged by
+ * the internal tolerance.
+ * \param[in] i Index of the target element in the m_elements structure.
+ * \param[out] pmin Minimum coordinates of the bounding box.
+ * \param[out] pmax Maximum coordinates of the bounding box.
  */
-void BvTree::computeBoundingBox(int inode)
+void BvTree::getElementBoundingBox(int i, darray3E & pmin, darray3E & pmax)
 {
-    BvNode &node(m_nodes[inode]);
-
-    int is = node.m_element[0];
-    int ie = node.m_element[1];
-
-    int nV;
+    const double maxl = std::numeric_limits<double>::max();
+    pmin = {{maxl, maxl, maxl}};
+    pmax = {{-maxl, -maxl, -maxl}};
 
-    node.m_minPoint = {{m_MAXLIMIT, m_MAXLIMIT, m_MAXLIMIT}};
-    node.m_maxPoint = {{-m_MAXLIMIT, -m_MAXLIMIT, -m_MAXLIMIT}};
-
-    bitpit::Cell     cell;
-    darray3E         coords;
-
-    for (int i=is; i<ie; i++ )
+    const bitpit::Cell & cell = m_patch->getCell(m_elements[i].m_label);
+    int nV = cell.getVertexCount();
+    for (int iV=0; iV<nV; ++iV )
     {
-        cell = m_patch->getCell(m_elements[i].m_label);
-        nV = cell.getVertexCount();
-        for (int iV=0; iV<nV; ++iV )
+        const darray3E & coords = m_patch->getVertexCoords(cell.getVertex(iV));
+        for (int j=0; j<m_dim; ++j )
         {
-            coords = m_patch->getVertexCoords(cell.getVertex(iV));
-            for (int j=0; j<m_dim; ++j )
-            {
-                node.m_minPoint[j] = std::min(node.m_minPoint[j], coords[j]);
-                node.m_maxPoint[j] = std::max(node.m_maxPoint[j], coords[j]);
-            }
+            pmin[j] = std::min(pmin[j], coords[j]);
+            pmax[j] = std::max(pmax[j], coords[j]);
         }
     }
-    node.m_minPoint -= m_tol;
-    node.m_maxPoint += m_tol;
+    pmin -= m_tol;
+    pmax += m_tol;
 }
 
 /*!
@@ -507,7 +816,7 @@ bool BvTree::inBoundingBox(darray3E *P_, BvNode *node_, double r)
     bool in = true;
     for ( int i=0; i<m_dim; i++ )
     {
-        if ( ( (*P_)[i] < ( node_->m_minPoint[i] - r) ) || ( (*P_)[i] > ( node_->m_maxPoint[i] + r ) ) ){
+        if ( ( (*P_)[i] < ( double(node_->m_minPoint[i]) - r) ) || ( (*P_)[i] > ( double(node_->m_maxPoint[i]) + r ) ) ){
             in = false;
             break;
         }
@@ -527,12 +836,12 @@ bool BvTree::inBoundingBox(darray3E *P_, BvNode *node_, double r)
 bool BvTree::SphereBoundingBox(darray3E *P_, BvNode *node_, double r)
 {
 
-    darray3E closestP;
+    double dist = 0.0;
     for ( int i=0; i<m_dim; i++ )
     {
-        closestP[i] = std::min(std::max((*P_)[i], node_->m_minPoint[i]), node_->m_maxPoint[i]);
+        double d = std::min(std::max((*P_)[i], double(node_->m_minPoint[i])), double(node_->m_maxPoint[i])) - (*P_)[i];
+        dist += d*d;
     }
-    double dist = dotProduct(closestP-(*P_), closestP-(*P_));
 
     return (dist < r*r);
 }
@@ -545,9 +854,12 @@ void BvTree::clean(){
     m_dim        = 3;
     m_nelements = 0;
     m_nnodes    = 0;
-    m_maxstk    = 10;
     m_nodes.clear();
     m_elements.clear();
+    m_coords.clear();
+    m_coordsPtr.clear();
+    m_nVertexElement = -1;
+    m_buildCost = 0.0;
     m_nleaf        = 0;
 }
 
@@ -561,173 +873,408 @@ void BvTree::setup(){
     m_nleaf        = 0;
     if (m_patch != NULL)
     {
-        m_maxstk    = std::max(10, int(m_patch->getVertexCount()));
         m_nelements = m_patch->getCellCount();
     }
     else
     {
-        m_maxstk    = 10;
         m_nelements = 0;
     }
     m_elements.resize(m_nelements);
-    increaseStack();
 }
 
-/*! 
- * Whenever the bv-tree reaches its full capacity (i.e. the number of BvNode
- * stored in the tree is equal to the memory reserved), increase the memory
- * reserve by maxstack.
+/*!
+ * It writes the bv-tree in binary form, to be restored on the same patch
+ * (see restore). The linked patch is not written.
+ * \param[in] out output stream
  */
-void BvTree::increaseStack()
+void BvTree::dump(std::ostream & out) const
 {
-    m_nodes.resize(m_nodes.size() + m_maxstk);
+    int32_t header[8] = {m_dim, m_nelements, m_nnodes, m_nVertexElement, m_nleaf, m_maxsize,
+                         int32_t(sizeof(BvElement)), int32_t(sizeof(BvNode))};
+    double params[3] = {m_tol, m_buildCost, m_refitTol};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(params), sizeof(params));
+    bvWriteVector(out, m_elements);
+    bvWriteVector(out, m_nodes);
+    bvWriteVector(out, m_coordsPtr);
+    bvWriteVector(out, m_coords);
 }
 
-/*! 
- * Decrease the memory reserved for bv-tree by maxstack.
- * Resize the m_nodes to effective number of nodes.
+/*!
+ * It reads a bv-tree written by dump. The linked patch is preserved and it has to be
+ * the same patch (same cell ids and vertex coordinates) the tree was built on: the number
+ * of elements of the tree is checked against the cell count of the patch, the labels and
+ * the number of vertices of the elements against its cells, if any
+ * (see MimmoObject::restoreStructure for a complete check).
+ * Sizes, element ranges and child links of the nodes are validated before the tree is accepted.
+ * \param[in] in input stream
+ * \return false if the tree cannot be read; in that case the tree is cleaned.
  */
-void BvTree::decreaseStack()
+bool BvTree::restore(std::istream & in)
 {
-    m_nodes.resize(m_nnodes);
+    clean();
+    int32_t header[8];
+    double params[3];
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    in.read(reinterpret_cast<char *>(params), sizeof(params));
+    bool check = in.good() && header[6] == int32_t(sizeof(BvElement)) && header[7] == int32_t(sizeof(BvNode));
+    check = check && header[1] >= 0 && header[2] >= 0 && std::size_t(header[2]) <= 2*std::size_t(header[1]);
+    check = check && (m_patch == NULL || long(header[1]) == m_patch->getCellCount());
+    std::size_t nelements = check ? std::size_t(header[1]) : 0;
+    check = check && bvReadVector(in, m_elements, nelements) && bvReadVector(in, m_nodes, 2*nelements);
+    check = check && bvReadVector(in, m_coordsPtr, nelements+1);
+    check = check && m_elements.size() == nelements && m_nodes.size() >= std::size_t(header[2]);
+    check = check && m_coordsPtr.size() == nelements+1 && m_coordsPtr[0] == 0;
+    for (std::size_t i=0; check && i<nelements; ++i)
+    {
+        check = (m_coordsPtr[i+1] >= m_coordsPtr[i]);
+        if (check && m_patch != NULL)
+        {
+            long label = m_elements[i].m_label;
+            check = m_patch->getCells().exists(label)
+                    && (m_coordsPtr[i+1] - m_coordsPtr[i]) == m_patch->getCell(label).getVertexCount();
+        }
+    }
+    check = check && bvReadVector(in, m_coords, 3*std::size_t(m_coordsPtr.back()));
+    check = check && m_coords.size() == 3*std::size_t(m_coordsPtr.back());
+    if (check)
+    {
+        int nleaf = 0;
+        if (header[1] == 0)     check = (header[2] == 0);
+        else                    check = (bvCheckNodes(m_nodes, header[2], 0, 0, header[1], 0, nleaf) == header[2]);
+        check = check && (nleaf == header[4]);
+    }
+    if (!check){
+        clean();
+        return false;
+    }
+    m_dim = header[0];
+    m_nelements = header[1];
+    m_nnodes = header[2];
+    m_nVertexElement = header[3];
+    m_nleaf = header[4];
+    m_maxsize = header[5];
+    m_tol = params[0];
+    m_buildCost = params[1];
+    m_refitTol = params[2];
+    return true;
 }
 
 namespace bvTreeUtils{
+
 /*!
- * It computes the signed distance of a point to a geometry linked in a BvTree
- * object. The geometry has to be a surface mesh, in particular an object of type
- * bitpit::SurfUnstructured (a static cast is hardly coded in the method).
- * The sign of the distance is provided by the normal to the geometry locally
- * computed. A positive distance means that the point is located, in respect to the
- * surface mesh, on the same side of the outer normal vector.
- * It searches the element with minimum distance in a box of length 2*r, if none
- * is found return a default value of distance equal to 1.0e+18;
- * \param[in] P_ Pointer to coordinates of input point.
- * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
- * \param[out] id Label of the element found as minimum distance element in the bv-tree.
- * \param[out] n Pseudo-normal of the element (i.e. unit vector with direction (P-xP),
- * where P is the input point and xP the nearest point on the element (simplex) to
- * the projection of P on the plane of the simplex.
- * \param[in] r Length of the side of the box or radius of the sphere used to search. (The algorithm checks
- * every element encountered inside the box/sphere).
- * \param[in] method Method used to search the element (0=bounding box, 1=sphere).
- * \param[in] spatch_ Pointer to bitpit::SurfUnstructured patch related to the bv-tree (optional).
- * \param[in] next Index of the starting node to perform the searching (optional).
- * \param[in] h Initial minimum distance (if no value find below the initial value, it returns this value as result) (optional).
- * \return Signed distance of the input point from the patch in the bv-tree.
+ * It computes the squared distance of a point from a segment.
+ * \param[in] P Coordinates of the point.
+ * \param[in] A Coordinates of the first vertex of the segment.
+ * \param[in] B Coordinates of the second vertex of the segment.
+ * \return Squared distance.
  */
-double signedDistance(std::array<double,3> *P_, BvTree *bvtree_, long &id, std::array<double,3> &n, double &r, int method, bitpit::SurfUnstructured *spatch_, int next, double h)
+static inline double squaredDistancePointSegment(const double * P, const double * A, const double * B)
 {
+    double ab[3], ap[3];
+    for (int j=0; j<3; ++j)
+    {
+        ab[j] = B[j] - A[j];
+        ap[j] = P[j] - A[j];
+    }
+    double l2 = ab[0]*ab[0] + ab[1]*ab[1] + ab[2]*ab[2];
+    double t = (ap[0]*ab[0] + ap[1]*ab[1] + ap[2]*ab[2]) / (l2 > 0.0 ? l2 : 1.0);
+    t = std::min(std::max(t, 0.0), 1.0);
+    double d2 = 0.0;
+    for (int j=0; j<3; ++j)
+    {
+        double d = ap[j] - t*ab[j];
+        d2 += d*d;
+    }
+    return d2;
+}
 
-    if ( spatch_ == NULL ) spatch_ = static_cast<bitpit::SurfUnstructured*>(bvtree_->m_patch);
-
-    // Local variables
-    double        hr = 1.0e+18,    hl = 1.0e+18;
-    double        rstart = r;
-    long        idr = -1,            idl = -1;
-    int            index_l = -1,    index_r = -1;
-
+/*!
+ * It computes the squared distance of a point from a triangle.
+ * The distance from the plane of the triangle and from its three edges
+ * are always evaluated and the result is selected without branching,
+ * so that the kernel can be vectorized over a block of triangles.
+ * \param[in] P Coordinates of the point.
+ * \param[in] V Packed coordinates of the three vertices of the triangle.
+ * \return Squared distance.
+ */
+static inline double squaredDistancePointTriangle(const double * P, const double * V)
+{
+    const double * A = V;
+    const double * B = V + 3;
+    const double * C = V + 6;
+    double e0[3], e1[3], ap[3];
+    for (int j=0; j<3; ++j)
+    {
+        e0[j] = B[j] - A[j];
+        e1[j] = C[j] - A[j];
+        ap[j] = P[j] - A[j];
+    }
+    double d00 = e0[0]*e0[0] + e0[1]*e0[1] + e0[2]*e0[2];
+    double d01 = e0[0]*e1[0] + e0[1]*e1[1] + e0[2]*e1[2];
+    double d11 = e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2];
+    double d20 = ap[0]*e0[0] + ap[1]*e0[1] + ap[2]*e0[2];
+    double d21 = ap[0]*e1[0] + ap[1]*e1[1] + ap[2]*e1[2];
+
+    //squared norm of e0 x e1
+    double den = d00*d11 - d01*d01;
+    bool valid = (den > 1.0e-14*d00*d11);
+    double inv = valid ? 1.0/den : 0.0;
+    double v = (d11*d20 - d01*d21) * inv;
+    double w = (d00*d21 - d01*d20) * inv;
+    double u = 1.0 - v - w;
+    bool inside = valid && (u >= 0.0) && (v >= 0.0) && (w >= 0.0);
+
+    double n0 = e0[1]*e1[2] - e0[2]*e1[1];
+    double n1 = e0[2]*e1[0] - e0[0]*e1[2];
+    double n2 = e0[0]*e1[1] - e0[1]*e1[0];
+    double dn = ap[0]*n0 + ap[1]*n1 + ap[2]*n2;
+    double dplane = dn*dn*inv;
+
+    double dedge = std::min(squaredDistancePointSegment(P, A, B),
+                   std::min(squaredDistancePointSegment(P, B, C), squaredDistancePointSegment(P, C, A)));
+
+    return (inside ? dplane : dedge);
+}
 
-    if ( bvtree_->m_nnodes == 0 ) return 1.0e+18;
+/*!
+ * It computes the minimum distance of a point from the elements of a leaf node
+ * of a BvTree, using the packed coordinates of the tree.
+ * Triangles are processed in blocks of MIMMO_BVTREE_BLOCKSIZE elements.
+ * \param[in] P_ Pointer to coordinates of input point.
+ * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
+ * \param[in] inode Index of the leaf node.
+ * \param[in,out] h Current minimum distance, updated if a nearer element is found.
+ * \param[in,out] id Label of the nearest element, updated if a nearer element is found.
+ * \param[in,out] r Search radius, updated to the new minimum distance.
+ */
+static void leafDistance(const std::array<double,3> *P_, const BvTree *bvtree_, int inode, double &h, long &id, double &r)
+{
+    const BvNode & node = bvtree_->m_nodes[inode];
+    const double * P = P_->data();
+    int ibegin = node.m_element[0];
+    int iend = node.m_element[1];
 
-    if ( !(bvtree_->m_nodes[next].m_leaf) )
+    if (bvtree_->m_nVertexElement == 3)
     {
-
-        index_l = bvtree_->m_nodes[next].m_lchild;
-        index_r = bvtree_->m_nodes[next].m_rchild;
-        if ( index_l >= 0 )
+        const double * V = bvtree_->getElementCoords(ibegin);
+        double d2[MIMMO_BVTREE_BLOCKSIZE];
+        for (int ib=ibegin; ib<iend; ib+=MIMMO_BVTREE_BLOCKSIZE)
         {
-            if (method == 0){
-                if ( bvtree_->inBoundingBox(P_, &bvtree_->m_nodes[index_l], r) )
-                {
-                    hl = signedDistance(P_, bvtree_, idl, n, r, method, spatch_, index_l, h);
-                }
+            int nb = std::min(MIMMO_BVTREE_BLOCKSIZE, iend-ib);
+            const double * VB = V + 9*(ib-ibegin);
+            for (int t=0; t<nb; ++t)
+            {
+                d2[t] = squaredDistancePointTriangle(P, VB + 9*t);
             }
-            else if (method == 1){
-                if ( bvtree_->SphereBoundingBox(P_, &bvtree_->m_nodes[index_l], r) )
+            for (int t=0; t<nb; ++t)
+            {
+                double ah_ = std::sqrt(d2[t]);
+                if ( ah_ < h )
                 {
-                    hl = signedDistance(P_, bvtree_, idl, n, r, method, spatch_, index_l, h);
+                    h = ah_;
+                    id = bvtree_->m_elements[ib+t].m_label;
+                    r = h;
                 }
             }
+        }
+        return;
+    }
 
+    for (int iel=ibegin; iel<iend; ++iel)
+    {
+        int nV = bvtree_->getElementVertexCount(iel);
+        const double * V = bvtree_->getElementCoords(iel);
+        double ah_;
+        if ( nV == 3 )
+        {
+            ah_ = std::sqrt(squaredDistancePointTriangle(P, V));
         }
-        if ( hl < h )
+        else if ( nV == 2 )
         {
-            h = hl;
-            id = idl;
-            r = h;
+            ah_ = std::sqrt(squaredDistancePointSegment(P, V, V+3));
         }
-
-        if ( index_r >= 0 )
+        else
         {
-            if (method == 0){
-                if ( bvtree_->inBoundingBox(P_, &bvtree_->m_nodes[index_r], r) )
-                {
-                    hr = signedDistance(P_, bvtree_, idr, n, r, method, spatch_, index_r, h);
-                }
-            }
-            else if (method == 1){
-                if ( bvtree_->SphereBoundingBox(P_, &bvtree_->m_nodes[index_r], r) )
-                {
-                    hr = signedDistance(P_, bvtree_, idr, n, r, method, spatch_, index_r, h);
-                }
+            dvecarr3E VS(nV);
+            for (int iV=0; iV<nV; ++iV)
+            {
+                VS[iV] = {{V[3*iV], V[3*iV+1], V[3*iV+2]}};
             }
+            darray3E xP;
+            int flag;
+            ah_ = bitpit::CGElem::distancePointSimplex((*P_), VS, xP, flag);
         }
-        if ( hr < h )
+
+        if ( ah_ < h )
         {
-            h = hr;
-            id = idr;
+            h = ah_;
+            id = bvtree_->m_elements[iel].m_label;
             r = h;
         }
+    }
+}
 
+/*!
+ * It computes the squared distance of a point from the bounding box of a node.
+ * \param[in] P Coordinates of the point.
+ * \param[in] node Target node.
+ * \return Squared distance, zero if the point is inside the box.
+ */
+static inline double squaredDistancePointBox(const double * P, const BvNode & node)
+{
+    double d2 = 0.0;
+    for (int j=0; j<3; ++j)
+    {
+        double d = std::min(std::max(P[j], double(node.m_minPoint[j])), double(node.m_maxPoint[j])) - P[j];
+        d2 += d*d;
     }
-    else
+    return d2;
+}
+
+/*!
+ * It searches the element of a BvTree with minimum distance from a point, starting from a
+ * target node. The tree is visited depth-first with an explicit stack; each node is checked against
+ * the current search box/sphere when it is extracted from the stack, so that the search radius
+ * shrinks as soon as a nearer element is found. With the sphere method the nearest child is visited first.
+ * \param[in] P_ Pointer to coordinates of input point.
+ * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
+ * \param[in,out] id Label of the element found as minimum distance element, untouched if none is found.
+ * \param[in,out] r Length of the side of the box or radius of the sphere used to search, set to the minimum distance found.
+ * \param[in] method Method used to search the element (0=bounding box, 1=sphere).
+ * \param[in] next Index of the starting node.
+ * \param[in] h Initial minimum distance.
+ * \return Minimum distance found, or h if no nearer element is found.
+ */
+static double nearestElement(std::array<double,3> *P_, BvTree *bvtree_, long &id, double &r, int method, int next, double h)
+{
+    const double * P = P_->data();
+    std::array<int, BVTREE_STACKSIZE> stack;
+    int nstack = 0;
+    stack[nstack++] = next;
+
+    while (nstack > 0)
     {
+        int inode = stack[--nstack];
+        BvNode & node = bvtree_->m_nodes[inode];
 
-        long         id_;
-        darray3E     xP;
-        int         nV;
-        double         ah_;
+        //the starting node is visited in any case
+        if (inode != next)
+        {
+            bool visit = false;
+            if (method == 0)        visit = bvtree_->inBoundingBox(P_, &node, r);
+            else if (method == 1)   visit = (squaredDistancePointBox(P, node) < r*r);
+            if (!visit) continue;
+        }
 
-        for (int ie = 0; ie < bvtree_->m_nodes[next].m_nrange; ++ie)
+        if (node.isLeaf())
         {
-            id_ = bvtree_->m_elements[bvtree_->m_nodes[next].m_element[0]+ie].m_label;
-            bitpit::Cell cell = spatch_->getCell(id_);
-            nV = cell.getVertexCount();
-            dvecarr3E VS(nV);
-            for (int iV=0; iV<nV; ++iV)
-            {
-                VS[iV] = spatch_->getVertexCoords(cell.getVertex(iV));
-            }
+            leafDistance(P_, bvtree_, inode, h, id, r);
+            continue;
+        }
 
-            //signed distance only for patch with triangles or segments
-            if ( nV == 3 )
-            {
-                darray3E lambda ;
-                int flag;
-                ah_ = bitpit::CGElem::distancePointTriangle((*P_), VS[0], VS[1], VS[2], xP, lambda, flag);
-            }
-            else if ( nV == 2 )
-            {
-                darray2E lambda ;
-                int flag;
-                ah_ = bitpit::CGElem::distancePointSegment((*P_), VS[0], VS[1], xP, lambda, flag);
+        int lchild = inode + 1;
+        int rchild = node.m_rchild;
+        if (method == 1 && squaredDistancePointBox(P, bvtree_->m_nodes[rchild]) < squaredDistancePointBox(P, bvtree_->m_nodes[lchild]))
+        {
+            std::swap(lchild, rchild);
+        }
+        stack[nstack++] = rchild;
+        stack[nstack++] = lchild;
+    }
 
-            }
-            else{
-                int flag;
-                ah_ = bitpit::CGElem::distancePointSimplex((*P_), VS, xP, flag);
-            }
+    return h;
+}
 
-            if ( ah_ < h )
-            {
-                h = ah_;
-                id = id_;
-                r = h;
-            }
+/*!
+ * It computes an ordering of a list of points along a Morton (Z-order) space-filling curve,
+ * so that points near in the list are near in space.
+ * \param[in] points List of points.
+ * \return Indices of the points in the list, sorted along the curve.
+ */
+static std::vector<int> sortByMortonCode(const std::vector<std::array<double,3> > & points)
+{
+    int nP = points.size();
+    std::vector<int> order(nP);
+    if (nP == 0) return order;
+
+    darray3E pmin = points[0], pmax = points[0];
+    for (const darray3E & p : points)
+    {
+        for (int j=0; j<3; ++j)
+        {
+            pmin[j] = std::min(pmin[j], p[j]);
+            pmax[j] = std::max(pmax[j], p[j]);
         }
+    }
+    darray3E scale;
+    for (int j=0; j<3; ++j)
+    {
+        scale[j] = (pmax[j] > pmin[j]) ? double((1 << 21) - 1) / (pmax[j] - pmin[j]) : 0.0;
+    }
 
+    std::vector<std::pair<uint64_t, int> > keys(nP);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i=0; i<nP; ++i)
+    {
+        uint64_t key = 0;
+        for (int j=0; j<3; ++j)
+        {
+            uint64_t x = uint64_t((points[i][j] - pmin[j]) * scale[j]);
+            //spread the 21 bits of x, leaving two zeros between each bit
+            x &= 0x1fffff;
+            x = (x | x << 32) & 0x1f00000000ffffULL;
+            x = (x | x << 16) & 0x1f0000ff0000ffULL;
+            x = (x | x << 8)  & 0x100f00f00f00f00fULL;
+            x = (x | x << 4)  & 0x10c30c30c30c30c3ULL;
+            x = (x | x << 2)  & 0x1249249249249249ULL;
+            key |= (x << j);
+        }
+        keys[i] = std::make_pair(key, i);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (int i=0; i<nP; ++i)
+    {
+        order[i] = keys[i].second;
     }
+    return order;
+}
+
+/*!
+ * It computes the signed distance of a point to a geometry linked in a BvTree
+ * object. The geometry has to be a surface mesh, in particular an object of type
+ * bitpit::SurfUnstructured (a static cast is hardly coded in the method).
+ * The sign of the distance is provided by the normal to the geometry locally
+ * computed. A positive distance means that the point is located, in respect to the
+ * surface mesh, on the same side of the outer normal vector.
+ * It searches the element with minimum distance in a box of length 2*r, if none
+ * is found return a default value of distance equal to 1.0e+18;
+ * \param[in] P_ Pointer to coordinates of input point.
+ * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
+ * \param[out] id Label of the element found as minimum distance element in the bv-tree.
+ * \param[out] n Pseudo-normal of the element (i.e. unit vector with direction (P-xP),
+ * where P is the input point and xP the nearest point on the element (simplex) to
+ * the projection of P on the plane of the simplex.
+ * \param[in] r Length of the side of the box or radius of the sphere used to search. (The algorithm checks
+ * every element encountered inside the box/sphere).
+ * \param[in] method Method used to search the element (0=bounding box, 1=sphere).
+ * \param[in] spatch_ Pointer to bitpit::SurfUnstructured patch related to the bv-tree (optional).
+ * \param[in] next Index of the starting node to perform the searching (optional).
+ * \param[in] h Initial minimum distance (if no value find below the initial value, it returns this value as result) (optional).
+ * \return Signed distance of the input point from the patch in the bv-tree.
+ */
+double signedDistance(std::array<double,3> *P_, BvTree *bvtree_, long &id, std::array<double,3> &n, double &r, int method, bitpit::SurfUnstructured *spatch_, int next, double h)
+{
+
+    if ( spatch_ == NULL ) spatch_ = static_cast<bitpit::SurfUnstructured*>(bvtree_->m_patch);
+
+    double        rstart = r;
+
+    if ( bvtree_->m_nnodes == 0 ) return 1.0e+18;
+
+    h = nearestElement(P_, bvtree_, id, r, method, next, h);
 
     if ( next == 0 )
     {
@@ -738,7 +1285,7 @@ double signedDistance(std::array<double,3> *P_, BvTree *bvtree_, long &id, std::
             darray3E     xP, normal;
             int         nV;
 
-            bitpit::Cell cell = spatch_->getCell(id);
+            const bitpit::Cell & cell = spatch_->getCell(id);
             nV = cell.getVertexCount();
             dvecarr3E VS(nV);
             for (int iV = 0; iV < nV; ++iV )
@@ -819,107 +1366,11 @@ double signedDistance(std::array<double,3> *P_, BvTree *bvtree_, long &id, std::
 double distance(std::array<double,3> *P_, BvTree* bvtree_, long &id, double &r, int method, int next, double h)
 {
 
-    // Local variables
-    int        index_l = -1,    index_r = -1;
-    double     hr = 1.0e+18,    hl = 1.0e+18;
-    long    idr = -1,        idl = -1;
     double  rstart = r;
 
     if ( bvtree_->m_nnodes == 0 ) return 1.0e+18;
 
-    if ( !(bvtree_->m_nodes[next].m_leaf) )
-    {
-
-        index_l = bvtree_->m_nodes[next].m_lchild;
-        index_r = bvtree_->m_nodes[next].m_rchild;
-        if ( index_l >= 0 )
-        {
-            if (method == 0){
-                if ( bvtree_->inBoundingBox(P_, &bvtree_->m_nodes[index_l], r) )
-                {
-                    hl = distance(P_, bvtree_, idl, r, method, index_l, h);
-                }
-            }
-            else if (method == 1){
-                if ( bvtree_->SphereBoundingBox(P_, &bvtree_->m_nodes[index_l], r) )
-                {
-                    hl = distance(P_, bvtree_, idl, r, method, index_l, h);
-                }
-            }
-        }
-        if ( hl < h )
-        {
-            h = hl;
-            id = idl;
-            r = h;
-        }
-        if ( index_r >= 0 )
-        {
-            if (method == 0){
-                if ( bvtree_->inBoundingBox(P_, &bvtree_->m_nodes[index_r], r) )
-                {
-                    hr = distance(P_, bvtree_, idr, r, method, index_r, h);
-                }
-            }
-            else if (method == 1){
-                if ( bvtree_->SphereBoundingBox(P_, &bvtree_->m_nodes[index_r], r) )
-                {
-                    hr = distance(P_, bvtree_, idr, r, method, index_r, h);
-                }
-            }
-        }
-        if ( hr < h )
-        {
-            h = hr;
-            id = idr;
-            r = h;
-        }
-
-    }
-    else{
-
-        long         id_;
-        darray3E     xP;
-        int         nV;
-        double         ah_;
-
-        for (int ie = 0; ie < bvtree_->m_nodes[next].m_nrange; ++ie)
-        {
-            id_ = bvtree_->m_elements[bvtree_->m_nodes[next].m_element[0]+ie].m_label;
-            bitpit::Cell cell = bvtree_->m_patch->getCell(id_);
-            nV = cell.getVertexCount();
-            dvecarr3E VS(nV);
-            for (int iV = 0; iV < nV; ++iV )
-            {
-                VS[iV] = bvtree_->m_patch->getVertexCoords(cell.getVertex(iV));
-            }
-
-            if ( nV == 3 )
-            {
-                darray3E lambda ;
-                int flag;
-                ah_ = bitpit::CGElem::distancePointTriangle((*P_), VS[0], VS[1], VS[2], xP, lambda, flag);
-            }
-            else if ( nV == 2 )
-            {
-                darray2E lambda ;
-                int flag;
-                ah_ = bitpit::CGElem::distancePointSegment((*P_), VS[0], VS[1], xP, lambda, flag);
-            }
-            else{
-                int flag;
-                ah_ = bitpit::CGElem::distancePointSimplex((*P_), VS, xP, flag);
-            }
-
-
-            if ( ah_ < h )
-            {
-                h = ah_;
-                id = id_;
-                r = h;
-            }
-        }
-    }
+    h = nearestElement(P_, bvtree_, id, r, method, next, h);
 
     if ( next == 0 && h > rstart ) h = 1.0e+18;
 
@@ -967,6 +1418,9 @@ darray3E projectPoint( std::array<double,3> *P_, BvTree *bvtree_, double r )
  * surface mesh, on the same side of the outer normal vector.
  * It searches the elements with minimum distance in a box of length 2*r or sphere of radius r alternatively. If none
  * is found return a default value of distance equal to 1.0e+18;
+ * The points are processed in parallel (if mimmo is compiled with OpenMP support), following
+ * their order along a Morton space-filling curve to improve the coherence of the tree traversals.
+ * Each point is searched with the initial size r_.
  * \param[in] P_ Pointer to a vector with the coordinates of input points.
  * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
  * \param[out] id Vector of labels of the elements found as minimum distance elements in the bv-tree.
@@ -982,11 +1436,18 @@ dvector1D signedDistance(std::vector<std::array<double,3> > *P_, BvTree *bvtree_
 {
     bitpit::SurfUnstructured *spatch_ = static_cast<bitpit::SurfUnstructured*>(bvtree_->m_patch);
 
-    double         r = r_;
     int            nP = P_->size();
     dvector1D     dist(nP);
-
-    for (int i = 0; i < nP; ++i){
+    id.resize(nP, -1);
+    n.resize(nP, darray3E({{0.0, 0.0, 0.0}}));
+
+    std::vector<int> order = sortByMortonCode(*P_);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int k = 0; k < nP; ++k){
+        int i = order[k];
+        double r = r_;
         dist[i] = signedDistance(&((*P_)[i]), bvtree_, id[i], n[i], r, method, spatch_);
     }
     return dist;
@@ -998,6 +1459,9 @@ dvector1D signedDistance(std::vector<std::array<double,3> > *P_, BvTree *bvtree_
  * bitpit::SurfUnstructured (a static cast is hardly coded in the method).
  * It searches the elements with minimum distance in a box of length 2*r or sphere of radius r alternatively. If none
  * is found return a default value of distance equal to 1.0e+18;
+ * The points are processed in parallel (if mimmo is compiled with OpenMP support), following
+ * their order along a Morton space-filling curve to improve the coherence of the tree traversals.
+ * Each point is searched with the initial size r_.
  * \param[in] P_ Pointer to vector with the coordinates of input points.
  * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
  * \param[out] id Vector with labels of the elements found as minimum distance elements in the bv-tree.
@@ -1009,11 +1473,17 @@ dvector1D signedDistance(std::vector<std::array<double,3> > *P_, BvTree *bvtree_
 dvector1D distance(std::vector<std::array<double,3> > *P_, BvTree *bvtree_, std::vector<long> &id, double r_, int method)
 {
 
-    double         r = r_;
     int            nP = P_->size();
     dvector1D     dist(nP);
-
-    for (int i = 0; i < nP; ++i){
+    id.resize(nP, -1);
+
+    std::vector<int> order = sortByMortonCode(*P_);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int k = 0; k < nP; ++k){
+        int i = order[k];
+        double r = r_;
         dist[i] = distance(&((*P_)[i]), bvtree_, id[i], r, method);
     }
     return dist;
@@ -1026,6 +1496,9 @@ dvector1D distance(std::vector<std::array<double,3> > *P_, BvTree *bvtree_, std:
  * It searches the elements of the geometry with minimum distance
  * recursively in a box of length 2*r or sphere of radius r, by increasing the size r at each step
  * until at least one element is found.
+ * The points are processed in parallel (if mimmo is compiled with OpenMP support), following
+ * their order along a Morton space-filling curve to improve the coherence of the tree traversals.
+ * Each point is searched with the initial size r_.
  * \param[in] P_ Pointer to vector with coordinates of input points.
  * \param[in] bvtree_ Pointer to Boundary Volume Hierarchy tree that stores the geometry.
  * \param[in] r_ Initial length of the sphere radius used to search. (The algorithm checks
@@ -1036,10 +1509,14 @@ dvecarr3E projectPoint(std::vector<std::array<double,3> > *P_, BvTree *bvtree_,
 {
 
     int            nP = P_->size();
-    dvector1D     dist(nP);
     dvecarr3E     projPoint(nP);
 
-    for (int i = 0; i < nP; ++i){
+    std::vector<int> order = sortByMortonCode(*P_);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int k = 0; k < nP; ++k){
+        int i = order[k];
         projPoint[i] = projectPoint(&(*P_)[i], bvtree_, r_);
     }
     return projPoint;
@@ -1052,29 +1529,41 @@ dvecarr3E projectPoint(std::vector<std::array<double,3> > *P_, BvTree *bvtree_,
  * \param[in] target Pointer to bv-tree that store the target geometry.
  * \param[in] tol Distance threshold used to select the elements of target.
  * \return Vector of the label of all the elements of the target bv-tree placed
- * at a distance <= tol from the bounding boxes of the leaf nodes of the bv-tree
+ * at a distance <= tol from the bounding boxes of the elements of the bv-tree
  * selection.
+ *
+ * Leaf nodes of the selection can contain more elements: the bounding box of each
+ * element of the selection leaves is used, so that the selected set does not depend
+ * on the maximum leaf size of the selection tree.
  */
 std::vector<long> selectByPatch(BvTree *selection, BvTree *target, double tol){
 
-    int nleafs = selection->m_nleaf;
-    int nnodess = selection->m_nnodes;
-    std::vector<BvNode*> leafSelection(nleafs);
-    int count = 0;
-    for (int i=0; i<nnodess; i++){
-        if (selection->m_nodes[i].m_leaf){
-            if (bitpit::CGElem::intersectBoxBox(selection->m_nodes[i].m_minPoint-tol,
-                    selection->m_nodes[i].m_maxPoint+tol,
-                    target->m_nodes[0].m_minPoint,
-                    target->m_nodes[0].m_maxPoint ) ){
-                leafSelection[count] = &(selection->m_nodes[i]);
-                count++;
-
+    if (selection->m_nnodes == 0 || target->m_nnodes == 0) return std::vector<long>();
+
+    darray3E targetMin = target->m_nodes[0].getMinPoint();
+    darray3E targetMax = target->m_nodes[0].getMaxPoint();
+    std::vector<BvNode> elementSelection;
+    darray3E elMin, elMax;
+    for (int i=0; i<selection->m_nnodes; i++){
+        const BvNode & leaf = selection->m_nodes[i];
+        if (!leaf.isLeaf()) continue;
+        if (!bitpit::CGElem::intersectBoxBox(leaf.getMinPoint()-tol, leaf.getMaxPoint()+tol, targetMin, targetMax)) continue;
+        for (int iel=leaf.m_element[0]; iel<leaf.m_element[1]; iel++){
+            selection->getElementBoundingBox(iel, elMin, elMax);
+            if (bitpit::CGElem::intersectBoxBox(elMin-tol, elMax+tol, targetMin, targetMax)){
+                BvNode box;
+                box.setBoundingBox(elMin, elMax);
+                box.m_element[0] = iel;
+                box.m_element[1] = iel+1;
+                elementSelection.push_back(box);
             }
         }
     }
-    leafSelection.resize(count);
 
+    std::vector<BvNode*> leafSelection(elementSelection.size());
+    for (std::size_t i=0; i<elementSelection.size(); i++){
+        leafSelection[i] = &elementSelection[i];
+    }
 
     std::vector<long> extracted;
     extractTarget(target, leafSelection, extracted, tol);
@@ -1089,11 +1578,11 @@ std::vector<long> selectByPatch(BvTree *selection, BvTree *target, double tol){
  * by a distance criterion in respect to an other geometry stored
  * in a different bv-tree. It is a recursive method used in selectByPatch method.
  * \param[in] target Pointer to bv-tree that store the target geometry.
- * \param[in,out] leafSelection Vector of pointers to the leaf nodes currently interesting
- * for the selection procedure.
+ * \param[in,out] leafSelection Vector of pointers to the nodes (leaf nodes or single elements 
+ * boxes) currently interesting for the selection procedure.
  * \param[in,out] extracted of the label of all the elements of the target bv-tree,
  * currently found placed at a distance <= tol from the bounding boxes of the
- * leaf nodes in leafSelection.
+ * nodes in leafSelection.
  * \param[in] tol Distance threshold used to select the elements of target.
  * \param[in] next Index of the node of the bv-tree target to be checked. If
  * the next-th node is not a leaf node the method is recursively called.
@@ -1107,11 +1596,13 @@ void extractTarget(BvTree *target, std::vector<BvNode*> leafSelection, std::vect
 
     bool check = false;
     std::vector<BvNode*> tocheck;
+    darray3E nodeMin = target->m_nodes[next].getMinPoint();
+    darray3E nodeMax = target->m_nodes[next].getMaxPoint();
     for (int i=0; i<(int)leafSelection.size(); i++){
-        if (bitpit::CGElem::intersectBoxBox(leafSelection[i]->m_minPoint-tol,
-                leafSelection[i]->m_maxPoint+tol,
-                target->m_nodes[next].m_minPoint,
-                target->m_nodes[next].m_maxPoint ) ){
+        if (bitpit::CGElem::intersectBoxBox(leafSelection[i]->getMinPoint()-tol,
+                leafSelection[i]->getMaxPoint()+tol,
+                nodeMin,
+                nodeMax ) ){
             check = true;
             tocheck.push_back(leafSelection[i]);
         }
@@ -1122,13 +1613,22 @@ void extractTarget(BvTree *target, std::vector<BvNode*> leafSelection, std::vect
 
     int nextl, nextr;
     if (check){
-        if (target->m_nodes[next].m_leaf){
-            for (int ie=0; ie<target->m_nodes[next].m_nrange; ie++){
-                extracted.push_back(target->m_elements[target->m_nodes[next].m_element[0]+ie].m_label);
+        if (target->m_nodes[next].isLeaf()){
+            //leaf nodes can contain more elements: check each element bounding box
+            darray3E elMin, elMax;
+            for (int ie=0; ie<target->m_nodes[next].getNRange(); ie++){
+                int iel = target->m_nodes[next].m_element[0]+ie;
+                target->getElementBoundingBox(iel, elMin, elMax);
+                for (BvNode * leaf : leafSelection){
+                    if (bitpit::CGElem::intersectBoxBox(leaf->getMinPoint()-tol, leaf->getMaxPoint()+tol, elMin, elMax)){
+                        extracted.push_back(target->m_elements[iel].m_label);
+                        break;
+                    }
+                }
             }
         }
         else{
-        nextl = target->m_nodes[next].m_lchild;
+        nextl = next + 1;
         extractTarget(target, leafSelection, extracted, tol, nextl);
         nextr = target->m_nodes[next].m_rchild;
         extractTarget(target, leafSelection, extracted, tol, nextr);
@@ -26,7 +26,12 @@
 
 # include "bitpit_patchkernel.hpp"
 # include "bitpit_surfunstructured.hpp"
+# include <iostream>
 
+/*!
+ * Number of elements of a leaf node processed together by the distance kernels of bvTreeUtils.
+ */
+#define MIMMO_BVTREE_BLOCKSIZE 8
 
 namespace mimmo{
 
@@ -56,19 +61,18 @@ public:
  * \ingroup core
  * \brief Bv-Node is the class of a node of a Bv-Tree.
  *
+ * Nodes are stored in depth-first order, so that the left child of an internal
+ * node is always the node immediately following it and the elements of a node
+ * are contiguous. The bounding box is stored in single precision, rounded outward,
+ * to keep the node compact.
+ *
  */
 class BvNode {
 public:
-    std::array<double,3>    m_minPoint;    /**<Minimum coordinates of the bounding box of the node. */
-    std::array<double,3>    m_maxPoint;    /**<Maximum coordinates of the bounding box of the node. */
-    std::array<int,2>         m_element;    /**<Range index of elements of the node. */
-    int                         m_nrange;    /**<Number of elements in the bounding box of the node. */
-    int                        m_lchild;    /**<Index of left child. */
-    int                        m_rchild;    /**<Index of right child. */
-    bool                    m_leaf;        /**<True if the node is a leaf node. */
-
-private:
-    const double m_MAXLIMIT = std::numeric_limits<double>::max(); /**<Constant number used as infite.*/
+    std::array<float,3>     m_minPoint;    /**<Minimum coordinates of the bounding box of the node. */
+    std::array<float,3>     m_maxPoint;    /**<Maximum coordinates of the bounding box of the node. */
+    std::array<int,2>       m_element;     /**<Range index of elements of the node. */
+    int                     m_rchild;      /**<Index of right child, -1 for leaf nodes. The left child is the following node. */
 
 public:
     BvNode();
@@ -78,6 +82,19 @@ public:
      */
     BvNode(const BvNode & other) = default;
     BvNode & operator=(const BvNode & other);
+
+    /*!
+     * \return true if the node is a leaf node.
+     */
+    inline bool isLeaf() const { return (m_rchild < 0); };
+    /*!
+     * \return number of elements in the bounding box of the node.
+     */
+    inline int getNRange() const { return (m_element[1] - m_element[0]); };
+
+    void setBoundingBox(const std::array<double,3> & pmin, const std::array<double,3> & pmax);
+    std::array<double,3> getMinPoint() const;
+    std::array<double,3> getMaxPoint() const;
 };
 
 /*!
@@ -89,15 +106,26 @@ public:
  * A node has two possible child given by splitting in two sub-volume its bounding box.
  * The bounding box of each node is computed as the bounding volume of all the simplex
  * (elements) of the geometry contained in the box.
- * In order to split the box the average of the centroids of the elements
- * is computede and then the volume is divided by using the plane normal to
- * the direction of maximum span of the centroids.
- * Each node has the information about many elements are contained in its
- * bounding volume and the first and last index of them as stored in the structure
- * elements. The elements are ordered in function of the coordinates of their
- * centroid during the construction of the tree.
- * The leaf nodes can be have a number of elements in their bounding volume
- * greater then one.
+ * The split of a node is chosen by a binned Surface Area Heuristic (SAH): the centroids
+ * of the elements are binned along each direction and the partition minimizing the
+ * expected cost of a query (area of the children boxes weighted by their number of
+ * elements) is retained. A node is not split if its elements are less than the maximum
+ * leaf size and the split is not convenient, so leaf nodes can contain more than one element.
+ * Each leaf node has the information about how many elements are contained in its
+ * bounding volume and the index of the first of them as stored in the structure
+ * elements. The elements are ordered during the construction of the tree, so that the elements
+ * of each node are contiguous.
+ * The nodes are stored in depth-first order: the left child of a node is the node following it,
+ * while the index of the right child is stored in the node.
+ * When mimmo is compiled with OpenMP support, the elements bounding boxes are computed in parallel
+ * and the upper levels of the tree are built concurrently.
+ * Alongside the tree, the vertex coordinates of the elements are packed in the order of the tree,
+ * so that the coordinates of the elements of a leaf node are contiguous in memory and can be
+ * accessed by the distance queries without visiting the patch.
+ * If only the coordinates of the vertices of the patch are modified, the tree can be refitted
+ * (see refitTree) instead of rebuilt: the structure of the tree is preserved and the bounding boxes
+ * of the nodes are recomputed bottom-up. The quality of the refitted tree is measured by its SAH cost,
+ * compared to the cost of the tree at the time of its construction.
  *
  */
 class BvTree {
@@ -108,14 +136,17 @@ public:
     std::vector<BvElement>        m_elements;        /**< Bv-tree elements structure. */
     int                            m_nnodes;        /**< Number of nodes in the tree. */
     std::vector<BvNode>            m_nodes;        /**< Bv-tree nodes structure. */
-    int                         m_maxstk;        /**< Max stack size. */
+    std::vector<double>            m_coords;        /**< Vertex coordinates of the elements (x,y,z of each vertex), packed in the order of m_elements. */
+    std::vector<int>               m_coordsPtr;     /**< Index of the first vertex of each element in m_coords (size m_nelements+1). */
+    int                            m_nVertexElement;/**< Number of vertices of the elements if common to all of them, -1 otherwise. */
 
     int                            m_nleaf;        /**<Number of leaf nodes in the bv-tree. */
     int                            m_maxsize;        /**<Maximum number of elements for leaf nodes. */
 
 private:
     double                         m_tol;            /**<Internal tolerance.*/
-    const double m_MAXLIMIT = std::numeric_limits<double>::max(); /**<Constant number used as infite.*/
+    double                         m_buildCost;      /**<SAH cost of the tree at the time of its construction.*/
+    double                         m_refitTol;       /**<Maximum ratio between the SAH cost of a refitted tree and its build cost.*/
 
 public:
     BvTree(bitpit::PatchKernel *patch_ = NULL);
@@ -130,20 +161,31 @@ public:
     void setMaxLeafSize(int maxsize);
     bool inBoundingBox(std::array<double,3> *P_, BvNode *nod_, double r = 0.0);
     bool SphereBoundingBox(std::array<double,3> *P_, BvNode *nod_, double r = 0.0);
+    void getElementBoundingBox(int i, std::array<double,3> & pmin, std::array<double,3> & pmax);
+    /*!
+     * \param[in] i Index of the target element in the m_elements structure.
+     * \return pointer to the packed vertex coordinates of the element.
+     */
+    inline const double * getElementCoords(int i) const { return (m_coords.data() + 3*m_coordsPtr[i]); };
+    /*!
+     * \param[in] i Index of the target element in the m_elements structure.
+     * \return number of vertices of the element.
+     */
+    inline int getElementVertexCount(int i) const { return (m_coordsPtr[i+1] - m_coordsPtr[i]); };
 
     void clean();
     void setup();
     void buildTree();
+    bool refitTree();
+    double evalCost();
+    void setRefitTolerance(double tol);
+    double getRefitTolerance();
 
+    void dump(std::ostream & out) const;
+    bool restore(std::istream & in);
 
 private:
-    void fillTree(int iparent);
-    std::array<double,3> computeMeanPoint(int istart, int iend);
-    int findFirstGreater(int inode, std::array<double,3> meanC, int dir);
-    int pseudoSort(std::vector<BvElement>::iterator itstart, std::vector<BvElement>::iterator itend, std::array<double,3> meanC, int dir);
-    void computeBoundingBox(int inode);
-    void increaseStack();
-    void decreaseStack();
+    void fillCoords();
 
 };
 
@@ -0,0 +1,239 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include "CSRMatrix.hpp"
+#include <algorithm>
+
+namespace mimmo{
+
+/*!
+ * Default constructor of CSRMatrix. It builds an empty 0x0 matrix.
+ */
+CSRMatrix::CSRMatrix(){
+    initialize(0,0);
+};
+
+/*!
+ * Custom constructor of CSRMatrix. It builds a nrows x ncols matrix with no nonzero entries.
+ * \param[in] nrows number of rows
+ * \param[in] ncols number of columns
+ */
+CSRMatrix::CSRMatrix(long nrows, long ncols){
+    initialize(nrows, ncols);
+};
+
+/*!
+ * Default destructor of CSRMatrix.
+ */
+CSRMatrix::~CSRMatrix(){};
+
+/*!
+ * Copy constructor of CSRMatrix.
+ * \param[in] other CSRMatrix where copy from
+ */
+CSRMatrix::CSRMatrix(const CSRMatrix & other){
+    *this = other;
+};
+
+/*!
+ * Copy operator of CSRMatrix.
+ * \param[in] other CSRMatrix where copy from
+ */
+CSRMatrix & CSRMatrix::operator=(const CSRMatrix & other){
+    m_nrows = other.m_nrows;
+    m_ncols = other.m_ncols;
+    m_rowPtr = other.m_rowPtr;
+    m_colIndex = other.m_colIndex;
+    m_values = other.m_values;
+    return(*this);
+};
+
+/*!
+ * Clear the matrix, resetting it to an empty 0x0 matrix.
+ */
+void
+CSRMatrix::clear(){
+    initialize(0,0);
+};
+
+/*!
+ * Set the dimensions of the matrix, erasing all its nonzero entries.
+ * \param[in] nrows number of rows
+ * \param[in] ncols number of columns
+ */
+void
+CSRMatrix::initialize(long nrows, long ncols){
+    m_nrows = std::max(long(0), nrows);
+    m_ncols = std::max(long(0), ncols);
+    m_rowPtr.assign(m_nrows+1, 0);
+    livector1D().swap(m_colIndex);
+    dvector1D().swap(m_values);
+};
+
+/*!
+ * \return number of rows of the matrix
+ */
+long
+CSRMatrix::getNRows() const{
+    return(m_nrows);
+};
+
+/*!
+ * \return number of columns of the matrix
+ */
+long
+CSRMatrix::getNCols() const{
+    return(m_ncols);
+};
+
+/*!
+ * \return number of nonzero entries of the matrix
+ */
+long
+CSRMatrix::getNNZ() const{
+    return(long(m_values.size()));
+};
+
+/*!
+ * \return true if the matrix has no rows or no columns
+ */
+bool
+CSRMatrix::isEmpty() const{
+    return(m_nrows == 0 || m_ncols == 0);
+};
+
+/*!
+ * Matrix-vector product y = A*x. 
+ * The rows are split among the available threads (if OpenMP support is enabled).
+ * \param[in] x vector of size equal to the number of columns
+ * \return vector of size equal to the number of rows, empty if x size is not coherent.
+ */
+dvector1D
+CSRMatrix::multiply(const dvector1D & x) const{
+
+    if(long(x.size()) != m_ncols) return dvector1D(0);
+
+    dvector1D y(m_nrows, 0.0);
+    multiply(x, y);
+    return(y);
+};
+
+/*!
+ * Matrix-vector product y = A*x, written into a vector provided by the caller, 
+ * e.g. to reuse the same storage across the iterations of a solver.
+ * The rows are split among the available threads (if OpenMP support is enabled).
+ * \param[in] x vector of size equal to the number of columns
+ * \param[out] y vector resized to the number of rows, untouched if x size is not coherent.
+ */
+void
+CSRMatrix::multiply(const dvector1D & x, dvector1D & y) const{
+
+    if(long(x.size()) != m_ncols) return;
+
+    y.resize(m_nrows);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for(long i=0; i<m_nrows; ++i){
+        double val = 0.0;
+        for(long j=m_rowPtr[i]; j<m_rowPtr[i+1]; ++j){
+            val += m_values[j]*x[m_colIndex[j]];
+        }
+        y[i] = val;
+    }
+};
+
+/*!
+ * Matrix-vector product y = A*x, applied component-wise to a field of 3D vectors. 
+ * The rows are split among the available threads (if OpenMP support is enabled).
+ * \param[in] x vector field of size equal to the number of columns
+ * \return vector field of size equal to the number of rows, empty if x size is not coherent.
+ */
+dvecarr3E
+CSRMatrix::multiply(const dvecarr3E & x) const{
+
+    if(long(x.size()) != m_ncols) return dvecarr3E(0);
+
+    dvecarr3E y(m_nrows);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for(long i=0; i<m_nrows; ++i){
+        darray3E val = {{0.0, 0.0, 0.0}};
+        for(long j=m_rowPtr[i]; j<m_rowPtr[i+1]; ++j){
+            const darray3E & xj = x[m_colIndex[j]];
+            for(int k=0; k<3; ++k){
+                val[k] += m_values[j]*xj[k];
+            }
+        }
+        y[i] = val;
+    }
+    return(y);
+};
+
+/*!
+ * Transposed matrix-vector product x = A^T*y, e.g. to project sensitivities 
+ * of vertex displacements onto the design variables.
+ * \param[in] y vector of size equal to the number of rows
+ * \return vector of size equal to the number of columns, empty if y size is not coherent.
+ */
+dvector1D
+CSRMatrix::multiplyTransposed(const dvector1D & y) const{
+
+    if(long(y.size()) != m_nrows) return dvector1D(0);
+
+    dvector1D x(m_ncols, 0.0);
+    for(long i=0; i<m_nrows; ++i){
+        for(long j=m_rowPtr[i]; j<m_rowPtr[i+1]; ++j){
+            x[m_colIndex[j]] += m_values[j]*y[i];
+        }
+    }
+    return(x);
+};
+
+/*!
+ * Transposed matrix-vector product x = A^T*y, applied component-wise to a field of 3D vectors,
+ * e.g. to project sensitivities of vertex displacements onto the design variables.
+ * \param[in] y vector field of size equal to the number of rows
+ * \return vector field of size equal to the number of columns, empty if y size is not coherent.
+ */
+dvecarr3E
+CSRMatrix::multiplyTransposed(const dvecarr3E & y) const{
+
+    if(long(y.size()) != m_nrows) return dvecarr3E(0);
+
+    dvecarr3E x(m_ncols, darray3E{{0.0, 0.0, 0.0}});
+    for(long i=0; i<m_nrows; ++i){
+        const darray3E & yi = y[i];
+        for(long j=m_rowPtr[i]; j<m_rowPtr[i+1]; ++j){
+            darray3E & xj = x[m_colIndex[j]];
+            for(int k=0; k<3; ++k){
+                xj[k] += m_values[j]*yi[k];
+            }
+        }
+    }
+    return(x);
+};
+
+}
@@ -0,0 +1,77 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#ifndef __CSRMATRIX_HPP__
+#define __CSRMATRIX_HPP__
+
+#include "bitpit_common.hpp"
+#include "mimmoTypeDef.hpp"
+
+namespace mimmo{
+
+/*!
+ * \class CSRMatrix
+ * \ingroup core
+ * \brief CSRMatrix is a minimal sparse matrix stored in Compressed Sparse Row format.
+ *
+ * It is meant to export linear operators of the deformation blocks, e.g. the map from control
+ * point displacements to geometry vertex displacements of FFDLattice and MRBF. 
+ * Nonzero entries of the i-th row are stored in m_colIndex and m_values, in the positions
+ * ranging from m_rowPtr[i] to m_rowPtr[i+1] (excluded). 
+ * Vector fields of 3D displacements are multiplied component-wise, i.e. the same scalar
+ * matrix acts on each of the three components.
+ */
+class CSRMatrix{
+public:
+    long            m_nrows;    /**< Number of rows.*/
+    long            m_ncols;    /**< Number of columns.*/
+    livector1D      m_rowPtr;   /**< Index of the first nonzero entry of each row, m_nrows+1 sized.*/
+    livector1D      m_colIndex; /**< Column index of each nonzero entry.*/
+    dvector1D       m_values;   /**< Value of each nonzero entry.*/
+
+public:
+    CSRMatrix();
+    CSRMatrix(long nrows, long ncols);
+    virtual ~CSRMatrix();
+
+    CSRMatrix(const CSRMatrix & other);
+    CSRMatrix & operator=(const CSRMatrix & other);
+
+    void        clear();
+    void        initialize(long nrows, long ncols);
+
+    long        getNRows() const;
+    long        getNCols() const;
+    long        getNNZ() const;
+    bool        isEmpty() const;
+
+    dvector1D   multiply(const dvector1D & x) const;
+    void        multiply(const dvector1D & x, dvector1D & y) const;
+    dvecarr3E   multiply(const dvecarr3E & x) const;
+    dvector1D   multiplyTransposed(const dvector1D & y) const;
+    dvecarr3E   multiplyTransposed(const dvecarr3E & y) const;
+};
+
+}
+
+#endif /* __CSRMATRIX_HPP__ */
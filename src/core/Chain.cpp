@@ -22,6 +22,16 @@
  *
 \*---------------------------------------------------------------------------*/
 #include "Chain.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <unordered_set>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+#if MIMMO_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 
@@ -41,6 +51,7 @@ Chain::Chain(){
     sm_chaincounter++;
     m_plotDebRes = false;
     m_outputDebRes = ".";
+    m_parallel = false;
     m_log = &bitpit::log::cout(MIMMO_LOG_FILE);
 };
 
@@ -70,6 +81,7 @@ Chain & Chain::operator=(const Chain & other){
     m_objcounter   = other.m_objcounter;
     m_plotDebRes   = other.m_plotDebRes;
     m_outputDebRes = other.m_outputDebRes;
+    m_parallel     = other.m_parallel;
     m_log = &bitpit::log::cout(MIMMO_LOG_FILE);
     return (*this);
 };
@@ -263,6 +275,23 @@ std::string Chain::getOutputDebugResults(){
     return m_outputDebRes;
 }
 
+/*!
+ * Activate parallel execution of the chain. Objects without mutual dependencies
+ * are executed concurrently on the available threads. Meaningful only if mimmo
+ * is compiled with OpenMP support, otherwise the chain is always executed serially.
+ * \param[in] parallel true/false to activate parallel execution
+ */
+void Chain::setParallel(bool parallel){
+    m_parallel = parallel;
+}
+
+/*!
+ * \return true if parallel execution of the chain is active.
+ */
+bool Chain::isParallel(){
+    return m_parallel;
+}
+
 
 /*!
  * It executes the chain, i.e. it executes all the manipulator objects
@@ -289,6 +318,20 @@ Chain::exec(bool debug){
     }
     (*m_log) << " " << std::endl;
     checkLoops();
+#if MIMMO_ENABLE_OPENMP
+    if (m_parallel && m_objects.size() > 1){
+        execParallel();
+        logMemoryUsage();
+        (*m_log) << " " << std::endl;
+        (*m_log) << "--------------------------------------------------" << std::endl;
+        (*m_log) << " " << std::endl;
+        m_log->setPriority(bitpit::log::DEBUG);
+        return;
+    }
+#endif
+    ivector2D geometries = resolveGeometries();
+    ivector2D lastConsumer = findLastConsumers(geometries);
+    int nreleased = 0;
     int i = 1;
     for (it = itb; it != itend; ++it){
         (*m_log) << " execution object " << i << "	: " << (*it)->getName() << std::endl;
@@ -296,9 +339,15 @@ Chain::exec(bool debug){
             (*it)->setPlotInExecution(m_plotDebRes);
             (*it)->setOutputPlot(m_outputDebRes);
         }    
+        prepareStructures(*it, geometries[i-1]);
         (*it)->exec();
+        nreleased += releaseCompactGeometries(lastConsumer[i-1]);
         i++;
     }
+    if (nreleased > 0){
+        (*m_log) << " released index maps of " << nreleased << " compact geometries" << std::endl;
+    }
+    logMemoryUsage();
 
     (*m_log) << " " << std::endl;
     (*m_log) << "--------------------------------------------------" << std::endl;
@@ -316,6 +365,299 @@ Chain::exec(int idobj){
     if (idx <  (int)m_objects.size()) m_objects[idx]->exec();
 }
 
+/*!
+ * It executes the chain in parallel. The dependency graph of the objects is built
+ * from their parent/child connections; objects working on the same geometry (see resolveGeometries),
+ * linked to them or received through any of their input ports, are executed in the order of
+ * the chain, since they may modify the geometry or build its on-demand structures and index maps.
+ * The index maps of a geometry in compact mode are released as soon as the last object working
+ * on it is executed (see findLastConsumers).
+ * The index maps of the geometries of an object and the acceleration structures it requires
+ * (see prepareStructures) are built by a separate task of the graph, launched as soon as the
+ * previous objects working on the same geometries are executed (or at the start of the chain,
+ * if none), so that the build runs concurrently with the other parents of the object, which
+ * waits for it only at its launch. The index maps are thus not rebuilt lazily while the object
+ * is executed, unless it modifies the geometry.
+ * The threads of an OpenMP team wait on a queue of ready tasks, sorted by priority and by 
+ * position in the chain; once a task is executed, its children whose parents are all 
+ * executed are released. Nested parallelism is enabled: the OpenMP regions inside each task 
+ * run on a share of the available threads, inversely proportional to the number of tasks 
+ * running at its launch. The messages of the objects are written by each thread in its own 
+ * log (MIMMO_LOG_FILE followed by _thread and the thread number), to avoid interleaving.
+ * The execution summary is printed in the order of the chain, independently
+ * from the actual scheduling of the objects.
+ * If an object throws an error, no further objects are launched and the error
+ * is rethrown at the end of the execution.
+ */
+void
+Chain::execParallel(){
+
+    int nobj = m_objects.size();
+    std::unordered_map<BaseManipulation*, int> index;
+    for (int i=0; i<nobj; i++){
+        index[m_objects[i]] = i;
+    }
+
+    //build dependency graph. Task 2*i prepares the geometries of the object i,
+    //task 2*i+1 executes it.
+    ivector2D geometries = resolveGeometries();
+    ivector2D lastConsumer = findLastConsumers(geometries);
+    std::unordered_map<int, int> lastOnGeometry;
+    int ntasks = 2*nobj;
+    std::vector<bool> active(ntasks, true);
+    std::vector<std::set<int> > children(ntasks);
+    for (int i=0; i<nobj; i++){
+        int buildTask = 2*i;
+        int execTask = 2*i+1;
+        for (int j=0; j<m_objects[i]->getNChild(); j++){
+            auto itchild = index.find(m_objects[i]->getChild(j));
+            if (itchild != index.end()) children[execTask].insert(2*itchild->second+1);
+        }
+        active[buildTask] = (!geometries[i].empty() && m_objects[i]->isActive());
+        if (active[buildTask])  children[buildTask].insert(execTask);
+        for (int geo : geometries[i]){
+            auto itlast = lastOnGeometry.find(geo);
+            if (itlast != lastOnGeometry.end()){
+                children[2*itlast->second+1].insert(execTask);
+                if (active[buildTask])  children[2*itlast->second+1].insert(buildTask);
+            }
+            lastOnGeometry[geo] = i;
+        }
+    }
+    ivector1D nparents(ntasks, 0);
+    int nactive = 0;
+    for (int k=0; k<ntasks; k++){
+        if (!active[k]) continue;
+        nactive++;
+        for (int child : children[k])   nparents[child]++;
+    }
+
+    //ready queue sorted by priority and position in the chain
+    std::set<std::pair<uint, int> > ready;
+    for (int i=0; i<nobj; i++){
+        if(m_plotDebRes){
+            m_objects[i]->setPlotInExecution(m_plotDebRes);
+            m_objects[i]->setOutputPlot(m_outputDebRes);
+        }
+    }
+    for (int k=0; k<ntasks; k++){
+        if (active[k] && nparents[k] == 0)  ready.insert(std::make_pair(m_objects[k/2]->getPriority(), k));
+    }
+
+    int nthreads = 1;
+#if MIMMO_ENABLE_OPENMP
+    nthreads = omp_get_max_threads();
+    int maxLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(std::max(2, maxLevels));
+#endif
+
+    //thread loggers, created before launching the threads
+    std::vector<bitpit::Logger*> logs(nthreads);
+    for (int k=0; k<nthreads; k++){
+        logs[k] = &bitpit::log::cout(MIMMO_LOG_FILE + "_thread" + std::to_string(k));
+        bitpit::log::setConsoleVerbosity((*logs[k]), bitpit::log::QUIET);
+        bitpit::log::setFileVerbosity((*logs[k]), bitpit::log::DEBUG);
+    }
+
+    int ndone = 0;
+    int nrunning = 0;
+    int nreleased = 0;
+    bool failed = false;
+    std::string error;
+    ivector1D thread(nobj, -1);
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+    {
+        int tid = 0;
+#if MIMMO_ENABLE_OPENMP
+        tid = omp_get_thread_num();
+#endif
+        while (true){
+            int current = -1;
+            int share = 1;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [&](){ return (ndone == nactive || failed || !ready.empty()); });
+                if (ndone == nactive || failed)    break;
+                current = ready.begin()->second;
+                ready.erase(ready.begin());
+                nrunning++;
+                share = std::max(1, nthreads/nrunning);
+            }
+#if MIMMO_ENABLE_OPENMP
+            omp_set_num_threads(share);
+#else
+            BITPIT_UNUSED(share);
+#endif
+
+            BaseManipulation * obj = m_objects[current/2];
+            bool isBuild = (current%2 == 0);
+            bitpit::Logger * objlog = obj->m_log;
+            obj->m_log = logs[tid];
+            bool success = true;
+            std::string message;
+            int released = 0;
+            try{
+                if (isBuild){
+                    prepareStructures(obj, geometries[current/2]);
+                }else{
+                    //objects with unresolved geometry build their structures at launch
+                    if (!active[current-1])    prepareStructures(obj, geometries[current/2]);
+                    obj->exec();
+                    released = releaseCompactGeometries(lastConsumer[current/2]);
+                }
+            }catch(std::exception & e){
+                success = false;
+                message = e.what();
+            }
+            obj->m_log = objlog;
+
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (!success && !failed){
+                    failed = true;
+                    error = message;
+                }
+                if (!isBuild)   thread[current/2] = tid;
+                nreleased += released;
+                nrunning--;
+                ndone++;
+                for (int child : children[current]){
+                    if (!active[child]) continue;
+                    nparents[child]--;
+                    if (nparents[child] == 0)   ready.insert(std::make_pair(m_objects[child/2]->getPriority(), child));
+                }
+            }
+            queueCondition.notify_all();
+        }
+    }
+
+#if MIMMO_ENABLE_OPENMP
+    omp_set_max_active_levels(maxLevels);
+#endif
+
+    for (int i=0; i<nobj; i++){
+        if (thread[i] < 0) continue;
+        (*m_log) << " execution object " << i+1 << "	: " << m_objects[i]->getName() << " (thread " << thread[i] << ")" << std::endl;
+    }
+    if (nreleased > 0){
+        (*m_log) << " released index maps of " << nreleased << " compact geometries" << std::endl;
+    }
+
+    if (failed){
+        (*m_log) << " error : parallel execution of chain stopped : " << error << std::endl;
+        throw std::runtime_error (error);
+    }
+}
+
+/*!
+ * It checks if the data communicated through a port carry pointers to geometries.
+ * \param[in] type data type of the port
+ * \return true for MimmoObject pointers, alone or paired with fields or other data.
+ */
+static bool
+carriesGeometry(DataType type){
+    switch (type.m_dataType){
+    case dataTAG::MIMMO_:
+    case dataTAG::MIMMO_VECFLOAT_:
+    case dataTAG::MIMMO_VECARR3FLOAT_:
+    case dataTAG::STRINGPAIRINTMIMMO_:
+    case dataTAG::PAIRMIMMO_VECFLOAT_:
+    case dataTAG::PAIRMIMMO_VECARR3FLOAT_:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*!
+ * It resolves the geometries each object of the chain works on, identified by the first
+ * object of the chain providing them. An object provides the geometry linked to it, if any;
+ * otherwise, for objects receiving it in execution through a M_GEOM input port, the geometry is
+ * the one of the first parent linked to that port. Objects without a geometry but with an
+ * output port carrying geometries (e.g. readers) provide the geometries they create in execution.
+ * Each object works on the geometry it provides and on the geometries provided by the parents
+ * linked to any of its input ports carrying geometries (M_GEOM, M_GEOM2, geometry-field pairs,...).
+ * Since the geometries are identified by their providers, objects are grouped correctly even if
+ * the geometries are created or replaced during the execution of the chain.
+ * Objects are visited in the order of the chain, so that parents are resolved before their children.
+ * \return indices of the objects providing the geometries of each object of the chain, sorted; 
+ * the first object working on a geometry is not necessarily its provider.
+ */
+ivector2D
+Chain::resolveGeometries(){
+
+    int nobj = m_objects.size();
+    std::unordered_map<BaseManipulation*, int> index;
+    for (int i=0; i<nobj; i++){
+        index[m_objects[i]] = i;
+    }
+
+    ivector1D provided(nobj, -1);
+    ivector2D geometries(nobj);
+    std::unordered_map<MimmoObject*, int> provider;
+    for (int i=0; i<nobj; i++){
+        std::map<BaseManipulation::PortID, PortIn*> ports = m_objects[i]->getPortsIn();
+        MimmoObject * geo = m_objects[i]->getGeometry();
+        if (geo != NULL){
+            provided[i] = provider.insert(std::make_pair(geo, i)).first->second;
+        }else{
+            auto itport = ports.find(PortType::M_GEOM);
+            if (itport != ports.end()){
+                for (BaseManipulation* sender : itport->second->getLink()){
+                    auto itsender = index.find(sender);
+                    if (itsender != index.end() && provided[itsender->second] >= 0){
+                        provided[i] = provided[itsender->second];
+                        break;
+                    }
+                }
+            }
+        }
+        if (provided[i] < 0){
+            for (auto & port : m_objects[i]->m_portOut){
+                if (carriesGeometry(port.second->getDataType())){
+                    provided[i] = i;
+                    break;
+                }
+            }
+        }
+
+        std::set<int> used;
+        if (provided[i] >= 0)   used.insert(provided[i]);
+        for (auto & port : ports){
+            if (!carriesGeometry(port.second->getDataType()))   continue;
+            for (BaseManipulation* sender : port.second->getLink()){
+                auto itsender = index.find(sender);
+                if (itsender != index.end() && provided[itsender->second] >= 0)    used.insert(provided[itsender->second]);
+            }
+        }
+        geometries[i].assign(used.begin(), used.end());
+    }
+    return geometries;
+}
+
+/*!
+ * It finds the last object of the chain working on each geometry.
+ * \param[in] geometries indices of the objects providing the geometries of each object of the chain (see resolveGeometries).
+ * \return for each object, the indices of the providers of the geometries it is executed last on.
+ */
+ivector2D
+Chain::findLastConsumers(const ivector2D & geometries){
+    int nobj = geometries.size();
+    ivector2D last(nobj);
+    std::unordered_set<int> visited;
+    for (int i=nobj-1; i>=0; i--){
+        for (int geo : geometries[i]){
+            if (visited.insert(geo).second)    last[i].push_back(geo);
+        }
+    }
+    return last;
+}
+
 /*!
  * It checks if a loop exists in the chain.
  * In the case that a loop exists the process ends with an error.
@@ -338,5 +680,63 @@ Chain::checkLoops(){
     }
 }
 
+/*!
+ * It prepares the geometries an object works on for its execution: their index maps are
+ * synchronized (see MimmoObject::syncIndexMaps), so that they are not rebuilt lazily during
+ * the execution, and the acceleration structures of the geometry linked to the object,
+ * declared as needed by the object (see BaseManipulation::requireStructure), are built.
+ * Structures already built and synchronized with the geometry are not built again.
+ * \param[in] obj pointer to the object to be executed.
+ * \param[in] geometries indices of the objects providing the geometries of the object (see resolveGeometries).
+ */
+void
+Chain::prepareStructures(BaseManipulation* obj, const ivector1D & geometries){
+    if (!obj->isActive())  return;
+    for (int provider : geometries){
+        MimmoObject * geo = m_objects[provider]->getGeometry();
+        if (geo != NULL)    geo->syncIndexMaps();
+    }
+    MimmoObject * geo = obj->getGeometry();
+    if (geo == NULL)    return;
+    geo->syncIndexMaps();
+    geo->buildStructures(obj->getRequiredStructures());
+}
+
+/*!
+ * It releases the index maps of a list of geometries, if they are in compact mode 
+ * (see MimmoObject::releaseIndexMaps). It is called once the last object of the chain working
+ * on the geometries is executed; the maps are rebuilt on demand if needed by any further execution.
+ * \param[in] geometries indices of the objects providing the geometries (see findLastConsumers).
+ * \return number of geometries whose index maps have been released.
+ */
+int
+Chain::releaseCompactGeometries(const ivector1D & geometries){
+    int released = 0;
+    for (int provider : geometries){
+        MimmoObject * geo = m_objects[provider]->getGeometry();
+        if (geo == NULL || !geo->isCompact())   continue;
+        geo->releaseIndexMaps();
+        released++;
+    }
+    return released;
+}
+
+/*!
+ * It reports in the log the peak resident set size of the process, if available on the current platform.
+ */
+void
+Chain::logMemoryUsage(){
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)   return;
+#if defined(__APPLE__)
+    double peakMB = double(usage.ru_maxrss) / (1024.0*1024.0);
+#else
+    double peakMB = double(usage.ru_maxrss) / 1024.0;
+#endif
+    (*m_log) << " peak memory usage (RSS) : " << peakMB << " MB" << std::endl;
+#endif
+}
+
 }
 
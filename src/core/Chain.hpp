@@ -44,6 +44,23 @@ namespace mimmo{
  * conflicts in parent/child dependencies.
  * Closed connections loops in the chain are not allowed.
  *
+ * When mimmo is compiled with OpenMP support, the chain can be executed in parallel
+ * mode (see setParallel). The dependency graph of the chain is built from the parent/child
+ * connections of its objects and every object is launched as soon as all its parents
+ * have been executed, so that independent branches of the workflow run concurrently.
+ * Among the objects ready for execution, the ones with lower priority value (higher priority)
+ * are launched first. Objects working on a common geometry are executed in the same order 
+ * of the serial execution. Serial execution is the default.
+ *
+ * Before the execution of each object, the acceleration structures it needs on its geometry
+ * (see BaseManipulation::requireStructure) are built, if not already available; in parallel mode
+ * they are built by a separate task, started as soon as the geometry is available and
+ * concurrently with the other parents of the object, which waits for it only at its launch.
+ * The index maps of the geometries in compact mode (see MimmoObject::setCompact) are released
+ * as soon as the last object of the chain working on them is executed, since no other object
+ * of the chain needs them anymore. At the end of the execution the peak memory usage
+ * of the process is reported in the log.
+ *
  */
 class Chain{
 protected:
@@ -57,6 +74,7 @@ protected:
 
     bool                            m_plotDebRes;       /**<boolean to activate plotting of debug intermediate results */
     std::string                     m_outputDebRes;     /**<directory path to store the debug intermediate results, if plot is enabled*/
+    bool                            m_parallel;         /**<boolean to activate concurrent execution of independent objects */
 	//static members
 	static	uint8_t					sm_chaincounter;	/**<Current global number of chain in the instance. */
 
@@ -84,6 +102,8 @@ public:
     void            setOutputDebugResults(std::string path);
     bool            isPlottingDebugResults();
     std::string     getOutputDebugResults();
+    void            setParallel(bool parallel);
+    bool            isParallel();
     
 	//relationship methods
 	void 		exec(bool debug = false);
@@ -92,6 +112,12 @@ public:
 private:
 	//check methods
 	void		checkLoops();
+	void		execParallel();
+	ivector2D	resolveGeometries();
+	ivector2D	findLastConsumers(const ivector2D & geometries);
+	void		prepareStructures(BaseManipulation* obj, const ivector1D & geometries);
+	int			releaseCompactGeometries(const ivector1D & geometries);
+	void		logMemoryUsage();
 
 };
 
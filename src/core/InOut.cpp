@@ -808,6 +808,35 @@ bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buffer, const std::vect
     return buffer;
 };
 
+/*!
+* Input stream operator for mimmo::CSRMatrix
+* \param[in] buffer is the input stream
+* \param[in] element is the element to be streamed
+* \result Returns the same input stream received in input.
+*/
+bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, mimmo::CSRMatrix& element){
+
+    buffer >> element.m_nrows;
+    buffer >> element.m_ncols;
+    buffer >> element.m_rowPtr;
+    buffer >> element.m_colIndex;
+    buffer >> element.m_values;
+    return buffer;
+};
+
+/*!
+* Output stream operator for mimmo::CSRMatrix
+* \param[in] buffer is the output stream
+* \param[in] element is the element to be streamed
+* \result Returns the same output stream received in input.
+*/
+bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buffer, const mimmo::CSRMatrix& element){
+
+    buffer << element.m_nrows << element.m_ncols;
+    buffer << element.m_rowPtr << element.m_colIndex << element.m_values;
+    return buffer;
+};
+
 //==============================================================//
 // DATA TYPE  CLASS	IMPLEMENTATION								//
 //==============================================================//
@@ -865,6 +894,27 @@ bool DataType::operator==(const DataType & other){
     return(check);
 };
 
+/*!
+ * It gets if the data type is communicated through zero-copy transport between ports,
+ * i.e. if it is a potentially large container (vectors, maps, pairs) or a sparse matrix.
+ * \return true if data are handed to receivers as shared objects instead of serialized.
+ */
+bool DataType::isSharedTransport() const{
+    switch(m_conType){
+    case containerTAG::VECTOR:
+    case containerTAG::VECVEC:
+    case containerTAG::VECARR3:
+    case containerTAG::VECARR2:
+    case containerTAG::VECVECARR2:
+    case containerTAG::MAP:
+    case containerTAG::UN_MAP:
+    case containerTAG::PAIR:
+        return true;
+    default:
+        return (m_dataType == dataTAG::CSRMATRIX);
+    }
+};
+
 
 //==============================================================//
 // BASE INOUT CLASS	IMPLEMENTATION                              //
@@ -875,6 +925,7 @@ bool DataType::operator==(const DataType & other){
  */
 PortOut::PortOut(){
     m_objLink.clear();
+    m_sharedOwned = false;
 };
 
 /*!
@@ -888,6 +939,7 @@ PortOut::~PortOut(){};
 PortOut::PortOut(const PortOut & other){
     m_objLink 	= other.m_objLink;
     m_obuffer	= other.m_obuffer;
+    m_sharedOwned = false;
     m_portLink	= other.m_portLink;
     m_datatype	= other.m_datatype;
     return;
@@ -948,6 +1000,7 @@ PortOut::getDataType(){
 void
 mimmo::PortOut::cleanBuffer(){
     m_obuffer.seekg(0);
+    m_shared.reset();
 }
 
 /*!
@@ -979,6 +1032,32 @@ mimmo::PortOut::clear(int j){
 void
 mimmo::PortOut::exec(){
     if (m_objLink.size() > 0){
+
+        //zero-copy transport, if all receivers get data of the same type of the sender.
+        bool shared = m_datatype.isSharedTransport();
+        std::size_t type = getTypeHash();
+        int last = -1;
+        for (int j=0; j<(int)m_objLink.size(); j++){
+            if (m_objLink[j] != NULL){
+                shared = shared && (m_objLink[j]->getTypeHashIn(m_portLink[j]) == type);
+                last = j;
+            }
+        }
+        if (shared){
+            writeShared();
+            for (int j=0; j<(int)m_objLink.size(); j++){
+                if (m_objLink[j] != NULL){
+                    //the last receiver takes the reference of the port, to move owned data.
+                    if (j == last)  m_objLink[j]->setSharedIn(m_portLink[j], std::move(m_shared), m_sharedOwned);
+                    else            m_objLink[j]->setSharedIn(m_portLink[j], m_shared, m_sharedOwned);
+                    m_objLink[j]->readBufferIn(m_portLink[j]);
+                    m_objLink[j]->cleanBufferIn(m_portLink[j]);
+                }
+            }
+            cleanBuffer();
+            return;
+        }
+
         writeBuffer();
         bitpit::IBinaryStream input(m_obuffer.data(), m_obuffer.getSize());
         cleanBuffer();
@@ -998,6 +1077,7 @@ mimmo::PortOut::exec(){
 PortIn::PortIn(){
     m_mandatory =false;
     m_familym = 0;
+    m_sharedOwned = false;
 };
 
 /*!
@@ -1011,6 +1091,7 @@ PortIn::~PortIn(){};
 PortIn::PortIn(const PortIn & other){
     m_objLink 	= other.m_objLink;
     m_ibuffer	= other.m_ibuffer;
+    m_sharedOwned = false;
     m_datatype  = other.m_datatype;
     m_mandatory = other.m_mandatory;
     m_familym   = other.m_familym;
@@ -1103,6 +1184,7 @@ mimmo::PortIn::clear(int j){
 void
 mimmo::PortIn::cleanBuffer(){
     m_ibuffer.seekg(0);
+    m_shared.reset();
 }
 
 }
@@ -30,7 +30,10 @@
 #include "BasicShapes.hpp"
 #include "MimmoObject.hpp"
 #include "TrackingPointer.hpp"
+#include "CSRMatrix.hpp"
 #include <functional>
+#include <memory>
+#include <typeinfo>
 
 namespace mimmo{
 
@@ -63,6 +66,7 @@ public:
     DataType & operator=(const DataType & other);
     bool operator==(const DataType & other);
 
+    bool isSharedTransport() const;
 };
 
 /*!
@@ -86,6 +90,10 @@ public:
 * will be sent to a list of BaseManipulation objects/receivers. Input ports of receivers are responsible to decode the 
 * data buffer sent, and make available the data to their respective receveir. 
 * 
+* Large containers (see DataType::isSharedTransport) are not serialized: data are handed to receivers
+* as a reference-counted shared object (m_shared), without copies (zero-copy transport). Receivers copy the data 
+* only when they need to own it, and the last receiver moves it, if the data are owned by the port.
+* 
 * The execution of the output PortT will automatically
 * exchange the buffer data, pass it to the input ports connected and makes them reading and decoding the data.
 */
@@ -93,6 +101,8 @@ class PortOut{
 public:
     //members
     bitpit::OBinaryStream           m_obuffer;	/**<Output buffer to communicate data.*/
+    std::shared_ptr<void>           m_shared;	/**<Shared data to communicate in zero-copy transport.*/
+    bool                            m_sharedOwned;	/**<True if shared data are owned by the port, false if they refer to a variable of the sender.*/
     std::vector<BaseManipulation*>  m_objLink;	/**<Outputs object to which communicate the data.*/
     std::vector<PortID>             m_portLink;	/**<ID of the input ports of the linked objects.*/
     DataType                        m_datatype;	/**<TAG of type of data communicated.*/
@@ -113,6 +123,14 @@ public:
      * Pure virtual function to write a buffer.
      */
     virtual void	writeBuffer() = 0;
+    /*!
+     * Pure virtual function to write the shared data of zero-copy transport.
+     */
+    virtual void	writeShared() = 0;
+    /*!
+     * Pure virtual function to get the hash code of the C++ type of the data communicated.
+     */
+    virtual std::size_t	getTypeHash() = 0;
     void 			cleanBuffer();
 
     void clear();
@@ -170,6 +188,8 @@ public:
     bool operator==(const PortOutT & other);
 
     void writeBuffer();
+    void writeShared();
+    std::size_t getTypeHash();
 
 };
 
@@ -200,6 +220,8 @@ class PortIn{
 public:
     //members
     bitpit::IBinaryStream               m_ibuffer;          /**<input buffer to recover data.*/
+    std::shared_ptr<void>               m_shared;           /**<Shared data received in zero-copy transport.*/
+    bool                                m_sharedOwned;      /**<True if shared data can be moved when it is the last reference.*/
     std::vector<BaseManipulation*>      m_objLink;          /**<Input objects from which recover the data. */
     DataType                            m_datatype;         /**<TAG of type of data communicated.*/
     bool                                m_mandatory;        /**<Does the port have to be mandatorily linked?.*/
@@ -227,6 +249,10 @@ public:
      * Pure virtual function to read a buffer.
      */
     virtual void    readBuffer() = 0;
+    /*!
+     * Pure virtual function to get the hash code of the C++ type of the data communicated.
+     */
+    virtual std::size_t getTypeHash() = 0;
     void            cleanBuffer();
 
 };
@@ -281,6 +307,7 @@ public:
     bool operator==(const PortInT & other);
 
     void readBuffer();
+    std::size_t getTypeHash();
 
 };
 
@@ -360,6 +387,9 @@ bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buf, const std::vector<
 bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buf, std::vector< std::pair<mimmo::MimmoObject*, dvecarr3E *> >& element);
 bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buf, const std::vector< std::pair<mimmo::MimmoObject*, dvecarr3E *> >& element);
 
+bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buf, mimmo::CSRMatrix& element);
+bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream &buf, const mimmo::CSRMatrix& element);
+
 /*!
  *\}
  */
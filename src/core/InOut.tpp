@@ -148,6 +148,38 @@ PortOutT<T,O>::writeBuffer(){
     return;
 }
 
+/*!
+* It writes the shared data of the output port for zero-copy transport.
+* It uses the linked get function if the member pointer m_getVar_ is not NULL: 
+* the returned value is moved in a shared object owned by the port.
+* Alternatively it refers m_var_ directly (if not NULL), without copies and without ownership.
+*/
+template<typename T, typename O>
+void
+PortOutT<T,O>::writeShared(){
+    m_shared.reset();
+    m_sharedOwned = false;
+    if (m_getVar_ != NULL){
+        m_shared = std::make_shared<T>((m_obj_->*m_getVar_)());
+        m_sharedOwned = true;
+        return;
+    }
+    if (m_var_ != NULL){
+        m_shared = std::shared_ptr<T>(m_var_, [](T*){});
+    }
+    return;
+}
+
+/*!
+* It gets the hash code of the C++ type of the data communicated.
+* \return hash code of type T
+*/
+template<typename T, typename O>
+std::size_t
+PortOutT<T,O>::getTypeHash(){
+    return(typeid(T).hash_code());
+}
+
 
 
 /*!
@@ -267,10 +299,28 @@ bool  PortInT<T, O>::operator==(const PortInT<T, O> & other){
 /*!
  * It reads the buffer of the output port with the data to be communicated.
  * It stores the read values in the linked m_var_ by casting in the stream operator.
+ * If shared data are received (zero-copy transport), they are passed directly to the linked 
+ * set function or variable; they are moved if this port holds the last reference of data owned
+ * by the sender port, copied otherwise.
  */
 template<typename T, typename O>
 void
 PortInT<T, O>::readBuffer(){
+    if (m_shared){
+        std::shared_ptr<T> data = std::static_pointer_cast<T>(m_shared);
+        m_shared.reset();
+        bool movable = m_sharedOwned && data.use_count() == 1;
+        if (m_setVar_ != NULL){
+            if (movable)    (m_obj_->*m_setVar_)(std::move(*data));
+            else            (m_obj_->*m_setVar_)(*data);
+            return;
+        }
+        if (m_var_ != NULL){
+            if (movable)    (*m_var_) = std::move(*data);
+            else            (*m_var_) = *data;
+        }
+        return;
+    }
     T temp;
     m_ibuffer >> temp;
     if (m_setVar_ != NULL){
@@ -283,4 +333,14 @@ PortInT<T, O>::readBuffer(){
     return;
 }
 
+/*!
+* It gets the hash code of the C++ type of the data communicated.
+* \return hash code of type T
+*/
+template<typename T, typename O>
+std::size_t
+PortInT<T,O>::getTypeHash(){
+    return(typeid(T).hash_code());
+}
+
 }
@@ -0,0 +1,729 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+# include "KdTree.hpp"
+# include <cmath>
+# include <algorithm>
+# include <cstdint>
+# include <limits>
+# include <queue>
+
+namespace mimmo{
+
+/*!
+ * Size of the stack used to visit the kd-tree.
+ * Since the tree is balanced, its depth is bounded by the logarithm of the number of points.
+ */
+static const int KDTREE_STACKSIZE = 128;
+
+/*!
+ * Default constructor for class KdNode.
+ * Initialize an empty leaf node of the kd-tree.
+ */
+KdNode::KdNode()
+{
+    m_minPoint.fill(0.0f);
+    m_maxPoint.fill(0.0f);
+    m_element.fill(0);
+    m_rchild = -1;
+}
+
+/*!
+ * Default destructor for class KdNode.
+ */
+KdNode::~KdNode(){}
+
+/*!
+ * It sets the bounding box of the node. The coordinates are converted
+ * in single precision rounding them outward, so that the stored box
+ * always contains the original one.
+ * \param[in] pmin Minimum coordinates of the bounding box.
+ * \param[in] pmax Maximum coordinates of the bounding box.
+ */
+void KdNode::setBoundingBox(const darray3E & pmin, const darray3E & pmax)
+{
+    for (int j=0; j<3; ++j)
+    {
+        float lo = float(pmin[j]);
+        if (double(lo) > pmin[j]) lo = std::nextafter(lo, -std::numeric_limits<float>::max());
+        float hi = float(pmax[j]);
+        if (double(hi) < pmax[j]) hi = std::nextafter(hi, std::numeric_limits<float>::max());
+        m_minPoint[j] = lo;
+        m_maxPoint[j] = hi;
+    }
+}
+
+/*!
+ * \return Minimum coordinates of the bounding box of the node.
+ */
+darray3E KdNode::getMinPoint() const
+{
+    return darray3E({{double(m_minPoint[0]), double(m_minPoint[1]), double(m_minPoint[2])}});
+}
+
+/*!
+ * \return Maximum coordinates of the bounding box of the node.
+ */
+darray3E KdNode::getMaxPoint() const
+{
+    return darray3E({{double(m_maxPoint[0]), double(m_maxPoint[1]), double(m_maxPoint[2])}});
+}
+
+/*!
+ * \class KdBuilder
+ * \ingroup core
+ * \brief KdBuilder is an ad-hoc class used to build the nodes of a Kd-Tree
+ * by median splits.
+ *
+ * The points are referred by their index in the coordinates structure;
+ * the construction reorders the list of the indices so that the points
+ * of each node are contiguous. Since the splits are balanced, the number
+ * of nodes of each subtree depends only on its number of points: the nodes
+ * are written directly in their final depth-first position, so that subtrees
+ * can be built concurrently on the same list.
+ *
+ */
+class KdBuilder{
+public:
+    const dvecarr3E     & points;       /**< coordinates of the points */
+    ivector1D           & order;        /**< indices of the points, reordered during the construction */
+    std::vector<KdNode> & nodes;        /**< nodes of the tree */
+    int                 maxsize;        /**< maximum number of points of a leaf node */
+
+    static const int    TASKSIZE = 16384;   /**< minimum number of points of a node built in a separate task */
+
+public:
+    /*!Custom constructor for class KdBuilder.
+     * \param[in] points_ coordinates of the points.
+     * \param[in] order_ indices of the points to be reordered.
+     * \param[in] nodes_ list of nodes to be filled.
+     * \param[in] maxsize_ maximum number of points of a leaf node.
+     */
+    KdBuilder(const dvecarr3E & points_, ivector1D & order_, std::vector<KdNode> & nodes_, int maxsize_) :
+        points(points_), order(order_), nodes(nodes_), maxsize(std::max(1, maxsize_)){}
+
+    /*!
+     * \param[in] n number of points of a subtree.
+     * \return number of nodes of the subtree.
+     */
+    int countNodes(int n) const
+    {
+        return countNodesPair(n)[0];
+    }
+
+    /*!
+     * It counts the nodes of the subtrees of m and m+1 points. Since the children
+     * of a node differ at most by one point, both counts follow from the counts of the
+     * subtrees of m/2 and m/2+1 points, so that only one recursion per level is needed.
+     * \param[in] m number of points of a subtree.
+     * \return number of nodes of the subtrees of m and m+1 points.
+     */
+    std::array<int,2> countNodesPair(int m) const
+    {
+        if (m+1 <= maxsize) return std::array<int,2>({{1, 1}});
+        std::array<int,2> c = countNodesPair(m/2);
+        std::array<int,2> result;
+        if (m%2 == 0)
+        {
+            result[0] = 1 + 2*c[0];
+            result[1] = 1 + c[0] + c[1];
+        }
+        else
+        {
+            result[0] = 1 + c[0] + c[1];
+            result[1] = 1 + 2*c[1];
+        }
+        if (m <= maxsize) result[0] = 1;
+        return result;
+    }
+
+    /*!
+     * It builds the subtree of a range of points, whose root is stored in a target position.
+     * \param[in] begin index of the first point of the range in order list.
+     * \param[in] end index next to the last point of the range in order list.
+     * \param[in] inode position of the root of the subtree in the list of nodes.
+     */
+    void build(int begin, int end, int inode)
+    {
+        const double maxl = std::numeric_limits<double>::max();
+        darray3E bmin({{maxl, maxl, maxl}}), bmax({{-maxl, -maxl, -maxl}});
+        for (int i=begin; i<end; ++i)
+        {
+            const darray3E & p = points[order[i]];
+            for (int j=0; j<3; ++j)
+            {
+                bmin[j] = std::min(bmin[j], p[j]);
+                bmax[j] = std::max(bmax[j], p[j]);
+            }
+        }
+        KdNode & node = nodes[inode];
+        node.setBoundingBox(bmin, bmax);
+        node.m_element[0] = begin;
+        node.m_element[1] = end;
+        node.m_rchild = -1;
+
+        int n = end - begin;
+        if (n <= maxsize) return;
+
+        int dir = 0;
+        for (int j=1; j<3; ++j)
+        {
+            if ((bmax[j] - bmin[j]) > (bmax[dir] - bmin[dir])) dir = j;
+        }
+        int mid = begin + n/2;
+        const dvecarr3E & pts = points;
+        std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end,
+                [&pts, dir](int a, int b){ return (pts[a][dir] < pts[b][dir]); });
+
+        int lchild = inode + 1;
+        int rchild = lchild + countNodes(mid - begin);
+        node.m_rchild = rchild;
+
+#if MIMMO_ENABLE_OPENMP
+        if (n >= TASKSIZE)
+        {
+#pragma omp task
+            build(begin, mid, lchild);
+#pragma omp task
+            build(mid, end, rchild);
+#pragma omp taskwait
+            return;
+        }
+#endif
+        build(begin, mid, lchild);
+        build(mid, end, rchild);
+    }
+};
+
+/*!
+ * Default constructor for class KdTree.
+ * Initialize an empty kd-tree structure.
+ *
+ *  \param[in] patch_ Pointer to the target bitpit::PatchKernel, whose vertices are stored in the tree.
+ *
+ */
+KdTree::KdTree(bitpit::PatchKernel *patch_)
+{
+    m_patch     = patch_;
+    m_npoints   = 0;
+    m_nnodes    = 0;
+    m_nleaf     = 0;
+    m_maxsize   = 8;
+}
+
+/*!
+ * Default destructor for class KdTree.
+ * Clear kd-tree content and release memory.
+ */
+KdTree::~KdTree()
+{
+    m_patch = NULL;
+    clean();
+}
+
+/*!
+ * It sets the patch whose vertices are stored in the kd-tree.
+ * \param[in] patch_ Pointer to the target bitpit::PatchKernel.
+ */
+void KdTree::setPatch(bitpit::PatchKernel *patch_)
+{
+    m_patch = patch_;
+}
+
+/*!
+ * It sets the maximum number of points of a leaf node (bucket size).
+ * \param[in] maxsize Maximum number of points in a leaf node of the kd-tree.
+ */
+void KdTree::setMaxLeafSize(int maxsize)
+{
+    m_maxsize = std::max(1, maxsize);
+}
+
+/*!
+ * It cleans the kd-tree and releases the memory.
+ */
+void KdTree::clean()
+{
+    m_npoints = 0;
+    m_nnodes = 0;
+    m_nleaf = 0;
+    std::vector<long>().swap(m_labels);
+    std::vector<double>().swap(m_coords);
+    std::vector<KdNode>().swap(m_nodes);
+}
+
+/*!
+ * It writes the kd-tree in binary form (see restore). The linked patch is not written;
+ * the labels of the points are written as 64-bit integers.
+ * \param[in] out output stream
+ */
+void KdTree::dump(std::ostream & out) const
+{
+    int32_t header[5] = {m_npoints, m_nnodes, m_nleaf, m_maxsize, int32_t(sizeof(KdNode))};
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    uint64_t sizes[3] = {uint64_t(m_labels.size()), uint64_t(m_coords.size()), uint64_t(m_nodes.size())};
+    out.write(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+    std::vector<int64_t> labels(m_labels.begin(), m_labels.end());
+    out.write(reinterpret_cast<const char *>(labels.data()), sizes[0]*sizeof(int64_t));
+    out.write(reinterpret_cast<const char *>(m_coords.data()), sizes[1]*sizeof(double));
+    out.write(reinterpret_cast<const char *>(m_nodes.data()), sizes[2]*sizeof(KdNode));
+}
+
+/*!
+ * Check recursively the consistency of a subtree of nodes read from a stream:
+ * each node has to cover the expected range of points, internal nodes are split at the
+ * median position used by the builder, the left child follows its parent and the right
+ * child follows the whole left subtree. The depth is bounded by the traversal stack size.
+ * \param[in] nodes list of nodes
+ * \param[in] inode index of the root of the subtree
+ * \param[in] begin index of the first point expected in the subtree
+ * \param[in] end index next to the last point expected in the subtree
+ * \param[in] depth depth of the root of the subtree
+ * \param[in,out] nleaf number of leaves found
+ * \return number of nodes of the subtree, -1 if the subtree is not consistent
+ */
+static int kdCheckNodes(const std::vector<KdNode> & nodes, int inode, int begin, int end, int depth, int & nleaf)
+{
+    if (inode < 0 || inode >= int(nodes.size()) || depth >= KDTREE_STACKSIZE - 1) return -1;
+    const KdNode & node = nodes[inode];
+    int n = end - begin;
+    if (node.m_element[0] != begin || node.m_element[1] != end || n < 1) return -1;
+    if (node.isLeaf())
+    {
+        nleaf++;
+        return 1;
+    }
+    if (n < 2) return -1;
+    int mid = begin + n/2;
+    int nl = kdCheckNodes(nodes, inode+1, begin, mid, depth+1, nleaf);
+    if (nl < 0 || node.m_rchild != inode + 1 + nl) return -1;
+    int nr = kdCheckNodes(nodes, node.m_rchild, mid, end, depth+1, nleaf);
+    if (nr < 0) return -1;
+    return (1 + nl + nr);
+}
+
+/*!
+ * It reads a kd-tree written by dump. The linked patch is preserved; the labels
+ * of the points are valid for the point set the tree was built on. The number of points
+ * of the tree is checked against the vertex count of the patch and the labels against its
+ * vertices, if any (see MimmoObject::restoreStructure for a complete check).
+ * Sizes, point ranges and child links of the nodes are validated before the tree is accepted.
+ * \param[in] in input stream
+ * \return false if the tree cannot be read; in that case the tree is cleaned.
+ */
+bool KdTree::restore(std::istream & in)
+{
+    clean();
+    int32_t header[5];
+    uint64_t sizes[3];
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    in.read(reinterpret_cast<char *>(sizes), sizeof(sizes));
+    bool check = in.good() && header[4] == int32_t(sizeof(KdNode)) && header[0] >= 0 && header[3] >= 1;
+    check = check && header[1] >= 0 && header[1] <= 2*int64_t(header[0]);
+    check = check && sizes[0] == uint64_t(header[0]) && sizes[1] == 3*sizes[0] && sizes[2] == uint64_t(header[1]);
+    check = check && (m_patch == NULL || long(header[0]) == m_patch->getVertexCount());
+    if (!check){
+        clean();
+        return false;
+    }
+    std::vector<int64_t> labels(sizes[0]);
+    m_coords.resize(sizes[1]);
+    m_nodes.resize(sizes[2]);
+    in.read(reinterpret_cast<char *>(labels.data()), sizes[0]*sizeof(int64_t));
+    in.read(reinterpret_cast<char *>(m_coords.data()), sizes[1]*sizeof(double));
+    in.read(reinterpret_cast<char *>(m_nodes.data()), sizes[2]*sizeof(KdNode));
+    check = in.good();
+    m_labels.assign(labels.begin(), labels.end());
+    for (std::size_t i=0; check && m_patch != NULL && i<m_labels.size(); ++i)
+    {
+        check = m_patch->getVertices().exists(m_labels[i]);
+    }
+    if (check)
+    {
+        int nleaf = 0;
+        if (header[0] == 0)     check = (header[1] == 0);
+        else                    check = (kdCheckNodes(m_nodes, 0, 0, header[0], 0, nleaf) == header[1]);
+        check = check && (nleaf == header[2]);
+    }
+    if (!check){
+        clean();
+        return false;
+    }
+    m_npoints = header[0];
+    m_nnodes = header[1];
+    m_nleaf = header[2];
+    m_maxsize = header[3];
+    return true;
+}
+
+/*!
+ * It builds the kd-tree on the vertices of the linked patch.
+ * The labels of the points are the unique ids of the vertices.
+ */
+void KdTree::buildTree()
+{
+    clean();
+    if (m_patch == NULL) return;
+
+    m_npoints = m_patch->getVertexCount();
+    dvecarr3E points(m_npoints);
+    m_labels.resize(m_npoints);
+    int i = 0;
+    for (const auto & vertex : m_patch->getVertices())
+    {
+        m_labels[i] = vertex.getId();
+        points[i] = vertex.getCoords();
+        ++i;
+    }
+    build(points);
+}
+
+/*!
+ * It builds the kd-tree on a list of points, without any reference to the linked patch.
+ * The labels of the points are their indices in the list.
+ * \param[in] points List of points to be stored.
+ */
+void KdTree::buildTree(const std::vector<std::array<double,3> > & points)
+{
+    clean();
+    m_npoints = points.size();
+    m_labels.resize(m_npoints);
+    for (int i=0; i<m_npoints; ++i)
+    {
+        m_labels[i] = i;
+    }
+    build(points);
+}
+
+/*!
+ * It builds the nodes of the kd-tree and packs the points in the order of the tree.
+ * The labels of the points must be already set in the order of the list.
+ * \param[in] points List of points to be stored.
+ */
+void KdTree::build(const std::vector<std::array<double,3> > & points)
+{
+    if (m_npoints == 0) return;
+
+    ivector1D order(m_npoints);
+    for (int i=0; i<m_npoints; ++i)
+    {
+        order[i] = i;
+    }
+
+    KdBuilder builder(points, order, m_nodes, m_maxsize);
+    m_nnodes = builder.countNodes(m_npoints);
+    m_nodes.resize(m_nnodes);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+    {
+#pragma omp single
+        builder.build(0, m_npoints, 0);
+    }
+#else
+    builder.build(0, m_npoints, 0);
+#endif
+    for (const KdNode & node : m_nodes)
+    {
+        if (node.isLeaf()) m_nleaf++;
+    }
+
+    //pack coordinates and labels in the order of the tree
+    std::vector<long> labels(m_npoints);
+    m_coords.resize(3*m_npoints);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i=0; i<m_npoints; ++i)
+    {
+        int k = order[i];
+        labels[i] = m_labels[k];
+        for (int j=0; j<3; ++j)
+        {
+            m_coords[3*i+j] = points[k][j];
+        }
+    }
+    m_labels.swap(labels);
+}
+
+/*!
+ * It computes the squared distance of a point from the bounding box of a node.
+ * \param[in] P Coordinates of the point.
+ * \param[in] node Target node.
+ * \return Squared distance, zero if the point is inside the box.
+ */
+static inline double squaredDistancePointBox(const double * P, const KdNode & node)
+{
+    double d2 = 0.0;
+    for (int j=0; j<3; ++j)
+    {
+        double d = std::min(std::max(P[j], double(node.m_minPoint[j])), double(node.m_maxPoint[j])) - P[j];
+        d2 += d*d;
+    }
+    return d2;
+}
+
+/*!
+ * It computes the squared distance between two points.
+ * \param[in] P Coordinates of the first point.
+ * \param[in] Q Coordinates of the second point.
+ * \return Squared distance.
+ */
+static inline double squaredDistancePointPoint(const double * P, const double * Q)
+{
+    double dx = P[0] - Q[0], dy = P[1] - Q[1], dz = P[2] - Q[2];
+    return (dx*dx + dy*dy + dz*dz);
+}
+
+/*!
+ * It searches the points of the kd-tree with distance from a target point
+ * not greater than a given radius.
+ * The labels found are appended to the list L, excluding those contained in the list EXC.
+ * \param[in] P_ Pointer to coordinates of the target point.
+ * \param[in] h Radius of the search.
+ * \param[in,out] L List of labels of the points found.
+ * \param[in] EXC Pointer to a list of labels to be excluded from the search (optional).
+ */
+void KdTree::hNeighbors(const std::array<double,3> *P_, double h, std::vector<long> *L, const std::vector<long> *EXC) const
+{
+    if (m_nnodes == 0 || L == NULL) return;
+    const double * P = P_->data();
+    double h2 = h*h;
+    bool exclude = (EXC != NULL && !EXC->empty());
+
+    std::array<int, KDTREE_STACKSIZE> stack;
+    int nstack = 0;
+    stack[nstack++] = 0;
+    while (nstack > 0)
+    {
+        int inode = stack[--nstack];
+        const KdNode & node = m_nodes[inode];
+        if (squaredDistancePointBox(P, node) > h2) continue;
+
+        if (node.isLeaf())
+        {
+            for (int i=node.m_element[0]; i<node.m_element[1]; ++i)
+            {
+                if (squaredDistancePointPoint(P, getPointCoords(i)) > h2) continue;
+                if (exclude && std::find(EXC->begin(), EXC->end(), m_labels[i]) != EXC->end()) continue;
+                L->push_back(m_labels[i]);
+            }
+            continue;
+        }
+        stack[nstack++] = node.m_rchild;
+        stack[nstack++] = inode + 1;
+    }
+}
+
+/*!
+ * It searches the point of the kd-tree nearest to a target point, within a maximum distance.
+ * The nearest child of each node is visited first.
+ * \param[in] P_ Pointer to coordinates of the target point.
+ * \param[out] dist Distance of the nearest point found, r if no point is found.
+ * \param[in] r Maximum distance of the search.
+ * \return Label of the nearest point, -1 if no point is found.
+ */
+long KdTree::nearest(const std::array<double,3> *P_, double &dist, double r) const
+{
+    long label = -1;
+    dist = r;
+    if (m_nnodes == 0) return label;
+    const double * P = P_->data();
+    double best = r*r;
+
+    std::array<int, KDTREE_STACKSIZE> stack;
+    int nstack = 0;
+    stack[nstack++] = 0;
+    while (nstack > 0)
+    {
+        int inode = stack[--nstack];
+        const KdNode & node = m_nodes[inode];
+        if (squaredDistancePointBox(P, node) > best) continue;
+
+        if (node.isLeaf())
+        {
+            for (int i=node.m_element[0]; i<node.m_element[1]; ++i)
+            {
+                double d2 = squaredDistancePointPoint(P, getPointCoords(i));
+                if (d2 <= best)
+                {
+                    best = d2;
+                    label = m_labels[i];
+                }
+            }
+            continue;
+        }
+
+        int lchild = inode + 1;
+        int rchild = node.m_rchild;
+        if (squaredDistancePointBox(P, m_nodes[rchild]) < squaredDistancePointBox(P, m_nodes[lchild]))
+        {
+            std::swap(lchild, rchild);
+        }
+        stack[nstack++] = rchild;
+        stack[nstack++] = lchild;
+    }
+
+    if (label >= 0) dist = std::sqrt(best);
+    return label;
+}
+
+/*!
+ * It searches the k points of the kd-tree nearest to a target point.
+ * If the tree contains less than k points, all the points are returned.
+ * \param[in] P_ Pointer to coordinates of the target point.
+ * \param[in] k Number of points to be found.
+ * \param[out] L Labels of the points found, sorted by increasing distance.
+ * \param[out] dist Distances of the points found.
+ */
+void KdTree::kNearest(const std::array<double,3> *P_, int k, std::vector<long> &L, std::vector<double> &dist) const
+{
+    L.clear();
+    dist.clear();
+    if (m_nnodes == 0 || k <= 0) return;
+    const double * P = P_->data();
+
+    //max-heap of the squared distances of the best points found
+    std::priority_queue<std::pair<double,int> > heap;
+    std::array<int, KDTREE_STACKSIZE> stack;
+    int nstack = 0;
+    stack[nstack++] = 0;
+    while (nstack > 0)
+    {
+        int inode = stack[--nstack];
+        const KdNode & node = m_nodes[inode];
+        if (int(heap.size()) == k && squaredDistancePointBox(P, node) > heap.top().first) continue;
+
+        if (node.isLeaf())
+        {
+            for (int i=node.m_element[0]; i<node.m_element[1]; ++i)
+            {
+                double d2 = squaredDistancePointPoint(P, getPointCoords(i));
+                if (int(heap.size()) < k)
+                {
+                    heap.push(std::make_pair(d2, i));
+                }
+                else if (d2 < heap.top().first)
+                {
+                    heap.pop();
+                    heap.push(std::make_pair(d2, i));
+                }
+            }
+            continue;
+        }
+
+        int lchild = inode + 1;
+        int rchild = node.m_rchild;
+        if (squaredDistancePointBox(P, m_nodes[rchild]) < squaredDistancePointBox(P, m_nodes[lchild]))
+        {
+            std::swap(lchild, rchild);
+        }
+        stack[nstack++] = rchild;
+        stack[nstack++] = lchild;
+    }
+
+    int nfound = heap.size();
+    L.resize(nfound);
+    dist.resize(nfound);
+    for (int i=nfound-1; i>=0; --i)
+    {
+        L[i] = m_labels[heap.top().second];
+        dist[i] = std::sqrt(heap.top().first);
+        heap.pop();
+    }
+}
+
+namespace kdTreeUtils{
+
+/*!
+ * It searches the points of a kd-tree with distance not greater than a given radius
+ * from each point of a list. The points of the list are processed in parallel when
+ * mimmo is compiled with OpenMP support.
+ * \param[in] P_ Pointer to the list of target points.
+ * \param[in] kdtree_ Pointer to the kd-tree.
+ * \param[in] h Radius of the search.
+ * \return Labels of the points found for each target point.
+ */
+std::vector<std::vector<long> > hNeighbors(const std::vector<std::array<double,3> > *P_, KdTree *kdtree_, double h)
+{
+    int nP = P_->size();
+    std::vector<std::vector<long> > L(nP);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int i=0; i<nP; ++i)
+    {
+        kdtree_->hNeighbors(&(*P_)[i], h, &L[i]);
+    }
+    return L;
+}
+
+/*!
+ * It searches the point of a kd-tree nearest to each point of a list, within a maximum distance.
+ * The points of the list are processed in parallel when mimmo is compiled with OpenMP support.
+ * \param[in] P_ Pointer to the list of target points.
+ * \param[in] kdtree_ Pointer to the kd-tree.
+ * \param[out] dist Distance of the nearest point found for each target point, r if none is found.
+ * \param[in] r Maximum distance of the search.
+ * \return Label of the nearest point for each target point, -1 if none is found.
+ */
+std::vector<long> nearest(const std::vector<std::array<double,3> > *P_, KdTree *kdtree_, std::vector<double> &dist, double r)
+{
+    int nP = P_->size();
+    std::vector<long> L(nP);
+    dist.resize(nP);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int i=0; i<nP; ++i)
+    {
+        L[i] = kdtree_->nearest(&(*P_)[i], dist[i], r);
+    }
+    return L;
+}
+
+/*!
+ * It searches the k points of a kd-tree nearest to each point of a list.
+ * The points of the list are processed in parallel when mimmo is compiled with OpenMP support.
+ * \param[in] P_ Pointer to the list of target points.
+ * \param[in] kdtree_ Pointer to the kd-tree.
+ * \param[in] k Number of points to be found.
+ * \param[out] L Labels of the points found for each target point, sorted by increasing distance.
+ * \param[out] dist Distances of the points found for each target point.
+ */
+void kNearest(const std::vector<std::array<double,3> > *P_, KdTree *kdtree_, int k, std::vector<std::vector<long> > &L, std::vector<std::vector<double> > &dist)
+{
+    int nP = P_->size();
+    L.resize(nP);
+    dist.resize(nP);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int i=0; i<nP; ++i)
+    {
+        kdtree_->kNearest(&(*P_)[i], k, L[i], dist[i]);
+    }
+}
+
+}; //end namespace kdTreeUtils
+
+} //end namespace mimmo
@@ -0,0 +1,151 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+# ifndef __KDTREE_HPP__
+# define __KDTREE_HPP__
+
+# include "bitpit_patchkernel.hpp"
+# include "mimmoTypeDef.hpp"
+# include <iostream>
+
+namespace mimmo{
+
+/*!
+ * \class KdNode
+ * \ingroup core
+ * \brief Kd-Node is the class of a node of a Kd-Tree.
+ *
+ * Nodes are stored in depth-first order, so that the left child of an internal
+ * node is always the node immediately following it and the points of a node
+ * are contiguous. The bounding box of the points of the node is stored in single
+ * precision, rounded outward, to keep the node compact.
+ *
+ */
+class KdNode {
+public:
+    std::array<float,3>     m_minPoint;    /**<Minimum coordinates of the bounding box of the node. */
+    std::array<float,3>     m_maxPoint;    /**<Maximum coordinates of the bounding box of the node. */
+    std::array<int,2>       m_element;     /**<Range index of points of the node. */
+    int                     m_rchild;      /**<Index of right child, -1 for leaf nodes. The left child is the following node. */
+
+public:
+    KdNode();
+    ~KdNode();
+    /*!
+     * Default copy constructor of KdNode.
+     */
+    KdNode(const KdNode & other) = default;
+    KdNode & operator=(const KdNode & other) = default;
+
+    /*!
+     * \return true if the node is a leaf node.
+     */
+    inline bool isLeaf() const { return (m_rchild < 0); };
+    /*!
+     * \return number of points in the bounding box of the node.
+     */
+    inline int getNRange() const { return (m_element[1] - m_element[0]); };
+
+    void setBoundingBox(const std::array<double,3> & pmin, const std::array<double,3> & pmax);
+    std::array<double,3> getMinPoint() const;
+    std::array<double,3> getMaxPoint() const;
+};
+
+/*!
+ * \class KdTree
+ * \ingroup core
+ * \brief Kd-Tree is the class to manage a balanced, bucketed k-d tree of a cloud of points.
+ *
+ * The tree is built on the vertices of a bitpit patch or on a generic list of points.
+ * Each node is split at the median of its points along the direction of maximum extent
+ * of its bounding box, so that the tree is balanced, until the points of a node are
+ * not more than the maximum leaf size (bucket). The points are reordered during the
+ * construction, so that the points of each node are contiguous; their coordinates
+ * and labels are packed in the order of the tree and the tree does not refer to
+ * the patch after its construction.
+ * The nodes are stored in depth-first order: the left child of a node is the node following it,
+ * while the index of the right child is stored in the node.
+ * When mimmo is compiled with OpenMP support the upper levels of the tree are built concurrently.
+ * The queries (radius search, nearest and k-nearest points) do not modify the tree and can be
+ * performed concurrently; batch versions running in parallel are provided in kdTreeUtils.
+ *
+ */
+class KdTree {
+public:
+    bitpit::PatchKernel            *m_patch;        /**< Patch linked by the kd-tree. */
+    int                            m_npoints;       /**< Number of points in the tree. */
+    std::vector<long>              m_labels;        /**< Labels of the points (vertex ids or indices in the list), in the order of the tree. */
+    std::vector<double>            m_coords;        /**< Coordinates of the points (x,y,z of each point), in the order of the tree. */
+    int                            m_nnodes;        /**< Number of nodes in the tree. */
+    std::vector<KdNode>            m_nodes;         /**< Kd-tree nodes structure. */
+
+    int                            m_nleaf;         /**<Number of leaf nodes in the kd-tree. */
+    int                            m_maxsize;       /**<Maximum number of points for leaf nodes. */
+
+public:
+    KdTree(bitpit::PatchKernel *patch_ = NULL);
+    ~KdTree();
+    /*!
+     * Default copy constructor of KdTree.
+     */
+    KdTree(const KdTree & other) = default;
+    KdTree & operator=(const KdTree & other) = default;
+
+    void setPatch(bitpit::PatchKernel *patch_);
+    void setMaxLeafSize(int maxsize);
+    /*!
+     * \param[in] i Index of the target point in the order of the tree.
+     * \return pointer to the coordinates of the point.
+     */
+    inline const double * getPointCoords(int i) const { return (m_coords.data() + 3*i); };
+
+    void clean();
+    void buildTree();
+    void buildTree(const std::vector<std::array<double,3> > & points);
+
+    void dump(std::ostream & out) const;
+    bool restore(std::istream & in);
+
+    void hNeighbors(const std::array<double,3> *P_, double h, std::vector<long> *L, const std::vector<long> *EXC = NULL) const;
+    long nearest(const std::array<double,3> *P_, double &dist, double r = 1.0e+18) const;
+    void kNearest(const std::array<double,3> *P_, int k, std::vector<long> &L, std::vector<double> &dist) const;
+
+private:
+    void build(const std::vector<std::array<double,3> > & points);
+};
+
+/*!
+ * \brief Utilities employing kdTree.
+ * \ingroup core
+ */
+namespace kdTreeUtils{
+
+    std::vector<std::vector<long> > hNeighbors(const std::vector<std::array<double,3> > *P_, KdTree *kdtree_, double h);
+    std::vector<long> nearest(const std::vector<std::array<double,3> > *P_, KdTree *kdtree_, std::vector<double> &dist, double r = 1.0e+18);
+    void kNearest(const std::vector<std::array<double,3> > *P_, KdTree *kdtree_, int k, std::vector<std::vector<long> > &L, std::vector<std::vector<double> > &dist);
+
+}; //end namespace kdTreeUtils
+
+} //end namespace mimmo
+
+#endif
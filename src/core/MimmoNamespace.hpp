@@ -84,6 +84,7 @@ BETTER_ENUM(PortType, int,
             M_VALUEB4			= 142,
             M_VALUEB5			= 143,
             M_VALUEI2			= 150,
+            M_CSROPERATOR		= 160,
             M_VECPAIRSF			= 200,
             M_VECPAIRVF			= 201,
             M_POLYDATA_         = 1100
@@ -187,6 +188,7 @@ struct FileDataInfo{
 * - <B>M_VALUEB4       </B>= 142  Port dedicated to communicate a scalar value [bool].,
 * - <B>M_VALUEB5       </B>= 143  Port dedicated to communicate a scalar value [bool].,
 * - <B>M_VALUEI2       </B>= 150  Port dedicated to communicate a scalar value [int].,
+* - <B>M_CSROPERATOR   </B>= 160  Port dedicated to communicate a sparse linear operator in CSR format [mimmo::CSRMatrix].,
 * - <B>M_VECPAIRSF     </B>= 200  Port dedicated to communicate a std::vector<std::pair<MimmoObject*, dvector1D*> >.,
 * - <B>M_VECPAIRVF     </B>= 201  Port dedicated to communicate a std::vector<std::pair<MimmoObject*, dvecarr3E*> >.,
 * - <B>M_POLYDATA_     </B>= 1100 Port dedicated to communicate a pointer to a vtk polydata mesh [vtkPolyData *].
@@ -267,7 +269,8 @@ enum class dataTAG{
     COORDT						/**< TAG related to a mimmo::CoordType data.*/,
     POLYDATA_					/**< TAG related to a VTK::vtkPolyData* data.*/,
     TRACKINGPTR_                /**< TAG related to a generic object derived from mimmo::TrackingPointer class */,
-    BCCGNS_                     /**< TAG related to a mimmo::BCCGNS* object (class with Boundary Conditions Info for CGNS export) */
+    BCCGNS_                     /**< TAG related to a mimmo::BCCGNS* object (class with Boundary Conditions Info for CGNS export) */,
+    CSRMATRIX                   /**< TAG related to a mimmo::CSRMatrix sparse matrix data.*/
 };
 
 
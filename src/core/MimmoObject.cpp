@@ -24,6 +24,9 @@
 
 #include "MimmoObject.hpp"
 #include "Operators.hpp"
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <set>
 
 using namespace std;
@@ -31,6 +34,40 @@ using namespace bitpit;
 
 namespace mimmo{
 
+/*!
+ * Mutex serializing the creation and destruction of bitpit patches, which are
+ * registered in the global bitpit patch manager: geometries can thus be
+ * instantiated concurrently (e.g. by readers running in parallel).
+ */
+static std::mutex patchRegistryMutex;
+
+/*!
+ * Create an internal bitpit patch, in expert mode.
+ * \param[in] type type of mesh (2 volume unstructured, surface unstructured otherwise)
+ * \return pointer to the new patch
+ */
+static PatchKernel * createPatch(int type){
+    std::lock_guard<std::mutex> lock(patchRegistryMutex);
+    const int id = 0;
+    if (type == 2){
+        VolUnstructured * patch = new VolUnstructured(id, 3);
+        patch->setExpert(true);
+        return patch;
+    }
+    SurfUnstructured * patch = new SurfUnstructured(id);
+    patch->setExpert(true);
+    return patch;
+}
+
+/*!
+ * Destroy an internal bitpit patch created by createPatch.
+ * \param[in] patch pointer to the patch
+ */
+static void destroyPatch(PatchKernel * patch){
+    std::lock_guard<std::mutex> lock(patchRegistryMutex);
+    delete patch;
+}
+
 /*!
 * Default constructor of MimmoObject.
 * It requires a int flag identifying the type of mesh meant to be created:
@@ -44,14 +81,7 @@ namespace mimmo{
 MimmoObject::MimmoObject(int type){
     
     m_type = max(type,1);
-    const int id = 0;
-    if (m_type == 2){
-        m_patch = new VolUnstructured(id, 3);
-        dynamic_cast<VolUnstructured*>(m_patch)->setExpert(true);
-    }else{
-        m_patch = new SurfUnstructured(id);
-        dynamic_cast<SurfUnstructured*>(m_patch)->setExpert(true);
-    }
+    m_patch = createPatch(m_type);
     m_internalPatch = true;
     m_bvTree.setPatch(m_patch);
     m_bvTreeBuilt = false;
@@ -60,6 +90,19 @@ MimmoObject::MimmoObject(int type){
     m_bvTreeSync = false;
     m_kdTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
+    m_mapDataSync = true;
+    m_mapCellSync = true;
+    m_mapDataInvSync = true;
+    m_mapCellInvSync = true;
+    m_compact = false;
+    //the logger is shared by geometries created concurrently (see MultipleMimmoGeometries::read)
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
     m_log = &bitpit::log::cout(MIMMO_LOG_FILE);
 }
 
@@ -82,16 +125,17 @@ MimmoObject::MimmoObject(int type){
 */
 MimmoObject::MimmoObject(int type, dvecarr3E & vertex, ivector2D * connectivity){
     m_type = max(1,type);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
     m_log = &bitpit::log::cout(MIMMO_LOG_FILE);
     m_internalPatch = true;
-    const int id = 0;
-    if (m_type == 2){
-        m_patch = new VolUnstructured(id, 3);
-        dynamic_cast<VolUnstructured*> (m_patch)->setExpert(true);
-    }else{
-        m_patch = new SurfUnstructured(id);
-        dynamic_cast<SurfUnstructured*> (m_patch)->setExpert(true);
-    }
+    m_mapDataSync = true;
+    m_mapCellSync = true;
+    m_mapDataInvSync = true;
+    m_mapCellInvSync = true;
+    m_compact = false;
+    m_patch = createPatch(m_type);
     
     bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::UNDEFINED;
     int sizeVert, sizeCell;
@@ -143,8 +187,13 @@ MimmoObject::MimmoObject(int type, dvecarr3E & vertex, ivector2D * connectivity)
             m_pidsType.insert(0);
             
         }else{
-            (*m_log)<<"Not supported connectivity found for MimmoObject"<<std::endl;
-            (*m_log)<<"Proceeding as Point Cloud geometry"<<std::endl;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
+            {
+                (*m_log)<<"Not supported connectivity found for MimmoObject"<<std::endl;
+                (*m_log)<<"Proceeding as Point Cloud geometry"<<std::endl;
+            }
         }	
     }
     m_bvTree.setPatch(m_patch);
@@ -154,6 +203,10 @@ MimmoObject::MimmoObject(int type, dvecarr3E & vertex, ivector2D * connectivity)
     m_bvTreeSync = false;
     m_kdTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
 };
 
 /*!
@@ -165,7 +218,20 @@ MimmoObject::MimmoObject(int type, dvecarr3E & vertex, ivector2D * connectivity)
 */
 MimmoObject::MimmoObject(int type, bitpit::PatchKernel* geometry){
     m_patch = NULL;
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
+    m_mapDataSync = false;
+    m_mapCellSync = false;
+    m_mapDataInvSync = false;
+    m_mapCellInvSync = false;
+    m_compact = false;
+    m_AdjBuilt = false;
+    m_boundarySync = false;
     setPatch(type,geometry);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
     m_log = &bitpit::log::cout(MIMMO_LOG_FILE);
 }
 
@@ -194,7 +260,7 @@ MimmoObject::MimmoObject(const MimmoObject & other){
 MimmoObject & MimmoObject::operator=(const MimmoObject & other){
     m_type 			= other.m_type;
     if(m_patch != NULL){
-        if (m_internalPatch)    delete m_patch;
+        if (m_internalPatch)    destroyPatch(m_patch);
         m_patch = NULL;
     }
     m_patch 		= other.m_patch;
@@ -205,6 +271,14 @@ MimmoObject & MimmoObject::operator=(const MimmoObject & other){
     m_mapDataInv	= other.m_mapDataInv;
     m_mapCellInv	= other.m_mapCellInv;
     m_pidsType		= other.m_pidsType;
+    m_mapDataSync   = other.m_mapDataSync;
+    m_mapCellSync   = other.m_mapCellSync;
+    m_mapDataInvSync = other.m_mapDataInvSync;
+    m_mapCellInvSync = other.m_mapCellInvSync;
+    m_compact       = other.m_compact;
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
     
     m_bvTreeSupported = other.m_bvTreeSupported;
     m_bvTreeBuilt   = other.m_bvTreeBuilt;
@@ -216,7 +290,11 @@ MimmoObject & MimmoObject::operator=(const MimmoObject & other){
     if(m_kdTreeBuilt)	buildKdTree();
 
     m_AdjBuilt = other.m_AdjBuilt;
+    m_boundarySync = false;
     
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
     m_log = &bitpit::log::cout(MIMMO_LOG_FILE);
     return *this;
 };
@@ -230,13 +308,24 @@ void
 MimmoObject::clear(){
     m_type=1;
     if(m_patch != NULL){
-        if (m_internalPatch)    delete m_patch;
+        if (m_internalPatch)    destroyPatch(m_patch);
         m_patch = NULL;
     }    
     m_mapData.clear();
     m_mapCell.clear();
     m_mapDataInv.clear();
     m_mapCellInv.clear();
+    m_mapDataDense.clear();
+    m_mapCellDense.clear();
+    for (auto & coords : m_coordsSoA)  coords.clear();
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
+    m_mapDataSync = true;
+    m_mapCellSync = true;
+    m_mapDataInvSync = true;
+    m_mapCellInvSync = true;
+    m_compact = false;
     m_pidsType.clear();
     m_bvTree.clean();
     cleanKdTree();
@@ -246,6 +335,7 @@ MimmoObject::clear(){
     m_bvTreeSync = false;
     m_kdTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
 
 };
 
@@ -439,11 +529,13 @@ MimmoObject::getPatch(){
 
 /*!
  * Return the indexing vertex map, to pass from local, compact indexing 
- * to bitpit::PatchKernel unique-labeled indexing
+ * to bitpit::PatchKernel unique-labeled indexing.
+ * The map is rebuilt on demand if it was released or not kept up to date (compact mode).
  * \return local/unique-id map
  */
 livector1D&
 MimmoObject::getMapData(){
+    if(!m_mapDataSync)     setMapData();
     return m_mapData;
 };
 
@@ -455,23 +547,30 @@ MimmoObject::getMapData(){
 long
 MimmoObject::getMapData(int i){
     if(i<0 || i>=getNVertex())	return -1;
+    if(!m_mapDataSync)     setMapData();
     return m_mapData[i];
 };
 
 
 /*!
  * Return the indexing vertex map, to pass from bitpit::PatchKernel unique-labeled indexing
- * to local, compact indexing;
+ * to local, compact indexing.
+ * The map is rebuilt on demand if it was released or not kept up to date (compact mode).
+ * Prefer getMapDataInv(long id) for single queries, which does not need this map in most cases.
  * \return unique-id/local map
  */
 liimap&
 MimmoObject::getMapDataInv(){
+    if(!m_mapDataSync)     setMapData();
+    if(!m_mapDataInvSync)  updateMapDataInv();
     return m_mapDataInv;
 };
 
 /*!
  * Return the const reference to the indexing vertex map, to pass from 
  * bitpit::PatchKernel unique-labeled indexing to local, compact indexing.
+ * The map cannot be rebuilt on demand from a const object: in compact mode or
+ * after releaseIndexMaps() it may be empty.
  * \return unique-id/local map as const reference
  */
 const liimap&
@@ -480,24 +579,37 @@ MimmoObject::getMapDataInv()const{
 };
 
 /*!
- * Return the local compact index i of a vertex, given its unique id label. 
+ * Return the local compact index i of a vertex, given its unique id label.
+ * The dense inverse map is used if available (see getMapDataDense), so that no
+ * search is performed. The first call after a topology change rebuilds the dense map,
+ * hence it is not safe to be performed inside a parallel region, unless the maps are
+ * synchronized first (see syncIndexMaps).
  * \param[in] id unique-id of the vertex.
  * \return local index of the vertex. Return -1 if index is not found.
  */
 int
 MimmoObject::getMapDataInv(long id){
-    if(!(getVertices().exists(id)))	return -1;
-    return m_mapDataInv[id];
+    if(!m_mapDataDenseSync)    updateMapDataDense();
+    if(!m_mapDataDense.empty()){
+        if(id < 0 || id >= long(m_mapDataDense.size()))   return -1;
+        return m_mapDataDense[id];
+    }
+    if(!m_mapDataInvSync)  updateMapDataInv();
+    liimap::const_iterator it = m_mapDataInv.find(id);
+    if(it == m_mapDataInv.end())  return -1;
+    return it->second;
 };
 
 
 /*!
  * Return the indexing cell map, to pass from local, compact indexing 
- * to bitpit::PatchKernel unique-labeled indexing
+ * to bitpit::PatchKernel unique-labeled indexing.
+ * The map is rebuilt on demand if it was released or not kept up to date (compact mode).
  * \return local/unique-id map
  */
 livector1D&
 MimmoObject::getMapCell(){
+    if(!m_mapCellSync)     setMapCell();
     return m_mapCell;
 };
 
@@ -509,28 +621,94 @@ MimmoObject::getMapCell(){
 long
 MimmoObject::getMapCell(int i){
     if(i<0 || i>=getNCells())	return -1;
+    if(!m_mapCellSync)     setMapCell();
     return m_mapCell[i];
 };
 
 /*!
  * Return the indexing cell map, to pass from bitpit::PatchKernel unique-labeled indexing
- * to local, compact indexing;
+ * to local, compact indexing.
+ * The map is rebuilt on demand if it was released or not kept up to date (compact mode).
+ * Prefer getMapCellInv(long id) for single queries, which does not need this map in most cases.
  * \return unique-id/local map
  */
 liimap&
 MimmoObject::getMapCellInv(){
+    if(!m_mapCellSync)     setMapCell();
+    if(!m_mapCellInvSync)  updateMapCellInv();
     return m_mapCellInv;
 };
 
 /*!
- * Return the local compact index i of a cell, given its unique id label. 
+ * Return the local compact index i of a cell, given its unique id label.
+ * The dense inverse map is used if available (see getMapCellDense), so that no
+ * search is performed. The first call after a topology change rebuilds the dense map,
+ * hence it is not safe to be performed inside a parallel region, unless the maps are
+ * synchronized first (see syncIndexMaps).
  * \param[in] id unique-id of the cell.
  * \return local index of the cell. Return -1 if index is not found.
  */
 int
 MimmoObject::getMapCellInv(long id){
-    if(!(getCells().exists(id)))	return -1;
-    return m_mapCellInv[id];
+    if(!m_mapCellDenseSync)    updateMapCellDense();
+    if(!m_mapCellDense.empty()){
+        if(id < 0 || id >= long(m_mapCellDense.size()))   return -1;
+        return m_mapCellDense[id];
+    }
+    if(!m_mapCellInvSync)  updateMapCellInv();
+    liimap::const_iterator it = m_mapCellInv.find(id);
+    if(it == m_mapCellInv.end())  return -1;
+    return it->second;
+};
+
+/*!
+ * Return the dense inverse vertex map, i.e. a vector indexed directly by vertex unique-id
+ * and storing the local compact index of the vertex, or -1 for unused ids.
+ * The map is built on demand and kept until the next change of the vertex list.
+ * If the vertex ids are too sparse to be stored densely the returned vector is empty
+ * and getMapDataInv(long id) falls back on the search map.
+ * \return dense unique-id/local map
+ */
+const ivector1D &
+MimmoObject::getMapDataDense(){
+    if(!m_mapDataDenseSync)    updateMapDataDense();
+    return m_mapDataDense;
+};
+
+/*!
+ * Return the dense inverse cell map, i.e. a vector indexed directly by cell unique-id
+ * and storing the local compact index of the cell, or -1 for unused ids.
+ * The map is built on demand and kept until the next change of the cell list.
+ * If the cell ids are too sparse to be stored densely the returned vector is empty
+ * and getMapCellInv(long id) falls back on the search map.
+ * \return dense unique-id/local map
+ */
+const ivector1D &
+MimmoObject::getMapCellDense(){
+    if(!m_mapCellDenseSync)    updateMapCellDense();
+    return m_mapCellDense;
+};
+
+/*!
+ * Return the vertex coordinates as a structure of arrays: the j-th array holds
+ * the j-th coordinate of all vertices, in local compact ordering.
+ * The view is built on demand, it is kept up to date by modifyVertex and
+ * applyDisplacements and it is rebuilt only after a change of the vertex list.
+ * Vertices moved directly on the linked bitpit::PatchKernel are not tracked.
+ * \return coordinates of mesh vertices, one array per direction
+ */
+const std::array<dvector1D,3> &
+MimmoObject::getVertexCoordsSoA(){
+    if(!m_coordsSoASync)   updateVertexCoordsSoA();
+    return m_coordsSoA;
+};
+
+/*!
+ * \return true if the class is in compact, memory-lean mode (see setCompact).
+ */
+bool
+MimmoObject::isCompact(){
+    return m_compact;
 };
 
 /*!
@@ -605,7 +783,7 @@ MimmoObject::isKdTreeBuilt(){
 /*!
  * \return pointer to geometry KdTree internal structure
  */
-bitpit::KdTree<3, bitpit::Vertex, long >*
+KdTree*
 MimmoObject::getKdTree(){
     return &m_kdTree;
 }
@@ -653,6 +831,10 @@ MimmoObject::setVertices(const bitpit::PiercedVector<bitpit::Vertex> & vertices)
     
     m_mapData.clear();
     m_mapDataInv.clear();
+    m_mapDataSync = true;
+    m_mapDataInvSync = !m_compact;
+    m_mapDataDenseSync = false;
+    m_coordsSoASync = false;
     m_patch->resetVertices();
     
     int sizeVert = vertices.size();
@@ -698,13 +880,21 @@ MimmoObject::addVertex(const darray3E & vertex, const long idtag){
         checkedID = idtag;
     }
     
-    m_mapData.push_back(checkedID);
-    m_mapDataInv[checkedID] = m_mapData.size()-1;
+    if(!m_compact && m_mapDataSync){
+        m_mapData.push_back(checkedID);
+        if(m_mapDataInvSync)    m_mapDataInv[checkedID] = m_mapData.size()-1;
+    }else{
+        m_mapDataSync = false;
+        m_mapDataInvSync = false;
+    }
+    m_mapDataDenseSync = false;
+    m_coordsSoASync = false;
     m_bvTreeBuilt = false;
     m_kdTreeBuilt = false;
     m_bvTreeSync = false;
     m_kdTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
     return true;
 };
 
@@ -721,6 +911,56 @@ MimmoObject::modifyVertex(const darray3E & vertex, long id){
     if(!(getVertices().exists(id)))	return false;
     bitpit::Vertex &vert = m_patch->getVertex(id);
     vert.setCoords(vertex);
+    if(m_coordsSoASync){
+        int idx = getMapDataInv(id);
+        if(idx >= 0){
+            for (int j=0; j<3; ++j)    m_coordsSoA[j][idx] = vertex[j];
+        }
+    }
+    m_bvTreeSync = false;
+    m_kdTreeSync = false;
+    return true;
+};
+
+/*!
+ * It applies a displacement field to the vertices of the geometry in a single call.
+ * The i-th displacement is added to the coordinates of the vertex with local index i
+ * (see getMapData), i.e. the vertices are visited in the order of their storage,
+ * without any search by unique-id. If the displacements are less than the vertices,
+ * only the first vertices are moved; exceeding displacements are ignored.
+ * The update is performed in parallel if mimmo is compiled with OpenMP support, and
+ * the search trees are marked as not synchronized once at the end. The structure-of-arrays
+ * coordinates (see getVertexCoordsSoA), if present, are updated too.
+ * \param[in] displacements displacement of each vertex, in local index order.
+ * \return false if no geometry is present.
+ */
+bool
+MimmoObject::applyDisplacements(const dvecarr3E & displacements){
+    if (isEmpty()) return false;
+    long nv = std::min(long(getNVertex()), long(displacements.size()));
+    if (nv == 0) return true;
+
+    std::vector<bitpit::Vertex*> vertices(nv);
+    long count = 0;
+    for (auto & vertex : m_patch->getVertices()){
+        if (count == nv) break;
+        vertices[count] = &vertex;
+        ++count;
+    }
+
+    bool soa = m_coordsSoASync;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long i=0; i<nv; ++i){
+        darray3E coords = vertices[i]->getCoords();
+        coords += displacements[i];
+        vertices[i]->setCoords(coords);
+        if(soa){
+            for (int j=0; j<3; ++j)    m_coordsSoA[j][i] = coords[j];
+        }
+    }
+
     m_bvTreeSync = false;
     m_kdTreeSync = false;
     return true;
@@ -742,6 +982,9 @@ MimmoObject::setCells(const bitpit::PiercedVector<Cell> & cells){
 
     m_mapCell.clear();
     m_mapCellInv.clear();
+    m_mapCellSync = true;
+    m_mapCellInvSync = !m_compact;
+    m_mapCellDenseSync = false;
     m_pidsType.clear();
 
     getPatch()->resetCells();
@@ -816,11 +1059,18 @@ MimmoObject::addConnectedCell(const livector1D & conn, bitpit::ElementInfo::Type
     m_pidsType.insert(0);		
     
     //create inverse map of cells
-    m_mapCell.push_back(checkedID);
-    m_mapCellInv[checkedID] = m_mapCell.size()-1;
+    if(!m_compact && m_mapCellSync){
+        m_mapCell.push_back(checkedID);
+        if(m_mapCellInvSync)    m_mapCellInv[checkedID] = m_mapCell.size()-1;
+    }else{
+        m_mapCellSync = false;
+        m_mapCellInvSync = false;
+    }
+    m_mapCellDenseSync = false;
     m_bvTreeBuilt = false;
     m_bvTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
     return true;
 };
 
@@ -865,11 +1115,18 @@ MimmoObject::addConnectedCell(const livector1D & conn, bitpit::ElementInfo::Type
     
     setPIDCell(checkedID, PID);
     //create inverse map of cells
-    m_mapCell.push_back(checkedID);
-    m_mapCellInv[checkedID] = m_mapCell.size()-1;
+    if(!m_compact && m_mapCellSync){
+        m_mapCell.push_back(checkedID);
+        if(m_mapCellInvSync)    m_mapCellInv[checkedID] = m_mapCell.size()-1;
+    }else{
+        m_mapCellSync = false;
+        m_mapCellInvSync = false;
+    }
+    m_mapCellDenseSync = false;
     m_bvTreeBuilt = false;
     m_bvTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
     return true;
 };
 
@@ -889,24 +1146,34 @@ MimmoObject::setPatch(int type, PatchKernel* geometry){
     m_type 			= type;
     
     if(m_patch != NULL){
-        if (m_internalPatch)    delete m_patch;
+        if (m_internalPatch)    destroyPatch(m_patch);
         m_patch = NULL;
     }    
     m_patch 		= geometry;
     m_internalPatch = false;
     
-    setMapData();
+    m_mapDataSync = false;
+    m_mapCellSync = false;
+    m_mapDataInvSync = false;
+    m_mapCellInvSync = false;
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
+    m_boundarySync = false;
+    if(!m_compact)  setMapData();
 
     m_pidsType.clear();
 
     if(m_patch->getCellCount() != 0){
         m_bvTreeSupported = true;
         m_bvTree.setPatch(m_patch);
+        if(!m_compact)  setMapCell();
         
         for(auto & cell : geometry->getCells()){
             m_pidsType.insert(cell.getPID());
         }
         m_AdjBuilt = false;
+        m_boundarySync = false;
     }	
     m_bvTreeBuilt = false;
     m_kdTreeBuilt = false;
@@ -917,6 +1184,8 @@ MimmoObject::setPatch(int type, PatchKernel* geometry){
 
 /*!
  * It builds the vertex map of local/unique-id indexing and its inverse.
+ * In compact mode the inverse search map is not built; it is created on demand
+ * by getMapDataInv() only.
  * \return false if no geometry is present in the class.
  */
 bool
@@ -929,20 +1198,26 @@ MimmoObject::setMapData(){
     m_mapData.clear();
     m_mapData.resize(nv);
     m_mapDataInv.clear();
+    m_mapDataDenseSync = false;
+    m_coordsSoASync = false;
     
     PatchKernel::VertexIterator it;
     PatchKernel::VertexIterator itend = m_patch->vertexEnd();
     int i = 0;
     for (it = m_patch->vertexBegin(); it != itend; ++it){
         m_mapData[i] = it->getId();
-        m_mapDataInv[ it->getId()] = i;
         i++;
     }
+    m_mapDataSync = true;
+    m_mapDataInvSync = false;
+    if(!m_compact)  updateMapDataInv();
     return true;
 };
 
 /*!
  * It builds the cell map of local/unique-id indexing and its inverse.
+ * In compact mode the inverse search map is not built; it is created on demand
+ * by getMapCellInv() only.
  * \return false if no geometry is present in the class.
  */
 bool
@@ -953,6 +1228,7 @@ MimmoObject::setMapCell(){
     m_mapCell.clear();
     m_mapCell.resize(getNCells());
     m_mapCellInv.clear();
+    m_mapCellDenseSync = false;
     
     PatchKernel::CellIterator it;
     PatchKernel::CellIterator itend = m_patch->cellEnd();
@@ -960,12 +1236,89 @@ MimmoObject::setMapCell(){
     int i = 0;
     for (it = m_patch->cellBegin(); it != itend; ++it){
         m_mapCell[i] = it->getId();
-        m_mapCellInv[ it->getId()] = i;
         i++;
     }
+    m_mapCellSync = true;
+    m_mapCellInvSync = false;
+    if(!m_compact)  updateMapCellInv();
     return true;
 };
 
+/*!
+ * Set the compact, memory-lean mode of the class.
+ * In compact mode the local/unique-id maps of vertices and cells are not updated
+ * while vertices and cells are added, and the inverse search maps are never built
+ * unless explicitly requested through getMapDataInv() or getMapCellInv().
+ * All maps are rebuilt on demand by their getters, so the mode is transparent to
+ * the callers. Switching to compact mode frees the inverse search maps already stored.
+ * \param[in] compact true to activate compact mode.
+ */
+void
+MimmoObject::setCompact(bool compact){
+    m_compact = compact;
+    if(m_compact){
+        liimap().swap(m_mapDataInv);
+        liimap().swap(m_mapCellInv);
+        m_mapDataInvSync = false;
+        m_mapCellInvSync = false;
+    }
+};
+
+/*!
+ * Release the memory held by the local/unique-id maps of vertices and cells, by their inverse
+ * maps (search and dense ones) and by the structure-of-arrays view of vertex coordinates.
+ * Everything released is rebuilt on demand by the related getters, hence this method
+ * can be safely called as soon as no one needs the maps anymore.
+ * Optionally, the search trees can be released too; in that case they have to be
+ * built again (see isBvTreeBuilt and isKdTreeBuilt) before being used.
+ * \param[in] releaseTrees if true, release BvTree and KdTree too.
+ */
+void
+MimmoObject::releaseIndexMaps(bool releaseTrees){
+    livector1D().swap(m_mapData);
+    livector1D().swap(m_mapCell);
+    liimap().swap(m_mapDataInv);
+    liimap().swap(m_mapCellInv);
+    ivector1D().swap(m_mapDataDense);
+    ivector1D().swap(m_mapCellDense);
+    for (auto & coords : m_coordsSoA)  dvector1D().swap(coords);
+    m_mapDataSync = false;
+    m_mapCellSync = false;
+    m_mapDataInvSync = false;
+    m_mapCellInvSync = false;
+    m_mapDataDenseSync = false;
+    m_mapCellDenseSync = false;
+    m_coordsSoASync = false;
+
+    if(releaseTrees){
+        m_bvTree.clean();
+        cleanKdTree();
+        m_bvTreeBuilt = false;
+        m_kdTreeBuilt = false;
+        m_bvTreeSync = false;
+        m_kdTreeSync = false;
+    }
+};
+
+/*!
+ * Synchronize the local/unique-id maps of vertices and cells, their inverse maps and the
+ * structure-of-arrays view of vertex coordinates with the current geometry. Their getters
+ * do not rebuild them afterwards, hence they can be called concurrently (e.g. inside a
+ * parallel region) until the geometry is modified. In compact mode the inverse search maps
+ * are built only if the ids are too sparse for the dense inverse maps.
+ */
+void
+MimmoObject::syncIndexMaps(){
+    if(isEmpty())   return;
+    getMapData();
+    if(getMapDataDense().empty() || !m_compact)  getMapDataInv();
+    if(m_bvTreeSupported){
+        getMapCell();
+        if(getMapCellDense().empty() || !m_compact)  getMapCellInv();
+    }
+    getVertexCoordsSoA();
+};
+
 /*!
  * Set PIDs for all geometry cells available. 
  * The PID list must be referred to the compact local/indexing of the cells in the class.
@@ -1041,14 +1394,7 @@ void MimmoObject::setHARDCopy(const MimmoObject * other){
     m_type 			= other->m_type;
     
     m_internalPatch = true;
-    const int id = 0;
-    if (m_type == 2){
-        m_patch = new VolUnstructured(id, 3);
-        dynamic_cast<VolUnstructured*> (m_patch)->setExpert(true);
-    }else{
-        m_patch = new SurfUnstructured(id);
-        dynamic_cast<SurfUnstructured*> (m_patch)->setExpert(true);
-    }
+    m_patch = createPatch(m_type);
     
     //copy data 
     const bitpit::PiercedVector<bitpit::Vertex> & pvert = other->getVertices();
@@ -1058,16 +1404,30 @@ void MimmoObject::setHARDCopy(const MimmoObject * other){
     m_bvTreeBuilt	= other->m_bvTreeBuilt;
     m_kdTreeBuilt   = other->m_kdTreeBuilt;
     
+    //trees synchronized with the argument are valid for the copy (same ids and coordinates), others are rebuilt.
     if(m_bvTreeSupported){
         const bitpit::PiercedVector<bitpit::Cell> & pcell = other->getCells();
         setCells(pcell);
-        if(m_bvTreeBuilt)	buildBvTree();
+        if(m_bvTreeBuilt && other->m_bvTreeSync){
+            m_bvTree = other->m_bvTree;
+            m_bvTree.m_patch = m_patch;
+        }else if(m_bvTreeBuilt){
+            m_bvTreeBuilt = false;
+            buildBvTree();
+        }
     }	
-    if(m_kdTreeBuilt)	buildKdTree();
+    if(m_kdTreeBuilt && other->m_kdTreeSync){
+        m_kdTree = other->m_kdTree;
+        m_kdTree.m_patch = m_patch;
+    }else if(m_kdTreeBuilt){
+        m_kdTreeBuilt = false;
+        buildKdTree();
+    }
     m_bvTreeSync = true;
     m_kdTreeSync = true;
 
     m_AdjBuilt = other->m_AdjBuilt;;
+    m_boundarySync = false;
 
     //it's all copied(maps are update in the loops, pids if exists), trees are rebuilt and sync'ed is they must be
 };
@@ -1089,6 +1449,7 @@ MimmoObject::cleanGeometry(){
     m_bvTreeSync = false;
     m_bvTreeSync = false;
     m_AdjBuilt = false;
+    m_boundarySync = false;
     return true;
 };
 
@@ -1236,12 +1597,14 @@ livector1D MimmoObject::convertLocalToCellID(ivector1D cList){
 
 /*!
  * Extract vertices at the mesh boundaries, if any.
+ * The list is cached and extracted again only after a change of the mesh topology.
  * \return list of vertex unique-ids.
  */
 livector1D 	MimmoObject::extractBoundaryVertexID(){
     
     if(isEmpty())	return livector1D(0);
-    getPatch()->buildAdjacencies();
+    if(m_boundarySync)  return m_boundaryVertices;
+    if(!areAdjacenciesBuilt())  buildAdjacencies();
     
     std::unordered_set<long> container;
     std::unordered_set<long>::iterator it;
@@ -1270,6 +1633,8 @@ livector1D 	MimmoObject::extractBoundaryVertexID(){
         result[counter] = *it;
         ++counter;
     }
+    m_boundaryVertices = result;
+    m_boundarySync = true;
     return result;
 };
 
@@ -1355,11 +1720,17 @@ void MimmoObject::getBoundingBox(std::array<double,3> & pmin, std::array<double,
 
 /*!
  * Reset and build again simplex bvTree of your geometry (if supports connectivity elements).
- *\param[in] value build the minimum leaf of the tree as a bounding box containing value elements at most.
+ *\param[in] value build the minimum leaf of the tree as a bounding box containing value elements at most (default 4).
  */
 void MimmoObject::buildBvTree(int value){
     if(!m_bvTreeSupported || m_patch == NULL)	return;
     
+    //only vertex coordinates are changed since last build: try to refit the tree
+    if (m_bvTreeBuilt && !m_bvTreeSync && value == m_bvTree.m_maxsize){
+        updateBvTree();
+        return;
+    }
+
     if (!m_bvTreeBuilt || !m_bvTreeSync){
         m_bvTree.clean();
         m_bvTree.setup();
@@ -1371,23 +1742,46 @@ void MimmoObject::buildBvTree(int value){
     return;
 }
 
+/*!
+ * Update the simplex bvTree of your geometry after a modification of the vertex coordinates
+ * (see modifyVertex), without changes of the cells. The tree is refitted to the new coordinates
+ * keeping its structure; if the refitted tree is degraded beyond the tolerance of the tree
+ * (see BvTree::setRefitTolerance) it is built again from scratch.
+ * If the tree is not built yet, it is built.
+ */
+void MimmoObject::updateBvTree(){
+    if(!m_bvTreeSupported || m_patch == NULL)	return;
+
+    if (!m_bvTreeBuilt){
+        buildBvTree();
+        return;
+    }
+    if (m_bvTreeSync) return;
+
+    if (!m_bvTree.refitTree()){
+        int maxsize = m_bvTree.m_maxsize;
+        m_bvTree.clean();
+        m_bvTree.setup();
+        m_bvTree.setMaxLeafSize(maxsize);
+        m_bvTree.buildTree();
+    }
+    m_bvTreeSync = true;
+    return;
+}
+
 /*!
  * Reset and build again vertex kdTree of your geometry.
+ * The tree is balanced and bucketed; it is built in parallel if mimmo is compiled
+ * with OpenMP support.
  */
 void MimmoObject::buildKdTree(){
     if( m_patch == NULL)	return;
-    long label;
     
-    if (!m_kdTreeBuilt || !m_bvTreeSync){
-        cleanKdTree();
-        m_kdTree.nodes.resize(getNVertex() + m_kdTree.MAXSTK);
-        
-        for(auto & val : getVertices()){
-            label = val.getId();
-            m_kdTree.insert(&val, label);
-        }
+    if (!m_kdTreeBuilt || !m_kdTreeSync){
+        m_kdTree.setPatch(m_patch);
+        m_kdTree.buildTree();
         m_kdTreeBuilt = true;
-        m_bvTreeSync = true;
+        m_kdTreeSync = true;
     }
     return;
 }
@@ -1396,8 +1790,83 @@ void MimmoObject::buildKdTree(){
  * Clean the KdTree of the class
  */
 void	MimmoObject::cleanKdTree(){
-    m_kdTree.n_nodes = 0;
-    m_kdTree.nodes.clear();
+    m_kdTree.clean();
+}
+
+/*!
+ * Build the inverse search vertex map from the local/unique-id vertex map.
+ */
+void	MimmoObject::updateMapDataInv(){
+    m_mapDataInv.clear();
+    long nv = m_mapData.size();
+    for (long i=0; i<nv; ++i)  m_mapDataInv[m_mapData[i]] = i;
+    m_mapDataInvSync = true;
+}
+
+/*!
+ * Build the inverse search cell map from the local/unique-id cell map.
+ */
+void	MimmoObject::updateMapCellInv(){
+    m_mapCellInv.clear();
+    long nc = m_mapCell.size();
+    for (long i=0; i<nc; ++i)  m_mapCellInv[m_mapCell[i]] = i;
+    m_mapCellInvSync = true;
+}
+
+/*!
+ * Build the dense inverse vertex map from the local/unique-id vertex map.
+ * Unique-ids are stored densely only if the greatest id does not exceed
+ * four times the number of vertices (plus a fixed margin); otherwise the dense
+ * map is left empty.
+ */
+void	MimmoObject::updateMapDataDense(){
+    if(!m_mapDataSync)     setMapData();
+    m_mapDataDense.clear();
+    long maxId = -1;
+    for (const auto & id : m_mapData)  maxId = std::max(maxId, id);
+    long nv = m_mapData.size();
+    if(maxId < 4*nv + 1024){
+        m_mapDataDense.resize(maxId+1, -1);
+        for (long i=0; i<nv; ++i)  m_mapDataDense[m_mapData[i]] = i;
+    }
+    m_mapDataDenseSync = true;
+}
+
+/*!
+ * Build the dense inverse cell map from the local/unique-id cell map.
+ * Unique-ids are stored densely only if the greatest id does not exceed
+ * four times the number of cells (plus a fixed margin); otherwise the dense
+ * map is left empty.
+ */
+void	MimmoObject::updateMapCellDense(){
+    if(!m_mapCellSync)     setMapCell();
+    m_mapCellDense.clear();
+    long maxId = -1;
+    for (const auto & id : m_mapCell)  maxId = std::max(maxId, id);
+    long nc = m_mapCell.size();
+    if(maxId < 4*nc + 1024){
+        m_mapCellDense.resize(maxId+1, -1);
+        for (long i=0; i<nc; ++i)  m_mapCellDense[m_mapCell[i]] = i;
+    }
+    m_mapCellDenseSync = true;
+}
+
+/*!
+ * Copy the vertex coordinates in the structure-of-arrays view, in local compact ordering.
+ */
+void	MimmoObject::updateVertexCoordsSoA(){
+    long nv = 0;
+    if(!isEmpty())  nv = getNVertex();
+    for (auto & coords : m_coordsSoA)  coords.resize(nv);
+    if(nv > 0){
+        long i = 0;
+        for (auto & vertex : m_patch->getVertices()){
+            const std::array<double,3> & coords = vertex.getCoords();
+            for (int j=0; j<3; ++j)    m_coordsSoA[j][i] = coords[j];
+            ++i;
+        }
+    }
+    m_coordsSoASync = true;
 }
 
 /*!
@@ -1457,6 +1926,172 @@ void MimmoObject::buildAdjacencies(){
     m_AdjBuilt = true;
 };
 
+/*!
+ * \param[in] structure type of acceleration structure, see GeometryStructure enum.
+ * \return true if the acceleration structure is built and synchronized with the current geometry.
+ * Structures not supported by the current geometry (e.g. BvTree of point clouds) are reported as built,
+ * since there is nothing to build.
+ */
+bool MimmoObject::isStructureBuilt(GeometryStructure structure){
+    switch(structure){
+        case GeometryStructure::BVTREE:
+            return (!m_bvTreeSupported || isBvTreeBuilt());
+        case GeometryStructure::KDTREE:
+            return isKdTreeBuilt();
+        case GeometryStructure::ADJACENCIES:
+            return (!m_bvTreeSupported || areAdjacenciesBuilt());
+        case GeometryStructure::BOUNDARY:
+            return (!m_bvTreeSupported || m_boundarySync);
+        default:
+            return true;
+    }
+};
+
+/*!
+ * Build an acceleration structure of the geometry, if not already built and
+ * synchronized with the current geometry. Each structure is thus built at most once
+ * between two modifications of the geometry: BvTree is refitted if only the vertex
+ * coordinates are changed (see updateBvTree), the other structures are rebuilt.
+ * The building is serialized, so that the method can be safely called by
+ * blocks executed concurrently on the same geometry.
+ * \param[in] structure type of acceleration structure, see GeometryStructure enum.
+ */
+void MimmoObject::buildStructure(GeometryStructure structure){
+    if(isEmpty())   return;
+    std::lock_guard<std::mutex> lock(m_structuresMutex);
+    if(isStructureBuilt(structure)) return;
+    switch(structure){
+        case GeometryStructure::BVTREE:
+            buildBvTree();
+            break;
+        case GeometryStructure::KDTREE:
+            buildKdTree();
+            break;
+        case GeometryStructure::ADJACENCIES:
+            buildAdjacencies();
+            break;
+        case GeometryStructure::BOUNDARY:
+            extractBoundaryVertexID();
+            break;
+        default:
+            break;
+    }
+};
+
+/*!
+ * Build a set of acceleration structures of the geometry, see buildStructure.
+ * \param[in] structures types of acceleration structures, see GeometryStructure enum.
+ */
+void MimmoObject::buildStructures(const std::set<GeometryStructure> & structures){
+    for (GeometryStructure structure : structures)  buildStructure(structure);
+};
+
+/*!
+ * \return hash of a unique id, used for the checksums of the geometry signature.
+ * \param[in] id unique id
+ */
+static inline uint64_t hashStructureId(long id){
+    uint64_t x = uint64_t(id) + UINT64_C(0x9E3779B97F4A7C15);
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+}
+
+/*!
+ * Evaluate the signature of a patch written along with its acceleration structures:
+ * number of cells, number of vertices, checksums of the cell and vertex unique ids and
+ * checksum of the vertex coordinates (bit patterns hashed together with the vertex id).
+ * The checksums do not depend on the storage order of cells and vertices.
+ * \param[in] patch target patch
+ * \param[out] signature signature of the patch
+ */
+static void evalStructureSignature(bitpit::PatchKernel * patch, uint64_t signature[5]){
+    signature[0] = uint64_t(patch->getCellCount());
+    signature[1] = uint64_t(patch->getVertexCount());
+    signature[2] = 0;
+    signature[3] = 0;
+    signature[4] = 0;
+    for (const auto & cell : patch->getCells())         signature[2] += hashStructureId(cell.getId());
+    for (const auto & vertex : patch->getVertices()){
+        uint64_t hash = hashStructureId(vertex.getId());
+        signature[3] += hash;
+        const darray3E & coords = vertex.getCoords();
+        for (int i=0; i<3; ++i){
+            uint64_t bits;
+            std::memcpy(&bits, &coords[i], sizeof(bits));
+            hash = hashStructureId(long(hash ^ bits));
+        }
+        signature[4] += hash;
+    }
+}
+
+/*!
+ * Write an acceleration structure of the geometry in binary form, to be restored
+ * later on the same geometry (see restoreStructure). Only search trees (BVTREE, KDTREE)
+ * can be written, and only if they are built and synchronized with the geometry.
+ * The structure is preceded by the signature of the geometry (number of cells and vertices,
+ * checksums of their unique ids and of the vertex coordinates), checked when the structure is restored.
+ * \param[in] structure type of acceleration structure, see GeometryStructure enum.
+ * \param[in] out output stream
+ * \return false if the structure is not written.
+ */
+bool MimmoObject::dumpStructure(GeometryStructure structure, std::ostream & out){
+    switch(structure){
+        case GeometryStructure::BVTREE:
+            if(!isBvTreeBuilt())    return false;
+            break;
+        case GeometryStructure::KDTREE:
+            if(!isKdTreeBuilt())    return false;
+            break;
+        default:
+            return false;
+    }
+    uint64_t signature[5];
+    evalStructureSignature(m_patch, signature);
+    out.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+    if(structure == GeometryStructure::BVTREE)  m_bvTree.dump(out);
+    else                                        m_kdTree.dump(out);
+    return true;
+};
+
+/*!
+ * Read an acceleration structure of the geometry written by dumpStructure.
+ * The geometry must be the same (same ids and coordinates) the structure was written for:
+ * the number of cells and vertices and the checksums of their unique ids and of the vertex
+ * coordinates are checked against
+ * the ones written with the structure. The structure is then marked as built and synchronized
+ * with the geometry.
+ * \param[in] structure type of acceleration structure, see GeometryStructure enum.
+ * \param[in] in input stream
+ * \return false if the structure cannot be restored.
+ */
+bool MimmoObject::restoreStructure(GeometryStructure structure, std::istream & in){
+    if(isEmpty())   return false;
+    std::lock_guard<std::mutex> lock(m_structuresMutex);
+    uint64_t signature[5], current[5];
+    in.read(reinterpret_cast<char *>(signature), sizeof(signature));
+    if(!in.good())  return false;
+    evalStructureSignature(m_patch, current);
+    for(int i=0; i<5; ++i){
+        if(signature[i] != current[i])  return false;
+    }
+    switch(structure){
+        case GeometryStructure::BVTREE:
+            if(!m_bvTreeSupported)  return false;
+            m_bvTree.setPatch(m_patch);
+            m_bvTreeBuilt = m_bvTree.restore(in);
+            m_bvTreeSync = m_bvTreeBuilt;
+            return m_bvTreeBuilt;
+        case GeometryStructure::KDTREE:
+            m_kdTree.setPatch(m_patch);
+            m_kdTreeBuilt = m_kdTree.restore(in);
+            m_kdTreeSync = m_kdTreeBuilt;
+            return m_kdTreeBuilt;
+        default:
+            return false;
+    }
+};
+
 /*!
  * Desume Element type of your current mesh. 
  * Please note MimmoObject is handling meshes with homogeneous elements.
@@ -29,11 +29,26 @@
 #include "bitpit_surfunstructured.hpp"
 #include "bitpit_SA.hpp"
 #include "BvTree.hpp"
+#include "KdTree.hpp"
 #include "mimmoTypeDef.hpp"
 #include "MimmoNamespace.hpp"
+#include <mutex>
+#include <set>
 
 namespace mimmo{
 
+/*!
+ * \enum GeometryStructure
+ * \ingroup core
+ * \brief Identifies the acceleration structures of a MimmoObject which can be built on demand
+ */
+enum class GeometryStructure{
+    BVTREE      /**< Bounding volume tree of the cells.*/,
+    KDTREE      /**< Kd-tree of the vertices.*/,
+    ADJACENCIES /**< Cell-cell adjacencies.*/,
+    BOUNDARY    /**< List of the vertices on the mesh boundaries.*/
+};
+
 /*!
  * \ingroup core
  */
@@ -59,12 +74,23 @@ protected:
     livector1D                              m_mapCell;         /**<Map of cell ids actually set, for aligning external cell data to bitpit::PatchKernel ordering*/ 
     liimap                                  m_mapDataInv;      /**<Inverse of Map of vertex ids actually set, for aligning external vertex data to bitpit::Patch ordering */
     liimap                                  m_mapCellInv;     /**<Inverse of Map of cell ids actually set, for aligning external vertex data to bitpit::Patch ordering */
+    ivector1D                               m_mapDataDense;    /**<Dense inverse of vertex Map, indexed directly by vertex unique-id (-1 for unused ids) */
+    ivector1D                               m_mapCellDense;    /**<Dense inverse of cell Map, indexed directly by cell unique-id (-1 for unused ids) */
+    bool                                    m_mapDataDenseSync; /**<False if dense vertex inverse Map needs to be rebuilt after topology changes */
+    bool                                    m_mapCellDenseSync; /**<False if dense cell inverse Map needs to be rebuilt after topology changes */
+    std::array<dvector1D,3>                 m_coordsSoA;       /**<Structure-of-arrays copy of vertex coordinates, in local compact ordering */
+    bool                                    m_coordsSoASync;   /**<False if structure-of-arrays coordinates need to be rebuilt after topology changes */
+    bool                                    m_mapDataSync;     /**<False if vertex Map needs to be rebuilt from the linked patch */
+    bool                                    m_mapCellSync;     /**<False if cell Map needs to be rebuilt from the linked patch */
+    bool                                    m_mapDataInvSync;  /**<False if inverse vertex search Map needs to be rebuilt */
+    bool                                    m_mapCellInvSync;  /**<False if inverse cell search Map needs to be rebuilt */
+    bool                                    m_compact;         /**<True if index Maps are built only on demand (memory-lean mode) */
 
     std::unordered_set<short>               m_pidsType;        /**<pid type available for your geometry */
 
     BvTree                                  m_bvTree;          /**< ordered tree of geometry simplicies for fast searching purposes */
     bool                                    m_bvTreeBuilt;     /**< track correct building of bvtree along with geometry modifications */
-    bitpit::KdTree<3,bitpit::Vertex,long>   m_kdTree;          /**< ordered tree of geometry vertices for fast searching purposes */
+    KdTree                                  m_kdTree;          /**< ordered tree of geometry vertices for fast searching purposes */
     bool                                    m_kdTreeBuilt;     /**< track correct building of kdtree along eith geometry modifications */
     bool                                    m_bvTreeSupported; /**< Flag for geometries not supporting bvTree building*/
 
@@ -73,6 +99,9 @@ protected:
     bool                                    m_kdTreeSync;    /**< set false if Bv tree is not sync'd with geometry modifications */
 
     bool                                    m_AdjBuilt;     /**< track correct building of adjacencies along with geometry modifications */
+    livector1D                              m_boundaryVertices; /**< cached list of boundary vertex unique-ids */
+    bool                                    m_boundarySync;  /**< false if the boundary vertex list needs to be extracted again */
+    std::mutex                              m_structuresMutex; /**< serializes on-demand building of acceleration structures */
 
     bitpit::Logger*                         m_log;          /**<Pointer to logger.*/
 
@@ -113,6 +142,10 @@ public:
     long                                            getMapCell(int i);
     liimap&                                         getMapCellInv();
     int                                             getMapCellInv(long id);
+    const ivector1D &                               getMapDataDense();
+    const ivector1D &                               getMapCellDense();
+    const std::array<dvector1D,3> &                 getVertexCoordsSoA();
+    bool                                            isCompact();
 
     std::unordered_set<short> &                     getPIDTypeList();
     shivector1D                                     getCompactPID();
@@ -121,7 +154,7 @@ public:
     bool                                            isBvTreeBuilt();
     BvTree*                                         getBvTree();
     bool                                            isKdTreeBuilt();
-    bitpit::KdTree<3, bitpit::Vertex, long> *       getKdTree();
+    KdTree *                                        getKdTree();
     bool                                            isBvTreeSync();
     bool                                            isKdTreeSync();
 
@@ -130,6 +163,7 @@ public:
     bool        setVertices(const bitpit::PiercedVector<bitpit::Vertex> & vertices);
     bool        addVertex(const darray3E & vertex, const long idtag = bitpit::Vertex::NULL_ID);
     bool        modifyVertex(const darray3E & vertex, long id);
+    bool        applyDisplacements(const dvecarr3E & displacements);
     bool        setCells(const bitpit::PiercedVector<bitpit::Cell> & cells);
     bool        addConnectedCell(const livector1D & locConn, bitpit::ElementInfo::Type type, long idtag = bitpit::Cell::NULL_ID);
     bool        addConnectedCell(const livector1D & locConn, bitpit::ElementInfo::Type type, short PID, long idtag = bitpit::Cell::NULL_ID);
@@ -137,6 +171,9 @@ public:
     bool        setPatch(int type, bitpit::PatchKernel* geometry);
     bool        setMapData();
     bool        setMapCell();
+    void        setCompact(bool compact);
+    void        releaseIndexMaps(bool releaseTrees = false);
+    void        syncIndexMaps();
 
     void        setPID(shivector1D ); 
     void        setPID(std::unordered_map<long, short>  ); 
@@ -159,11 +196,8 @@ public:
     livector1D  extractPIDCells(shivector1D);
 
     void        getBoundingBox(std::array<double,3> & pmin, std::array<double,3> & pmax);
-    void        buildBvTree(int value = 1);
+    void        buildBvTree(int value = 4);
     void        buildKdTree();
-    /*!
-     * Update BvTree (not available)
-     */
     void        updateBvTree();
     /*!
      * Update KdTree (not available)
@@ -172,6 +206,11 @@ public:
     void        buildAdjacencies();
 
     bool        areAdjacenciesBuilt();
+    bool        isStructureBuilt(GeometryStructure structure);
+    void        buildStructure(GeometryStructure structure);
+    void        buildStructures(const std::set<GeometryStructure> & structures);
+    bool        dumpStructure(GeometryStructure structure, std::ostream & out);
+    bool        restoreStructure(GeometryStructure structure, std::istream & in);
     bool        isClosedLoop();
     
     bitpit::VTKElementType	desumeElement();
@@ -179,6 +218,11 @@ public:
 private:
     int     checkCellType(bitpit::ElementInfo::Type type);
     void    cleanKdTree();
+    void    updateMapDataInv();
+    void    updateMapCellInv();
+    void    updateMapDataDense();
+    void    updateMapCellDense();
+    void    updateVertexCoordsSoA();
 };
 
 };
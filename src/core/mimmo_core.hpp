@@ -42,9 +42,11 @@
 #include "BasicMeshes.hpp"
 #include "BasicShapes.hpp"
 #include "BvTree.hpp"
+#include "CSRMatrix.hpp"
 #include "Chain.hpp"
 #include "InOut.hpp"
 #include "IOConnections.hpp"
+#include "KdTree.hpp"
 #include "Lattice.hpp"
 #include "MimmoNamespace.hpp"
 #include "MimmoObject.hpp"
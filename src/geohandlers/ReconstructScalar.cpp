@@ -266,13 +266,7 @@ ReconstructScalar::plotData(std::string dir, std::string name, bool flag, int co
 
     output.addData("field", bitpit::VTKFieldType::SCALAR, bitpit::VTKLocation::POINT, m_result);
 
-    std::vector<long> ids(points.size());
-    long ID;
-    auto convMap = getGeometry()->getMapDataInv(); 
-    for (auto vertex : getGeometry()->getVertices()){
-        ID = vertex.getId();
-        ids[convMap[ID]] = ID;
-    }
+    std::vector<long> ids = getGeometry()->getMapData();
 
     output.addData("ID", bitpit::VTKFieldType::SCALAR, bitpit::VTKLocation::POINT, ids);
 
@@ -292,7 +286,7 @@ ReconstructScalar::execute(){
 
     if(getGeometry() == NULL)    return;
 
-    liimap & vMotherMap = getGeometry()->getMapDataInv();
+    MimmoObject * geo = getGeometry();
 
     m_result.resize(getGeometry()->getPatch()->getVertexCount(), 0.0);
 
@@ -301,7 +295,7 @@ ReconstructScalar::execute(){
     std::unordered_map<long, dvector1D> map = checkOverlapping();
 
     for(auto && obj : map){
-        m_result[vMotherMap[obj.first]] = overlapFields(obj.second);
+        m_result[geo->getMapDataInv(obj.first)] = overlapFields(obj.second);
         obj.second.clear();
     }
 
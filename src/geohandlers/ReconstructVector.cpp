@@ -267,13 +267,7 @@ ReconstructVector::plotData(std::string dir, std::string name, bool flag, int co
 
     output.addData("vectorfield", bitpit::VTKFieldType::VECTOR, bitpit::VTKLocation::POINT, m_result);
 
-    std::vector<long> ids(points.size());
-    long ID;
-    auto convMap = getGeometry()->getMapDataInv();
-    for (auto vertex : getGeometry()->getVertices()){
-        ID = vertex.getId();
-        ids[convMap[ID]] = ID;
-    }
+    std::vector<long> ids = getGeometry()->getMapData();
 
     output.addData("ID", bitpit::VTKFieldType::SCALAR, bitpit::VTKLocation::POINT, ids);
 
@@ -293,14 +287,14 @@ void
 ReconstructVector::execute(){
     if(getGeometry() == NULL)    return;
 
-    liimap & vMotherMap = getGeometry()->getMapDataInv();
+    MimmoObject * geo = getGeometry();
 
     m_result.resize(getGeometry()->getPatch()->getVertexCount(), {{0.0,0.0,0.0}});
     if(m_subpatch.empty())    return;
     std::unordered_map<long, dvecarr3E > map = checkOverlapping();
 
     for(auto && obj : map){
-        m_result[vMotherMap[obj.first]] = overlapFields(obj.second);
+        m_result[geo->getMapDataInv(obj.first)] = overlapFields(obj.second);
         obj.second.clear();
     }
 
@@ -34,6 +34,7 @@ namespace mimmo{
  */
 SelectionByMapping::SelectionByMapping(int topo){
     m_name = "mimmo.SelectionByMapping";
+    requireStructure(GeometryStructure::BVTREE);
     m_type = SelectionType::MAPPING;
     m_tolerance = 1.E-08;
 
@@ -59,6 +60,7 @@ SelectionByMapping::SelectionByMapping(int topo){
 SelectionByMapping::SelectionByMapping(const bitpit::Config::Section & rootXML){
 
     m_name = "mimmo.SelectionByMapping";
+    requireStructure(GeometryStructure::BVTREE);
     m_type = SelectionType::MAPPING;
     m_tolerance = 1.E-08;
 
@@ -99,6 +101,7 @@ SelectionByMapping::SelectionByMapping(const bitpit::Config::Section & rootXML){
  */
 SelectionByMapping::SelectionByMapping(std::unordered_map<std::string, int> & geolist, MimmoObject * target, double tolerance){
     m_name = "mimmo.SelectionByMapping";
+    requireStructure(GeometryStructure::BVTREE);
     m_type = SelectionType::MAPPING;
     m_tolerance = 1.E-08;
 
@@ -288,7 +291,7 @@ SelectionByMapping::clear(){
 livector1D
 SelectionByMapping::extractSelection(){
 
-    if(!(getGeometry()->isBvTreeBuilt()))    getGeometry()->buildBvTree();
+    getGeometry()->buildStructure(GeometryStructure::BVTREE);
     std::set<long> cellList;
 
     for (auto && file : m_geolist){
@@ -366,7 +369,7 @@ SelectionByMapping::getProximity(std::pair<std::string, int> val){
 livector1D
 SelectionByMapping::getProximity(MimmoObject* obj){
 
-    obj->buildBvTree(true);
+    obj->buildStructure(GeometryStructure::BVTREE);
 
     if(obj->getNVertex() == 0 || obj->getNCells() == 0 ){
         m_log->setPriority(bitpit::log::NORMAL);
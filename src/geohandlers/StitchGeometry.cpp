@@ -312,8 +312,8 @@ StitchGeometry::execute(){
         }
     }//scope for optional vars;
 
-    if(m_buildBvTree)    dum->buildBvTree();
-    if(m_buildKdTree)    dum->buildKdTree();
+    if(m_buildBvTree)    dum->buildStructure(GeometryStructure::BVTREE);
+    if(m_buildKdTree)    dum->buildStructure(GeometryStructure::KDTREE);
 
     m_patch = std::move(dum);
 }
@@ -0,0 +1,382 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include "GeoMimmoInterface.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <streambuf>
+
+namespace mimmo{
+
+/*!
+ * Version of the geomimmo binary format.
+ */
+static const uint32_t GEOMIMMO_VERSION = 3;
+
+/*!
+ * Byte order mark of the geomimmo binary format.
+ */
+static const uint32_t GEOMIMMO_ENDIAN = 0x01020304;
+
+/*!
+ * Flag of the geomimmo header marking a BvTree stored in the file.
+ */
+static const uint32_t GEOMIMMO_BVTREE = 1;
+
+/*!
+ * Flag of the geomimmo header marking a KdTree stored in the file.
+ */
+static const uint32_t GEOMIMMO_KDTREE = 2;
+
+/*!
+ * Size of the blocks of data buffered by the geomimmo writer.
+ */
+static const std::size_t GEOMIMMO_WRITEBLOCK = 1 << 20;
+
+/*!
+ * \class GeoMimmoHeader
+ * \ingroup iogeneric
+ * \brief GeoMimmoHeader is the fixed size header of a geomimmo binary file.
+ */
+struct GeoMimmoHeader{
+    char        magic[8];       /**< magic string "MIMMOGEO" */
+    uint32_t    version;        /**< version of the format */
+    uint32_t    endian;         /**< byte order mark */
+    int32_t     type;           /**< type of the MimmoObject */
+    uint32_t    flags;          /**< search trees stored in the file */
+    uint64_t    nVertices;      /**< number of vertices */
+    uint64_t    nCells;         /**< number of cells */
+    uint64_t    nConnect;       /**< size of the connectivity of all cells */
+    uint64_t    treesOffset;    /**< position of the search trees in the file */
+    uint64_t    fileSize;       /**< size of the file */
+};
+
+/*!
+ * \class GeoMimmoLayout
+ * \ingroup iogeneric
+ * \brief GeoMimmoLayout is an ad-hoc struct holding the position of the data arrays of a geomimmo file.
+ */
+struct GeoMimmoLayout{
+    uint64_t    vertexIds;      /**< vertex unique ids, int64 */
+    uint64_t    coords;         /**< vertex coordinates, 3 double per vertex */
+    uint64_t    cellIds;        /**< cell unique ids, int64 */
+    uint64_t    connect;        /**< cell connectivity as vertex unique ids, int64 */
+    uint64_t    types;          /**< cell types, uint8 */
+    uint64_t    pids;           /**< cell PIDs, int16 */
+    uint64_t    end;            /**< end of the data arrays */
+};
+
+/*!
+ * \return offset rounded up to a multiple of 8 bytes.
+ * \param[in] offset offset in bytes
+ */
+static inline uint64_t geoAlign(uint64_t offset){
+    return (offset + 7) & ~uint64_t(7);
+}
+
+/*!
+ * \return position of the data arrays in a geomimmo file.
+ * \param[in] header header of the file
+ */
+static GeoMimmoLayout geoLayout(const GeoMimmoHeader & header){
+    GeoMimmoLayout layout;
+    layout.vertexIds = sizeof(GeoMimmoHeader);
+    layout.coords = layout.vertexIds + 8*header.nVertices;
+    layout.cellIds = layout.coords + 24*header.nVertices;
+    layout.connect = layout.cellIds + 8*header.nCells;
+    layout.types = layout.connect + 8*header.nConnect;
+    layout.pids = geoAlign(layout.types + header.nCells);
+    layout.end = geoAlign(layout.pids + 2*header.nCells);
+    return layout;
+}
+
+/*!
+ * Check the header of a geomimmo file.
+ * \param[in] header header of the file
+ * \return true if the header belongs to a geomimmo file of the supported version
+ */
+static inline bool geoCheckHeader(const GeoMimmoHeader & header){
+    return (std::memcmp(header.magic, "MIMMOGEO", 8) == 0 && header.version == GEOMIMMO_VERSION
+            && header.endian == GEOMIMMO_ENDIAN);
+}
+
+/*!
+ * Check the element type of a cell stored in a geomimmo file.
+ * \param[in] type element type, as stored in the file
+ * \return true if the type is a fixed-size element type
+ */
+static inline bool geoCheckType(uint8_t type){
+    switch (static_cast<bitpit::ElementInfo::Type>(type)){
+    case bitpit::ElementInfo::VERTEX:
+    case bitpit::ElementInfo::LINE:
+    case bitpit::ElementInfo::TRIANGLE:
+    case bitpit::ElementInfo::PIXEL:
+    case bitpit::ElementInfo::QUAD:
+    case bitpit::ElementInfo::TETRA:
+    case bitpit::ElementInfo::VOXEL:
+    case bitpit::ElementInfo::HEXAHEDRON:
+    case bitpit::ElementInfo::WEDGE:
+    case bitpit::ElementInfo::PYRAMID:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*!
+ * Read an array of unique ids of a geomimmo file and sort it.
+ * \param[in] begin beginning of the array in the file
+ * \param[in] n number of ids
+ * \param[out] ids sorted ids
+ * \return false if the array holds repeated ids
+ */
+static bool geoSortedIds(const char * begin, long n, std::vector<int64_t> & ids){
+    ids.resize(n);
+    if (n > 0)  std::memcpy(ids.data(), begin, 8*n);
+    std::sort(ids.begin(), ids.end());
+    return (std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+}
+
+/*!
+ * Append a value to a write buffer, flushing the buffer on the stream when full.
+ * \param[in,out] buffer write buffer
+ * \param[in] out output stream
+ * \param[in] value value to be written
+ */
+template<typename T>
+static inline void geoAppend(std::vector<char> & buffer, std::ostream & out, const T & value){
+    if (buffer.size() + sizeof(T) > GEOMIMMO_WRITEBLOCK){
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    const char * bytes = reinterpret_cast<const char *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/*!
+ * Flush a write buffer on the stream, padding the written data to a multiple of 8 bytes.
+ * \param[in,out] buffer write buffer
+ * \param[in] out output stream
+ */
+static inline void geoFlush(std::vector<char> & buffer, std::ostream & out){
+    out.write(buffer.data(), buffer.size());
+    uint64_t position = uint64_t(out.tellp());
+    static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    out.write(zeros, geoAlign(position) - position);
+    buffer.clear();
+}
+
+/*!
+ * \class GeoMimmoBuffer
+ * \ingroup iogeneric
+ * \brief GeoMimmoBuffer is a read-only stream buffer on a memory region, used to restore the search trees
+ * directly from the memory-mapped file.
+ */
+class GeoMimmoBuffer : public std::streambuf{
+public:
+    /*!
+     * Constructor.
+     * \param[in] begin beginning of the memory region
+     * \param[in] end end of the memory region
+     */
+    GeoMimmoBuffer(const char * begin, const char * end){
+        setg(const_cast<char *>(begin), const_cast<char *>(begin), const_cast<char *>(end));
+    }
+};
+
+/*!
+ * Read the type of the geometry stored in a geomimmo binary file.
+ * \param[in] filename path to the file
+ * \return type of the MimmoObject (1-surface, 2-volume, 3-point cloud, 4-3D curve),
+ * 0 if the file is not a geomimmo binary file.
+ */
+int
+GeoMimmoInterface::readType(const std::string & filename){
+    std::ifstream in(filename, std::ios::binary);
+    GeoMimmoHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in.good() || !geoCheckHeader(header))  return 0;
+    return header.type;
+}
+
+/*!
+ * Read a geomimmo binary file and fill the geometry. Vertices and cells are inserted
+ * with their original unique ids; stored search trees are restored, if they match the geometry.
+ * The content of the file is validated before filling the geometry: the element types of
+ * the cells, the uniqueness of the ids and the existence of the vertices referenced by
+ * the cells are checked.
+ * \param[in] filename path to the file
+ * \param[in,out] geo target empty MimmoObject, of the same type as the stored one (see readType)
+ * \return false if the file cannot be read, the geometry type does not match or the file is corrupted.
+ * The geometry is left untouched if the file is not a valid geomimmo file.
+ */
+bool
+GeoMimmoInterface::read(const std::string & filename, MimmoObject * geo){
+
+    if (geo == NULL)    return false;
+
+    MappedFile file;
+    if (!file.open(filename) || file.size() < sizeof(GeoMimmoHeader))   return false;
+    const char * data = file.data();
+
+    GeoMimmoHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (!geoCheckHeader(header) || header.type != geo->getType() || header.fileSize != file.size())   return false;
+    GeoMimmoLayout layout = geoLayout(header);
+    if (layout.end > file.size() || (header.flags != 0 && header.treesOffset < layout.end))   return false;
+
+    long nVertices = long(header.nVertices);
+    long nCells = long(header.nCells);
+
+    //validate the cells before filling the geometry
+    {
+        std::vector<int64_t> ids;
+        if (!geoSortedIds(data + layout.cellIds, nCells, ids))   return false;
+        if (!geoSortedIds(data + layout.vertexIds, nVertices, ids))  return false;
+        const char * connect = data + layout.connect;
+        const char * connectEnd = data + layout.types;
+        for (long i=0; i<nCells; ++i){
+            uint8_t type = uint8_t(data[layout.types + i]);
+            if (!geoCheckType(type))    return false;
+            int nv = bitpit::ElementInfo::getElementInfo(static_cast<bitpit::ElementInfo::Type>(type)).nVertices;
+            if (nv <= 0 || connect + 8*nv > connectEnd)   return false;
+            for (int j=0; j<nv; ++j){
+                int64_t vertex;
+                std::memcpy(&vertex, connect + 8*j, 8);
+                if (!std::binary_search(ids.begin(), ids.end(), vertex))  return false;
+            }
+            connect += 8*nv;
+        }
+        if (connect != connectEnd)  return false;
+    }
+
+    bitpit::PatchKernel * patch = geo->getPatch();
+    patch->reserveVertices(nVertices);
+    patch->reserveCells(nCells);
+
+    int64_t id;
+    darray3E coords;
+    for (long i=0; i<nVertices; ++i){
+        std::memcpy(&id, data + layout.vertexIds + 8*i, 8);
+        std::memcpy(coords.data(), data + layout.coords + 24*i, 24);
+        geo->addVertex(coords, long(id));
+    }
+
+    livector1D conn;
+    const char * connect = data + layout.connect;
+    for (long i=0; i<nCells; ++i){
+        std::memcpy(&id, data + layout.cellIds + 8*i, 8);
+        bitpit::ElementInfo::Type type = static_cast<bitpit::ElementInfo::Type>(uint8_t(data[layout.types + i]));
+        int16_t pid;
+        std::memcpy(&pid, data + layout.pids + 2*i, 2);
+        int nv = bitpit::ElementInfo::getElementInfo(type).nVertices;
+        conn.resize(nv);
+        for (int j=0; j<nv; ++j){
+            int64_t vertex;
+            std::memcpy(&vertex, connect + 8*j, 8);
+            conn[j] = long(vertex);
+        }
+        connect += 8*nv;
+        geo->addConnectedCell(conn, type, short(pid), long(id));
+    }
+
+    //search trees, restored from the mapped memory
+    if (header.flags != 0){
+        GeoMimmoBuffer buffer(data + header.treesOffset, data + file.size());
+        std::istream in(&buffer);
+        if (header.flags & GEOMIMMO_BVTREE)  geo->restoreStructure(GeometryStructure::BVTREE, in);
+        if (header.flags & GEOMIMMO_KDTREE)  geo->restoreStructure(GeometryStructure::KDTREE, in);
+    }
+
+    return true;
+}
+
+/*!
+ * Write a geometry in a geomimmo binary file, together with its search trees if they are
+ * built and synchronized with the geometry.
+ * \param[in] filename path to the file
+ * \param[in] geo geometry to be written
+ * \return false if the file cannot be written or the geometry holds variable-size elements.
+ */
+bool
+GeoMimmoInterface::write(const std::string & filename, MimmoObject * geo){
+
+    if (geo == NULL || geo->isEmpty())  return false;
+    bitpit::PatchKernel * patch = geo->getPatch();
+
+    GeoMimmoHeader header;
+    std::memcpy(header.magic, "MIMMOGEO", 8);
+    header.version = GEOMIMMO_VERSION;
+    header.endian = GEOMIMMO_ENDIAN;
+    header.type = geo->getType();
+    header.flags = 0;
+    header.nVertices = patch->getVertexCount();
+    header.nCells = patch->getCellCount();
+    header.nConnect = 0;
+    for (const auto & cell : patch->getCells()){
+        bitpit::ElementInfo::Type type = cell.getType();
+        if (type == bitpit::ElementInfo::UNDEFINED || type == bitpit::ElementInfo::POLYGON
+                || type == bitpit::ElementInfo::POLYHEDRON) return false;
+        header.nConnect += cell.getVertexCount();
+    }
+    header.treesOffset = 0;
+    header.fileSize = 0;
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.good())    return false;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    std::vector<char> buffer;
+    buffer.reserve(GEOMIMMO_WRITEBLOCK);
+    for (const auto & vertex : patch->getVertices())    geoAppend(buffer, out, int64_t(vertex.getId()));
+    geoFlush(buffer, out);
+    for (const auto & vertex : patch->getVertices())    geoAppend(buffer, out, vertex.getCoords());
+    geoFlush(buffer, out);
+    for (const auto & cell : patch->getCells())         geoAppend(buffer, out, int64_t(cell.getId()));
+    geoFlush(buffer, out);
+    for (const auto & cell : patch->getCells()){
+        const long * conn = cell.getConnect();
+        int nv = cell.getVertexCount();
+        for (int j=0; j<nv; ++j)    geoAppend(buffer, out, int64_t(conn[j]));
+    }
+    geoFlush(buffer, out);
+    for (const auto & cell : patch->getCells())         geoAppend(buffer, out, uint8_t(cell.getType()));
+    geoFlush(buffer, out);
+    for (const auto & cell : patch->getCells())         geoAppend(buffer, out, int16_t(cell.getPID()));
+    geoFlush(buffer, out);
+
+    //search trees
+    header.treesOffset = uint64_t(out.tellp());
+    if (geo->dumpStructure(GeometryStructure::BVTREE, out))  header.flags |= GEOMIMMO_BVTREE;
+    if (geo->dumpStructure(GeometryStructure::KDTREE, out))  header.flags |= GEOMIMMO_KDTREE;
+    header.fileSize = uint64_t(out.tellp());
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    return out.good();
+}
+
+}
@@ -0,0 +1,61 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#ifndef __GEOMIMMOINTERFACE_HPP__
+#define __GEOMIMMOINTERFACE_HPP__
+
+#include "MimmoObject.hpp"
+#include <string>
+
+namespace mimmo{
+
+/*!
+ * \class GeoMimmoInterface
+ * \ingroup iogeneric
+ * \brief GeoMimmoInterface is an interface class for the native binary snapshot format of MimmoObject *.geomimmo.
+ *
+ * The snapshot holds the type of the geometry, its vertices (unique ids and coordinates), its cells
+ * (unique ids, element types, PIDs and connectivity as vertex unique ids) and, optionally, the search
+ * trees (BvTree, KdTree) built on the geometry. Vertices and cells are stored in the order of the
+ * geometry storage, so the local/unique-id maps of the geometry are restored as they were.
+ * Data are stored as contiguous, 8-bytes aligned arrays after a fixed size header: the file
+ * is memory-mapped and streamed into the geometry storage, while trees are restored without
+ * being rebuilt.
+ *
+ * The format is versioned and bound to the platform that wrote it (byte order and sizes of
+ * the tree nodes are checked while reading): it is meant as a cache of geometries already
+ * read and cleaned, not as an exchange format.
+ * Only geometries with fixed-size elements (no polygons/polyhedra) can be written.
+ */
+class GeoMimmoInterface{
+
+public:
+    static int  readType(const std::string & filename);
+
+    bool read(const std::string & filename, MimmoObject * geo);
+    bool write(const std::string & filename, MimmoObject * geo);
+};
+
+}
+
+#endif /* __GEOMIMMOINTERFACE_HPP__ */
@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include "MappedFile.hpp"
+#include <fstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mimmo{
+
+/*!
+ * Default constructor of MappedFile.
+ */
+MappedFile::MappedFile() : m_data(NULL), m_size(0), m_mapped(false){}
+
+/*!
+ * Default destructor of MappedFile. It releases the file content.
+ */
+MappedFile::~MappedFile(){
+    close();
+}
+
+/*!
+ * Give access to the content of a file.
+ * \param[in] filename path to the file
+ * \return false if the file cannot be opened or it is empty
+ */
+bool
+MappedFile::open(const std::string & filename){
+    close();
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0){
+        ::close(fd);
+        return false;
+    }
+    void * data = mmap(NULL, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data != MAP_FAILED){
+        madvise(data, std::size_t(info.st_size), MADV_SEQUENTIAL);
+        m_data = static_cast<const char *>(data);
+        m_size = std::size_t(info.st_size);
+        m_mapped = true;
+        return true;
+    }
+#endif
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.good()) return false;
+    std::streamoff size = in.tellg();
+    if (size <= 0) return false;
+    m_buffer.resize(std::size_t(size));
+    in.seekg(0);
+    in.read(m_buffer.data(), size);
+    if (!in.good()) return false;
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
+
+/*!
+ * Release the content of the file.
+ */
+void
+MappedFile::close(){
+#if defined(__unix__) || defined(__APPLE__)
+    if (m_mapped)   munmap(const_cast<char *>(m_data), m_size);
+#endif
+    std::vector<char>().swap(m_buffer);
+    m_data = NULL;
+    m_size = 0;
+    m_mapped = false;
+}
+
+/*!
+ * \return pointer to the content of the file.
+ */
+const char *
+MappedFile::data() const{
+    return m_data;
+}
+
+/*!
+ * \return size of the file in bytes.
+ */
+std::size_t
+MappedFile::size() const{
+    return m_size;
+}
+
+}
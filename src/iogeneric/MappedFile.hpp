@@ -0,0 +1,63 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#ifndef __MAPPEDFILE_HPP__
+#define __MAPPEDFILE_HPP__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mimmo{
+
+/*!
+ * \class MappedFile
+ * \ingroup iogeneric
+ * \brief MappedFile is a utility class giving read-only access to the whole content of a file.
+ *
+ * The file is memory-mapped if the platform supports it, otherwise it is read in memory.
+ * The content is released when the class is destroyed or closed.
+ */
+class MappedFile{
+
+    const char *        m_data;     /**< pointer to the file content */
+    std::size_t         m_size;     /**< size of the file in bytes */
+    bool                m_mapped;   /**< true if the file content is memory-mapped */
+    std::vector<char>   m_buffer;   /**< file content, if not memory-mapped */
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile & other) = delete;
+    MappedFile & operator=(const MappedFile & other) = delete;
+
+    bool            open(const std::string & filename);
+    void            close();
+    const char *    data() const;
+    std::size_t     size() const;
+};
+
+}
+
+#endif /* __MAPPEDFILE_HPP__ */
@@ -22,8 +22,22 @@
  *
 \*---------------------------------------------------------------------------*/
 #include "MimmoGeometry.hpp"
+#include "STLInterface.hpp"
+#include "VTUInterface.hpp"
+#include "GeoMimmoInterface.hpp"
+#include "MappedFile.hpp"
 #include "customOperators.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#if MIMMO_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace bitpit;
@@ -82,8 +96,10 @@ MimmoGeometry & MimmoGeometry::operator=(const MimmoGeometry & other){
     m_codex = other.m_codex;
     m_buildBvTree = other.m_buildBvTree;
     m_buildKdTree = other.m_buildKdTree;
+    m_compact = other.m_compact;
     m_refPID = other.m_refPID;
     m_multiSolidSTL = other.m_multiSolidSTL;
+    m_conformingVTU = other.m_conformingVTU;
     
     if(other.m_isInternal){
         m_geometry = other.m_intgeo.get();
@@ -148,8 +164,10 @@ MimmoGeometry::setDefaults(){
     m_codex            = true;
     m_buildBvTree    = false;
     m_buildKdTree    = false;
+    m_compact        = false;
     m_refPID = 0;
     m_multiSolidSTL = true;
+    m_conformingVTU = false;
 }
 
 /*!It sets the condition to read the geometry on file during the execution.
@@ -375,6 +393,16 @@ void MimmoGeometry::setMultiSolidSTL(bool multi){
     m_multiSolidSTL = multi;
 }
 
+/*!
+ * Declare VTU files to be read as conforming meshes, i.e. without coincident
+ * or orphan vertices, as the ones written by mimmo. The cleaning of the geometry
+ * after reading is skipped. The method has effect only while reading VTU format types.
+ * \param[in] conforming boolean, true if the VTU file is conforming.
+ */
+void MimmoGeometry::setConformingVTU(bool conforming){
+    m_conformingVTU = conforming;
+}
+
 
 /*!Sets your current class as a "soft" copy of the argument.
  * Soft copy means that only your current geometric object MimmoObject is
@@ -415,8 +443,10 @@ MimmoGeometry::setHARDCopy(const MimmoGeometry * other){
     m_codex = other->m_codex;
     m_buildBvTree = other->m_buildBvTree;
     m_buildKdTree = other->m_buildKdTree;
+    m_compact = other->m_compact;
     m_refPID = other->m_refPID;
     m_multiSolidSTL = other->m_multiSolidSTL;
+    m_conformingVTU = other->m_conformingVTU;
 }
 
 /*!
@@ -546,6 +576,16 @@ MimmoGeometry::setBuildKdTree(bool build){
     m_buildKdTree = build;
 }
 
+/*!It sets if the geometry has to be set in compact mode during execution,
+ * i.e. its index maps are built only on demand and released by the chain
+ * as soon as they are not needed anymore (see MimmoObject::setCompact).
+ * \param[in] compact If true the geometry is set in compact mode in execution.
+ */
+void
+MimmoGeometry::setCompact(bool compact){
+    m_compact = compact;
+}
+
 /*!
  * Check if geometry is not linked or not locally instantiated in your class.
  * True - no geometry present, False otherwise.
@@ -604,6 +644,9 @@ MimmoGeometry::write(){
         //Export STL
     {
         string name = (m_winfo.fdir+"/"+m_winfo.fname+".stl");
+        //streaming binary writer, bitpit exporter for ascii files.
+        STLInterface stl;
+        if (m_codex && stl.writeBinary(name, getGeometry()))  return true;
         dynamic_cast<SurfUnstructured*>(getGeometry()->getPatch())->exportSTL(name, m_codex, false); // m_multiSolidSTL, false);
         return true;
     }
@@ -748,9 +791,11 @@ MimmoGeometry::write(){
     break;
 
     case FileType::MIMMO :
-        //Export in mimmo (bitpit) dump format
+        //Export in mimmo native binary format, bitpit dump format for unsupported geometries
     {
         string name = (m_winfo.fdir+"/"+m_winfo.fname+".geomimmo");
+        GeoMimmoInterface geomimmo;
+        if (geomimmo.write(name, getGeometry()))  return true;
         std::filebuf buffer;
         std::ostream out(&buffer);
         buffer.open(name, std::ios::out);
@@ -799,23 +844,14 @@ MimmoGeometry::read(){
             }
         }
 
-        ifstream in(name);
-        string    ss, sstype;
-        getline(in,ss);
-        stringstream ins;
-        ins << ss;
-        ins >> sstype;
-        bool binary = true;
-        if (sstype == "solid" || sstype == "SOLID") binary = false;
-        in.close();
-
-        dynamic_cast<SurfUnstructured*>(getGeometry()->getPatch())->importSTL(name, binary);
-        getGeometry()->cleanGeometry();
-
-        //count PID if multi-solid
-        auto & map = getGeometry()->getPIDTypeList();
-        for(auto & cell : getGeometry()->getCells() ){
-            map.insert(cell.getPID());
+        //native reader: coincident vertices are merged while reading, no cleaning needed.
+        STLInterface stl;
+        if (!stl.read(name, getGeometry())){
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
+            (*m_log) << "error: " << m_name << " cannot read STL file " << name << std::endl;
+            return false;
         }
     }
     break;
@@ -823,246 +859,102 @@ MimmoGeometry::read(){
     case FileType::STVTU :
         //Import Triangulation Surface VTU
     {
-        std::ifstream infile(m_rinfo.fdir+"/"+m_rinfo.fname+".vtu");
-        bool check = infile.good();
-        if (!check) return false;
-
-        dvecarr3E    Ipoints ;
-        ivector2D    Iconnectivity ;
-        shivector1D pids;
-
-        bitpit::VTKUnstructuredGrid  vtk(m_rinfo.fdir, m_rinfo.fname, bitpit::VTKElementType::TRIANGLE);
-        vtk.setGeomData( bitpit::VTKUnstructuredField::POINTS, Ipoints) ;
-        vtk.setGeomData( bitpit::VTKUnstructuredField::CONNECTIVITY, Iconnectivity) ;
-        vtk.addData("PID", pids);
-
-        vtk.read() ;
-
-        bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::TRIANGLE;
-
-        setGeometry(1);
-
-        int sizeV, sizeC, sizeP;
-        sizeV = Ipoints.size();
-        sizeC = Iconnectivity.size();
-        sizeP = pids.size();
-        m_intgeo->getPatch()->reserveVertices(sizeV);
-        m_intgeo->getPatch()->reserveCells(sizeC);
-
-        for(auto & vv : Ipoints)        m_intgeo->addVertex(vv);
-
-        int ccell = 0;
-        for(auto & cc : Iconnectivity)    {
-            livector1D temp(cc.size());
-            int counter = 0;
-            for(auto && val : cc){
-                temp[counter] = val;
-                ++counter;
-            }
-            if(sizeP == 0){
-                m_intgeo->addConnectedCell(temp, eltype);
-            }else{
-                m_intgeo->addConnectedCell(temp, eltype, pids[ccell]);
-            }
-            ccell++;
-        }
-
-        m_intgeo->cleanGeometry();
+        if (!readVTU(1, bitpit::VTKElementType::TRIANGLE))   return false;
     }
     break;
 
     case FileType::SQVTU :
         //Import Quadrilateral Surface VTU
     {
-
-        std::ifstream infile(m_rinfo.fdir+"/"+m_rinfo.fname+".vtu");
-        bool check = infile.good();
-        if (!check) return false;
-
-        dvecarr3E    Ipoints ;
-        ivector2D    Iconnectivity ;
-        shivector1D pids;
-
-        bitpit::VTKUnstructuredGrid  vtk(m_rinfo.fdir, m_rinfo.fname, bitpit::VTKElementType::QUAD);
-        vtk.setGeomData( bitpit::VTKUnstructuredField::POINTS, Ipoints) ;
-        vtk.setGeomData( bitpit::VTKUnstructuredField::CONNECTIVITY, Iconnectivity) ;
-        vtk.addData("PID", pids);
-        vtk.read() ;
-
-        bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::QUAD;
-
-        setGeometry(1);
-
-        int sizeV, sizeC, sizeP;
-        sizeV = Ipoints.size();
-        sizeC = Iconnectivity.size();
-        sizeP = pids.size();
-        m_intgeo->getPatch()->reserveVertices(sizeV);
-        m_intgeo->getPatch()->reserveCells(sizeC);
-
-        int ccell = 0;
-        for(auto & vv : Ipoints)        m_intgeo->addVertex(vv);
-        for(auto & cc : Iconnectivity)    {
-            livector1D temp(cc.size());
-            int counter = 0;
-            for(auto && val : cc){
-                temp[counter] = val;
-                ++counter;
-            }
-            if(sizeP == 0){
-                m_intgeo->addConnectedCell(temp, eltype);
-            }else{
-                m_intgeo->addConnectedCell(temp, eltype, pids[ccell]);
-            }
-            ccell++;
-        }
-
-        m_intgeo->cleanGeometry();
+        if (!readVTU(1, bitpit::VTKElementType::QUAD))   return false;
     }
     break;
 
     case FileType::VTVTU :
         //Import Tetra Volume VTU
     {
-
-        std::ifstream infile(m_rinfo.fdir+"/"+m_rinfo.fname+".vtu");
-        bool check = infile.good();
-        if (!check) return false;
-
-        dvecarr3E    Ipoints ;
-        ivector2D    Iconnectivity ;
-        shivector1D pids;
-
-        bitpit::VTKUnstructuredGrid  vtk(m_rinfo.fdir, m_rinfo.fname, bitpit::VTKElementType::TETRA);
-        vtk.setGeomData( bitpit::VTKUnstructuredField::POINTS, Ipoints) ;
-        vtk.setGeomData( bitpit::VTKUnstructuredField::CONNECTIVITY, Iconnectivity) ;
-        vtk.addData("PID", pids);
-        vtk.read() ;
-
-        bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::TETRA;
-
-        setGeometry(2);
-
-        int sizeV, sizeC, sizeP;
-        sizeV = Ipoints.size();
-        sizeC = Iconnectivity.size();
-        sizeP = pids.size();
-        m_intgeo->getPatch()->reserveVertices(sizeV);
-        m_intgeo->getPatch()->reserveCells(sizeC);
-
-        int ccell = 0;
-        for(auto & vv : Ipoints)        m_intgeo->addVertex(vv);
-        for(auto & cc : Iconnectivity)    {
-            livector1D temp(cc.size());
-            int counter = 0;
-            for(auto && val : cc){
-                temp[counter] = val;
-                ++counter;
-            }
-            if(sizeP == 0){
-                m_intgeo->addConnectedCell(temp, eltype);
-            }else{
-                m_intgeo->addConnectedCell(temp, eltype, pids[ccell]);
-            }
-            ccell++;
-        }
-
-
-        m_intgeo->cleanGeometry();
+        if (!readVTU(2, bitpit::VTKElementType::TETRA))   return false;
     }
     break;
 
     case FileType::VHVTU :
         //Import Hexa Volume VTU
     {
-
-        std::ifstream infile(m_rinfo.fdir+"/"+m_rinfo.fname+".vtu");
-        bool check = infile.good();
-        if (!check) return false;
-
-        dvecarr3E    Ipoints ;
-        ivector2D    Iconnectivity ;
-        shivector1D pids;
-
-        bitpit::VTKUnstructuredGrid  vtk(m_rinfo.fdir, m_rinfo.fname, bitpit::VTKElementType::HEXAHEDRON);
-        vtk.setGeomData( bitpit::VTKUnstructuredField::POINTS, Ipoints) ;
-        vtk.setGeomData( bitpit::VTKUnstructuredField::CONNECTIVITY, Iconnectivity) ;
-        vtk.addData("PID", pids);
-        vtk.read() ;
-
-        bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::HEXAHEDRON;
-
-        setGeometry(2);
-
-        int sizeV, sizeC, sizeP;
-        sizeV = Ipoints.size();
-        sizeC = Iconnectivity.size();
-        sizeP = pids.size();
-        m_intgeo->getPatch()->reserveVertices(sizeV);
-        m_intgeo->getPatch()->reserveCells(sizeC);
-
-        int ccell = 0;
-        for(auto & vv : Ipoints)        m_intgeo->addVertex(vv);
-        for(auto & cc : Iconnectivity)    {
-            livector1D temp(cc.size());
-            int counter = 0;
-            for(auto && val : cc){
-                temp[counter] = val;
-                ++counter;
-            }
-            if(sizeP == 0){
-                m_intgeo->addConnectedCell(temp, eltype);
-            }else{
-                m_intgeo->addConnectedCell(temp, eltype, pids[ccell]);
-            }
-            ccell++;
-        }
-
-        m_intgeo->cleanGeometry();
+        if (!readVTU(2, bitpit::VTKElementType::HEXAHEDRON))   return false;
     }
     break;
 
     case FileType::NAS :
-        //Import Surface NAS
+        //Import Surface/Volume NAS
     {
 
-        std::ifstream infile(m_rinfo.fdir+"/"+m_rinfo.fname+".nas");
-        bool check = infile.good();
-        if (!check) return false;
-        infile.close();
-
         dvecarr3E    Ipoints ;
-        ivector2D    Iconnectivity ;
+        livector1D   Iconnectivity ;
+        std::vector<bitpit::ElementInfo::Type> Itypes;
+        shivector1D  Ipids;
 
         NastranInterface nastran;
         nastran.setWFormat(m_wformat);
+        bool check = nastran.read(m_rinfo.fdir+"/"+m_rinfo.fname+".nas", Ipoints, Iconnectivity, Itypes, Ipids);
+        if (!check && Itypes.empty())   return false;
+        if (!check){
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
+            (*m_log) << m_name << " warning: some cards of Nastran file " << m_rinfo.fname << " could not be parsed and were skipped" << std::endl;
+        }
 
-        shivector1D pids;
-        nastran.read(m_rinfo.fdir, m_rinfo.fname, Ipoints, Iconnectivity, pids );
-
-        bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::TRIANGLE;
-
-        setGeometry(1);
+        //volume mesh if any volume element is found, in that case surface elements are skipped
+        bool volume = false;
+        for (auto type : Itypes){
+            volume = volume || (type == bitpit::ElementInfo::TETRA || type == bitpit::ElementInfo::HEXAHEDRON);
+        }
+        setGeometry(volume ? 2 : 1);
+
+        //retain only vertices referenced by retained elements
+        long sizeV = Ipoints.size();
+        long sizeC = 0;
+        livector1D vmap(sizeV, -1);
+        std::size_t offset = 0;
+        for (auto type : Itypes){
+            int nv = bitpit::ElementInfo::getElementInfo(type).nVertices;
+            bool isvolume = (type == bitpit::ElementInfo::TETRA || type == bitpit::ElementInfo::HEXAHEDRON);
+            if (isvolume == volume){
+                for (int j=0; j<nv; ++j)    vmap[Iconnectivity[offset+j]] = 0;
+                ++sizeC;
+            }
+            offset += nv;
+        }
+        long nV = 0;
+        for (auto & val : vmap){
+            if (val == 0)   val = nV++;
+        }
 
-        int sizeV, sizeC;
-        sizeV = Ipoints.size();
-        sizeC = Iconnectivity.size();
-        m_intgeo->getPatch()->reserveVertices(sizeV);
+        m_intgeo->getPatch()->reserveVertices(nV);
         m_intgeo->getPatch()->reserveCells(sizeC);
 
-
-        for(auto & vv : Ipoints)        m_intgeo->addVertex(vv);
-        for(auto & cc : Iconnectivity)    {
-            livector1D temp(cc.size());
-            int counter = 0;
-            for(auto && val : cc){
-                temp[counter] = val;
-                ++counter;
+        for (long i=0; i<sizeV; ++i){
+            if (vmap[i] >= 0)   m_intgeo->addVertex(Ipoints[i], vmap[i]);
+        }
+        dvecarr3E().swap(Ipoints);
+
+        offset = 0;
+        long idC = 0;
+        livector1D temp;
+        for (std::size_t e=0; e<Itypes.size(); ++e){
+            bitpit::ElementInfo::Type type = Itypes[e];
+            int nv = bitpit::ElementInfo::getElementInfo(type).nVertices;
+            bool isvolume = (type == bitpit::ElementInfo::TETRA || type == bitpit::ElementInfo::HEXAHEDRON);
+            if (isvolume == volume){
+                temp.resize(nv);
+                for (int j=0; j<nv; ++j)    temp[j] = vmap[Iconnectivity[offset+j]];
+                m_intgeo->addConnectedCell(temp, type, Ipids[e], idC);
+                ++idC;
             }
-            m_intgeo->addConnectedCell(temp, eltype);
-
+            offset += nv;
         }
-        m_intgeo->setPID(pids);
+
+        //decks assembled from parts may hold coincident grids with different ids
         m_intgeo->cleanGeometry();
     }
 
@@ -1159,10 +1051,25 @@ MimmoGeometry::read(){
     break;
 
     case FileType::MIMMO :
-        //Import in mimmo (bitpit) restore format
+        //Import in mimmo native binary format, bitpit restore format for files written by previous versions
     {
         int type;
         string name = (m_rinfo.fdir+"/"+m_rinfo.fname+".geomimmo");
+        type = GeoMimmoInterface::readType(name);
+        if (type > 0){
+            setGeometry(type);
+            GeoMimmoInterface geomimmo;
+            if (!geomimmo.read(name, getGeometry())){
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
+                (*m_log) << "error: " << m_name << " cannot read geomimmo file " << name << std::endl;
+                //discard the partially filled geometry
+                setGeometry(type);
+                return false;
+            }
+            break;
+        }
         std::filebuf buffer;
         std::istream in(&buffer);
         buffer.open(name, std::ios::in);
@@ -1190,6 +1097,76 @@ MimmoGeometry::read(){
     return true;
 };
 
+/*!
+ * Read a VTU file of constant element type in the internal geometry. The native
+ * VTUInterface reader is used, which streams the file arrays into the geometry storage;
+ * files it does not support (e.g. compressed ones) are read through bitpit.
+ * Geometry cleaning is skipped if the file is declared conforming, see setConformingVTU.
+ * \param[in] type 1-Surface MimmoObject, 2-Volume MimmoObject
+ * \param[in] vtktype VTK element type of the file, used by the bitpit reader
+ * \return false if the file cannot be read
+ */
+bool
+MimmoGeometry::readVTU(int type, bitpit::VTKElementType vtktype){
+
+    std::string name = m_rinfo.fdir+"/"+m_rinfo.fname+".vtu";
+    std::ifstream infile(name);
+    bool check = infile.good();
+    if (!check) return false;
+    infile.close();
+
+    setGeometry(type);
+
+    VTUInterface vtu;
+    if (!vtu.read(name, getGeometry())){
+
+        //fallback to bitpit reader on a fresh geometry
+        setGeometry(type);
+
+        dvecarr3E    Ipoints ;
+        ivector2D    Iconnectivity ;
+        shivector1D pids;
+
+        bitpit::VTKUnstructuredGrid  vtk(m_rinfo.fdir, m_rinfo.fname, vtktype);
+        vtk.setGeomData( bitpit::VTKUnstructuredField::POINTS, Ipoints) ;
+        vtk.setGeomData( bitpit::VTKUnstructuredField::CONNECTIVITY, Iconnectivity) ;
+        vtk.addData("PID", pids);
+        vtk.read() ;
+
+        bitpit::ElementInfo::Type eltype = bitpit::ElementInfo::UNDEFINED;
+        switch(vtktype){
+        case bitpit::VTKElementType::TRIANGLE :     eltype = bitpit::ElementInfo::TRIANGLE;     break;
+        case bitpit::VTKElementType::QUAD :         eltype = bitpit::ElementInfo::QUAD;         break;
+        case bitpit::VTKElementType::TETRA :        eltype = bitpit::ElementInfo::TETRA;        break;
+        case bitpit::VTKElementType::HEXAHEDRON :   eltype = bitpit::ElementInfo::HEXAHEDRON;   break;
+        default :   break;
+        }
+
+        long sizeV, sizeC, sizeP;
+        sizeV = Ipoints.size();
+        sizeC = Iconnectivity.size();
+        sizeP = pids.size();
+        m_intgeo->getPatch()->reserveVertices(sizeV);
+        m_intgeo->getPatch()->reserveCells(sizeC);
+
+        for(auto & vv : Ipoints)        m_intgeo->addVertex(vv);
+        dvecarr3E().swap(Ipoints);
+
+        livector1D temp;
+        for(long ccell=0; ccell<sizeC; ++ccell){
+            temp.assign(Iconnectivity[ccell].begin(), Iconnectivity[ccell].end());
+            if(sizeP == 0){
+                m_intgeo->addConnectedCell(temp, eltype);
+            }else{
+                m_intgeo->addConnectedCell(temp, eltype, pids[ccell]);
+            }
+        }
+    }
+
+    if(!m_conformingVTU)    m_intgeo->cleanGeometry();
+    return true;
+}
+
 /*!Execution command.
  * It reads the geometry if the condition m_read is true.
  * It writes the geometry if the condition m_write is true.
@@ -1199,19 +1176,30 @@ MimmoGeometry::execute(){
     bool check = true;
     if (m_read) check = read();
     if (!check){
-        (*m_log) << m_name << " error: file not found : "<< m_rinfo.fname << std::endl;
-        (*m_log) << " " << std::endl;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
+        {
+            (*m_log) << m_name << " error: file not found : "<< m_rinfo.fname << std::endl;
+            (*m_log) << " " << std::endl;
+        }
         throw std::runtime_error (m_name + " : file not found : " + m_rinfo.fname);
     }
     check = true;
     if (m_write) check = write();
     if (!check){
-        (*m_log) << m_name << " error: write not done : geometry not linked " << std::endl;
-        (*m_log) << " " << std::endl;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp critical (mimmo_log)
+#endif
+        {
+            (*m_log) << m_name << " error: write not done : geometry not linked " << std::endl;
+            (*m_log) << " " << std::endl;
+        }
         throw std::runtime_error (m_name + " : write not done : geometry not linked ");
     }
-    if (m_buildBvTree) getGeometry()->buildBvTree();
-    if (m_buildKdTree) getGeometry()->buildKdTree();
+    if (m_compact && getGeometry() != NULL) getGeometry()->setCompact(true);
+    if (m_buildBvTree) getGeometry()->buildStructure(GeometryStructure::BVTREE);
+    if (m_buildKdTree) getGeometry()->buildStructure(GeometryStructure::KDTREE);
 }
 
 /*!
@@ -1461,6 +1449,16 @@ MimmoGeometry::absorbSectionXML(const bitpit::Config::Section & slotXML, std::st
         setBuildKdTree(value);
     };
 
+    if(slotXML.hasOption("Compact")){
+        input = slotXML.get("Compact");
+        bool value = false;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setCompact(value);
+    };
+
     if(slotXML.hasOption("AssignRefPID")){
         input = slotXML.get("AssignRefPID");
         short int value = 0;
@@ -1480,6 +1478,16 @@ MimmoGeometry::absorbSectionXML(const bitpit::Config::Section & slotXML, std::st
         }
         setMultiSolidSTL(value);
     };
+
+    if(slotXML.hasOption("ConformingVTU")){
+        input = slotXML.get("ConformingVTU");
+        bool value = false;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setConformingVTU(value);
+    };
     
 };
 
@@ -1535,8 +1543,10 @@ MimmoGeometry::flushSectionXML(bitpit::Config::Section & slotXML, std::string na
 
     output = std::to_string(m_buildKdTree);
     slotXML.set("KdTree", output);
+    slotXML.set("Compact", std::to_string(m_compact));
     slotXML.set("AssignRefPID", std::to_string(m_refPID));
     slotXML.set("WriteMultiSolidSTL", std::to_string(m_multiSolidSTL));
+    slotXML.set("ConformingVTU", std::to_string(m_conformingVTU));
 };
 
 
@@ -1820,122 +1830,541 @@ void NastranInterface::write(string& outputDir, string& surfaceName, dvecarr3E&
 }
 
 //========READ====//
+
 /*!
- * Read a bdf nastran file
- * \param[in] inputDir    input directory
- * \param[in] surfaceName    input filename
- * \param[out] points    reference of a point container that has to be filled
- * \param[out] faces     reference to element-point connectivity that has to be filled
- * \param[out] PIDS        reference to short int vector for Part Identifier storage
+ * \class NasField
+ * \ingroup iogeneric
+ * \brief NasField is an ad-hoc struct pointing to the text of a field of a Nastran card.
  */
-void NastranInterface::read(string& inputDir, string& surfaceName, dvecarr3E& points, ivector2D& faces, shivector1D& PIDS){
+struct NasField{
+    const char * begin; /**< first character of the field */
+    const char * end;   /**< end of the field */
+};
 
-    ifstream is(inputDir +"/"+surfaceName + ".nas");
+/*!
+ * Maximum number of data fields of a card parsed by the Nastran reader.
+ */
+static const int NAS_MAXFIELDS = 16;
 
-    points.clear();
-    faces.clear();
-    PIDS.clear();
+/*!
+ * \class NasChunk
+ * \ingroup iogeneric
+ * \brief NasChunk is an ad-hoc struct collecting the cards parsed from a chunk of a Nastran file.
+ */
+struct NasChunk{
+    std::vector<long>       gridIds;    /**< unique-ids of GRID cards */
+    std::vector<double>     coords;     /**< coordinates of GRID cards */
+    std::vector<long>       connect;    /**< grid unique-ids of elements */
+    std::vector<bitpit::ElementInfo::Type>  types;  /**< types of elements */
+    std::vector<short>      pids;       /**< part identifiers of elements */
+    bool                    failed;     /**< true if a card cannot be parsed */
+};
 
-    int ipoint = 0;
-    int iface  = 0;
-    darray3E point;
-    ivector1D face(3);
-    map<int,int> mapnodes;
-    int id;
-    int pid;
-    string sread;
-    string ssub = trim(sread.substr(0,8));
+/*!
+ * \return pointer to the end of the line (new line character or end of buffer), starting from position p.
+ * \param[in] p current position in the buffer
+ * \param[in] end end of the buffer
+ */
+static inline const char * nasLineEnd(const char * p, const char * end){
+    const char * q = static_cast<const char *>(std::memchr(p, '\n', std::size_t(end - p)));
+    return (q == NULL) ? end : q;
+}
 
-    while(!is.eof()){
-        while(ssub != "GRID" &&
-                ssub != "GRID*" &&
-                ssub != "CTRIA3" &&
-                ssub != "CTRIA3*" &&
-                !is.eof()){
+/*!
+ * \return pointer to the beginning of the next line, starting from position p.
+ * \param[in] p current position in the buffer
+ * \param[in] end end of the buffer
+ */
+static inline const char * nasNextLine(const char * p, const char * end){
+    const char * q = nasLineEnd(p, end);
+    return (q == end) ? end : q + 1;
+}
 
-            getline(is,sread);
-            ssub = trim(sread.substr(0,8));
+/*!
+ * Trim blanks from both sides of a field.
+ * \param[in] field field of a card
+ * \return trimmed field
+ */
+static inline NasField nasTrim(NasField field){
+    while (field.begin < field.end && std::isspace((unsigned char)*field.begin))     ++field.begin;
+    while (field.end > field.begin && std::isspace((unsigned char)*(field.end-1)))   --field.end;
+    return field;
+}
 
+/*!
+ * Check if a line is the continuation of a card, i.e. it starts with '+', '*', ','
+ * or with a blank first field and some data.
+ * \param[in] p beginning of the line
+ * \param[in] lend end of the line
+ * \return true if the line is a continuation line
+ */
+static inline bool nasIsContinuation(const char * p, const char * lend){
+    if (p == lend)  return false;
+    if (*p == '+' || *p == '*' || *p == ',')  return true;
+    if (*p != ' ')  return false;
+    for (const char * q = p; q < lend; ++q){
+        if (!std::isspace((unsigned char)*q))  return true;
+    }
+    return false;
+}
+
+/*!
+ * Parse an integer field of a card.
+ * \param[in] field field of a card
+ * \param[out] value parsed value
+ * \return false if the field is not a valid integer
+ */
+static inline bool nasParseInt(NasField field, long & value){
+    field = nasTrim(field);
+    const char * p = field.begin;
+    if (p == field.end) return false;
+    bool negative = false;
+    if (*p == '+' || *p == '-'){
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == field.end) return false;
+    long result = 0;
+    for (; p < field.end; ++p){
+        if (*p < '0' || *p > '9')   return false;
+        result = 10*result + (*p - '0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+/*!
+ * Parse a real field of a card. Besides standard notation, the Nastran
+ * notations with implicit exponent (e.g. 1.5-3 for 1.5e-3) and with D exponent are supported.
+ * \param[in] field field of a card
+ * \param[out] value parsed value
+ * \return false if the field is not a valid real number
+ */
+static inline bool nasParseReal(NasField field, double & value){
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    field = nasTrim(field);
+    const char * p = field.begin;
+    const char * end = field.end;
+    if (p == end)   return false;
+
+    bool negative = false;
+    if (*p == '+' || *p == '-'){
+        negative = (*p == '-');
+        ++p;
+    }
+
+    //mantissa, up to 19 significant digits
+    uint64_t mantissa = 0;
+    int ndigits = 0, exponent = 0;
+    bool found = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p){
+        found = true;
+        if (ndigits < 19){
+            mantissa = 10*mantissa + uint64_t(*p - '0');
+            if (mantissa > 0)   ++ndigits;
+        }else{
+            ++exponent;
         }
-        if(ssub == "GRID"){
-            id = stoi(sread.substr(8,8));
-            mapnodes[id] = ipoint;
-            point[0] = stod(convertVertex(trim(sread.substr(24,8))));
-            point[1] = stod(convertVertex(trim(sread.substr(32,8))));
-            point[2] = stod(convertVertex(trim(sread.substr(40,8))));
-            points.push_back(point);
-            ipoint++;
-            getline(is,sread);
-            ssub = trim(sread.substr(0,8));
+    }
+    if (p < end && *p == '.'){
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p){
+            found = true;
+            if (ndigits < 19){
+                mantissa = 10*mantissa + uint64_t(*p - '0');
+                if (mantissa > 0)   ++ndigits;
+                --exponent;
+            }
         }
-        else if(ssub == "GRID*"){
-            id = stoi(sread.substr(16,16));
-            mapnodes[id] = ipoint;
-            point[0] = stod(convertVertex(trim(sread.substr(48,16))));
-            point[1] = stod(convertVertex(trim(sread.substr(64,16))));
-            point[2] = stod(convertVertex(trim(sread.substr(80,16))));
-            points.push_back(point);
-            ipoint++;
-            getline(is,sread);
-            ssub = trim(sread.substr(0,8));
+    }
+    if (!found) return false;
+
+    //exponent, explicit (E/D) or implicit (sign only)
+    if (p < end){
+        if (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D')  ++p;
+        else if (*p != '+' && *p != '-')    return false;
+        bool negexp = false;
+        if (p < end && (*p == '+' || *p == '-')){
+            negexp = (*p == '-');
+            ++p;
         }
-        else if(ssub == "CTRIA3"){
-            pid = stoi(sread.substr(16,8));
-            face[0] = mapnodes[stoi(sread.substr(24,8))];
-            face[1] = mapnodes[stoi(sread.substr(32,8))];
-            face[2] = mapnodes[stoi(sread.substr(40,8))];
-            faces.push_back(face);
-            PIDS.push_back(pid);
-            iface++;
-            getline(is,sread);
-            ssub = trim(sread.substr(0,8));
+        if (p == end)   return false;
+        int expvalue = 0;
+        for (; p < end; ++p){
+            if (*p < '0' || *p > '9')   return false;
+            if (expvalue < 10000)   expvalue = 10*expvalue + (*p - '0');
         }
-        else if(ssub == "CTRIA3*"){
-            pid = stoi(sread.substr(32,16));
-            face[0] = mapnodes[stoi(sread.substr(48,16))];
-            face[1] = mapnodes[stoi(sread.substr(64,16))];
-            face[2] = mapnodes[stoi(sread.substr(80,16))];
-            faces.push_back(face);
-            PIDS.push_back((short)pid);
-            iface++;
-            getline(is,sread);
-            ssub = trim(sread.substr(0,8));
+        exponent += negexp ? -expvalue : expvalue;
+    }
+
+    //exact fast path, otherwise rely on the standard library
+    if (mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22){
+        value = double(mantissa);
+        if (exponent >= 0)  value *= pow10[exponent];
+        else                value /= pow10[-exponent];
+    }else{
+        char buffer[48];
+        std::snprintf(buffer, sizeof(buffer), "%llue%d", (unsigned long long)mantissa, exponent);
+        value = std::strtod(buffer, NULL);
+    }
+    if (negative)   value = -value;
+    return true;
+}
+
+/*!
+ * Split a card in its keyword and data fields. Small and large field formats
+ * (fixed columns of 8 and 16 characters) and free field format (comma separated)
+ * are supported, as well as continuation lines. Comment lines between the card
+ * and its continuations are skipped.
+ * The i-th data field of the j-th line of the card is stored as the (j*n+i)-th field, being
+ * n the number of data fields per line (8 in small format, 4 in large format).
+ * \param[in] p beginning of the first line of the card
+ * \param[in] end end of the buffer
+ * \param[out] keyword keyword of the card, trimmed and without the large format mark '*'
+ * \param[out] fields data fields of the card (at most NAS_MAXFIELDS, missing fields are empty)
+ * \return number of data fields found
+ */
+static int nasSplitCard(const char * p, const char * end, std::string & keyword, NasField * fields){
+
+    for (int i=0; i<NAS_MAXFIELDS; ++i)    fields[i].begin = fields[i].end = p;
+
+    const char * lend = nasLineEnd(p, end);
+    bool freefield = (std::memchr(p, ',', std::size_t(lend - p)) != NULL);
+
+    //keyword
+    const char * kend = freefield ? static_cast<const char *>(std::memchr(p, ',', std::size_t(lend - p))) : std::min(p + 8, lend);
+    NasField key = nasTrim(NasField{p, kend});
+    bool large = (key.end > key.begin && *(key.end-1) == '*');
+    if (large)  --key.end;
+    keyword.assign(key.begin, key.end);
+    for (auto & c : keyword)    c = std::toupper((unsigned char)c);
+
+    int perline = large ? 4 : 8;
+    int width = large ? 16 : 8;
+    int nfields = 0;
+    int line = 0;
+    const char * q = p;
+    while (true){
+        int base = line*perline;
+        if (base >= NAS_MAXFIELDS)  break;
+        const char * start = (line == 0) ? kend : q;
+        if (freefield){
+            //skip the keyword or the continuation mark
+            const char * f = (line == 0) ? start : static_cast<const char *>(std::memchr(q, ',', std::size_t(lend - q)));
+            for (int i=0; f != NULL && f < lend && i < perline && base + i < NAS_MAXFIELDS; ++i){
+                const char * fbegin = f + 1;
+                const char * fend = static_cast<const char *>(std::memchr(fbegin, ',', std::size_t(lend - fbegin)));
+                if (fend == NULL)   fend = lend;
+                fields[base + i] = NasField{fbegin, fend};
+                nfields = std::max(nfields, base + i + 1);
+                f = (fend < lend) ? fend : NULL;
+            }
+        }else{
+            int lwidth = (line > 0 && *q == '*') ? 16 : width;
+            int lperline = (lwidth == 16) ? 4 : 8;
+            for (int i=0; i < lperline && i < perline && base + i < NAS_MAXFIELDS; ++i){
+                const char * fbegin = q + 8 + lwidth*i;
+                if (fbegin >= lend) break;
+                const char * fend = std::min(fbegin + lwidth, lend);
+                fields[base + i] = NasField{fbegin, fend};
+                nfields = std::max(nfields, base + i + 1);
+            }
         }
 
+        //look for a continuation line, skipping comments
+        q = nasNextLine(q, end);
+        while (q < end && *q == '$')    q = nasNextLine(q, end);
+        if (q >= end)   break;
+        lend = nasLineEnd(q, end);
+        if (!nasIsContinuation(q, lend))   break;
+        freefield = (std::memchr(q, ',', std::size_t(lend - q)) != NULL);
+        ++line;
     }
-    is.close();
+    return nfields;
 }
 
 /*!
- * Custom trimming of nas string 
- * \return trimmed string
- */
-string
-NastranInterface::trim(string in){
+ * Parse the cards of a chunk of a Nastran file. Only cards starting in the chunk are parsed.
+ * Supported cards are GRID, CTRIA3, CQUAD4, CTETRA and CHEXA (only corner nodes are retained
+ * for higher order elements); any other card is ignored. Element cards with a PID not
+ * representable as short are rejected as not parsable.
+ * \param[in] begin beginning of the chunk
+ * \param[in] cend end of the chunk
+ * \param[in] end end of the buffer
+ * \param[out] chunk parsed cards
+ */
+static void nasParseChunk(const char * begin, const char * cend, const char * end, NasChunk & chunk){
+
+    chunk.failed = false;
+    std::string keyword;
+    NasField fields[NAS_MAXFIELDS];
+    long value;
+
+    for (const char * p = begin; p < cend; p = nasNextLine(p, end)){
+        if (!std::isalpha((unsigned char)*p))  continue;
+        //cheap check on first character, before splitting the card
+        char c = std::toupper((unsigned char)*p);
+        if (c != 'G' && c != 'C')   continue;
+
+        int nfields = nasSplitCard(p, end, keyword, fields);
+
+        if (keyword == "GRID"){
+            darray3E point;
+            bool ok = (nfields >= 5) && nasParseInt(fields[0], value);
+            for (int j=0; ok && j<3; ++j){
+                NasField coord = nasTrim(fields[2+j]);
+                if (coord.begin == coord.end)   point[j] = 0.0;
+                else                            ok = nasParseReal(coord, point[j]);
+            }
+            if (!ok){
+                chunk.failed = true;
+                continue;
+            }
+            chunk.gridIds.push_back(value);
+            chunk.coords.insert(chunk.coords.end(), point.begin(), point.end());
+            continue;
+        }
+
+        bitpit::ElementInfo::Type type;
+        int nnodes;
+        if (keyword == "CTRIA3"){
+            type = bitpit::ElementInfo::TRIANGLE;
+            nnodes = 3;
+        }else if (keyword == "CQUAD4"){
+            type = bitpit::ElementInfo::QUAD;
+            nnodes = 4;
+        }else if (keyword == "CTETRA"){
+            type = bitpit::ElementInfo::TETRA;
+            nnodes = 4;
+        }else if (keyword == "CHEXA"){
+            type = bitpit::ElementInfo::HEXAHEDRON;
+            nnodes = 8;
+        }else{
+            continue;
+        }
 
-    stringstream out;
-    out << in;
-    out >> in;
-    return in;
+        long pid = 0;
+        bool ok = (nfields >= 2 + nnodes);
+        if (ok && nasTrim(fields[1]).begin != nasTrim(fields[1]).end)   ok = nasParseInt(fields[1], pid);
+        //PIDs are stored as short: cards with PIDs out of range are rejected, not wrapped
+        ok = ok && (pid >= long(std::numeric_limits<short>::min()) && pid <= long(std::numeric_limits<short>::max()));
+        std::size_t size = chunk.connect.size();
+        for (int j=0; ok && j<nnodes; ++j){
+            ok = nasParseInt(fields[2+j], value);
+            chunk.connect.push_back(value);
+        }
+        if (!ok){
+            chunk.connect.resize(size);
+            chunk.failed = true;
+            continue;
+        }
+        chunk.types.push_back(type);
+        chunk.pids.push_back(short(pid));
+    }
+}
+
+/*!
+ * \return number of vertices of an element type supported by the Nastran reader.
+ * \param[in] type element type
+ */
+static inline int nasElementSize(bitpit::ElementInfo::Type type){
+    switch (type){
+    case bitpit::ElementInfo::TRIANGLE:     return 3;
+    case bitpit::ElementInfo::QUAD:         return 4;
+    case bitpit::ElementInfo::TETRA:        return 4;
+    case bitpit::ElementInfo::HEXAHEDRON:   return 8;
+    default:                                return 0;
+    }
 }
 
 /*!
- * Convert nas string of numerical floats 
- * \return string of regular floats
+ * \return hash of a grid unique-id, for the open-addressing map of the Nastran reader.
+ * \param[in] id grid unique-id
  */
-string
-NastranInterface::convertVertex(string in){
-    int pos = in.find_last_of("-");
-    if (pos<(int)in.size() && pos > 0){
-        in.insert(pos, "E");
+static inline uint64_t nasHashId(long id){
+    return (uint64_t(id) * UINT64_C(0x9E3779B97F4A7C15)) >> 16;
+}
+
+/*!
+ * Read a bdf nastran file. The file is memory-mapped and split in chunks, which are
+ * parsed in parallel if mimmo is compiled with OpenMP support.
+ * Supported cards are GRID, CTRIA3, CQUAD4, CTETRA and CHEXA, in small, large or free field
+ * format, with continuation lines. Elements referring to undefined grids are discarded.
+ * \param[in] filename path to the file
+ * \param[out] points coordinates of the grids, in order of appearance in the file
+ * \param[out] connect connectivity of the elements as local indices of the grids, element after element
+ * \param[out] types type of each element, giving its number of vertices in connect
+ * \param[out] PIDS part identifier of each element
+ * \return false if the file cannot be read or some supported card cannot be parsed
+ */
+bool NastranInterface::read(const std::string & filename, dvecarr3E & points, livector1D & connect,
+                            std::vector<bitpit::ElementInfo::Type> & types, shivector1D & PIDS){
+
+    points.clear();
+    connect.clear();
+    types.clear();
+    PIDS.clear();
+
+    MappedFile file;
+    if (!file.open(filename))   return false;
+    const char * data = file.data();
+    const char * end = data + file.size();
+
+    //split in chunks starting with a card
+#if MIMMO_ENABLE_OPENMP
+    long nthreads = omp_get_max_threads();
+#else
+    long nthreads = 1;
+#endif
+    long nchunks = std::max(1L, std::min(16*nthreads, long(file.size() >> 20)));
+    std::vector<const char *> bounds(nchunks + 1);
+    bounds[0] = data;
+    bounds[nchunks] = end;
+    for (long k=1; k<nchunks; ++k){
+        const char * p = nasNextLine(data + file.size()*std::size_t(k)/std::size_t(nchunks) - 1, end);
+        while (p < end && !std::isalpha((unsigned char)*p))   p = nasNextLine(p, end);
+        bounds[k] = std::max(p, bounds[k-1]);
     }
-    else{
-        pos = in.find_last_of("+");
-        if (pos<(int)in.size() && pos > 0){
-            in.insert(pos, "E");
+
+    std::vector<NasChunk> chunks(nchunks);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long k=0; k<nchunks; ++k){
+        nasParseChunk(bounds[k], bounds[k+1], end, chunks[k]);
+    }
+    file.close();
+
+    //gather grids and elements
+    long ngrids, nelements, nconnect;
+    bool failed = false;
+    std::vector<long> gridOffset(nchunks + 1, 0), elementOffset(nchunks + 1, 0), connectOffset(nchunks + 1, 0);
+    for (long k=0; k<nchunks; ++k){
+        failed = failed || chunks[k].failed;
+        gridOffset[k+1] = gridOffset[k] + chunks[k].gridIds.size();
+        elementOffset[k+1] = elementOffset[k] + chunks[k].types.size();
+        connectOffset[k+1] = connectOffset[k] + chunks[k].connect.size();
+    }
+    ngrids = gridOffset[nchunks];
+    nelements = elementOffset[nchunks];
+    nconnect = connectOffset[nchunks];
+
+    std::vector<long> gridIds(ngrids);
+    std::vector<long> gridConnect(nconnect);
+    points.resize(ngrids);
+    types.resize(nelements);
+    PIDS.resize(nelements);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long k=0; k<nchunks; ++k){
+        NasChunk & chunk = chunks[k];
+        long n = chunk.gridIds.size();
+        for (long i=0; i<n; ++i){
+            gridIds[gridOffset[k] + i] = chunk.gridIds[i];
+            for (int j=0; j<3; ++j)    points[gridOffset[k] + i][j] = chunk.coords[3*i+j];
+        }
+        std::copy(chunk.types.begin(), chunk.types.end(), types.begin() + elementOffset[k]);
+        std::copy(chunk.pids.begin(), chunk.pids.end(), PIDS.begin() + elementOffset[k]);
+        std::copy(chunk.connect.begin(), chunk.connect.end(), gridConnect.begin() + connectOffset[k]);
+        chunk = NasChunk();
+    }
+    std::vector<NasChunk>().swap(chunks);
+
+    //map grid unique-ids to local indices: dense table if ids are compact, flat open-addressing
+    //hash table otherwise. If a grid id is repeated, the last grid wins.
+    long minId = 0, maxId = -1;
+    for (long i=0; i<ngrids; ++i){
+        if (i == 0 || gridIds[i] < minId) minId = gridIds[i];
+        maxId = std::max(maxId, gridIds[i]);
+    }
+    bool dense = (minId >= 0 && maxId < 4*ngrids + 1024);
+    std::vector<long> mapIndex;
+    std::vector<long> mapKeys;
+    uint64_t mask = 0;
+    if (dense){
+        mapIndex.resize(maxId + 1, -1);
+        for (long i=0; i<ngrids; ++i)   mapIndex[gridIds[i]] = i;
+    }else{
+        uint64_t capacity = 1;
+        while (capacity < uint64_t(2*ngrids))   capacity <<= 1;
+        mask = capacity - 1;
+        mapIndex.resize(capacity, -1);
+        mapKeys.resize(capacity);
+        for (long i=0; i<ngrids; ++i){
+            uint64_t slot = nasHashId(gridIds[i]) & mask;
+            while (mapIndex[slot] >= 0 && mapKeys[slot] != gridIds[i])  slot = (slot + 1) & mask;
+            mapKeys[slot] = gridIds[i];
+            mapIndex[slot] = i;
+        }
+    }
+    std::vector<long>().swap(gridIds);
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long i=0; i<nconnect; ++i){
+        long id = gridConnect[i];
+        long index = -1;
+        if (dense){
+            if (id >= 0 && id <= maxId)  index = mapIndex[id];
+        }else{
+            uint64_t slot = nasHashId(id) & mask;
+            while (mapIndex[slot] >= 0 && mapKeys[slot] != id)  slot = (slot + 1) & mask;
+            index = mapIndex[slot];
+        }
+        gridConnect[i] = index;
+    }
+
+    //discard elements referring to undefined grids
+    connect.reserve(nconnect);
+    long nvalid = 0;
+    long offset = 0;
+    for (long e=0; e<nelements; ++e){
+        int size = nasElementSize(types[e]);
+        bool valid = true;
+        for (int j=0; j<size; ++j)  valid = valid && (gridConnect[offset+j] >= 0);
+        if (valid){
+            connect.insert(connect.end(), gridConnect.begin() + offset, gridConnect.begin() + offset + size);
+            types[nvalid] = types[e];
+            PIDS[nvalid] = PIDS[e];
+            ++nvalid;
+        }
+        offset += size;
+    }
+    types.resize(nvalid);
+    PIDS.resize(nvalid);
+
+    return !failed;
+}
+
+/*!
+ * Read a bdf nastran surface file. Only triangular and quadrilateral elements are retained.
+ * See read(const std::string &, dvecarr3E &, livector1D &, std::vector<bitpit::ElementInfo::Type> &, shivector1D &).
+ * \param[in] inputDir    input directory
+ * \param[in] surfaceName    input filename
+ * \param[out] points    reference of a point container that has to be filled
+ * \param[out] faces     reference to element-point connectivity that has to be filled
+ * \param[out] PIDS        reference to short int vector for Part Identifier storage
+ */
+void NastranInterface::read(string& inputDir, string& surfaceName, dvecarr3E& points, ivector2D& faces, shivector1D& PIDS){
+
+    livector1D connect;
+    std::vector<bitpit::ElementInfo::Type> types;
+    shivector1D pids;
+    read(inputDir +"/"+surfaceName + ".nas", points, connect, types, pids);
+
+    faces.clear();
+    PIDS.clear();
+    long offset = 0;
+    for (std::size_t e=0; e<types.size(); ++e){
+        int size = nasElementSize(types[e]);
+        if (types[e] == bitpit::ElementInfo::TRIANGLE || types[e] == bitpit::ElementInfo::QUAD){
+            faces.push_back(ivector1D(connect.begin() + offset, connect.begin() + offset + size));
+            PIDS.push_back(pids[e]);
         }
+        offset += size;
     }
-    return in;
 }
 
 }
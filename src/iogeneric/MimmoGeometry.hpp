@@ -53,8 +53,8 @@ enum WFORMAT{    /*!Single precision data.*/        Short,
  *  standard MimmoObject class as product of its execution;
  *  The mesh to import/export/convert has to be a mesh with constant type elements.
  *  The valid format are: binary .stl, ascii .vtu (triangle/quadrilateral elements) and
- *  ascii .nas (triangle elements) for surface mesh; ascii .vtu (tetra/hexa elements)
- *  for volume mesh.
+ *  ascii .nas (triangle/quadrilateral elements) for surface mesh; ascii .vtu (tetra/hexa elements)
+ *  and ascii .nas (tetra/hexa elements) for volume mesh.
  *
  *  \n
  *  It can be used in three modes reader/writerconverter. To set the mode it uses an enum
@@ -71,11 +71,11 @@ enum WFORMAT{    /*!Single precision data.*/        Short,
  * - <B>SQVTU     = 2</B> Surface quadrilateral vtu.
  * - <B>VTVTU     = 3</B> Volume tetrahedral VTU.
  * - <B>VHVTU     = 4</B> Volume hexahedral VTU.
- * - <B>NAS     = 5</B> Nastran triangulation nas.
+ * - <B>NAS     = 5</B> Nastran surface (triangle/quadrilateral) or volume (tetra/hexa) mesh nas.
  * - <B>OFP     = 6</B> Ascii OpenFoam point cloud.
  * - <B>PCVTU   = 7</B> Point Cloud VTU
  * - <B>CURVEVTU= 8</B> 3D Curve in VTU
- * - <B>MIMMO   = 99</B> mimmo dump/restore format *.geomimmo
+ * - <B>MIMMO   = 99</B> mimmo native binary snapshot *.geomimmo (see GeoMimmoInterface)
  *
  * Outside this list of options, the class cannot hold any other type of formats for now.
  * The smart enum can be recalled in every moment in your code, just using <tt>mimmo::FileType</tt>
@@ -112,6 +112,7 @@ enum WFORMAT{    /*!Single precision data.*/        Short,
  * - <B>ReadFileType</B>: file type identifier for reader (to be used in case of converter mode);
  * - <B>WriteFileType</B>: file type identifier for writer (to be used in case of converter mode);
  * - <B>WriteMultiSolidSTL<B>: 0-false/1-true, if WriteFileType is STL, MultiSolid STL writing can be activated or not 
+ * - <B>ConformingVTU<B>: 0-false/1-true, if ReadFileType is a VTU, declare the file as conforming (no coincident/orphan vertices), skipping geometry cleaning after reading 
  * - <B>ReadDir</B>: directory path (to be used in case of converter mode and different paths);
  * - <B>ReadFilename</B>: name of file for reading/writing (to be used in case of converter mode and different filenames);
  * - <B>WriteDir</B>: directory path (to be used in case of converter mode and different paths);
@@ -119,6 +120,7 @@ enum WFORMAT{    /*!Single precision data.*/        Short,
  * - <B>Codex</B>: boolean to write ascii/binary;
  * - <B>BvTree</B>: evaluate bvTree true 1/false 0;
  * - <B>KdTree</B>: evaluate kdTree true 1/false 0.
+ * - <B>Compact</B>: set the geometry in compact mode (index maps built only on demand, see MimmoObject::setCompact) true 1/false 0.
  * - <B>AssignRefPID</B>: assign a reference PID on the whole geometry, after reading or just before writing. If the geometry is already pidded,
  *                     translate all existent PIDs w.r.t. the reference PID assigned. Default value is RefPID = 0. 
  *
@@ -141,8 +143,10 @@ private:
 
     bool        m_buildBvTree;                /**<If true the simplex ordered BvTree of the geometry is built in execution, whenever geometry support simplicies. */
     bool        m_buildKdTree;                /**<If true the vertex ordered KdTree of the geometry is built in execution*/
+    bool        m_compact;                    /**<If true the geometry is set in compact mode in execution*/
     short int   m_refPID;                     /**<Reference PID, to be assigned on all cells of geometry in read/convert mode*/
     bool        m_multiSolidSTL;            /**< activate or not MultiSolid STL writing if STL writing Filetype is selected */
+    bool        m_conformingVTU;            /**< if true, VTU files are assumed conforming and no cleaning is performed after reading */
 
 public:
     MimmoGeometry();
@@ -178,6 +182,7 @@ public:
     void        setFileType(int type);
     void        setCodex(bool binary = true);
     void        setMultiSolidSTL(bool multi = true);
+    void        setConformingVTU(bool conforming = true);
     
     void        setHARDCopy( const MimmoGeometry * other);
     void        setSOFTCopy( const MimmoGeometry * other);
@@ -199,6 +204,7 @@ public:
 
     void        setBuildBvTree(bool build);
     void        setBuildKdTree(bool build);
+    void        setCompact(bool compact);
     
     bool         isEmpty();
     bool        isInternal();
@@ -218,6 +224,7 @@ private:
     void    setDefaults();
     void    _setRead(bool read = true);
     void    _setWrite(bool write = true);
+    bool    readVTU(int type, bitpit::VTKElementType vtktype);
 
 
 };
@@ -226,6 +233,9 @@ private:
  * \class NastranInterface
  * \ingroup iogeneric
  * \brief NastranInterface is an interface class for I/O handling of BDF bulk nastran format *.nas.
+ *
+ * Files are read through a memory-mapped, chunk-parallel parser supporting GRID, CTRIA3,
+ * CQUAD4, CTETRA and CHEXA cards in small, large and free field format, with continuation lines.
  */
 class NastranInterface{
     static const char nl = '\n'; /**< static const declaration of new line command. */
@@ -240,11 +250,10 @@ public:
     void writeGeometry(dvecarr3E& points, ivector2D& faces, std::ofstream& os, shivector1D* PIDS = NULL);
     void writeFooter(std::ofstream& os, std::unordered_set<short>* PIDSSET = NULL);
     void write(std::string& outputDir, std::string& surfaceName, dvecarr3E& points, ivector2D& faces, shivector1D* PIDS = NULL, std::unordered_set<short>* PIDSSET = NULL);
+    bool read(const std::string & filename, dvecarr3E & points, livector1D & connect,
+              std::vector<bitpit::ElementInfo::Type> & types, shivector1D & PIDS);
     void read(std::string& inputDir, std::string& surfaceName, dvecarr3E& points, ivector2D& faces, shivector1D& PIDS);
 
-    std::string trim(std::string in);
-    std::string convertVertex(std::string in);
-
     /*!
      * Write a template value according to WFORMAT chosen by the User
      * \param[in]     value    value of class Type
@@ -23,6 +23,15 @@
 \*---------------------------------------------------------------------------*/
 
 #include "MultipleMimmoGeometries.hpp"
+#include "GeoMimmoInterface.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#if MIMMO_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace bitpit;
@@ -100,6 +109,8 @@ MultipleMimmoGeometries & MultipleMimmoGeometries::operator=(const MultipleMimmo
     m_codex = other.m_codex;
     m_buildBvTree = other.m_buildBvTree;
     m_buildKdTree = other.m_buildKdTree;
+    m_compact = other.m_compact;
+    m_maxLoadingMemory = other.m_maxLoadingMemory;
     m_topo = other.m_topo;
     m_ftype_allow = other.m_ftype_allow;
 
@@ -241,15 +252,7 @@ MultipleMimmoGeometries::getObjMAP(){
 
     for(int i=0; i<totVal; ++i){
 
-        std::string tag = "vtu";
-        switch(info[i].ftype){
-        case 0: tag="stl"; break;
-        case 5: tag="nas"; break;
-        case 6: tag="";       break;
-        default:    break;
-        }
-
-        fullpath = info[i].fdir+"/"+info[i].fname+"."+tag;
+        fullpath = getFilePath(info[i]);
 
         if(m_isInternal)    objMap[fullpath] = std::make_pair(info[i].ftype, m_intgeo[i].get());
         else                objMap[fullpath] = std::make_pair(info[i].ftype, m_extgeo[i]);
@@ -449,6 +452,8 @@ MultipleMimmoGeometries::setHARDCopy(const MultipleMimmoGeometries * other){
 
     m_buildBvTree = other->m_buildBvTree;
     m_buildKdTree = other->m_buildKdTree;
+    m_compact = other->m_compact;
+    m_maxLoadingMemory = other->m_maxLoadingMemory;
     m_extgeo = other->m_extgeo;
 
     m_isInternal = other->m_isInternal;
@@ -535,6 +540,27 @@ MultipleMimmoGeometries::setBuildKdTree(bool build){
     m_buildKdTree = build;
 }
 
+/*!It sets if all the geometries read have to be set in compact mode during execution,
+ * i.e. their index maps are built only on demand (see MimmoObject::setCompact).
+ * \param[in] compact If true the geometries are set in compact mode in execution.
+ */
+void
+MultipleMimmoGeometries::setCompact(bool compact){
+    m_compact = compact;
+}
+
+/*!It sets the maximum size of the files loaded concurrently in reading mode.
+ * A file is not started while the size of the files being loaded (read, cleaned
+ * and provided of their trees) would exceed the limit; a file larger than the limit
+ * is loaded alone. The size of the files is taken as estimate of the memory
+ * needed to load them. Default is 4096 MB.
+ * \param[in] mbytes maximum size in MB, 0 for no limit.
+ */
+void
+MultipleMimmoGeometries::setMaxLoadingMemory(long mbytes){
+    m_maxLoadingMemory = std::max(0L, mbytes);
+}
+
 /*!
  * Check if geometries are not linked or not locally instantiated in your class.
  * True - no geometries present, False otherwise.
@@ -624,6 +650,12 @@ MultipleMimmoGeometries::write(){
 
 /*!It reads the mesh geometries from a list of input files and put them in the internal 
  * MimmoObject list container. If an external container is linked, skip reading and do nothing.
+ * When mimmo is compiled with OpenMP support the files are loaded concurrently: each
+ * file is read, cleaned and provided of the requested trees independently, within
+ * the limit on the size of the files loaded at the same time (see setMaxLoadingMemory).
+ * Nested parallelism is enabled during the loading: the threads not needed by the files
+ * are shared among the files being loaded, and used by their parallel readers and tree builds.
+ * The loading time of each file is reported in the log.
  * \return False if files do not exist or not found geometry container to address to.
  */
 bool
@@ -632,29 +664,104 @@ MultipleMimmoGeometries::read(){
 
     setGeometry();
 
+    //readers are instantiated serially, block construction is not thread-safe.
+    int nfiles = m_rinfo.size();
+    if(nfiles == 0) return false;
+    std::vector<std::unique_ptr<MimmoGeometry> > readers(nfiles);
+    std::vector<long> sizes(nfiles, 0);
+    for(int k=0; k<nfiles; ++k){
+        if(m_rinfo[k].ftype == 99){
+            int type = GeoMimmoInterface::readType(getFilePath(m_rinfo[k]));
+            if(type > 0 && type != m_topo){
+                (*m_log) << m_name << " error: " << getFilePath(m_rinfo[k]) << " holds a geometry of type " << type
+                         << ", incompatible with the topology " << m_topo << std::endl;
+                throw std::runtime_error (m_name + ": geomimmo file of incompatible topology");
+            }
+        }
+        readers[k] = std::unique_ptr<MimmoGeometry>(new MimmoGeometry());
+        readers[k]->setIOMode(IOMode::READ);
+        readers[k]->setDir(m_rinfo[k].fdir);
+        readers[k]->setFilename(m_rinfo[k].fname);
+        readers[k]->setFileType(m_rinfo[k].ftype);
+        std::ifstream infile(getFilePath(m_rinfo[k]), std::ios::binary | std::ios::ate);
+        if(infile.good())   sizes[k] = long(infile.tellg());
+    }
+
     //absorbing Geometries.
-    int counter = 0;
-    m_intgeo.resize(m_rinfo.size());
-    for(auto & data: m_rinfo){
-        std::unique_ptr<MimmoGeometry> geo(new MimmoGeometry());
-        std::unique_ptr<MimmoObject> subData(new MimmoObject());
-        geo->setIOMode(IOMode::READ);
-        geo->setDir(data.fdir);
-        geo->setFilename(data.fname);
-        geo->setFileType(data.ftype);
-        geo->execute();
-
-        subData->setHARDCopy(geo->getGeometry());
-        m_intgeo[counter] = std::move(subData);
-        counter++;
+    m_intgeo.resize(nfiles);
+    std::vector<double> times(nfiles, 0.0);
+    std::vector<std::exception_ptr> errors(nfiles);
+    long maxBytes = m_maxLoadingMemory*1024*1024;
+    long loadingBytes = 0;
+    std::mutex loadingMutex;
+    std::condition_variable loadingCondition;
+    auto start = std::chrono::steady_clock::now();
+
+#if MIMMO_ENABLE_OPENMP
+    int pending = nfiles;
+    int nthreads = omp_get_max_threads();
+    int nteam = std::max(1, std::min(nfiles, nthreads));
+    int maxActiveLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(std::max(maxActiveLevels, omp_get_active_level() + 2));
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nteam) if(nfiles > 1)
+#endif
+    for(int k=0; k<nfiles; ++k){
+
+        //wait for the memory of the files being loaded
+        {
+            std::unique_lock<std::mutex> lock(loadingMutex);
+            loadingCondition.wait(lock, [&](){ return (maxBytes == 0 || loadingBytes == 0 || loadingBytes + sizes[k] <= maxBytes); });
+            loadingBytes += sizes[k];
+#if MIMMO_ENABLE_OPENMP
+            //the nested regions of the file get its share of the threads among the files not loaded yet
+            omp_set_num_threads(std::max(1, nthreads/std::min(pending, nteam)));
+#endif
+        }
+
+        auto fileStart = std::chrono::steady_clock::now();
+        try{
+            readers[k]->execute();
+
+            std::unique_ptr<MimmoObject> subData(new MimmoObject());
+            subData->setHARDCopy(readers[k]->getGeometry());
+            readers[k].reset(nullptr);
+
+            //geometries read from native binary snapshots are already clean, and may hold their search trees
+            if(m_rinfo[k].ftype != 99)    subData->cleanGeometry();
+            if(m_compact)        subData->setCompact(true);
+            if(m_buildBvTree)    subData->buildStructure(GeometryStructure::BVTREE);
+            if(m_buildKdTree)    subData->buildStructure(GeometryStructure::KDTREE);
+            m_intgeo[k] = std::move(subData);
+        }catch(...){
+            readers[k].reset(nullptr);
+            errors[k] = std::current_exception();
+        }
+        times[k] = std::chrono::duration<double>(std::chrono::steady_clock::now() - fileStart).count();
+
+        {
+            std::lock_guard<std::mutex> lock(loadingMutex);
+            loadingBytes -= sizes[k];
+#if MIMMO_ENABLE_OPENMP
+            --pending;
+#endif
+        }
+        loadingCondition.notify_all();
     }
-    if(counter == 0) return false;
-    m_intgeo.resize(counter);
+#if MIMMO_ENABLE_OPENMP
+    omp_set_max_active_levels(maxActiveLevels);
+#endif
+
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double maxTime = 0.0;
+    for(int k=0; k<nfiles; ++k){
+        if(errors[k])   (*m_log) << m_name << " error: loading failed for " << getFilePath(m_rinfo[k]) << std::endl;
+        else            (*m_log) << m_name << " loaded " << getFilePath(m_rinfo[k]) << " in " << times[k] << " s" << std::endl;
+        maxTime = std::max(maxTime, times[k]);
+    }
+    (*m_log) << m_name << " loaded " << nfiles << " files in " << total << " s (largest file " << maxTime << " s)" << std::endl;
 
-    for(auto & val: m_intgeo){
-        val->cleanGeometry();
-        if(m_buildBvTree)    val->buildBvTree();
-        if(m_buildKdTree)    val->buildKdTree();
+    for(int k=0; k<nfiles; ++k){
+        if(errors[k])   std::rethrow_exception(errors[k]);
     }
     return true;
 };
@@ -832,6 +939,26 @@ MultipleMimmoGeometries::absorbSectionXML(const bitpit::Config::Section & slotXM
         setBuildKdTree(value);
     };
 
+    if(slotXML.hasOption("Compact")){
+        input = slotXML.get("Compact");
+        bool value = false;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setCompact(value);
+    };
+
+    if(slotXML.hasOption("MaxLoadingMemory")){
+        input = slotXML.get("MaxLoadingMemory");
+        long value = 4096;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setMaxLoadingMemory(value);
+    };
+
 };
 
 /*!
@@ -901,10 +1028,37 @@ MultipleMimmoGeometries::flushSectionXML(bitpit::Config::Section & slotXML, std:
         slotXML.set("KdTree", output);
     }
 
+    if(m_compact){
+        output = std::to_string(m_compact);
+        slotXML.set("Compact", output);
+    }
+
+    if(m_maxLoadingMemory != 4096){
+        output = std::to_string(m_maxLoadingMemory);
+        slotXML.set("MaxLoadingMemory", output);
+    }
+
 };
 
 
 
+/*!
+ * \return full path of a geometry file, with the extension tag of its file type.
+ * \param[in] info file data of the geometry
+ */
+std::string
+MultipleMimmoGeometries::getFilePath(const FileDataInfo & info){
+    std::string tag = "vtu";
+    switch(info.ftype){
+    case 0: tag="stl"; break;
+    case 5: tag="nas"; break;
+    case 6: tag="";       break;
+    case 99: tag="geomimmo"; break;
+    default:    break;
+    }
+    return info.fdir+"/"+info.fname+"."+tag;
+}
+
 /*!
  * Set proper member of the class to defaults
  */
@@ -919,6 +1073,8 @@ MultipleMimmoGeometries::setDefaults(){
     m_codex = true;
     m_buildBvTree = false;
     m_buildKdTree = false;
+    m_compact = false;
+    m_maxLoadingMemory = 4096;
 }
 
 
@@ -933,7 +1089,7 @@ MultipleMimmoGeometries::initializeClass(int topo, bool IOMode){
     m_name         = "mimmo.MultipleGeometries";
     m_read = !IOMode; m_write = IOMode;
 
-    m_topo     = std::min(1, topo);
+    m_topo     = std::max(1, topo);
     if(m_topo > 4)    m_topo = 1;
 
     //checking admissible format
@@ -957,6 +1113,8 @@ MultipleMimmoGeometries::initializeClass(int topo, bool IOMode){
         m_ftype_allow.insert(7);
         break;
     }
+    //native binary snapshot, its stored topology is checked against m_topo when read
+    m_ftype_allow.insert(99);
 
     setDefaults();
 };
@@ -57,6 +57,7 @@ namespace mimmo{
  * - <B>OFP     = 6</B> Ascii OpenFoam point cloud.
  * - <B>PCVTU   = 7</B> Point Cloud VTU
  * - <B>CURVEVTU= 8</B> 3D Curve in VTU
+ * - <B>MIMMO   = 99</B> mimmo native binary snapshot *.geomimmo, admissible for any topology
  *
  * Outside this list of options, the class cannot hold any other type of formats for now.
  * The smart enum can be recalled in every moment in your code, just using <tt>mimmo::FileType</tt>
@@ -130,7 +131,9 @@ namespace mimmo{
  *      \</WriteInfoData\> </tt> \n
  * - <B>Codex</B>: boolean to write ascii/binary;
  * - <B>BvTree</B>: evaluate bvTree true/false;
- * - <B>KdTree</B>: evaluate kdTree true/false.
+ * - <B>KdTree</B>: evaluate kdTree true/false;
+ * - <B>Compact</B>: set the geometries in compact mode (index maps built only on demand, see MimmoObject::setCompact) true/false;
+ * - <B>MaxLoadingMemory</B>: maximum size in MB of the files read concurrently, 0 for no limit.
  *
  * In case of writing mode Geometry has to be mandatorily passed through port.
  *
@@ -155,6 +158,8 @@ private:
 
     bool        m_buildBvTree;                /**<If true the simplex ordered BvTree of every geometries is built in execution, whenever geometry support simplicies. */
     bool        m_buildKdTree;                /**<If true the vertex ordered KdTree of every geometries is built in execution*/
+    bool        m_compact;                    /**<If true every geometry read is set in compact mode in execution*/
+    long        m_maxLoadingMemory;           /**<Maximum size in MB of the files loaded concurrently, 0 for no limit */
 
 
 public:
@@ -202,6 +207,8 @@ public:
 
     void        setBuildBvTree(bool build);
     void        setBuildKdTree(bool build);
+    void        setCompact(bool compact);
+    void        setMaxLoadingMemory(long mbytes);
 
 
     bool         isEmpty();
@@ -223,6 +230,7 @@ private:
     void     setDefaults();
     void     initializeClass(int topo, bool IOMode);
     void    setGeometry();
+    std::string getFilePath(const FileDataInfo & info);
 };
 
 REGISTER(BaseManipulation, MultipleMimmoGeometries, "mimmo.MultipleGeometries")
@@ -0,0 +1,477 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include "STLInterface.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#if MIMMO_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+namespace mimmo{
+
+/*!
+ * Size of the header of a binary STL file (80 bytes of comments + number of triangles).
+ */
+static const std::size_t STL_HEADERSIZE = 84;
+
+/*!
+ * Size of a triangle record of a binary STL file (normal, 3 vertices, attribute).
+ */
+static const std::size_t STL_RECORDSIZE = 50;
+
+/*!
+ * Number of triangles written at once by the streaming binary writer.
+ */
+static const long STL_WRITEBLOCK = 65536;
+
+/*!
+ * \return number of threads available for parallel regions.
+ */
+static inline int stlThreads(){
+#if MIMMO_ENABLE_OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/*!
+ * Hash of the coordinates of a point. Negative zeros are hashed as positive ones.
+ * \param[in] P coordinates of the point
+ * \return hash value
+ */
+template<typename T>
+static inline uint64_t stlHash(const std::array<T,3> & P){
+    uint64_t h = 1469598103934665603ULL;
+    for (int j=0; j<3; ++j){
+        double value = double(P[j]) + 0.0;
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits ^= bits >> 29;
+        h = (h ^ bits) * 1099511628211ULL;
+        h ^= h >> 32;
+    }
+    h *= 0x9E3779B97F4A7C15ULL;
+    return h;
+}
+
+/*!
+ * \class STLPointHash
+ * \ingroup iogeneric
+ * \brief Hash functor of point coordinates, used to merge coincident STL vertices.
+ */
+template<typename T>
+struct STLPointHash{
+    /*!\return hash of the point coordinates.
+     * \param[in] P coordinates of the point */
+    std::size_t operator()(const std::array<T,3> & P) const{
+        return std::size_t(stlHash(P));
+    }
+};
+
+/*!
+ * Merge coincident corners of a list of triangles.
+ * Corners are distributed in bins according to the hash of their coordinates, then every
+ * bin is processed independently (in parallel if mimmo is compiled with OpenMP support).
+ * Vertices are numbered in order of first appearance in the corner list, so that the result
+ * does not depend on the number of threads.
+ * \param[in] ncorners number of corners (3 times the number of triangles)
+ * \param[in] corner functor returning the coordinates of a corner, given its index
+ * \param[out] connect vertex index of each corner
+ * \param[out] first index of the first corner of each vertex
+ */
+template<typename T, typename Accessor>
+static void stlMergeCorners(long ncorners, const Accessor & corner, std::vector<long> & connect, std::vector<long> & first){
+
+    int nthreads = stlThreads();
+    int nbits = 0;
+    while ((1 << nbits) < 8*nthreads && nbits < 12)   ++nbits;
+    long nbins = 1L << nbits;
+    long nchunks = std::max(1L, std::min(long(nthreads), ncorners / 4096 + 1));
+
+    //count corners per chunk and bin
+    std::vector<long> offsets(nchunks*nbins + 1, 0);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long k=0; k<nchunks; ++k){
+        long begin = ncorners*k/nchunks, end = ncorners*(k+1)/nchunks;
+        for (long c=begin; c<end; ++c){
+            uint64_t h = stlHash(corner(c));
+            long bin = nbits > 0 ? long(h >> (64-nbits)) : 0;
+            offsets[bin*nchunks + k + 1]++;
+        }
+    }
+    for (long i=0; i<nchunks*nbins; ++i)   offsets[i+1] += offsets[i];
+
+    //scatter corners bin by bin, keeping their order inside each bin
+    std::vector<long> order(ncorners);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long k=0; k<nchunks; ++k){
+        std::vector<long> position(nbins);
+        for (long bin=0; bin<nbins; ++bin)  position[bin] = offsets[bin*nchunks + k];
+        long begin = ncorners*k/nchunks, end = ncorners*(k+1)/nchunks;
+        for (long c=begin; c<end; ++c){
+            uint64_t h = stlHash(corner(c));
+            long bin = nbits > 0 ? long(h >> (64-nbits)) : 0;
+            order[position[bin]++] = c;
+        }
+    }
+
+    //find the first coincident corner of each corner
+    connect.resize(ncorners);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long bin=0; bin<nbins; ++bin){
+        long begin = offsets[bin*nchunks], end = offsets[(bin+1)*nchunks];
+        std::unordered_map<std::array<T,3>, long, STLPointHash<T> > points;
+        points.reserve(std::size_t(end - begin));
+        for (long i=begin; i<end; ++i){
+            long c = order[i];
+            std::array<T,3> P = corner(c);
+            for (int j=0; j<3; ++j)    P[j] += T(0);
+            connect[c] = points.insert(std::make_pair(P, c)).first->second;
+        }
+    }
+
+    //number the vertices in order of first appearance
+    std::vector<long>().swap(offsets);
+    long nvertices = 0;
+    for (long c=0; c<ncorners; ++c){
+        if (connect[c] == c){
+            order[c] = nvertices;
+            ++nvertices;
+        }
+    }
+    first.resize(nvertices);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long c=0; c<ncorners; ++c){
+        if (connect[c] == c)    first[order[c]] = c;
+    }
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long c=0; c<ncorners; ++c){
+        connect[c] = order[connect[c]];
+    }
+}
+
+/*!
+ * Fill a geometry with the merged vertices and the triangles read from a STL file.
+ * \param[in] geo target geometry
+ * \param[in] corner functor returning the coordinates of a corner, given its index
+ * \param[in] connect vertex index of each corner
+ * \param[in] first index of the first corner of each vertex
+ * \param[in] pids part identifier of each triangle (if empty, all triangles have PID 0)
+ * \return false if a vertex or a triangle cannot be inserted in the geometry
+ */
+template<typename Accessor>
+static bool stlFillGeometry(MimmoObject * geo, const Accessor & corner, const std::vector<long> & connect,
+                            const std::vector<long> & first, const std::vector<short> & pids){
+    long nvertices = first.size();
+    long ntriangles = connect.size() / 3;
+    geo->getPatch()->reserveVertices(nvertices);
+    geo->getPatch()->reserveCells(ntriangles);
+
+    darray3E coords;
+    for (long v=0; v<nvertices; ++v){
+        auto P = corner(first[v]);
+        for (int j=0; j<3; ++j)    coords[j] = double(P[j]);
+        if (!geo->addVertex(coords, v))    return false;
+    }
+
+    livector1D conn(3);
+    for (long t=0; t<ntriangles; ++t){
+        for (int j=0; j<3; ++j)    conn[j] = connect[3*t+j];
+        short pid = pids.empty() ? 0 : pids[t];
+        if (!geo->addConnectedCell(conn, bitpit::ElementInfo::TRIANGLE, pid, t))  return false;
+    }
+    return true;
+}
+
+/*!
+ * \return pointer to the beginning of the next line of a text buffer.
+ * \param[in] p current position in the buffer
+ * \param[in] end end of the buffer
+ */
+static inline const char * stlNextLine(const char * p, const char * end){
+    const char * q = static_cast<const char *>(std::memchr(p, '\n', std::size_t(end - p)));
+    return (q == NULL) ? end : q + 1;
+}
+
+/*!
+ * \return pointer to the first character of a text buffer which is not a blank.
+ * \param[in] p current position in the buffer
+ * \param[in] end end of the buffer
+ */
+static inline const char * stlSkipBlanks(const char * p, const char * end){
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))    ++p;
+    return p;
+}
+
+/*!
+ * Check, case insensitive, if a text buffer starts with a keyword followed by a blank.
+ * \param[in] p current position in the buffer
+ * \param[in] end end of the buffer
+ * \param[in] key keyword, lower case
+ * \return true if the keyword is found
+ */
+static inline bool stlIsKeyword(const char * p, const char * end, const char * key){
+    std::size_t n = std::strlen(key);
+    if (std::size_t(end - p) < n)  return false;
+    for (std::size_t i=0; i<n; ++i){
+        if (std::tolower(p[i]) != key[i])  return false;
+    }
+    return (std::size_t(end - p) == n || std::isspace(p[n]));
+}
+
+/*!
+ * Parse a floating point value from a text buffer, advancing the current position.
+ * \param[in,out] p current position in the buffer
+ * \param[in] end end of the buffer
+ * \param[out] value parsed value
+ * \return false if no value is found
+ */
+static inline bool stlParseValue(const char *& p, const char * end, double & value){
+    p = stlSkipBlanks(p, end);
+    char token[64];
+    std::size_t n = 0;
+    while (p < end && n < sizeof(token)-1 && !std::isspace(*p))   token[n++] = *(p++);
+    token[n] = '\0';
+    if (n == 0) return false;
+    char * tail;
+    value = std::strtod(token, &tail);
+    return (tail != token);
+}
+
+/*!
+ * Check if a STL file is binary. The file is binary if its size matches the number
+ * of triangles declared in the binary header.
+ * \param[in] filename path to the file
+ * \return true if the file is a binary STL file
+ */
+bool
+STLInterface::isBinary(const std::string & filename){
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.good()) return false;
+    std::streamoff size = in.tellg();
+    if (size < std::streamoff(STL_HEADERSIZE)) return false;
+    uint32_t ntriangles;
+    in.seekg(STL_HEADERSIZE - sizeof(uint32_t));
+    in.read(reinterpret_cast<char *>(&ntriangles), sizeof(uint32_t));
+    return (size == std::streamoff(STL_HEADERSIZE + STL_RECORDSIZE*std::size_t(ntriangles)));
+}
+
+/*!
+ * Read a STL file, binary or ASCII, and fill a geometry with its triangulation.
+ * Coincident vertices are merged while reading.
+ * \param[in] filename path to the file
+ * \param[in] geo target surface geometry, empty
+ * \return false if the target geometry is not an empty surface, the file cannot be read,
+ * it contains no triangles or they cannot be inserted in the geometry
+ */
+bool
+STLInterface::read(const std::string & filename, MimmoObject * geo){
+
+    if (geo == NULL || geo->isEmpty()) return false;
+    if (geo->getType() != 1 || geo->getNVertex() != 0 || geo->getNCells() != 0)   return false;
+    bool binary = isBinary(filename);
+
+    MappedFile file;
+    if (!file.open(filename))   return false;
+    const char * data = file.data();
+    const char * end = data + file.size();
+
+    std::vector<long> connect, first;
+
+    if (binary){
+        uint32_t ntriangles;
+        std::memcpy(&ntriangles, data + STL_HEADERSIZE - sizeof(uint32_t), sizeof(uint32_t));
+        if (ntriangles == 0)   return false;
+        const char * records = data + STL_HEADERSIZE;
+        auto corner = [records](long c){
+            std::array<float,3> P;
+            std::memcpy(P.data(), records + STL_RECORDSIZE*std::size_t(c/3) + 12*std::size_t(1 + c%3), 3*sizeof(float));
+            return P;
+        };
+        stlMergeCorners<float>(3*long(ntriangles), corner, connect, first);
+        return stlFillGeometry(geo, corner, connect, first, std::vector<short>());
+    }
+
+    //ASCII file: split in chunks starting at the beginning of a line
+    long nchunks = std::max(1L, std::min(long(16*stlThreads()), long(file.size() >> 20)));
+    std::vector<const char *> bounds(nchunks + 1);
+    bounds[0] = data;
+    bounds[nchunks] = end;
+    for (long k=1; k<nchunks; ++k){
+        bounds[k] = stlNextLine(data + file.size()*std::size_t(k)/std::size_t(nchunks) - 1, end);
+    }
+
+    //count facets and solids of each chunk
+    std::vector<long> nfacets(nchunks + 1, 0), nsolids(nchunks + 1, 0);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long k=0; k<nchunks; ++k){
+        for (const char * p = bounds[k]; p < bounds[k+1]; p = stlNextLine(p, end)){
+            const char * q = stlSkipBlanks(p, end);
+            if (stlIsKeyword(q, end, "facet"))       nfacets[k+1]++;
+            else if (stlIsKeyword(q, end, "solid"))  nsolids[k+1]++;
+        }
+    }
+    for (long k=0; k<nchunks; ++k){
+        nfacets[k+1] += nfacets[k];
+        nsolids[k+1] += nsolids[k];
+    }
+    long ntriangles = nfacets[nchunks];
+    if (ntriangles == 0)   return false;
+
+    //parse the facets of each chunk
+    std::vector<double> coords(9*ntriangles);
+    std::vector<short> pids(ntriangles);
+    bool failed = false;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(||:failed)
+#endif
+    for (long k=0; k<nchunks; ++k){
+        long t = nfacets[k];
+        long solid = nsolids[k];
+        for (const char * p = bounds[k]; p < bounds[k+1]; p = stlNextLine(p, end)){
+            const char * q = stlSkipBlanks(p, end);
+            if (stlIsKeyword(q, end, "solid")){
+                ++solid;
+                continue;
+            }
+            if (!stlIsKeyword(q, end, "facet"))  continue;
+
+            int nvertices = 0;
+            const char * r = stlNextLine(p, end);
+            while (r < end && nvertices < 3){
+                const char * s = stlSkipBlanks(r, end);
+                if (stlIsKeyword(s, end, "vertex")){
+                    s += 6;
+                    for (int j=0; j<3; ++j){
+                        if (!stlParseValue(s, end, coords[9*t + 3*nvertices + j]))  failed = true;
+                    }
+                    ++nvertices;
+                }else if (stlIsKeyword(s, end, "endfacet") || stlIsKeyword(s, end, "facet")){
+                    break;
+                }
+                r = stlNextLine(r, end);
+            }
+            if (nvertices < 3)  failed = true;
+            pids[t] = short(std::max(0L, solid - 1));
+            ++t;
+        }
+    }
+    file.close();
+    if (failed) return false;
+
+    auto corner = [&coords](long c){
+        return std::array<double,3>({{coords[3*c], coords[3*c+1], coords[3*c+2]}});
+    };
+    stlMergeCorners<double>(3*ntriangles, corner, connect, first);
+    return stlFillGeometry(geo, corner, connect, first, pids);
+}
+
+/*!
+ * Write a triangulated surface geometry in a binary STL file.
+ * Triangles are written in blocks, whose records are filled in parallel if mimmo is
+ * compiled with OpenMP support; no copy of the whole geometry is created.
+ * \param[in] filename path to the file
+ * \param[in] geo surface geometry made of triangles only
+ * \return false if the geometry is not a triangulation or the file cannot be written
+ */
+bool
+STLInterface::writeBinary(const std::string & filename, MimmoObject * geo){
+
+    if (geo == NULL || geo->isEmpty()) return false;
+    if (geo->getType() != 1)    return false;
+    bitpit::PatchKernel * patch = geo->getPatch();
+    for (const auto & cell : patch->getCells()){
+        if (cell.getType() != bitpit::ElementInfo::TRIANGLE)    return false;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.good())    return false;
+
+    char header[STL_HEADERSIZE];
+    std::memset(header, 0, STL_HEADERSIZE);
+    std::strncpy(header, "mimmo binary STL", 80);
+    uint32_t ntriangles = uint32_t(geo->getNCells());
+    std::memcpy(header + STL_HEADERSIZE - sizeof(uint32_t), &ntriangles, sizeof(uint32_t));
+    out.write(header, STL_HEADERSIZE);
+
+    std::vector<const bitpit::Cell *> block;
+    block.reserve(STL_WRITEBLOCK);
+    std::vector<char> buffer(STL_RECORDSIZE*STL_WRITEBLOCK);
+
+    auto flush = [&](){
+        long nblock = block.size();
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (long i=0; i<nblock; ++i){
+            const long * conn = block[i]->getConnect();
+            std::array<darray3E,3> V;
+            for (int j=0; j<3; ++j)    V[j] = patch->getVertexCoords(conn[j]);
+            darray3E normal = crossProduct(V[1]-V[0], V[2]-V[0]);
+            double area = norm2(normal);
+            if (area > 0.0)    normal /= area;
+
+            float values[12];
+            for (int j=0; j<3; ++j){
+                values[j] = float(normal[j]);
+                for (int v=0; v<3; ++v)    values[3 + 3*v + j] = float(V[v][j]);
+            }
+            char * record = buffer.data() + STL_RECORDSIZE*i;
+            std::memcpy(record, values, sizeof(values));
+            std::memset(record + sizeof(values), 0, STL_RECORDSIZE - sizeof(values));
+        }
+        out.write(buffer.data(), STL_RECORDSIZE*nblock);
+        block.clear();
+    };
+
+    for (const auto & cell : patch->getCells()){
+        block.push_back(&cell);
+        if (long(block.size()) == STL_WRITEBLOCK)    flush();
+    }
+    if (!block.empty())   flush();
+
+    return out.good();
+}
+
+}
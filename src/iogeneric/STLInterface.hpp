@@ -0,0 +1,61 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#ifndef __STLINTERFACE_HPP__
+#define __STLINTERFACE_HPP__
+
+#include "MimmoObject.hpp"
+#include <string>
+
+namespace mimmo{
+
+/*!
+ * \class STLInterface
+ * \ingroup iogeneric
+ * \brief STLInterface is an interface class for native I/O handling of STL triangulations *.stl.
+ *
+ * Binary files are memory-mapped (where supported by the platform) and read in place,
+ * ASCII files are parsed in parallel chunks. Coincident vertices are merged while reading,
+ * through a spatial hash of their coordinates, so that the target MimmoObject is filled
+ * once, with exact reserved sizes and without any further cleaning of the geometry.
+ * Vertices are merged only if their coordinates are exactly the same, as it happens for
+ * STL files written by any mesh generator.
+ * Multi-solid ASCII files are supported: cells of the i-th solid are marked with PID i.
+ *
+ * Binary files can be written in a streaming fashion, without building any intermediate
+ * copy of the geometry.
+ * Binary data are read/written in the native byte order, which is assumed little-endian as
+ * prescribed by the format.
+ */
+class STLInterface{
+
+public:
+    static bool isBinary(const std::string & filename);
+
+    bool read(const std::string & filename, MimmoObject * geo);
+    bool writeBinary(const std::string & filename, MimmoObject * geo);
+};
+
+}
+
+#endif /* __STLINTERFACE_HPP__ */
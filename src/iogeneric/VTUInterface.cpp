@@ -0,0 +1,382 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include "VTUInterface.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace mimmo{
+
+/*!
+ * \enum VTUDataType
+ * \ingroup iogeneric
+ * Data types of the arrays of a VTU file.
+ */
+enum VTUDataType{
+    VTU_INT8, VTU_UINT8, VTU_INT16, VTU_UINT16, VTU_INT32, VTU_UINT32,
+    VTU_INT64, VTU_UINT64, VTU_FLOAT32, VTU_FLOAT64, VTU_UNKNOWN
+};
+
+/*!
+ * \class VTUArray
+ * \ingroup iogeneric
+ * \brief VTUArray is an ad-hoc struct pointing to the content of a data array of a VTU file.
+ */
+struct VTUArray{
+    bool            found;      /**< true if the array is present in the file */
+    VTUDataType     type;       /**< data type of the array */
+    int             components; /**< number of components of the array */
+    bool            ascii;      /**< true if data are stored in ascii format */
+    const char *    begin;      /**< beginning of the data */
+    const char *    end;        /**< end of the data */
+};
+
+/*!
+ * \class VTUCursor
+ * \ingroup iogeneric
+ * \brief VTUCursor is an ad-hoc struct reading sequentially the values of a VTUArray.
+ */
+struct VTUCursor{
+    const char *    p;      /**< current position */
+    const char *    end;    /**< end of the data */
+    VTUDataType     type;   /**< data type of the array */
+    bool            ascii;  /**< true if data are stored in ascii format */
+};
+
+/*!
+ * \return data type from its VTK name.
+ * \param[in] name VTK name of the data type
+ */
+static VTUDataType vtuDataType(const std::string & name){
+    if (name == "Int8")     return VTU_INT8;
+    if (name == "UInt8")    return VTU_UINT8;
+    if (name == "Int16")    return VTU_INT16;
+    if (name == "UInt16")   return VTU_UINT16;
+    if (name == "Int32")    return VTU_INT32;
+    if (name == "UInt32")   return VTU_UINT32;
+    if (name == "Int64")    return VTU_INT64;
+    if (name == "UInt64")   return VTU_UINT64;
+    if (name == "Float32")  return VTU_FLOAT32;
+    if (name == "Float64")  return VTU_FLOAT64;
+    return VTU_UNKNOWN;
+}
+
+/*!
+ * \return size in bytes of a data type.
+ * \param[in] type data type
+ */
+static std::size_t vtuDataSize(VTUDataType type){
+    switch (type){
+    case VTU_INT8:      case VTU_UINT8:     return 1;
+    case VTU_INT16:     case VTU_UINT16:    return 2;
+    case VTU_INT32:     case VTU_UINT32:    case VTU_FLOAT32:   return 4;
+    case VTU_INT64:     case VTU_UINT64:    case VTU_FLOAT64:   return 8;
+    default:            return 0;
+    }
+}
+
+/*!
+ * Find a token in a buffer.
+ * \param[in] p beginning of the buffer
+ * \param[in] end end of the buffer
+ * \param[in] token token to be found
+ * \return pointer to the first occurrence of the token, end if not found
+ */
+static inline const char * vtuFind(const char * p, const char * end, const char * token){
+    return std::search(p, end, token, token + std::strlen(token));
+}
+
+/*!
+ * Get the value of an attribute of a XML tag.
+ * \param[in] tag beginning of the tag
+ * \param[in] tagEnd end of the tag
+ * \param[in] name name of the attribute
+ * \param[out] value value of the attribute
+ * \return false if the attribute is not found
+ */
+static bool vtuAttribute(const char * tag, const char * tagEnd, const std::string & name, std::string & value){
+    std::string key = " " + name + "=\"";
+    const char * p = vtuFind(tag, tagEnd, key.c_str());
+    if (p == tagEnd)    return false;
+    p += key.size();
+    const char * q = std::find(p, tagEnd, '"');
+    if (q == tagEnd)    return false;
+    value.assign(p, q);
+    return true;
+}
+
+/*!
+ * Read the next value of a data array, converting it to type T.
+ * \param[in,out] cursor cursor on the data array
+ * \param[out] value value read
+ * \return false if no more values can be read
+ */
+template<typename T>
+static inline bool vtuNext(VTUCursor & cursor, T & value){
+    if (cursor.ascii){
+        while (cursor.p < cursor.end && std::isspace((unsigned char)*cursor.p))  ++cursor.p;
+        if (cursor.p >= cursor.end) return false;
+        char * q;
+        if (cursor.type == VTU_FLOAT32 || cursor.type == VTU_FLOAT64){
+            value = T(std::strtod(cursor.p, &q));
+        }else{
+            value = T(std::strtoll(cursor.p, &q, 10));
+        }
+        if (q == cursor.p || q > cursor.end)    return false;
+        cursor.p = q;
+        return true;
+    }
+
+    std::size_t size = vtuDataSize(cursor.type);
+    if (cursor.p + size > cursor.end)   return false;
+    switch (cursor.type){
+    case VTU_INT8:      {int8_t v;   std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_UINT8:     {uint8_t v;  std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_INT16:     {int16_t v;  std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_UINT16:    {uint16_t v; std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_INT32:     {int32_t v;  std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_UINT32:    {uint32_t v; std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_INT64:     {int64_t v;  std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_UINT64:    {uint64_t v; std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_FLOAT32:   {float v;    std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    case VTU_FLOAT64:   {double v;   std::memcpy(&v, cursor.p, size); value = T(v);} break;
+    default:            return false;
+    }
+    cursor.p += size;
+    return true;
+}
+
+/*!
+ * \return a cursor positioned at the beginning of a data array.
+ * \param[in] array data array
+ */
+static inline VTUCursor vtuCursor(const VTUArray & array){
+    return VTUCursor{array.begin, array.end, array.type, array.ascii};
+}
+
+/*!
+ * Check if a binary data array holds exactly the expected number of values.
+ * Ascii arrays are not checked, as their size is unknown until they are parsed.
+ * \param[in] array data array
+ * \param[in] nvalues expected number of values
+ * \return false if the array size does not match
+ */
+static inline bool vtuCheckSize(const VTUArray & array, long nvalues){
+    if (array.ascii)    return true;
+    return std::size_t(array.end - array.begin) == std::size_t(nvalues)*vtuDataSize(array.type);
+}
+
+/*!
+ * \return the element type corresponding to a VTK cell type, bitpit::ElementInfo::UNDEFINED
+ * if the cell type is not supported for the geometry type.
+ * \param[in] vtkType VTK cell type
+ * \param[in] geoType type of the MimmoObject (1 surface, 2 volume)
+ */
+static inline bitpit::ElementInfo::Type vtuElementType(long vtkType, int geoType){
+    if (geoType == 1){
+        if (vtkType == 5)   return bitpit::ElementInfo::TRIANGLE;
+        if (vtkType == 9)   return bitpit::ElementInfo::QUAD;
+    }else if (geoType == 2){
+        if (vtkType == 10)  return bitpit::ElementInfo::TETRA;
+        if (vtkType == 12)  return bitpit::ElementInfo::HEXAHEDRON;
+    }
+    return bitpit::ElementInfo::UNDEFINED;
+}
+
+/*!
+ * Read a VTU file and fill the geometry. Vertices and cells are inserted with the
+ * ids given by their position in the file.
+ * \param[in] filename path to the file
+ * \param[in,out] geo target empty surface or volume MimmoObject
+ * \return false if the file cannot be opened, is not supported or is corrupted
+ * (negative sizes, PIDs not representable as short). If the file is not supported
+ * the geometry is left untouched.
+ */
+bool
+VTUInterface::read(const std::string & filename, MimmoObject * geo){
+
+    if (geo == NULL || (geo->getType() != 1 && geo->getType() != 2))   return false;
+
+    MappedFile file;
+    if (!file.open(filename))   return false;
+    const char * data = file.data();
+    const char * end = data + file.size();
+
+    //file header: only uncompressed little-endian unstructured grids are supported
+    const char * tag = vtuFind(data, end, "<VTKFile");
+    if (tag == end) return false;
+    const char * tagEnd = std::find(tag, end, '>');
+    std::string value;
+    if (!vtuAttribute(tag, tagEnd, "type", value) || value != "UnstructuredGrid")   return false;
+    if (vtuAttribute(tag, tagEnd, "compressor", value))  return false;
+    if (vtuAttribute(tag, tagEnd, "byte_order", value) && value != "LittleEndian")  return false;
+    std::size_t headerSize = 4;
+    if (vtuAttribute(tag, tagEnd, "header_type", value)){
+        if (value == "UInt64")      headerSize = 8;
+        else if (value != "UInt32") return false;
+    }
+
+    //raw appended data, if any
+    const char * xmlEnd = vtuFind(tagEnd, end, "<AppendedData");
+    const char * appended = NULL;
+    if (xmlEnd != end){
+        const char * appendedEnd = std::find(xmlEnd, end, '>');
+        if (!vtuAttribute(xmlEnd, appendedEnd, "encoding", value) || value != "raw")  return false;
+        appended = std::find(appendedEnd, end, '_');
+        if (appended == end)    return false;
+        ++appended;
+    }
+
+    //piece sizes
+    tag = vtuFind(tagEnd, xmlEnd, "<Piece");
+    if (tag == xmlEnd)  return false;
+    tagEnd = std::find(tag, xmlEnd, '>');
+    long nPoints, nCells;
+    char * tail;
+    if (!vtuAttribute(tag, tagEnd, "NumberOfPoints", value))    return false;
+    nPoints = std::strtol(value.c_str(), &tail, 10);
+    if (tail == value.c_str() || nPoints < 0)   return false;
+    if (!vtuAttribute(tag, tagEnd, "NumberOfCells", value))     return false;
+    nCells = std::strtol(value.c_str(), &tail, 10);
+    if (tail == value.c_str() || nCells < 0)    return false;
+
+    //locate the data arrays of interest, walking the XML tags in order
+    VTUArray points{}, connectivity{}, types{}, pids{};
+    std::string section;
+    for (const char * p = std::find(tagEnd, xmlEnd, '<'); p < xmlEnd; p = std::find(p + 1, xmlEnd, '<')){
+        if (std::strncmp(p, "<Points", 7) == 0)         section = "Points";
+        else if (std::strncmp(p, "<Cells", 6) == 0)     section = "Cells";
+        else if (std::strncmp(p, "<CellData", 9) == 0)  section = "CellData";
+        else if (std::strncmp(p, "<PointData", 10) == 0)section = "PointData";
+        else if (std::strncmp(p, "</", 2) == 0 && std::strncmp(p, "</DataArray", 11) != 0)  section.clear();
+        if (std::strncmp(p, "<DataArray", 10) != 0) continue;
+
+        tagEnd = std::find(p, xmlEnd, '>');
+        std::string name;
+        vtuAttribute(p, tagEnd, "Name", name);
+        VTUArray * target = NULL;
+        if (section == "Points" && !points.found)                   target = &points;
+        else if (section == "Cells" && name == "connectivity")      target = &connectivity;
+        else if (section == "Cells" && name == "types")             target = &types;
+        else if (section == "CellData" && name == "PID")            target = &pids;
+        if (target == NULL) continue;
+
+        VTUArray array{};
+        array.found = true;
+        if (!vtuAttribute(p, tagEnd, "type", value))    return false;
+        array.type = vtuDataType(value);
+        if (array.type == VTU_UNKNOWN)  return false;
+        array.components = 1;
+        if (vtuAttribute(p, tagEnd, "NumberOfComponents", value))   array.components = std::atoi(value.c_str());
+        if (!vtuAttribute(p, tagEnd, "format", value))  return false;
+        if (value == "ascii"){
+            array.ascii = true;
+            array.begin = tagEnd + 1;
+            array.end = vtuFind(array.begin, xmlEnd, "</DataArray");
+        }else if (value == "appended" && appended != NULL){
+            if (!vtuAttribute(p, tagEnd, "offset", value))  return false;
+            const char * header = appended + std::strtoull(value.c_str(), NULL, 10);
+            if (header < appended || header + headerSize > end)  return false;
+            uint64_t nbytes = 0;
+            if (headerSize == 4){
+                uint32_t nbytes32;
+                std::memcpy(&nbytes32, header, 4);
+                nbytes = nbytes32;
+            }else{
+                std::memcpy(&nbytes, header, 8);
+            }
+            array.ascii = false;
+            array.begin = header + headerSize;
+            if (nbytes > uint64_t(end - array.begin))   return false;
+            array.end = array.begin + nbytes;
+        }else{
+            return false;
+        }
+        *target = array;
+    }
+
+    if (!points.found || points.components != 3 || (points.type != VTU_FLOAT32 && points.type != VTU_FLOAT64))    return false;
+    if (!connectivity.found || !types.found)    return false;
+    if (!vtuCheckSize(points, 3*nPoints) || !vtuCheckSize(types, nCells))   return false;
+    if (pids.found && !vtuCheckSize(pids, nCells))  return false;
+
+    //check cell types and connectivity size, before touching the geometry
+    int geoType = geo->getType();
+    long nConnect = 0;
+    VTUCursor typeCursor = vtuCursor(types);
+    for (long i=0; i<nCells; ++i){
+        long vtkType;
+        if (!vtuNext(typeCursor, vtkType))  return false;
+        bitpit::ElementInfo::Type eltype = vtuElementType(vtkType, geoType);
+        if (eltype == bitpit::ElementInfo::UNDEFINED)   return false;
+        nConnect += bitpit::ElementInfo::getElementInfo(eltype).nVertices;
+    }
+    if (!vtuCheckSize(connectivity, nConnect))  return false;
+
+    //stream vertices and cells into the geometry
+    bitpit::PatchKernel * patch = geo->getPatch();
+    patch->reserveVertices(nPoints);
+    patch->reserveCells(nCells);
+
+    VTUCursor pointCursor = vtuCursor(points);
+    darray3E coords;
+    for (long i=0; i<nPoints; ++i){
+        for (int j=0; j<3; ++j){
+            if (!vtuNext(pointCursor, coords[j]))   return false;
+        }
+        geo->addVertex(coords, i);
+    }
+
+    typeCursor = vtuCursor(types);
+    VTUCursor connectCursor = vtuCursor(connectivity);
+    VTUCursor pidCursor = vtuCursor(pids);
+    livector1D conn;
+    for (long i=0; i<nCells; ++i){
+        long vtkType;
+        vtuNext(typeCursor, vtkType);
+        bitpit::ElementInfo::Type eltype = vtuElementType(vtkType, geoType);
+        int nv = bitpit::ElementInfo::getElementInfo(eltype).nVertices;
+        conn.resize(nv);
+        for (int j=0; j<nv; ++j){
+            if (!vtuNext(connectCursor, conn[j]) || conn[j] < 0 || conn[j] >= nPoints)   return false;
+        }
+        if (pids.found){
+            long pid;
+            if (!vtuNext(pidCursor, pid))   return false;
+            //PIDs are stored as short: values out of range fail the read, they are not wrapped
+            if (pid < long(std::numeric_limits<short>::min()) || pid > long(std::numeric_limits<short>::max()))   return false;
+            geo->addConnectedCell(conn, eltype, short(pid), i);
+        }else{
+            geo->addConnectedCell(conn, eltype, i);
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,56 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#ifndef __VTUINTERFACE_HPP__
+#define __VTUINTERFACE_HPP__
+
+#include "MimmoObject.hpp"
+#include <string>
+
+namespace mimmo{
+
+/*!
+ * \class VTUInterface
+ * \ingroup iogeneric
+ * \brief VTUInterface is an interface class for native reading of VTK unstructured grids *.vtu.
+ *
+ * The file is memory-mapped and its data arrays are streamed directly into the vertex and
+ * cell storage of the target MimmoObject, with exact reserved sizes and without building
+ * any intermediate copy of points or connectivity.
+ * Uncompressed files with ascii or raw appended data (as written by mimmo/bitpit) are supported;
+ * triangle and quadrilateral cells are accepted for surface geometries, tetrahedral and
+ * hexahedral cells for volume geometries. Cell PIDs are read from the cell data array "PID", if any.
+ * Binary data are read in the native byte order, which is assumed little-endian.
+ *
+ * The method read returns false if the file is not supported: callers are expected to fall back
+ * to a generic reader in that case.
+ */
+class VTUInterface{
+
+public:
+    bool read(const std::string & filename, MimmoObject * geo);
+};
+
+}
+
+#endif /* __VTUINTERFACE_HPP__ */
@@ -40,5 +40,8 @@
 #include "IOCloudPoints.hpp"
 #include "MimmoGeometry.hpp"
 #include "MultipleMimmoGeometries.hpp"
+#include "STLInterface.hpp"
+#include "VTUInterface.hpp"
+#include "GeoMimmoInterface.hpp"
 
 #endif
@@ -539,7 +539,6 @@ bool IOOFOAM::readVTK(string& inputDir, string& surfaceName, short PID, MimmoObj
     //int np = 0;
     int nt = 0;
     darray3E point;
-    bitpit::Vertex vertex;
 
     //mapper for connectivity
     map<vtkIdType, long> mapID;
@@ -568,7 +567,7 @@ bool IOOFOAM::readVTK(string& inputDir, string& surfaceName, short PID, MimmoObj
         vtkPointData *pdata = output2->GetPointData();
 
 
-        bitpit::KdTree<3, bitpit::Vertex, long> * kdtree = m_volmesh->getKdTree();
+        KdTree * kdtree = m_volmesh->getKdTree();
         long ID;
 
         double point_[3], tol = 1.0e-08;
@@ -579,11 +578,10 @@ bool IOOFOAM::readVTK(string& inputDir, string& surfaceName, short PID, MimmoObj
         for (vtkIdType id=0; id<points->GetNumberOfPoints(); id++ ){
             points->GetPoint(id, point_);
             for (int i=0; i<3; i++) point[i] = point_[i];
-            vertex.setCoords(point);
             check = false;
             while(!check){
                 ids.clear();
-                kdtree->hNeighbors(&vertex, tol, &ids, &noids);
+                kdtree->hNeighbors(&point, tol, &ids, &noids);
                 if (ids.size() == 0){
                     tol *= 1.5;
                 }
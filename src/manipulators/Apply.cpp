@@ -98,14 +98,7 @@ void
 Apply::execute(){
     if (getGeometry() == NULL) return;
 
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_input.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_input[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_input);
 
 };
 
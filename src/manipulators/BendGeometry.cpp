@@ -249,19 +249,15 @@ BendGeometry::execute(){
     int nV = m_geometry->getNVertex();
     m_displ.resize(nV);
     m_filter.resize(nV, 1.0);
-    long ID;
-    int idx;
-    liimap mapID = m_geometry->getMapDataInv();
+    const std::array<dvector1D,3> & vcoords = m_geometry->getVertexCoordsSoA();
 
     darray3E point, point0;
-    for (auto vertex : m_geometry->getVertices()){
-        point = vertex.getCoords();
+    for (int idx=0; idx<nV; ++idx){
+        point = {{vcoords[0][idx], vcoords[1][idx], vcoords[2][idx]}};
         if (m_local){
             point0 = point;
             point = toLocalCoord(point);
         }
-        ID = vertex.getId();
-        idx = mapID[ID];
         for (int j=0; j<3; j++){
             for (int z=0; z<3; z++){
                 if (m_degree[j][z] > 0){
@@ -292,14 +288,7 @@ void
 BendGeometry::apply(){
 
     if (getGeometry() == NULL) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_displ.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_displ[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_displ);
 
 }
 
@@ -38,7 +38,13 @@ FFDLattice::FFDLattice(){
     m_mapNodes.resize(3);
     m_globalDispl = false;
     m_bfilter = false;
+    m_frozen = false;
+    m_stencilBuilt = false;
+    m_stencilGeo = NULL;
+    m_stencilNV = 0;
+    m_stencilSize = 0;
     m_name = "mimmo.FFDlattice";
+    requireStructure(GeometryStructure::BVTREE);
 };
 
 /*!
@@ -53,7 +59,13 @@ FFDLattice::FFDLattice(const bitpit::Config::Section & rootXML){
     m_mapNodes.resize(3);
     m_globalDispl = false;
     m_bfilter = false;
+    m_frozen = false;
+    m_stencilBuilt = false;
+    m_stencilGeo = NULL;
+    m_stencilNV = 0;
+    m_stencilSize = 0;
     m_name = "mimmo.FFDlattice";
+    requireStructure(GeometryStructure::BVTREE);
 
     std::string fallback_name = "ClassNONE";
     std::string input = rootXML.get("ClassName", fallback_name);
@@ -92,6 +104,8 @@ FFDLattice & FFDLattice::operator=(const FFDLattice & other){
     m_globalDispl = other.m_globalDispl;
     m_bfilter = other.m_bfilter;
     m_filter = other.m_filter;
+    m_frozen = other.m_frozen;
+    cleanStencils();
     return(*this);
 };
 
@@ -118,6 +132,7 @@ FFDLattice::buildPorts(){
     built = (built && createPortOut<dvector1D, FFDLattice>(this, &mimmo::FFDLattice::getFilter, PortType::M_FILTER, mimmo::pin::containerTAG::VECTOR, mimmo::pin::dataTAG::FLOAT));
     built = (built && createPortOut<dvector1D, FFDLattice>(this, &mimmo::FFDLattice::getWeights,PortType::M_NURBSWEIGHTS, mimmo::pin::containerTAG::VECTOR, mimmo::pin::dataTAG::FLOAT));
     built = (built && createPortOut<std::array<mimmo::CoordType,3>, FFDLattice>(this, &mimmo::FFDLattice::getCoordType, PortType::M_NURBSCOORDTYPE, mimmo::pin::containerTAG::ARRAY3, mimmo::pin::dataTAG::COORDT));
+    built = (built && createPortOut<CSRMatrix, FFDLattice>(this, &mimmo::FFDLattice::getDeformationOperator, PortType::M_CSROPERATOR, mimmo::pin::containerTAG::SCALAR, mimmo::pin::dataTAG::CSRMATRIX));
     m_arePortsBuilt = built;
 };
 
@@ -127,6 +142,7 @@ FFDLattice::clearLattice(){
     Lattice::clearLattice();
     clearKnots(); //clear all knots stuff;
     clearFilter();
+    cleanStencils();
     m_displ.clear();
 
 };
@@ -138,6 +154,22 @@ FFDLattice::clearFilter(){
     m_bfilter = false;
 };
 
+/*!Clean per-vertex NURBS stencils cached in frozen lattice mode. They will be recomputed
+ * at the next execution, if the frozen mode is still active.
+ */
+void
+FFDLattice::cleanStencils(){
+    m_stencilBuilt = false;
+    m_stencilGeo = NULL;
+    m_stencilNV = 0;
+    m_stencilSize = 0;
+    livector1D().swap(m_stencilList);
+    dvecarr3E().swap(m_stencilTarget);
+    dvecarr3E().swap(m_stencilPoint);
+    ivector1D().swap(m_stencilNodes);
+    dvector1D().swap(m_stencilCoeffs);
+};
+
 
 /*! Return a vector of six elements reporting the real number of knots effectively stored in the current class (first 3 elements)
  * and the theoretical number of knots (last 3 elements) for Nurbs representation (see Nurbs Books of Peigl)
@@ -250,6 +282,123 @@ FFDLattice::getDeformation(){
 };
 
 
+/*!
+ * Return the linear operator mapping the displacements of the lattice degrees of freedom
+ * to the deformation field of the linked geometry, as a sparse matrix in CSR format.
+ * Rows are the geometry vertices, ordered as in getDeformation (local indexing of the 
+ * geometry vertices); columns are the lattice degrees of freedom, ordered as in getDisplacements.
+ * The operator acts component-wise on displacements, filter field modulation is included.
+ * Periodic nodes sharing the same degree of freedom are merged in a unique column.
+ * The operator is exact for global displacements (see setDisplGlobal). For local displacements
+ * it interpolates the displacement field in the lattice local reference system: on cube lattices
+ * it is exact once the control displacements are expressed along the global axes, while the local
+ * system is mapped nonlinearly to the global one for curvilinear lattices.
+ * If frozen lattice mode is active, the cached stencils are reused.
+ * \return deformation operator; an empty matrix is returned if lattice or geometry are not available.
+ */
+CSRMatrix
+FFDLattice::getDeformationOperator(){
+
+    MimmoObject * container = getGeometry();
+    if(container == NULL || !isBuilt()) return CSRMatrix();
+
+    if(!isDisplGlobal() && getShapeType() != ShapeType::CUBE){
+        (*m_log) << "warning: " << m_name << " deformation operator is exact only for global displacements on curvilinear lattices" << std::endl;
+    }
+
+    //get vertex stencils, from cache if available.
+    bool cached = m_stencilBuilt && m_stencilGeo == container && m_stencilNV == container->getNVertex();
+    if(!cached){
+        cleanStencils();
+        if(container->isBvTreeSupported())    container->buildStructure(GeometryStructure::BVTREE);
+        else                                  container->buildStructure(GeometryStructure::KDTREE);
+        livector1D included;
+        if(container->isBvTreeSupported()) included= container->getVertexFromCellList(getShape()->includeGeometry(container));
+        else                               included= getShape()->includeCloudPoints(container);
+        buildStencils(included);
+    }
+
+    long nv = container->getNVertex();
+    long lsize = m_stencilList.size();
+    int ssize = m_stencilSize;
+
+    if(m_bfilter)  m_filter.resize(nv,0.0);
+
+    livector1D rows(lsize);
+    for(long ilist = 0; ilist < lsize; ++ilist){
+        rows[ilist] = container->getMapDataInv(m_stencilList[ilist]);
+    }
+
+    //merge stencil entries referring to the same degree of freedom
+    livector1D cols(lsize*ssize);
+    dvector1D vals(lsize*ssize);
+    livector1D counts(lsize, 0);
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        std::vector<std::pair<long,double> > entries(ssize);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp for schedule(static)
+#endif
+        for(long ilist = 0; ilist < lsize; ++ilist){
+            const int * nodes = m_stencilNodes.data() + ilist*ssize;
+            const double * coeffs = m_stencilCoeffs.data() + ilist*ssize;
+            double filter = 1.0;
+            if(m_bfilter)  filter = m_filter[rows[ilist]];
+
+            for(int n=0; n<ssize; ++n){
+                entries[n] = std::make_pair(long(m_intMapDOF[nodes[n]]), coeffs[n]);
+            }
+            std::sort(entries.begin(), entries.end(), [](const std::pair<long,double> & a, const std::pair<long,double> & b){return a.first < b.first;});
+
+            long offset = ilist*ssize;
+            long count = 0;
+            for(int n=0; n<ssize; ++n){
+                if(count > 0 && cols[offset+count-1] == entries[n].first){
+                    vals[offset+count-1] += entries[n].second;
+                }else{
+                    cols[offset+count] = entries[n].first;
+                    vals[offset+count] = entries[n].second;
+                    ++count;
+                }
+            }
+            for(long c=0; c<count; ++c){
+                vals[offset+c] *= filter;
+            }
+            counts[ilist] = (filter == 0.0) ? 0 : count;
+        }
+    }
+
+    //assemble CSR structure
+    CSRMatrix result(nv, getNNodes());
+    for(long ilist = 0; ilist < lsize; ++ilist){
+        result.m_rowPtr[rows[ilist]+1] = counts[ilist];
+    }
+    for(long i=0; i<nv; ++i){
+        result.m_rowPtr[i+1] += result.m_rowPtr[i];
+    }
+    result.m_colIndex.resize(result.m_rowPtr[nv]);
+    result.m_values.resize(result.m_rowPtr[nv]);
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for(long ilist = 0; ilist < lsize; ++ilist){
+        long offset = ilist*ssize;
+        long pos = result.m_rowPtr[rows[ilist]];
+        for(long c=0; c<counts[ilist]; ++c){
+            result.m_colIndex[pos+c] = cols[offset+c];
+            result.m_values[pos+c] = vals[offset+c];
+        }
+    }
+
+    if(!cached && !m_frozen) cleanStencils();
+
+    return(result);
+};
+
 /*! Check if displacements are meant as global-true or local-false
  * \return global displacements flag
  */
@@ -477,6 +626,33 @@ FFDLattice::setFilter(dvector1D filter){
 
 
 
+/*! Enable/disable the frozen lattice mode. In frozen mode, the first execution caches for each 
+ * geometry vertex included in the lattice its NURBS stencil, i.e. the indices of the control nodes 
+ * involved and their normalized rational basis coefficients. Subsequent executions skip the inclusion 
+ * test, the knot search and the basis evaluation, and reduce to a sparse matrix-vector product of 
+ * the cached stencils with the current control node displacements (see setDisplacements).
+ * Such mode is meant for optimization loops, where the same lattice and the same undeformed geometry 
+ * are executed many times with different displacements only.
+ * Cached stencils are invalidated when the lattice is rebuilt, when the linked geometry or 
+ * its number of vertices changes, or disabling the mode; they are not aware of vertex coordinates
+ * modifications (e.g. applying the deformation on the geometry itself), so call cleanStencils 
+ * in that case. Cache memory is O(number of included vertices x (deg0+1)(deg1+1)(deg2+1)).
+ * \param[in] flag true to enable the frozen lattice mode.
+ */
+void
+FFDLattice::setFrozen(bool flag){
+    m_frozen = flag;
+    if(!m_frozen) cleanStencils();
+};
+
+/*! Check if the frozen lattice mode is active. See FFDLattice::setFrozen.
+ * \return frozen lattice mode flag
+ */
+bool
+FFDLattice::isFrozen(){
+    return(m_frozen);
+};
+
 /*! Plot your current lattice as a structured grid to *vtu file. Wrapped method of plotGrid of father class UCubicMesh.
  * \param[in] directory output directory
  * \param[in] filename  output filename w/out tag
@@ -557,8 +733,8 @@ FFDLattice::execute(){
     if(container == NULL ) return;
 
     //build trees
-    if(container->isBvTreeSupported() && !container->isBvTreeBuilt())    container->buildBvTree();
-    else if(!container->isKdTreeBuilt())                                container->buildKdTree();
+    if(container->isBvTreeSupported())    container->buildStructure(GeometryStructure::BVTREE);
+    else                                  container->buildStructure(GeometryStructure::KDTREE);
 
     livector1D map;
     dvecarr3E localdef = apply(map);
@@ -566,11 +742,10 @@ FFDLattice::execute(){
     //reset displacement in a unique vector
     int size = container->getNVertex();
     m_gdispl.resize(size, darray3E{0,0,0});
-    auto convMap = container->getMapDataInv();
     {
         int counter = 0;
         for(auto mapp: map){
-            m_gdispl[convMap[mapp]] = localdef[counter];
+            m_gdispl[container->getMapDataInv(mapp)] = localdef[counter];
             ++counter;
         }
     }
@@ -604,19 +779,31 @@ FFDLattice::apply(livector1D & list){
 
     list.clear();
 
-    //check simplex included and extract their vertex in global IDs;
-    if(container->isBvTreeSupported()) list= container->getVertexFromCellList(getShape()->includeGeometry(container));
-    else                               list= getShape()->includeCloudPoints(container);
-    //return deformation
-    dvecarr3E result = nurbsEvaluator(list);
+    dvecarr3E result;
+    if(m_frozen){
+        if(!m_stencilBuilt || m_stencilGeo != container || m_stencilNV != container->getNVertex()){
+            cleanStencils();
+            livector1D included;
+            if(container->isBvTreeSupported()) included= container->getVertexFromCellList(getShape()->includeGeometry(container));
+            else                               included= getShape()->includeCloudPoints(container);
+            buildStencils(included);
+        }
+        list = m_stencilList;
+        result = stencilEvaluator();
+    }else{
+        //check simplex included and extract their vertex in global IDs;
+        if(container->isBvTreeSupported()) list= container->getVertexFromCellList(getShape()->includeGeometry(container));
+        else                               list= getShape()->includeCloudPoints(container);
+        //return deformation
+        result = nurbsEvaluator(list);
+    }
     if(m_bfilter){
 
         m_filter.resize(container->getNVertex(),0.0);
 
         dvecarr3E::iterator itL= result.begin();
-        liimap & vMap = container->getMapDataInv();
         for ( auto && vID : list){
-            *itL = (*itL) * m_filter[vMap[vID]];
+            *itL = (*itL) * m_filter[container->getMapDataInv(vID)];
             ++itL;
         }
     }
@@ -653,14 +840,7 @@ void
 FFDLattice::apply(){
 
     if (getGeometry() == NULL || !isBuilt()) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_gdispl.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_gdispl[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_gdispl);
 
 }
 
@@ -781,6 +961,13 @@ FFDLattice::nurbsEvaluator(darray3E & pointOr){
 
 /*! Return displacement of a list of points,
  * under the deformation effect of the whole Lattice.
+ * The list is split among the available threads (if OpenMP support is enabled);
+ * local basis functions are evaluated on fixed-size stack buffers up to degree 
+ * MIMMO_FFD_MAXSTACKDEG, so that no memory allocation occurs inside the loop on points. 
+ * The tensor product is performed by a kernel specialized at compile time for the most 
+ * common degree triples (all combinations of degree 2 and 3, and trilinear lattices); 
+ * other degrees are handled by the generic kernel. 
+ * Results do not depend on the number of threads used, nor on the kernel chosen.
  *  
  * \param[in] list 3D points
  * \return points displacements
@@ -789,131 +976,385 @@ dvecarr3E
 FFDLattice::nurbsEvaluator(livector1D & list){
 
     bitpit::PatchKernel * tri = getGeometry()->getPatch();
-    long int id;
-    int lsize = list.size();
-    livector1D::iterator it, itend = list.end();
-    darray3E target, point;
-    ivector1D knotInterval(3,0);
-    dvector1D BSbasisi0, BSbasisi1, BSbasisi2;
-    dvector1D valH(4,0), temp1(4,0),temp2(4,0);
+    long lsize = list.size();
 
-    dvecarr3E displ = recoverFullGridDispl();
+    dvector1D ctrl = recoverHomogeneousGridDispl();
     dvector1D weig = recoverFullNodeWeights();
 
-    int uind, vind, wind, index;
-
-    int intv, i, j, k;
-
     int i0 = m_mapdeg[0];
     int i1 = m_mapdeg[1];
     int i2 = m_mapdeg[2];
-    iarray3E mappedIndex;
 
     int md0 = m_deg[i0];
     int md1 = m_deg[i1];
     int md2 = m_deg[i2];
 
-    dvecarr3E outres(lsize);
-    dvecarr3E::iterator itout = outres.begin();
+    int stride = std::max(md0, std::max(md1, md2)) + 1;
+    bool useStack = (stride <= MIMMO_FFD_MAXSTACKDEG+1);
+
+    bool globalDispl = isDisplGlobal();
     darray3E scaling = getShape()->getScaling();
 
-    double bbasisw2;
-    double bbasis1, bbasis0;
+    NurbsKernel kernel = getNurbsKernel(md0, md1, md2);
 
-    for(it = list.begin(); it != itend; ++it){
+    dvecarr3E outres(lsize);
 
-        for(intv=0; intv<4; ++intv){
-            valH[intv] = 0.0;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        //thread private workspaces
+        double stackBasis[3*(MIMMO_FFD_MAXSTACKDEG+1)];
+        double stackLeft[MIMMO_FFD_MAXSTACKDEG+1], stackRight[MIMMO_FFD_MAXSTACKDEG+1];
+        dvector1D heapBasis, heapLeft, heapRight;
+
+        double * BSbasisi0 = stackBasis;
+        double * left = stackLeft;
+        double * right = stackRight;
+        if(!useStack){
+            heapBasis.resize(3*stride, 0.0);
+            heapLeft.resize(stride, 0.0);
+            heapRight.resize(stride, 0.0);
+            BSbasisi0 = heapBasis.data();
+            left = heapLeft.data();
+            right = heapRight.data();
         }
-        id  = *it;
-        target = tri->getVertex(id).getCoords();
-        point = transfToLocal(target);
+        double * BSbasisi1 = BSbasisi0 + stride;
+        double * BSbasisi2 = BSbasisi1 + stride;
 
-        // get reference Interval int the knot matrix
-        for(i=0; i<3; i++){
-            knotInterval[i] = getKnotInterval(point[i],i);
-        }
-        BSbasisi0 = basisITS0(knotInterval[i0], i0, point[i0]);
-        BSbasisi1 = basisITS0(knotInterval[i1], i1, point[i1]);
-        BSbasisi2 = basisITS0(knotInterval[i2], i2, point[i2]);
+        darray3E target, point, deformed;
+        int knotInterval[3];
+        double valH[4];
+        int i;
 
-        uind = knotInterval[i0] - md0;
-        vind = knotInterval[i1] - md1;
-        wind = knotInterval[i2] - md2;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp for schedule(static)
+#endif
+        for(long ilist = 0; ilist < lsize; ++ilist){
 
+            target = tri->getVertex(list[ilist]).getCoords();
+            point = transfToLocal(target);
 
-        for(i=0; i<=md0; ++i){
+            // get reference Interval int the knot matrix
+            for(i=0; i<3; i++){
+                knotInterval[i] = getKnotInterval(point[i],i);
+            }
+            basisITS0(knotInterval[i0], i0, point[i0], BSbasisi0, left, right);
+            basisITS0(knotInterval[i1], i1, point[i1], BSbasisi1, left, right);
+            basisITS0(knotInterval[i2], i2, point[i2], BSbasisi2, left, right);
 
-            mappedIndex[i0] = uind + i;
+            (this->*kernel)(BSbasisi0, BSbasisi1, BSbasisi2,
+                            knotInterval[i0] - md0, knotInterval[i1] - md1, knotInterval[i2] - md2,
+                            ctrl.data(), weig.data(), valH);
 
-            for(int intv=0; intv<4; ++intv){
-                temp1[intv] = 0.0;
-            }
+            darray3E & out = outres[ilist];
+            if(globalDispl){
 
-            for(j=0; j<=md1; ++j){
+                //adding to local point displ rescaled
+                for(i=0; i<3; ++i){
+                    out[i] = valH[i]/valH[3];
+                }
 
-                mappedIndex[i1] = vind + j;
+            }else{
 
-                for(intv=0; intv<4; ++intv){
-                    temp2[intv] = 0.0;
+                //adding to local point displ rescaled
+                for(i=0; i<3; ++i){
+                    point[i]+= valH[i]/(valH[3]*scaling[i]);
                 }
 
-                for(k=0; k<=md2; ++k){
+                //get absolute displ as difference of
+                deformed = transfToGlobal(point);
+                for(i=0; i<3; ++i){
+                    out[i] = deformed[i] - target[i];
+                }
 
-                    mappedIndex[i2] = wind + k;
+            }
 
-                    index = accessMapNodes(mappedIndex[0], mappedIndex[1], mappedIndex[2]);
+        }//next list id
+    }
 
-                    bbasisw2 = BSbasisi2[k]* weig[index];
+    return(outres);
 
-                    for(intv=0; intv<3; ++intv){
-                        temp2[intv] += bbasisw2 * displ[index][intv];
-                    }
-                    temp2[3] += bbasisw2;
+};
+
+/*! Tensor product of the local NURBS basis functions with the weighted control node 
+ * displacements, for a single point. Degrees D0, D1, D2 (referred to the curves ordered as m_mapdeg)
+ * are fixed at compile time, so that loop bounds are known and the compiler can fully unroll 
+ * and vectorize the 4-wide homogeneous accumulation. A negative degree identifies the generic 
+ * kernel, which reads the actual degree from m_deg at runtime.
+ *
+ * \param[in] BSbasisi0 local basis functions on curve m_mapdeg[0]
+ * \param[in] BSbasisi1 local basis functions on curve m_mapdeg[1]
+ * \param[in] BSbasisi2 local basis functions on curve m_mapdeg[2]
+ * \param[in] uind first theoretical node index involved on curve m_mapdeg[0]
+ * \param[in] vind first theoretical node index involved on curve m_mapdeg[1]
+ * \param[in] wind first theoretical node index involved on curve m_mapdeg[2]
+ * \param[in] ctrl homogeneous control node displacements (see recoverHomogeneousGridDispl)
+ * \param[in] weig full control node weights
+ * \param[out] valH 4-wide homogeneous result: weighted displacement sum and weight sum.
+ */
+template<int D0, int D1, int D2>
+void
+FFDLattice::nurbsTensorProduct(const double * BSbasisi0, const double * BSbasisi1, const double * BSbasisi2,
+                               int uind, int vind, int wind, const double * ctrl, const double * weig, double * valH){
+
+    const int i0 = m_mapdeg[0];
+    const int i1 = m_mapdeg[1];
+    const int i2 = m_mapdeg[2];
+
+    const int md0 = (D0 < 0) ? m_deg[i0] : D0;
+    const int md1 = (D1 < 0) ? m_deg[i1] : D1;
+    const int md2 = (D2 < 0) ? m_deg[i2] : D2;
+
+    iarray3E mappedIndex;
+    double temp1[4], temp2[4];
+    const double * node;
+    double bbasisw2, bbasis1, bbasis0;
+    int index, intv;
+
+    for(intv=0; intv<4; ++intv){
+        valH[intv] = 0.0;
+    }
+
+    for(int i=0; i<=md0; ++i){
+
+        mappedIndex[i0] = uind + i;
+
+        for(intv=0; intv<4; ++intv){
+            temp1[intv] = 0.0;
+        }
+
+        for(int j=0; j<=md1; ++j){
+
+            mappedIndex[i1] = vind + j;
+
+            for(intv=0; intv<4; ++intv){
+                temp2[intv] = 0.0;
+            }
+
+            for(int k=0; k<=md2; ++k){
+
+                mappedIndex[i2] = wind + k;
+
+                index = accessMapNodes(mappedIndex[0], mappedIndex[1], mappedIndex[2]);
+                node = ctrl + 4*index;
+
+                bbasisw2 = BSbasisi2[k]* weig[index];
 
-                }
-                bbasis1 = BSbasisi1[j];
                 for(intv=0; intv<4; ++intv){
-                    temp1[intv] += bbasis1*temp2[intv];
+                    temp2[intv] += bbasisw2 * node[intv];
                 }
-
             }
-            bbasis0 = BSbasisi0[i];
+            bbasis1 = BSbasisi1[j];
             for(intv=0; intv<4; ++intv){
-                valH[intv] += bbasis0*temp1[intv];
+                temp1[intv] += bbasis1*temp2[intv];
             }
+
+        }
+        bbasis0 = BSbasisi0[i];
+        for(intv=0; intv<4; ++intv){
+            valH[intv] += bbasis0*temp1[intv];
         }
+    }
+};
 
+/*! Return the tensor product kernel best suited to the given degrees (referred to the curves
+ * ordered as m_mapdeg). Specialized kernels are available for trilinear lattices and for all
+ * combinations of degree 2 and 3; the generic kernel is returned otherwise.
+ * \param[in] md0 degree of curve m_mapdeg[0]
+ * \param[in] md1 degree of curve m_mapdeg[1]
+ * \param[in] md2 degree of curve m_mapdeg[2]
+ * \return pointer to tensor product kernel.
+ */
+FFDLattice::NurbsKernel
+FFDLattice::getNurbsKernel(int md0, int md1, int md2){
+
+    //degrees above 3 have no specialized kernel, and would make the switch key ambiguous
+    if(std::max(md0, std::max(md1, md2)) > 3)  return &FFDLattice::nurbsTensorProduct<-1,-1,-1>;
+
+    switch(100*md0 + 10*md1 + md2){
+    case 111 :
+        return &FFDLattice::nurbsTensorProduct<1,1,1>;
+    case 222 :
+        return &FFDLattice::nurbsTensorProduct<2,2,2>;
+    case 223 :
+        return &FFDLattice::nurbsTensorProduct<2,2,3>;
+    case 232 :
+        return &FFDLattice::nurbsTensorProduct<2,3,2>;
+    case 233 :
+        return &FFDLattice::nurbsTensorProduct<2,3,3>;
+    case 322 :
+        return &FFDLattice::nurbsTensorProduct<3,2,2>;
+    case 323 :
+        return &FFDLattice::nurbsTensorProduct<3,2,3>;
+    case 332 :
+        return &FFDLattice::nurbsTensorProduct<3,3,2>;
+    case 333 :
+        return &FFDLattice::nurbsTensorProduct<3,3,3>;
+    default :
+        return &FFDLattice::nurbsTensorProduct<-1,-1,-1>;
+    }
+};
 
-        if(isDisplGlobal()){
+/*! Compute and cache the NURBS stencils of a list of geometry vertices (frozen lattice mode).
+ * For each vertex, the full grid indices of the control nodes involved and their rational basis 
+ * coefficients, normalized by the vertex weight sum, are stored; undeformed coordinates of the vertex 
+ * in the global and local lattice reference system are stored too. 
+ * The list is split among the available threads (if OpenMP support is enabled).
+ * \param[in] list ids of geometry vertices included in the lattice
+ */
+void
+FFDLattice::buildStencils(livector1D & list){
 
-            //adding to local point displ rescaled
-            for(i=0; i<3; ++i){
-                (*itout)[i] = valH[i]/valH[3];
-            }
+    MimmoObject * container = getGeometry();
+    bitpit::PatchKernel * tri = container->getPatch();
+    long lsize = list.size();
 
-        }else{
+    dvector1D weig = recoverFullNodeWeights();
 
-            //adding to local point displ rescaled
-            for(i=0; i<3; ++i){
-                point[i]+= valH[i]/(valH[3]*scaling[i]);
-            }
+    int i0 = m_mapdeg[0];
+    int i1 = m_mapdeg[1];
+    int i2 = m_mapdeg[2];
 
-            //get absolute displ as difference of
-            for(i=0; i<3; ++i){
-                (*itout)[i] = transfToGlobal(point)[i] - target[i];
-            }
+    int md0 = m_deg[i0];
+    int md1 = m_deg[i1];
+    int md2 = m_deg[i2];
+
+    int stride = std::max(md0, std::max(md1, md2)) + 1;
+    bool useStack = (stride <= MIMMO_FFD_MAXSTACKDEG+1);
 
+    m_stencilSize = (md0+1)*(md1+1)*(md2+1);
+    m_stencilList = list;
+    m_stencilTarget.resize(lsize);
+    m_stencilPoint.resize(lsize);
+    m_stencilNodes.resize(lsize*m_stencilSize);
+    m_stencilCoeffs.resize(lsize*m_stencilSize);
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        //thread private workspaces
+        double stackBasis[3*(MIMMO_FFD_MAXSTACKDEG+1)];
+        double stackLeft[MIMMO_FFD_MAXSTACKDEG+1], stackRight[MIMMO_FFD_MAXSTACKDEG+1];
+        dvector1D heapBasis, heapLeft, heapRight;
+
+        double * BSbasisi0 = stackBasis;
+        double * left = stackLeft;
+        double * right = stackRight;
+        if(!useStack){
+            heapBasis.resize(3*stride, 0.0);
+            heapLeft.resize(stride, 0.0);
+            heapRight.resize(stride, 0.0);
+            BSbasisi0 = heapBasis.data();
+            left = heapLeft.data();
+            right = heapRight.data();
         }
+        double * BSbasisi1 = BSbasisi0 + stride;
+        double * BSbasisi2 = BSbasisi1 + stride;
+
+        darray3E point;
+        int knotInterval[3];
+        iarray3E mappedIndex;
+        int uind, vind, wind, index, counter;
+        double coeff, wsum;
+        int * nodes;
+        double * coeffs;
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp for schedule(static)
+#endif
+        for(long ilist = 0; ilist < lsize; ++ilist){
+
+            m_stencilTarget[ilist] = tri->getVertex(list[ilist]).getCoords();
+            point = transfToLocal(m_stencilTarget[ilist]);
+            m_stencilPoint[ilist] = point;
+
+            for(int i=0; i<3; i++){
+                knotInterval[i] = getKnotInterval(point[i],i);
+            }
+            basisITS0(knotInterval[i0], i0, point[i0], BSbasisi0, left, right);
+            basisITS0(knotInterval[i1], i1, point[i1], BSbasisi1, left, right);
+            basisITS0(knotInterval[i2], i2, point[i2], BSbasisi2, left, right);
+
+            uind = knotInterval[i0] - md0;
+            vind = knotInterval[i1] - md1;
+            wind = knotInterval[i2] - md2;
+
+            nodes = m_stencilNodes.data() + ilist*m_stencilSize;
+            coeffs = m_stencilCoeffs.data() + ilist*m_stencilSize;
+            counter = 0;
+            wsum = 0.0;
+            for(int i=0; i<=md0; ++i){
+                mappedIndex[i0] = uind + i;
+                for(int j=0; j<=md1; ++j){
+                    mappedIndex[i1] = vind + j;
+                    for(int k=0; k<=md2; ++k){
+                        mappedIndex[i2] = wind + k;
+                        index = accessMapNodes(mappedIndex[0], mappedIndex[1], mappedIndex[2]);
+                        coeff = BSbasisi0[i]*BSbasisi1[j]*BSbasisi2[k]*weig[index];
+                        nodes[counter] = index;
+                        coeffs[counter] = coeff;
+                        wsum += coeff;
+                        ++counter;
+                    }
+                }
+            }
+            for(counter=0; counter<m_stencilSize; ++counter){
+                coeffs[counter] /= wsum;
+            }
+        }//next list id
+    }
 
-        itout++;
+    m_stencilGeo = container;
+    m_stencilNV = container->getNVertex();
+    m_stencilBuilt = true;
 
-    }//next list id
+    (*m_log) << m_name << " : NURBS stencils computed for " << lsize << " vertices" << std::endl;
+};
 
-    itout = outres.end();
+/*! Return displacement of the geometry vertices whose stencils are cached (frozen lattice mode),
+ * as sparse product of the stencils with the current control node displacements.
+ * The list is split among the available threads (if OpenMP support is enabled).
+ * \return displacements of vertices listed in m_stencilList
+ */
+dvecarr3E
+FFDLattice::stencilEvaluator(){
 
-    return(outres);
+    long lsize = m_stencilList.size();
+    dvecarr3E displ = recoverFullGridDispl();
+    bool globalDispl = isDisplGlobal();
+    darray3E scaling = getShape()->getScaling();
+
+    dvecarr3E outres(lsize);
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for(long ilist = 0; ilist < lsize; ++ilist){
+
+        const int * nodes = m_stencilNodes.data() + ilist*m_stencilSize;
+        const double * coeffs = m_stencilCoeffs.data() + ilist*m_stencilSize;
+        darray3E val = {{0.0, 0.0, 0.0}};
+        for(int n=0; n<m_stencilSize; ++n){
+            const darray3E & nodeDispl = displ[nodes[n]];
+            for(int i=0; i<3; ++i){
+                val[i] += coeffs[n]*nodeDispl[i];
+            }
+        }
+
+        if(globalDispl){
+            outres[ilist] = val;
+        }else{
+            darray3E point = m_stencilPoint[ilist];
+            for(int i=0; i<3; ++i){
+                point[i] += val[i]/scaling[i];
+            }
+            outres[ilist] = transfToGlobal(point) - m_stencilTarget[ilist];
+        }
+    }
 
+    return(outres);
 };
 
 /*! Return a specified component of a displacement of a given point, under the deformation effect of the whole Lattice. 
@@ -1002,13 +1443,37 @@ FFDLattice::nurbsEvaluatorScalar(darray3E & coordOr, int targ){
 dvector1D
 FFDLattice::basisITS0(int k, int pos, double coord){
 
-    //return local basis function given the local interval in theoretical knot index,
-    //local degree of the curve -> Please refer to NURBS book of PEIGL for this Inverted Triangular Scheme Algorithm (pag 74);
     int dd1 = m_deg[pos]+1;
     dvector1D basis(dd1,1);
     dvector1D left(dd1,0), right(dd1,0);
+    basisITS0(k, pos, coord, basis.data(), left.data(), right.data());
+
+    return(basis);
+};
+
+/*!Evaluate the local basis function of a Nurbs Curve on caller-provided buffers,
+ * without any memory allocation. See basisITS0(int k, int pos, double coord).
+ *\param[in] k  local knot interval in which coord resides -> theoretical knot indexing, 
+ *\param[in] pos identifies which nurbs curve of lattice (3 curve for 3 box direction) you are pointing
+ *\param[in] coord the evaluation point on the curve
+ *\param[out] basis local basis of ITS algorithm, at least m_deg[pos]+1 sized
+ *\param[in] left workspace buffer, at least m_deg[pos]+1 sized
+ *\param[in] right workspace buffer, at least m_deg[pos]+1 sized
+ */
+void
+FFDLattice::basisITS0(int k, int pos, double coord, double * basis, double * left, double * right){
+
+    //return local basis function given the local interval in theoretical knot index,
+    //local degree of the curve -> Please refer to NURBS book of PEIGL for this Inverted Triangular Scheme Algorithm (pag 74);
+    int dd1 = m_deg[pos]+1;
     double saved, tmp;
 
+    for(int j = 0; j < dd1; ++j){
+        basis[j] = 1.0;
+        left[j] = 0.0;
+        right[j] = 0.0;
+    }
+
     for(int j = 1; j < dd1; ++j){
         saved = 0.0;
         left[j] = coord - getKnotValue(k+1-j, pos);
@@ -1022,8 +1487,6 @@ FFDLattice::basisITS0(int k, int pos, double coord){
 
         basis[j] = saved;
     }//next j
-
-    return(basis);
 };
 
 /*!Return list of equally spaced knots for the Nurbs curve in a specific lattice direction
@@ -1388,6 +1851,26 @@ FFDLattice::recoverFullGridDispl(){
     return(result);
 };
 
+/*! Recover full displacements vector from DOF, in homogeneous flat layout:
+ * for each grid node, 4 contiguous values (dx, dy, dz, 1.0) are stored.
+ * \return control nodes homogeneous displacements
+ */
+dvector1D
+FFDLattice::recoverHomogeneousGridDispl(){
+
+    iarray3E dim = getDimension();
+    int size = dim[0]*dim[1]*dim[2];
+    dvector1D result(4*size);
+    for(int i=0; i<size; ++i){
+        darray3E & val = m_displ[m_intMapDOF[i]];
+        result[4*i]   = val[0];
+        result[4*i+1] = val[1];
+        result[4*i+2] = val[2];
+        result[4*i+3] = 1.0;
+    }
+    return(result);
+};
+
 /*! Recover full displacements vector from DOF */
 dvector1D FFDLattice::recoverFullNodeWeights(){
 
@@ -1510,6 +1993,7 @@ FFDLattice::build(){
 
     setKnotsStructure();
     orderDimension();
+    cleanStencils();
 
 };
 
@@ -1566,6 +2050,17 @@ FFDLattice::absorbSectionXML(const bitpit::Config::Section & slotXML, std::strin
         setDisplGlobal(temp);
     };
 
+    if(slotXML.hasOption("Frozen")){
+        std::string input = slotXML.get("Frozen");
+        input = bitpit::utils::string::trim(input);
+        bool temp = false;
+        if(!input.empty()){
+            std::stringstream ss(input);
+            ss>>temp;
+        }
+        setFrozen(temp);
+    };
+
 };
 
 /*!
@@ -1604,6 +2099,10 @@ FFDLattice::flushSectionXML(bitpit::Config::Section & slotXML, std::string name)
         slotXML.set("DisplGlobal", std::to_string(int(isDisplGlobal())));
     }
 
+    if(isFrozen()){
+        slotXML.set("Frozen", std::to_string(int(isFrozen())));
+    }
+
 };
 
 }
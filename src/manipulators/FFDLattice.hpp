@@ -26,6 +26,12 @@
 
 #include "Lattice.hpp"
 
+/*!
+ * Maximum NURBS degree whose local basis functions are evaluated by FFDLattice on fixed-size
+ * stack buffers. Lattices of higher degree fall back to per-thread heap workspaces.
+ */
+#define MIMMO_FFD_MAXSTACKDEG 8
+
 namespace mimmo{
 
 /*!
@@ -64,6 +70,7 @@ namespace mimmo{
      | 12    | M_FILTER          | getFilter         | (VECTOR, FLOAT)               |
      | 44    | M_NURBSWEIGHTS    | getWeights        | (VECTOR, FLOAT)               |
      | 43    | M_NURBSCOORDTYPE  | getCoordType      | (ARRAY3, COORDT)              |
+     | 160   | M_CSROPERATOR     | getDeformationOperator | (SCALAR, CSRMATRIX)      |
 
      
       Inherited from Lattice :
@@ -123,6 +130,7 @@ namespace mimmo{
  * - <B>CoordType</B>: Set Boundary conditions for each NURBS interpolant on their extrema. Available choice are <B>CLAMPED,SYMMETRIC,UNCLAMPED, PERIODIC</B>;
  * - <B>Degrees</B>: degrees for NURBS interpolant in each spatial direction;
  * - <B>DisplGlobal</B>:0/1 use local-shape/global x,y,z reference system to define displacements of lattice node;
+ * - <B>Frozen</B>:0/1 enable/disable frozen lattice mode (see FFDLattice::setFrozen);
  *
 
  *
@@ -130,6 +138,10 @@ namespace mimmo{
  */
 class FFDLattice: public Lattice {
 
+private:
+    /*! Pointer to a NURBS tensor product kernel, see nurbsTensorProduct. */
+    typedef void (FFDLattice::*NurbsKernel)(const double *, const double *, const double *, int, int, int, const double *, const double *, double *);
+
 protected:
     iarray3E    m_deg;            /**< Nurbs curve degree for each of the possible 3 direction in space*/
     dvector2D    m_knots;        /**< Nurbs curve knots for each of the possible 3 direction in space*/
@@ -145,6 +157,17 @@ private:
     dvector1D   m_filter;        /**< Filter scalar field defined on geometry nodes for displacements modulation*/
     bool         m_bfilter;        /**< Boolean to recognize if a filter field for for displacements modulation is set or not */
 
+    bool         m_frozen;        /**< Boolean to enable frozen lattice mode, i.e. caching of per-vertex NURBS stencils */
+    bool         m_stencilBuilt;  /**< Boolean to recognize if per-vertex stencils are currently cached */
+    MimmoObject* m_stencilGeo;    /**< Geometry on which the cached stencils are computed */
+    long         m_stencilNV;     /**< Number of vertices of the geometry when the cached stencils are computed */
+    int          m_stencilSize;   /**< Number of control nodes involved in each vertex stencil */
+    livector1D   m_stencilList;   /**< Ids of geometry vertices included in the lattice */
+    dvecarr3E    m_stencilTarget; /**< Undeformed coordinates of the included vertices */
+    dvecarr3E    m_stencilPoint;  /**< Undeformed coordinates of the included vertices in lattice local reference system */
+    ivector1D    m_stencilNodes;  /**< Full grid index of control nodes of each vertex stencil, m_stencilSize per vertex*/
+    dvector1D    m_stencilCoeffs; /**< Normalized NURBS coefficients of each vertex stencil, m_stencilSize per vertex*/
+
 public:
     FFDLattice();
     FFDLattice(const bitpit::Config::Section & rootXML);
@@ -169,6 +192,7 @@ public:
     dvector1D   getFilter();
     std::pair<MimmoObject *, dvecarr3E * >    getDeformedField();
     dvecarr3E     getDeformation();
+    CSRMatrix   getDeformationOperator();
     bool         isDisplGlobal();
     iarray3E    getDegrees();
 
@@ -186,6 +210,10 @@ public:
 
     void        setFilter(dvector1D );
 
+    void        setFrozen(bool flag);
+    bool        isFrozen();
+    void        cleanStencils();
+
     //plotting wrappers
     void        plotGrid(std::string directory, std::string filename, int counter, bool binary, bool deformed);
     void        plotCloud(std::string directory, std::string filename, int counter, bool binary, bool deformed);
@@ -213,9 +241,17 @@ private:
     darray3E    nurbsEvaluator(darray3E &);
     dvecarr3E    nurbsEvaluator(livector1D &);
     double        nurbsEvaluatorScalar(darray3E &, int);
+    template<int D0, int D1, int D2>
+    void        nurbsTensorProduct(const double *, const double *, const double *, int, int, int, const double *, const double *, double *);
+    NurbsKernel getNurbsKernel(int, int, int);
+
+    //frozen lattice stencils
+    void        buildStencils(livector1D &);
+    dvecarr3E   stencilEvaluator();
 
     //Nurbs utilities
     dvector1D    basisITS0(int k, int pos, double coord);
+    void         basisITS0(int k, int pos, double coord, double * basis, double * left, double * right);
     dvector1D    getNodeSpacing(int dir);
 
     //knots mantenaince utilities
@@ -230,6 +266,7 @@ private:
     //nodal displacement utility
     dvecarr3E    recoverFullGridDispl();
     dvector1D    recoverFullNodeWeights();
+    dvector1D    recoverHomogeneousGridDispl();
     void         setMapNodes(int ind);
     int          accessMapNodes(int,int,int);
 
@@ -23,6 +23,11 @@
  \ *---------------------------------------------------------------------------*/
 
 #include "MRBF.hpp"
+#include <chrono>
+#include <cmath>
+#if MIMMO_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace bitpit;
@@ -37,6 +42,10 @@ MRBF::MRBF(){
     setMode(MRBFSol::NONE);
     m_bfilter = false;
     m_SRRatio = -1.0;
+    m_compact = false;
+    m_treecode = false;
+    m_treeRatio = 0.5;
+    m_operatorBuilt = false;
 };
 
 /*!
@@ -51,6 +60,10 @@ MRBF::MRBF(const bitpit::Config::Section & rootXML){
     setMode(MRBFSol::NONE);
     m_bfilter = false;
     m_SRRatio = -1.0;
+    m_compact = false;
+    m_treecode = false;
+    m_treeRatio = 0.5;
+    m_operatorBuilt = false;
 
     std::string fallback_name = "ClassNONE";
     std::string input = rootXML.get("ClassName", fallback_name);
@@ -86,6 +99,7 @@ MRBF::buildPorts(){
 
     built = (built && createPortOut<dvecarr3E, MRBF>(this, &mimmo::MRBF::getDisplacements, PortType::M_GDISPLS, mimmo::pin::containerTAG::VECARR3, mimmo::pin::dataTAG::FLOAT));
     built = (built && createPortOut<std::pair<MimmoObject*, dvecarr3E*> , MRBF>(this, &mimmo::MRBF::getDeformedField, PortType::M_PAIRVECFIELD, mimmo::pin::containerTAG::PAIR, mimmo::pin::dataTAG::MIMMO_VECARR3FLOAT_));
+    built = (built && createPortOut<CSRMatrix, MRBF>(this, &mimmo::MRBF::getDeformationOperator, PortType::M_CSROPERATOR, mimmo::pin::containerTAG::SCALAR, mimmo::pin::dataTAG::CSRMATRIX));
     built = (built && createPortOut<MimmoObject*, MRBF>(this, &BaseManipulation::getGeometry, PortType::M_GEOM, mimmo::pin::containerTAG::SCALAR, mimmo::pin::dataTAG::MIMMO_));
     m_arePortsBuilt = built;
 };
@@ -102,6 +116,11 @@ MRBF & MRBF::operator=(const MRBF & other){
     m_supRIsValue = other.m_supRIsValue;
     m_bfilter = other.m_bfilter;
     if(m_bfilter)    m_filter = other.m_filter;
+    m_compact = other.m_compact;
+    m_treecode = other.m_treecode;
+    m_treeRatio = other.m_treeRatio;
+    m_operator = other.m_operator;
+    m_operatorBuilt = other.m_operatorBuilt;
 
     return(*this);
 };
@@ -138,7 +157,7 @@ MRBF::setMode(MRBFSol solver){
 /*!
  * Overloading of MRBF::setSolver(MRBFSol solver) with int input parameter
  * Reimplemented from RBF::setMode() of bitpit;
- * \param[in] type of solver 1-WHOLE, 2-GREEDY, see MRBFSol enum;
+ * \param[in] type of solver 1-WHOLE, 2-GREEDY, 3-SPARSE, see MRBFSol enum;
  */
 void 
 MRBF::setMode(int type){
@@ -147,6 +166,8 @@ MRBF::setMode(int type){
     break;
     case 2 : setMode(MRBFSol::GREEDY);
     break;
+    case 3 : setMode(MRBFSol::SPARSE);
+    break;
     default: setMode(MRBFSol::NONE);
     break;
     }
@@ -196,6 +217,58 @@ MRBF::getIsSupportRadiusValue(){
     return(m_supRIsValue);
 }
 
+/*!
+ * It gets if compact support evaluation of RBF through a spatial index of nodes is enabled.
+ * \return compact support evaluation enabled?
+ */
+bool
+MRBF::isCompactSupport(){
+    return(m_compact);
+}
+
+/*!
+ * It gets if treecode far-field approximation of RBF evaluation is enabled.
+ * \return treecode approximation enabled?
+ */
+bool
+MRBF::isTreecode(){
+    return(m_treecode);
+}
+
+/*!
+ * It gets the opening ratio of the treecode approximation. See MRBF::setTreecodeOpeningRatio.
+ * \return treecode opening ratio
+ */
+double
+MRBF::getTreecodeOpeningRatio(){
+    return(m_treeRatio);
+}
+
+/*!
+ * It gets if the current RBF kernel is compactly supported, i.e. it vanishes 
+ * for distances greater than the support radius. Gaussian and custom kernels
+ * are not considered compactly supported.
+ * \return RBF kernel is compactly supported?
+ */
+bool
+MRBF::isKernelCompact(){
+    bitpit::RBFBasisFunction type = getFunctionType();
+    return(type != RBFBasisFunction::CUSTOM && type != RBFBasisFunction::GAUSS90 &&
+           type != RBFBasisFunction::GAUSS95 && type != RBFBasisFunction::GAUSS99);
+}
+
+/*!
+ * It gets if the current RBF kernel is compactly supported and strictly positive definite 
+ * in 3D, i.e. if its sparse interpolation matrix is symmetric positive definite for any 
+ * set of distinct nodes. Only the Wendland C2 kernel is; the linear kernel is compactly
+ * supported but its interpolation matrix may be indefinite.
+ * \return RBF kernel is compactly supported and positive definite?
+ */
+bool
+MRBF::isKernelPositiveDefinite(){
+    return(getFunctionType() == RBFBasisFunction::WENDLANDC2);
+}
+
 /*!
  * Return actual computed deformation field (if any) for the geometry linked.
  * If no field is actually present, return null pointers;
@@ -219,6 +292,28 @@ MRBF::getDisplacements(){
     return m_displ;
 };
 
+/*!
+ * Return the linear operator mapping the RBF weights of the control nodes to the
+ * displacements field of the linked geometry, as a sparse matrix in CSR format.
+ * Rows are the geometry vertices, ordered as in getDisplacements; columns are the RBF nodes.
+ * The operator acts component-wise on the weights, filter field modulation is included;
+ * only nonzero basis function values are stored, so the matrix is sparse for compact support kernels.
+ * The operator is available in parameterization mode (MRBFSol::NONE) only, and it 
+ * refers to the support radius evaluated during the last execution of the block.
+ * It is built once after each execution and cached (see buildDeformationOperator).
+ * \return deformation operator; an empty matrix is returned if not available.
+ */
+CSRMatrix
+MRBF::getDeformationOperator(){
+
+    if(m_solver != MRBFSol::NONE){
+        (*m_log) << "warning: " << m_name << " deformation operator available only in parameterization mode" << std::endl;
+        return CSRMatrix();
+    }
+    if(!m_operatorBuilt)    buildDeformationOperator();
+    return(m_operator);
+};
+
 
 /*!Adds a RBF point to the total control node list and activate it.
  * Reimplemented from RBF::addNode of bitpit;
@@ -382,6 +477,47 @@ MRBF::setTol(double tol){
     m_tol = tol;
 }
 
+/*!It enables the evaluation of RBF through a spatial index of the active nodes.
+ * Each geometry vertex collects only the contributions of the nodes lying within the
+ * support radius, so that the cost of evaluation scales with the number of neighbor nodes 
+ * instead of the total number of nodes. Meaningful only for compactly supported kernels 
+ * (e.g. Wendland C2), for other kernels the full evaluation is performed.
+ * \param[in] flag true to enable compact support evaluation
+ */
+void
+MRBF::setCompactSupport(bool flag){
+    m_compact = flag;
+}
+
+/*!It enables the treecode far-field approximation of RBF evaluation, meant for globally 
+ * supported kernels (e.g. Gaussian). Active nodes are organized in an octree: contributions of
+ * tree cells far enough from the target point are approximated by a second order expansion 
+ * about the cell centroid, while near cells are summed directly. The evaluation cost scales 
+ * with the logarithm of the number of nodes instead of linearly.
+ * In MRBFSol::GREEDY mode the residuals driving the selection of the nodes are evaluated 
+ * with the treecode approximation too (see greedyTreecode).
+ * If compact support evaluation is enabled too and the kernel is compactly supported, 
+ * the compact support evaluation is performed.
+ * \param[in] flag true to enable treecode approximation
+ */
+void
+MRBF::setTreecode(bool flag){
+    m_treecode = flag;
+}
+
+/*!It sets the opening ratio of the treecode approximation: a tree cell is approximated 
+ * if the ratio between its size and its distance from the target point is lower than the 
+ * opening ratio. It is not an error bound: the error of each far cell contribution decreases
+ * roughly as the cube of the ratio, relative to the cell weights. Lower values give more 
+ * accurate and more expensive evaluations; zero value recovers the direct evaluation.
+ * Default value is 0.5.
+ * \param[in] ratio opening ratio, in [0,1]
+ */
+void
+MRBF::setTreecodeOpeningRatio(double ratio){
+    m_treeRatio = std::min(1.0, std::max(0.0, ratio));
+}
+
 /*!
  * Set a field  of 3D displacements on your RBF Nodes. According to MRBFSol mode
  * active in the class set: displacements as direct RBF weights coefficients in MRBFSol::NONE mode,
@@ -416,6 +552,15 @@ MRBF::clear(){
     clearFilter();
     m_tol = 0.00001;
     m_SRRatio = -1;
+    m_compact = false;
+    m_treecode = false;
+    m_treeRatio = 0.5;
+    cleanNodeGrid();
+    cleanNodeTree();
+    dvector1D().swap(m_activeCoords);
+    dvector1D().swap(m_activeWeights);
+    m_operator.clear();
+    m_operatorBuilt = false;
 };
 
 /*!Clean filter field */
@@ -454,6 +599,803 @@ MRBF::setWeight(dvector2D value){
     }
 }
 
+/*!
+ * Build a uniform grid over the active RBF nodes, with cells of size comparable to 
+ * the support radius, to retrieve quickly the nodes within the support of a point.
+ * The total number of cells is bounded by a multiple of the number of active nodes.
+ * \param[in] radius RBF support radius
+ */
+void
+MRBF::buildNodeGrid(double radius){
+
+    cleanNodeGrid();
+
+    ivector1D active = getActiveSet();
+    int nactive = active.size();
+    if(nactive == 0 || radius <= 0.0) return;
+
+    darray3E pmin = m_node[active[0]];
+    darray3E pmax = pmin;
+    for(auto & ind : active){
+        for(int k=0; k<3; ++k){
+            pmin[k] = std::min(pmin[k], m_node[ind][k]);
+            pmax[k] = std::max(pmax[k], m_node[ind][k]);
+        }
+    }
+
+    //grid dimensions, cells of support radius size, bounded in number.
+    double ncells = 1.0;
+    for(int k=0; k<3; ++k){
+        m_gridDim[k] = std::max(1, int(std::ceil((pmax[k] - pmin[k])/radius)));
+        ncells *= double(m_gridDim[k]);
+    }
+    double maxcells = 8.0*double(nactive);
+    if(ncells > maxcells){
+        double factor = std::cbrt(ncells/maxcells);
+        for(int k=0; k<3; ++k){
+            m_gridDim[k] = std::max(1, int(double(m_gridDim[k])/factor));
+        }
+    }
+    m_gridOrigin = pmin;
+    for(int k=0; k<3; ++k){
+        m_gridSpacing[k] = (pmax[k] > pmin[k]) ? (pmax[k] - pmin[k])/double(m_gridDim[k]) : 1.0;
+    }
+
+    //counting sort of nodes by cell
+    int size = m_gridDim[0]*m_gridDim[1]*m_gridDim[2];
+    ivector1D cellOf(nactive);
+    m_gridCellPtr.assign(size+1, 0);
+    for(int i=0; i<nactive; ++i){
+        iarray3E ijk;
+        for(int k=0; k<3; ++k){
+            ijk[k] = std::min(m_gridDim[k]-1, int((m_node[active[i]][k] - m_gridOrigin[k])/m_gridSpacing[k]));
+        }
+        cellOf[i] = ijk[0] + m_gridDim[0]*(ijk[1] + m_gridDim[1]*ijk[2]);
+        ++m_gridCellPtr[cellOf[i]+1];
+    }
+    for(int c=0; c<size; ++c){
+        m_gridCellPtr[c+1] += m_gridCellPtr[c];
+    }
+    m_gridNodes.resize(nactive);
+    ivector1D fill(m_gridCellPtr.begin(), m_gridCellPtr.end()-1);
+    for(int i=0; i<nactive; ++i){
+        m_gridNodes[fill[cellOf[i]]++] = active[i];
+    }
+};
+
+/*!
+ * Clean the uniform grid indexing the active RBF nodes.
+ */
+void
+MRBF::cleanNodeGrid(){
+    m_gridOrigin.fill(0.0);
+    m_gridSpacing.fill(1.0);
+    m_gridDim.fill(0);
+    ivector1D().swap(m_gridCellPtr);
+    ivector1D().swap(m_gridNodes);
+};
+
+/*!
+ * Get the active RBF nodes lying within the support of a point, using the grid built by buildNodeGrid.
+ * \param[in] point target point
+ * \param[in] radius RBF support radius
+ * \param[out] neighs indices of the RBF nodes whose distance from the point is lower than radius
+ */
+void
+MRBF::getNodesInSupport(const darray3E & point, double radius, ivector1D & neighs){
+
+    neighs.clear();
+    if(m_gridNodes.empty()) return;
+
+    iarray3E lo, hi;
+    for(int k=0; k<3; ++k){
+        double xlo = (point[k] - radius - m_gridOrigin[k])/m_gridSpacing[k];
+        double xhi = (point[k] + radius - m_gridOrigin[k])/m_gridSpacing[k];
+        if(xhi < 0.0 || xlo >= double(m_gridDim[k])) return;
+        lo[k] = std::max(0, int(std::floor(xlo)));
+        hi[k] = std::min(m_gridDim[k]-1, int(std::floor(xhi)));
+    }
+
+    for(int kk=lo[2]; kk<=hi[2]; ++kk){
+        for(int jj=lo[1]; jj<=hi[1]; ++jj){
+            for(int ii=lo[0]; ii<=hi[0]; ++ii){
+                int cell = ii + m_gridDim[0]*(jj + m_gridDim[1]*kk);
+                for(int n=m_gridCellPtr[cell]; n<m_gridCellPtr[cell+1]; ++n){
+                    int ind = m_gridNodes[n];
+                    if(norm2(point - m_node[ind]) < radius) neighs.push_back(ind);
+                }
+            }
+        }
+    }
+};
+
+/*!
+ * Evaluate the RBF data fields in a point, summing the contributions of the active nodes 
+ * lying within the support radius only. The grid of nodes must be built (see buildNodeGrid).
+ * \param[in] point target point
+ * \param[in] radius RBF support radius
+ * \param[in,out] neighs workspace for the list of nodes in support
+ * \param[out] values values of the data fields in the point, sized as the number of data fields
+ */
+void
+MRBF::evalRBFCompact(const darray3E & point, double radius, ivector1D & neighs, double * values){
+
+    int nfields = getDataCount();
+    for(int j=0; j<nfields; ++j){
+        values[j] = 0.0;
+    }
+    getNodesInSupport(point, radius, neighs);
+
+    for(auto & ind : neighs){
+        double basis = evalBasis(norm2(point - m_node[ind])/radius);
+        for(int j=0; j<nfields; ++j){
+            values[j] += basis * m_weight[j][ind];
+        }
+    }
+};
+
+/*!
+ * Pack coordinates and weights of the active RBF nodes in Structure-of-Arrays layout,
+ * so that distances and weighted sums of the dense evaluation run on contiguous arrays.
+ */
+void
+MRBF::packActiveNodes(){
+
+    ivector1D active = getActiveSet();
+    int nactive = active.size();
+    int nfields = getDataCount();
+
+    m_activeCoords.resize(3*nactive);
+    m_activeWeights.resize(nfields*nactive);
+    for(int i=0; i<nactive; ++i){
+        const darray3E & node = m_node[active[i]];
+        m_activeCoords[i] = node[0];
+        m_activeCoords[nactive+i] = node[1];
+        m_activeCoords[2*nactive+i] = node[2];
+        for(int j=0; j<nfields; ++j){
+            m_activeWeights[j*nactive+i] = m_weight[j][active[i]];
+        }
+    }
+};
+
+/*!
+ * Evaluate the RBF data fields in a point, summing the contributions of all the active nodes.
+ * Nodes are processed in blocks of MIMMO_MRBF_BLOCKSIZE: distances and basis values of a block are
+ * computed on stack buffers, then accumulated with the weights of the block. 
+ * Active nodes must be packed (see packActiveNodes).
+ * \param[in] point target point
+ * \param[in] radius RBF support radius
+ * \param[out] values values of the data fields in the point, sized as the number of data fields
+ */
+void
+MRBF::evalRBFDense(const darray3E & point, double radius, double * values){
+
+    int nfields = getDataCount();
+    int nactive = m_activeCoords.size()/3;
+    const double * xnode = m_activeCoords.data();
+    const double * ynode = xnode + nactive;
+    const double * znode = ynode + nactive;
+    const double * weights = m_activeWeights.data();
+
+    for(int j=0; j<nfields; ++j){
+        values[j] = 0.0;
+    }
+
+    double basis[MIMMO_MRBF_BLOCKSIZE];
+    for(int b=0; b<nactive; b+=MIMMO_MRBF_BLOCKSIZE){
+        int bsize = std::min(MIMMO_MRBF_BLOCKSIZE, nactive-b);
+        for(int k=0; k<bsize; ++k){
+            double dx = point[0] - xnode[b+k];
+            double dy = point[1] - ynode[b+k];
+            double dz = point[2] - znode[b+k];
+            basis[k] = std::sqrt(dx*dx + dy*dy + dz*dz)/radius;
+        }
+        for(int k=0; k<bsize; ++k){
+            basis[k] = evalBasis(basis[k]);
+        }
+        for(int j=0; j<nfields; ++j){
+            const double * w = weights + j*nactive + b;
+            double sum = 0.0;
+            for(int k=0; k<bsize; ++k){
+                sum += basis[k]*w[k];
+            }
+            values[j] += sum;
+        }
+    }
+};
+
+/*!
+ * Build the deformation operator of the class (see getDeformationOperator) and cache it.
+ * Vertices are split in contiguous blocks among threads: each thread evaluates the nonzero 
+ * entries of its rows once, storing them in private buffers which are then copied in place.
+ * For compactly supported kernels the nodes contributing to each vertex are retrieved 
+ * through the grid of nodes, otherwise all active nodes are visited.
+ */
+void
+MRBF::buildDeformationOperator(){
+
+    m_operator.clear();
+    m_operatorBuilt = true;
+
+    MimmoObject * container = getGeometry();
+    if(container == NULL || container->isEmpty()) return;
+
+    long nv = container->getNVertex();
+    long nn = getTotalNodesCount();
+    const bitpit::PiercedVector<bitpit::Vertex> & vertices = container->getVertices();
+    const livector1D & mapData = container->getMapData();
+    ivector1D active = getActiveSet();
+    double radius = RBF::getSupportRadius();
+
+    bool compact = isKernelCompact();
+    if(compact) buildNodeGrid(radius);
+
+    m_operator.initialize(nv, nn);
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        int nthreads = 1;
+        int thread = 0;
+#if MIMMO_ENABLE_OPENMP
+        nthreads = omp_get_num_threads();
+        thread = omp_get_thread_num();
+#endif
+        long begin = nv*thread/nthreads;
+        long end = nv*(thread+1)/nthreads;
+
+        livector1D cols;
+        dvector1D vals;
+        ivector1D neighs;
+        for(long i=begin; i<end; ++i){
+            long count = cols.size();
+            double filter = 1.0;
+            if(m_bfilter && i < long(m_filter.size()))  filter = m_filter[i];
+            if(filter != 0.0){
+                const darray3E & point = vertices[mapData[i]].getCoords();
+                if(compact){
+                    getNodesInSupport(point, radius, neighs);
+                    std::sort(neighs.begin(), neighs.end());
+                }
+                const ivector1D & cand = compact ? neighs : active;
+                for(auto & ind : cand){
+                    double basis = evalBasis(norm2(point - m_node[ind])/radius);
+                    if(basis != 0.0){
+                        cols.push_back(ind);
+                        vals.push_back(basis*filter);
+                    }
+                }
+            }
+            m_operator.m_rowPtr[i+1] = long(cols.size()) - count;
+        }
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+        {
+            for(long i=0; i<nv; ++i){
+                m_operator.m_rowPtr[i+1] += m_operator.m_rowPtr[i];
+            }
+            m_operator.m_colIndex.resize(m_operator.m_rowPtr[nv]);
+            m_operator.m_values.resize(m_operator.m_rowPtr[nv]);
+        }
+
+        std::copy(cols.begin(), cols.end(), m_operator.m_colIndex.begin() + m_operator.m_rowPtr[begin]);
+        std::copy(vals.begin(), vals.end(), m_operator.m_values.begin() + m_operator.m_rowPtr[begin]);
+    }
+};
+
+/*!
+ * Evaluate the RBF weights interpolating the current data fields on the active nodes, 
+ * for compactly supported positive definite kernels (see isKernelPositiveDefinite). 
+ * The interpolation matrix is assembled in sparse format, retrieving the nodes in support 
+ * through the grid of nodes, and it is solved for each data field with a preconditioned 
+ * conjugate gradient method (see solvePCG). Weights of inactive nodes are set to zero.
+ * The solution stops at the first data field not solved: in that case the weights are not
+ * valid and have to be evaluated otherwise.
+ * \param[in] radius RBF support radius
+ * \return number of data fields whose solution broke down or did not reach the target tolerance
+ */
+int
+MRBF::solveSparse(double radius){
+
+    ivector1D active = getActiveSet();
+    int nactive = active.size();
+    int nnodes = getTotalNodesCount();
+    int nfields = getDataCount();
+
+    m_weight.assign(nfields, dvector1D(nnodes, 0.0));
+    if(nactive == 0) return 0;
+
+    buildNodeGrid(radius);
+    ivector1D activeIndex(nnodes, -1);
+    for(int i=0; i<nactive; ++i){
+        activeIndex[active[i]] = i;
+    }
+
+    //assemble interpolation matrix, with sorted column indices. Rows are split in contiguous
+    //blocks among threads, each one filling private buffers then copied in place.
+    CSRMatrix matrix(nactive, nactive);
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        int nthreads = 1;
+        int thread = 0;
+#if MIMMO_ENABLE_OPENMP
+        nthreads = omp_get_num_threads();
+        thread = omp_get_thread_num();
+#endif
+        int begin = int(long(nactive)*thread/nthreads);
+        int end = int(long(nactive)*(thread+1)/nthreads);
+
+        livector1D cols;
+        dvector1D vals;
+        ivector1D neighs;
+        for(int i=begin; i<end; ++i){
+            long count = cols.size();
+            getNodesInSupport(m_node[active[i]], radius, neighs);
+            std::sort(neighs.begin(), neighs.end());
+            for(auto & ind : neighs){
+                double basis = evalBasis(norm2(m_node[active[i]] - m_node[ind])/radius);
+                if(basis != 0.0){
+                    cols.push_back(activeIndex[ind]);
+                    vals.push_back(basis);
+                }
+            }
+            matrix.m_rowPtr[i+1] = long(cols.size()) - count;
+        }
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+        {
+            for(int i=0; i<nactive; ++i){
+                matrix.m_rowPtr[i+1] += matrix.m_rowPtr[i];
+            }
+            matrix.m_colIndex.resize(matrix.m_rowPtr[nactive]);
+            matrix.m_values.resize(matrix.m_rowPtr[nactive]);
+        }
+
+        std::copy(cols.begin(), cols.end(), matrix.m_colIndex.begin() + matrix.m_rowPtr[begin]);
+        std::copy(vals.begin(), vals.end(), matrix.m_values.begin() + matrix.m_rowPtr[begin]);
+    }
+
+    (*m_log) << m_name << " : sparse interpolation matrix of " << nactive << " nodes with " << matrix.getNNZ() << " nonzeros" << std::endl;
+
+    int failed = 0;
+    dvector1D rhs(nactive), sol(nactive);
+    for(int j=0; j<nfields; ++j){
+        for(int i=0; i<nactive; ++i){
+            rhs[i] = m_value[j][active[i]];
+        }
+        int iter = solvePCG(matrix, rhs, sol);
+        if(iter < 0){
+            (*m_log) << "warning: " << getName() << " sparse solver did not converge for field " << j << std::endl;
+            ++failed;
+            break;
+        }
+        (*m_log) << m_name << " : field " << j << " solved in " << iter << " iterations" << std::endl;
+        for(int i=0; i<nactive; ++i){
+            m_weight[j][active[i]] = sol[i];
+        }
+    }
+    return(failed);
+};
+
+/*!
+ * Solve a symmetric positive definite sparse linear system with the conjugate gradient method,
+ * preconditioned by a symmetric Gauss-Seidel sweep. Column indices of each matrix row are
+ * required to be sorted. Convergence is reached when the residual norm, relative to the 
+ * right hand side norm, falls below the class tolerance (see setTol).
+ * \param[in] matrix square matrix of the system
+ * \param[in] rhs right hand side
+ * \param[out] sol solution
+ * \return number of iterations performed, -1 if not converged or if the method broke down
+ * (non positive curvature p'Ap or preconditioned residual, found for indefinite matrices)
+ */
+int
+MRBF::solvePCG(const CSRMatrix & matrix, const dvector1D & rhs, dvector1D & sol){
+
+    long n = matrix.getNRows();
+    sol.assign(n, 0.0);
+
+    double bnorm = norm2(rhs);
+    if(bnorm == 0.0) return 0;
+
+    const livector1D & rowPtr = matrix.m_rowPtr;
+    const livector1D & col = matrix.m_colIndex;
+    const dvector1D & val = matrix.m_values;
+
+    dvector1D diag(n, 1.0);
+    for(long i=0; i<n; ++i){
+        for(long k=rowPtr[i]; k<rowPtr[i+1]; ++k){
+            if(col[k] == i) diag[i] = val[k];
+        }
+    }
+
+    //symmetric Gauss-Seidel preconditioner, z = ((D+L) D^-1 (D+U))^-1 r
+    auto precondition = [&](const dvector1D & r, dvector1D & z){
+        for(long i=0; i<n; ++i){
+            double sum = r[i];
+            for(long k=rowPtr[i]; k<rowPtr[i+1] && col[k] < i; ++k){
+                sum -= val[k]*z[col[k]];
+            }
+            z[i] = sum/diag[i];
+        }
+        for(long i=0; i<n; ++i){
+            z[i] *= diag[i];
+        }
+        for(long i=n-1; i>=0; --i){
+            double sum = z[i];
+            for(long k=rowPtr[i+1]-1; k>=rowPtr[i] && col[k] > i; --k){
+                sum -= val[k]*z[col[k]];
+            }
+            z[i] = sum/diag[i];
+        }
+    };
+
+    dvector1D r = rhs;
+    dvector1D z(n), p(n), q(n);
+    precondition(r, z);
+    p = z;
+    double rz = dotProduct(r, z);
+    if(!(rz > 0.0) || !std::isfinite(rz)) return(-1);
+
+    int maxIter = std::max(long(100), n);
+    for(int iter=1; iter<=maxIter; ++iter){
+        matrix.multiply(p, q);
+        double pq = dotProduct(p, q);
+        if(!(pq > 0.0) || !std::isfinite(pq)) return(-1);
+        double alpha = rz/pq;
+        for(long i=0; i<n; ++i){
+            sol[i] += alpha*p[i];
+            r[i] -= alpha*q[i];
+        }
+        if(norm2(r) <= m_tol*bnorm) return iter;
+
+        precondition(r, z);
+        double rzNew = dotProduct(r, z);
+        if(!(rzNew > 0.0) || !std::isfinite(rzNew)) return(-1);
+        double beta = rzNew/rz;
+        rz = rzNew;
+        for(long i=0; i<n; ++i){
+            p[i] = z[i] + beta*p[i];
+        }
+    }
+    return(-1);
+};
+
+/*!
+ * Build the octree of active RBF nodes and compute the weight moments of each cell,
+ * used by the treecode approximation. Weights must be already evaluated.
+ */
+void
+MRBF::buildNodeTree(){
+
+    cleanNodeTree();
+
+    m_treeNodes = getActiveSet();
+    if(m_treeNodes.empty()) return;
+
+    TreeCell root;
+    root.begin = 0;
+    root.end = m_treeNodes.size();
+    m_tree.push_back(root);
+    splitTreeCell(0, 0);
+
+    //cell moments
+    int ncells = m_tree.size();
+    int nfields = getDataCount();
+    m_treeMonopole.assign(ncells*nfields, 0.0);
+    m_treeDipole.assign(ncells*nfields, darray3E{{0.0, 0.0, 0.0}});
+    m_treeQuadrupole.assign(6*ncells*nfields, 0.0);
+    for(int c=0; c<ncells; ++c){
+        const TreeCell & cell = m_tree[c];
+        for(int n=cell.begin; n<cell.end; ++n){
+            int ind = m_treeNodes[n];
+            darray3E dist = m_node[ind] - cell.center;
+            for(int j=0; j<nfields; ++j){
+                double w = m_weight[j][ind];
+                double * quad = m_treeQuadrupole.data() + 6*(c*nfields+j);
+                m_treeMonopole[c*nfields+j] += w;
+                m_treeDipole[c*nfields+j] += w*dist;
+                quad[0] += w*dist[0]*dist[0];
+                quad[1] += w*dist[1]*dist[1];
+                quad[2] += w*dist[2]*dist[2];
+                quad[3] += w*dist[0]*dist[1];
+                quad[4] += w*dist[0]*dist[2];
+                quad[5] += w*dist[1]*dist[2];
+            }
+        }
+    }
+};
+
+/*!
+ * Compute centroid and size of a tree cell and split it recursively in octants, 
+ * until cells hold few nodes. Children of a cell are stored contiguously.
+ * \param[in] cell index of the cell in m_tree
+ * \param[in] depth depth of the cell in the tree
+ */
+void
+MRBF::splitTreeCell(int cell, int depth){
+
+    int begin = m_tree[cell].begin;
+    int end = m_tree[cell].end;
+
+    darray3E center = {{0.0, 0.0, 0.0}};
+    darray3E pmin = m_node[m_treeNodes[begin]];
+    darray3E pmax = pmin;
+    for(int n=begin; n<end; ++n){
+        const darray3E & node = m_node[m_treeNodes[n]];
+        center += node;
+        for(int k=0; k<3; ++k){
+            pmin[k] = std::min(pmin[k], node[k]);
+            pmax[k] = std::max(pmax[k], node[k]);
+        }
+    }
+    center /= double(end - begin);
+    double size = 0.0;
+    for(int n=begin; n<end; ++n){
+        size = std::max(size, norm2(m_node[m_treeNodes[n]] - center));
+    }
+    m_tree[cell].center = center;
+    m_tree[cell].size = size;
+    m_tree[cell].child = -1;
+    m_tree[cell].nchildren = 0;
+
+    if(end - begin <= 16 || depth >= 32 || size == 0.0) return;
+
+    //partition nodes in octants around the bounding box center
+    darray3E mid = 0.5*(pmin + pmax);
+    ivector1D::iterator bounds[9];
+    bounds[0] = m_treeNodes.begin() + begin;
+    bounds[8] = m_treeNodes.begin() + end;
+    bounds[4] = std::partition(bounds[0], bounds[8], [&](int ind){return m_node[ind][0] < mid[0];});
+    for(int h=0; h<2; ++h){
+        bounds[4*h+2] = std::partition(bounds[4*h], bounds[4*h+4], [&](int ind){return m_node[ind][1] < mid[1];});
+        for(int q=0; q<2; ++q){
+            int o = 4*h+2*q;
+            bounds[o+1] = std::partition(bounds[o], bounds[o+2], [&](int ind){return m_node[ind][2] < mid[2];});
+        }
+    }
+
+    int first = m_tree.size();
+    for(int o=0; o<8; ++o){
+        if(bounds[o] == bounds[o+1]) continue;
+        TreeCell child;
+        child.begin = int(bounds[o] - m_treeNodes.begin());
+        child.end = int(bounds[o+1] - m_treeNodes.begin());
+        m_tree.push_back(child);
+    }
+    int last = m_tree.size();
+    m_tree[cell].child = first;
+    m_tree[cell].nchildren = last - first;
+
+    for(int c=first; c<last; ++c){
+        splitTreeCell(c, depth+1);
+    }
+};
+
+/*!
+ * Clean the octree of active RBF nodes used by the treecode approximation.
+ */
+void
+MRBF::cleanNodeTree(){
+    std::vector<TreeCell>().swap(m_tree);
+    ivector1D().swap(m_treeNodes);
+    dvector1D().swap(m_treeMonopole);
+    dvecarr3E().swap(m_treeDipole);
+    dvector1D().swap(m_treeQuadrupole);
+};
+
+/*!
+ * Evaluate the RBF data fields in a point with the treecode approximation. 
+ * Contribution of a far tree cell (see setTreecodeOpeningRatio) is approximated by the second order 
+ * Taylor expansion of the basis function about the cell centroid, using sum, first and second moments 
+ * of the cell weights; basis function derivatives are evaluated by central differences.
+ * Near leaf cells are summed directly. The tree must be built (see buildNodeTree).
+ * \param[in] point target point
+ * \param[in] radius RBF support radius
+ * \param[in,out] stack workspace for the tree traversal
+ * \param[out] values values of the data fields in the point, sized as the number of data fields
+ */
+void
+MRBF::evalRBFTreecode(const darray3E & point, double radius, ivector1D & stack, double * values){
+
+    int nfields = getDataCount();
+    for(int j=0; j<nfields; ++j){
+        values[j] = 0.0;
+    }
+    if(m_tree.empty()) return;
+
+    const double h = 1.0E-4;
+    stack.assign(1, 0);
+    while(!stack.empty()){
+        int c = stack.back();
+        stack.pop_back();
+        const TreeCell & cell = m_tree[c];
+        darray3E dir = cell.center - point;
+        double dist = norm2(dir);
+
+        if(cell.size < m_treeRatio*dist){
+            //far field expansion
+            double s = dist/radius;
+            double basis = evalBasis(s);
+            double bp = evalBasis(s+h);
+            double bm = evalBasis(std::abs(s-h));
+            double dbasis = (bp - bm)/(2.0*h)/radius;
+            double ddbasis = (bp - 2.0*basis + bm)/(h*h)/(radius*radius);
+            dir /= dist;
+            double radial = 0.5*(ddbasis - dbasis/dist);
+            double trace = 0.5*dbasis/dist;
+            for(int j=0; j<nfields; ++j){
+                const double * quad = m_treeQuadrupole.data() + 6*(c*nfields+j);
+                double qdir = quad[0]*dir[0]*dir[0] + quad[1]*dir[1]*dir[1] + quad[2]*dir[2]*dir[2]
+                            + 2.0*(quad[3]*dir[0]*dir[1] + quad[4]*dir[0]*dir[2] + quad[5]*dir[1]*dir[2]);
+                values[j] += basis*m_treeMonopole[c*nfields+j] + dbasis*dotProduct(dir, m_treeDipole[c*nfields+j])
+                           + radial*qdir + trace*(quad[0] + quad[1] + quad[2]);
+            }
+        }else if(cell.child < 0){
+            //near field direct sum
+            for(int n=cell.begin; n<cell.end; ++n){
+                int ind = m_treeNodes[n];
+                double basis = evalBasis(norm2(point - m_node[ind])/radius);
+                for(int j=0; j<nfields; ++j){
+                    values[j] += basis * m_weight[j][ind];
+                }
+            }
+        }else{
+            for(int k=0; k<cell.nchildren; ++k){
+                stack.push_back(cell.child + k);
+            }
+        }
+    }
+};
+
+/*!
+ * Evaluate the RBF weights interpolating the current data fields with the greedy algorithm,
+ * as bitpit::RBF::greedy does, but evaluating the residuals with the treecode approximation. 
+ * Starting from no active nodes, the node with the largest residual norm is activated and 
+ * the weights of the active nodes are solved again, until the largest residual norm of the 
+ * inactive nodes falls below the class tolerance (see setTol). At each step the residuals 
+ * of all nodes are evaluated in parallel on the octree of the active nodes, so that their 
+ * cost scales with the logarithm of the active nodes instead of linearly.
+ * The weights are solved by updating a Cholesky factorization of the interpolation matrix
+ * with the row of the new node, at a cost quadratic in the active nodes per step, instead of
+ * solving the whole system again; if the matrix is found not positive definite (kernels
+ * other than the Gaussian ones may give indefinite matrices), the whole system is solved
+ * from that step on (see bitpit::RBF::solve). The octree is rebuilt at each step.
+ * Only the residual evaluation is accelerated: for K selected nodes out of N the whole build 
+ * costs O(K^3) for the weights and O(K N log K) for the residuals, hence it does not scale 
+ * linearly when many nodes are selected.
+ * \param[in] radius RBF support radius
+ * \return number of active nodes selected
+ */
+int
+MRBF::greedyTreecode(double radius){
+
+    int nnodes = getTotalNodesCount();
+    int nfields = getDataCount();
+
+    deactivateAllNodes();
+    m_weight.assign(nfields, dvector1D(nnodes, 0.0));
+    if(nnodes == 0 || nfields == 0) return 0;
+
+    //residuals with no active nodes are the data values.
+    dvector1D error(nnodes, 0.0);
+    for(int i=0; i<nnodes; ++i){
+        double sum = 0.0;
+        for(int j=0; j<nfields; ++j){
+            sum += m_value[j][i]*m_value[j][i];
+        }
+        error[i] = std::sqrt(sum);
+    }
+
+    //lower triangular factor of the interpolation matrix of the selected nodes, packed by rows
+    bvector1D selected(nnodes, false);
+    ivector1D order;
+    dvector1D chol;
+    dvector1D sol;
+    bool factorized = true;
+    int nactive = 0;
+    while(nactive < nnodes){
+
+        int index = -1;
+        double maxError = m_tol;
+        for(int i=0; i<nnodes; ++i){
+            if(!selected[i] && error[i] > maxError){
+                maxError = error[i];
+                index = i;
+            }
+        }
+        if(index < 0) break;
+
+        selected[index] = true;
+        activateNode(index);
+        ++nactive;
+
+        if(factorized){
+            int k = order.size();
+            std::size_t row = chol.size();
+            chol.resize(row + k + 1);
+            double diag = evalBasis(0.0);
+            for(int c=0; c<k; ++c){
+                double sum = evalBasis(norm2(m_node[index] - m_node[order[c]])/radius);
+                std::size_t rowc = std::size_t(c)*(c+1)/2;
+                for(int m=0; m<c; ++m){
+                    sum -= chol[row+m]*chol[rowc+m];
+                }
+                chol[row+c] = sum/chol[rowc+c];
+                diag -= chol[row+c]*chol[row+c];
+            }
+            factorized = (diag > 0.0 && std::isfinite(diag));
+            if(factorized){
+                chol[row+k] = std::sqrt(diag);
+                order.push_back(index);
+            }else{
+                (*m_log) << "warning: " << getName() << " greedy interpolation matrix not positive definite, full system solved" << std::endl;
+            }
+        }
+
+        if(factorized){
+            int k = order.size();
+            sol.resize(k);
+            for(int j=0; j<nfields; ++j){
+                for(int r=0; r<k; ++r){
+                    std::size_t rowr = std::size_t(r)*(r+1)/2;
+                    double sum = m_value[j][order[r]];
+                    for(int m=0; m<r; ++m){
+                        sum -= chol[rowr+m]*sol[m];
+                    }
+                    sol[r] = sum/chol[rowr+r];
+                }
+                for(int r=k-1; r>=0; --r){
+                    double sum = sol[r];
+                    for(int m=r+1; m<k; ++m){
+                        sum -= chol[std::size_t(m)*(m+1)/2+r]*sol[m];
+                    }
+                    sol[r] = sum/chol[std::size_t(r)*(r+1)/2+r];
+                    m_weight[j][order[r]] = sol[r];
+                }
+            }
+        }else{
+            solve();
+        }
+        buildNodeTree();
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+        {
+            dvector1D values(nfields, 0.0);
+            ivector1D stack;
+#if MIMMO_ENABLE_OPENMP
+#pragma omp for schedule(dynamic, 256)
+#endif
+            for(int i=0; i<nnodes; ++i){
+                if(selected[i]){
+                    error[i] = 0.0;
+                    continue;
+                }
+                evalRBFTreecode(m_node[i], radius, stack, values.data());
+                double sum = 0.0;
+                for(int j=0; j<nfields; ++j){
+                    double diff = m_value[j][i] - values[j];
+                    sum += diff*diff;
+                }
+                error[i] = std::sqrt(sum);
+            }
+        }
+    }
+
+    (*m_log) << m_name << " : greedy interpolation selected " << nactive << " of " << nnodes << " nodes" << std::endl;
+    return(nactive);
+};
+
 /*!Execution of RBF object. It evaluates the displacements (values) over the point of the
  * linked geometry, given as result of RBF technique implemented in bitpit::RBF base class.
  * The result is stored in the m_displ member.
@@ -522,27 +1464,73 @@ MRBF::execute(){
     RBF::setSupportRadius(radius);
 
     if (m_solver == MRBFSol::WHOLE)    solve();
-    if (m_solver == MRBFSol::GREEDY)    greedy(m_tol);
+    if (m_solver == MRBFSol::GREEDY){
+        if(m_treecode && !(m_compact && isKernelCompact()))    greedyTreecode(radius);
+        else                                                  greedy(m_tol);
+    }
+    if (m_solver == MRBFSol::SPARSE){
+        if(!isKernelPositiveDefinite()){
+            (*m_log) << "warning: " << getName() << " sparse solver requires the Wendland C2 RBF kernel, dense solver used" << std::endl;
+            solve();
+        }else if(solveSparse(radius) > 0){
+            (*m_log) << "warning: " << getName() << " sparse solver failed, dense solver used" << std::endl;
+            solve();
+        }
+    }
 
-    int nv = container->getNVertex();
-    dvecarr3E vertex = container->getVertexCoords();
+    long nv = container->getNVertex();
+    int nfields = getDataCount();
+    const bitpit::PiercedVector<bitpit::Vertex> & vertices = container->getVertices();
+    const livector1D & mapData = container->getMapData();
 
-    m_displ.resize(nv, darray3E{0,0,0});
-    dvector1D displ;
-    for(int i=0; i<nv; ++i){
-        displ = RBF::evalRBF(vertex[i]);
-        for (int j=0; j<3; j++) m_displ[i][j] = displ[j];
+    bool compact = m_compact && isKernelCompact();
+    if(m_compact && !compact){
+        (*m_log) << "warning: " << getName() << " compact support evaluation disabled, RBF kernel is not compactly supported" << std::endl;
     }
-
-    //if m_filter is active;
-    if(m_bfilter){
-        m_filter.resize(nv,1.0);
-        int counter = 0;
-        for (auto && vec : m_displ){
-            vec = vec * m_filter[counter];
-            ++counter;
+    if(compact) buildNodeGrid(radius);
+    bool treecode = m_treecode && !compact;
+    if(treecode)     buildNodeTree();
+    else if(!compact) packActiveNodes();
+
+    if(m_bfilter)    m_filter.resize(nv,1.0);
+    m_displ.resize(nv);
+
+    //evaluate displacements of vertices, modulated by filter field if active.
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        //thread private workspaces
+        dvector1D values(std::max(3, nfields), 0.0);
+        ivector1D workspace;
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp for schedule(dynamic, 256)
+#endif
+        for(long i=0; i<nv; ++i){
+            const darray3E & point = vertices[mapData[i]].getCoords();
+            if(compact)         evalRBFCompact(point, radius, workspace, values.data());
+            else if(treecode)   evalRBFTreecode(point, radius, workspace, values.data());
+            else                evalRBFDense(point, radius, values.data());
+
+            double filter = 1.0;
+            if(m_bfilter)  filter = m_filter[i];
+            for (int j=0; j<3; j++) m_displ[i][j] = values[j]*filter;
         }
     }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    (*m_log) << m_name << " : evaluated " << nv << " vertices in " << elapsed.count() << " s";
+    if(elapsed.count() > 0.0) (*m_log) << " (" << double(nv)/elapsed.count() << " vertices/s)";
+    (*m_log) << std::endl;
+
+    //deformation operator refers to the current execution: build it now if a receiver is linked to its port.
+    m_operator.clear();
+    m_operatorBuilt = false;
+    if(m_solver == MRBFSol::NONE && m_portOut.count(PortType::M_CSROPERATOR) != 0 && !m_portOut[PortType::M_CSROPERATOR]->getLink().empty()){
+        buildDeformationOperator();
+    }
 
 };
 
@@ -553,14 +1541,7 @@ void
 MRBF::apply(){
 
     if (getGeometry() == NULL) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_displ.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_displ[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_displ);
 
 }
 
@@ -665,7 +1646,7 @@ MRBF::absorbSectionXML(const bitpit::Config::Section & slotXML, std::string name
             std::stringstream ss(bitpit::utils::string::trim(input));
             ss >> value;
             value = std::max(value, 0);
-            if(value > 2) value = 0;
+            if(value > 3) value = 0;
         }
         setMode(value);
     };
@@ -701,6 +1682,36 @@ MRBF::absorbSectionXML(const bitpit::Config::Section & slotXML, std::string name
             if(value > 0.0)    setTol(value);
         }
     };
+
+    if(slotXML.hasOption("CompactSupport")){
+        input = slotXML.get("CompactSupport");
+        bool value = false;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setCompactSupport(value);
+    };
+
+    if(slotXML.hasOption("Treecode")){
+        input = slotXML.get("Treecode");
+        bool value = false;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setTreecode(value);
+    };
+
+    if(slotXML.hasOption("TreecodeOpeningRatio")){
+        input = slotXML.get("TreecodeOpeningRatio");
+        double value = 0.5;
+        if(!input.empty()){
+            std::stringstream ss(bitpit::utils::string::trim(input));
+            ss >> value;
+        }
+        setTreecodeOpeningRatio(value);
+    };
 }
 
 /*!
@@ -743,6 +1754,17 @@ MRBF::flushSectionXML(bitpit::Config::Section & slotXML, std::string name){
         slotXML.set("Tolerance", ss.str());
     }
 
+    if(m_compact){
+        slotXML.set("CompactSupport", std::to_string(1));
+    }
+
+    if(m_treecode){
+        slotXML.set("Treecode", std::to_string(1));
+        std::stringstream ss;
+        ss<<std::scientific<<m_treeRatio;
+        slotXML.set("TreecodeOpeningRatio", ss.str());
+    }
+
  
 }
 
@@ -27,6 +27,12 @@
 #include "BaseManipulation.hpp"
 #include "rbf.hpp"
 
+/*!
+ * Number of RBF nodes processed together by MRBF in the evaluation of displacements with
+ * all active nodes: distances and basis values of a block are stored on stack buffers.
+ */
+#define MIMMO_MRBF_BLOCKSIZE 256
+
 namespace mimmo{
 
 /*!
@@ -37,7 +43,8 @@ namespace mimmo{
 enum class MRBFSol{
     NONE = 0,     /**< activate class as pure parameterizator. Set freely your RBF coefficients/weights */
             WHOLE = 1,    /**< activate class as pure interpolator, with RBF coefficients evaluated solving a full linear system for all active nodes.*/
-            GREEDY= 2   /**< activate class as pure interpolator, with RBF coefficients evaluated using a greedy algorithm on active nodes.*/
+            GREEDY= 2,   /**< activate class as pure interpolator, with RBF coefficients evaluated using a greedy algorithm on active nodes.*/
+            SPARSE= 3   /**< activate class as pure interpolator, with RBF coefficients evaluated solving iteratively a sparse linear system for all active nodes (Wendland C2 kernel only).*/
 };
 
 /*!
@@ -50,7 +57,9 @@ enum class MRBFSol{
  * It evaluates the result of RBF built over a set of control point given by the user
  * or stored in a MimmoObject (geometry container). Default solver in execution is
  * MRBFSol::NONE for direct parameterization. Use MRBFSol::GREEDY or MRBFSol::SOLVE to activate
- * interpolation features.
+ * interpolation features. MRBFSol::SPARSE solves iteratively the interpolation problem
+ * assembled in sparse format, meant for large sets of nodes and the compactly supported,
+ * positive definite Wendland C2 kernel; the full system is solved if the iterative solver fails.
  * See bitpit::RBF docs for further information.
  *
  * \n
@@ -73,6 +82,7 @@ enum class MRBFSol{
      |<B>PortID</B> | <B>PortType</B> | <B>variable/function</B> |<B>DataType</B>|
      | 11    | M_GDISPLS      | getDisplacements  | (VECARR3, FLOAT)             |
      | 80    | M_PAIRVECFIELD | getDeformedField  | (PAIR, MIMMO_VECARR3FLOAT_)  |
+     | 160   | M_CSROPERATOR  | getDeformationOperator | (SCALAR, CSRMATRIX)     |
      | 99    | M_GEOM   | getGeometry       | (SCALAR,MIMMO_) |
 
  *    =========================================================
@@ -86,11 +96,14 @@ enum class MRBFSol{
  * - <B>Apply</B>: boolean 0/1 activate apply deformation result on target geometry directly in execution;
  *
  * Proper of the class:
- * - <B>Mode</B>: mode of usage of the class 0-parameterizator class, 1-regular interpolator class, 2- greedy interpolator class );
+ * - <B>Mode</B>: mode of usage of the class 0-parameterizator class, 1-regular interpolator class, 2- greedy interpolator class, 3-sparse iterative interpolator class );
  * - <B>SupportRadius</B>: local radius of RBF function for each nodes, expressed as ratio of local geometry bounding box;
  * - <B>SupportRadiusReal</B>: local effective radius of RBF function for each nodes;
  * - <B>RBFShape</B>: shape of RBF function wendlandc2 (1), linear (2), gauss90 (3), gauss95 (4), gauss99 (5);
- * - <B>Tolerance</B>: greedy engine tolerance (meant for mode 2);
+ * - <B>Tolerance</B>: greedy engine tolerance (meant for mode 2) or relative residual tolerance of the iterative solver (meant for mode 3);
+ * - <B>CompactSupport</B>: boolean 0/1 enable evaluation of compactly supported kernels through a spatial index of RBF nodes (see MRBF::setCompactSupport);
+ * - <B>Treecode</B>: boolean 0/1 enable treecode far-field approximation of RBF evaluation and greedy residuals (see MRBF::setTreecode);
+ * - <B>TreecodeOpeningRatio</B>: opening ratio of the treecode approximation (see MRBF::setTreecodeOpeningRatio);
  * 
  *
  * Geometry, filter field, RBF nodes and displacements have to be mandatorily passed through port.
@@ -107,6 +120,36 @@ private:
     double        m_SRRatio;        /**<support Radius ratio */
     dvecarr3E    m_displ;        /**<Resulting displacements of geometry vertex.*/
     bool        m_supRIsValue;  /**<True if support radius is defined as absolute value, false if is ratio of bounding box diagonal.*/
+    bool        m_compact;      /**<True if compact support evaluation through spatial index of nodes is enabled.*/
+    darray3E    m_gridOrigin;   /**<Origin of the uniform grid indexing active RBF nodes.*/
+    darray3E    m_gridSpacing;  /**<Cell spacing of the uniform grid indexing active RBF nodes.*/
+    iarray3E    m_gridDim;      /**<Number of cells of the uniform grid indexing active RBF nodes.*/
+    ivector1D   m_gridCellPtr;  /**<Index of the first node of each grid cell in m_gridNodes, number of cells+1 sized.*/
+    ivector1D   m_gridNodes;    /**<Active RBF nodes grouped by grid cell.*/
+    dvector1D   m_activeCoords; /**<Coordinates of active RBF nodes in SoA layout, all x, then all y, then all z.*/
+    dvector1D   m_activeWeights;/**<Weights of active RBF nodes in SoA layout, one contiguous block per data field.*/
+
+    /*!
+     * \brief Cell of the octree of active RBF nodes used by the treecode approximation.
+     */
+    struct TreeCell{
+        darray3E    center;     /**< Centroid of the nodes of the cell.*/
+        double      size;       /**< Maximum distance of the nodes of the cell from the centroid.*/
+        int         begin;      /**< First node of the cell in m_treeNodes.*/
+        int         end;        /**< Past-the-end node of the cell in m_treeNodes.*/
+        int         child;      /**< Index of the first child cell, -1 for leaf cells.*/
+        int         nchildren;  /**< Number of children cells, stored contiguously.*/
+    };
+
+    bool        m_treecode;     /**<True if treecode far-field approximation of RBF evaluation is enabled.*/
+    double      m_treeRatio;    /**<Opening ratio of the treecode approximation, size of a cell over its distance from the target point.*/
+    std::vector<TreeCell> m_tree; /**<Octree cells of active RBF nodes, root cell first.*/
+    ivector1D   m_treeNodes;    /**<Active RBF nodes ordered by tree cell.*/
+    dvector1D   m_treeMonopole; /**<Sum of the weights of the nodes of each tree cell, for each data field.*/
+    dvecarr3E   m_treeDipole;   /**<First moment of the weights of the nodes of each tree cell about its centroid, for each data field.*/
+    dvector1D   m_treeQuadrupole; /**<Second moment of the weights of the nodes of each tree cell about its centroid (xx,yy,zz,xy,xz,yz), for each data field.*/
+    CSRMatrix   m_operator;     /**<Deformation operator cached after the last execution.*/
+    bool        m_operatorBuilt;/**<True if the cached deformation operator refers to the last execution.*/
 
 public:
     MRBF();
@@ -129,9 +172,15 @@ public:
     double            getSupportRadius();
     double            getSupportRadiusValue();
     bool            getIsSupportRadiusValue();
+    bool            isCompactSupport();
+    bool            isKernelCompact();
+    bool            isKernelPositiveDefinite();
+    bool            isTreecode();
+    double          getTreecodeOpeningRatio();
 
     std::pair<MimmoObject * , dvecarr3E * >    getDeformedField();
     dvecarr3E        getDisplacements();
+    CSRMatrix        getDeformationOperator();
 
     int             addNode(darray3E);
     ivector1D        addNode(dvecarr3E);
@@ -148,6 +197,9 @@ public:
     void            setSupportRadius(double suppR_);
     void            setSupportRadiusValue(double suppR_);
     void             setTol(double tol);
+    void            setCompactSupport(bool flag);
+    void            setTreecode(bool flag);
+    void            setTreecodeOpeningRatio(double ratio);
     void             setDisplacements(dvecarr3E displ);
 
     void             clear();
@@ -161,6 +213,20 @@ public:
 
 protected:
     void            setWeight(dvector2D value);
+    void            buildNodeGrid(double radius);
+    void            cleanNodeGrid();
+    void            getNodesInSupport(const darray3E & point, double radius, ivector1D & neighs);
+    void            evalRBFCompact(const darray3E & point, double radius, ivector1D & neighs, double * values);
+    void            packActiveNodes();
+    void            evalRBFDense(const darray3E & point, double radius, double * values);
+    void            buildDeformationOperator();
+    int             solveSparse(double radius);
+    int             solvePCG(const CSRMatrix & matrix, const dvector1D & rhs, dvector1D & sol);
+    void            buildNodeTree();
+    void            splitTreeCell(int cell, int depth);
+    void            cleanNodeTree();
+    void            evalRBFTreecode(const darray3E & point, double radius, ivector1D & stack, double * values);
+    int             greedyTreecode(double radius);
     void            plotCloud(std::string directory, std::string filename, int counterFile, bool binary, bool deformed);
     virtual void    plotOptionalResults();
 
@@ -128,16 +128,7 @@ MultiApply::execute(){
 
 
 
-        dvecarr3E vertex = val.first->getVertexCoords();
-        long nv = val.first->getNVertex();
-        nv = long(std::min(int(nv), int(val.second->size())));
-
-        livector1D & idmap = val.first->getMapData();
-        for (long i=0; i<nv; i++){
-
-            vertex[i] += (*(val.second))[i];
-            val.first->modifyVertex(vertex[i], idmap[i]);
-        }
+        val.first->applyDisplacements(*(val.second));
 
     }
     return;
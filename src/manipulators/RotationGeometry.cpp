@@ -184,14 +184,10 @@ RotationGeometry::execute(){
     double c = sin(m_alpha);
 
     darray3E point, rotated;
-    long ID;
-    int idx;
-    liimap mapID = m_geometry->getMapDataInv();
+    const std::array<dvector1D,3> & vcoords = m_geometry->getVertexCoordsSoA();
 
-    for (auto vertex : m_geometry->getVertices()){
-        point = vertex.getCoords();
-        ID = vertex.getId();
-        idx = mapID[ID];
+    for (int idx=0; idx<nV; ++idx){
+        point = {{vcoords[0][idx], vcoords[1][idx], vcoords[2][idx]}};
 
         point -= m_origin;
         //rodrigues formula
@@ -215,14 +211,7 @@ void
 RotationGeometry::apply(){
 
     if (getGeometry() == NULL) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_displ.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_displ[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_displ);
 
 }
 
@@ -164,25 +164,18 @@ ScaleGeometry::execute(){
     m_filter.resize(nV, 1.0);
 
 
-    long ID;
-    int idx;
-    liimap mapID = m_geometry->getMapDataInv();
+    const std::array<dvector1D,3> & vcoords = m_geometry->getVertexCoordsSoA();
 
     //computing centroid
     darray3E center = m_origin;
     if (m_meanP){
         center.fill(0.0);
-        for (auto vertex : m_geometry->getVertices()){
-            ID = vertex.getId();
-            idx = mapID[ID];
-            center += vertex.getCoords() / double(nV);
+        for (int idx=0; idx<nV; ++idx){
+            center += darray3E({{vcoords[0][idx], vcoords[1][idx], vcoords[2][idx]}}) / double(nV);
         }
     }
-    for (auto vertex : m_geometry->getVertices()){
-        ID = vertex.getId();
-        idx = mapID[ID];
-
-        darray3E coords = vertex.getCoords();
+    for (int idx=0; idx<nV; ++idx){
+        darray3E coords = {{vcoords[0][idx], vcoords[1][idx], vcoords[2][idx]}};
         m_displ[idx] = ( m_scaling*(coords - center) + center ) * m_filter[idx] - coords;
     }
 };
@@ -194,14 +187,7 @@ void
 ScaleGeometry::apply(){
 
     if (getGeometry() == NULL) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_displ.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_displ[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_displ);
 
 }
 
@@ -153,15 +153,7 @@ TranslationGeometry::execute(){
     m_displ.resize(nV);
     m_filter.resize(nV, 1.0);
 
-    long ID;
-    int idx;
-    liimap mapID = m_geometry->getMapDataInv();
-
-    for (auto vertex : m_geometry->getVertices()){
-        ID = vertex.getId();
-        idx = mapID[ID];
-
-
+    for (int idx=0; idx<nV; ++idx){
         m_displ[idx] = m_alpha*m_direction*m_filter[idx];
 
     }
@@ -174,14 +166,7 @@ void
 TranslationGeometry::apply(){
 
     if (getGeometry() == NULL) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_displ.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_displ[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_displ);
 
 }
 
@@ -201,18 +201,14 @@ TwistGeometry::execute(){
 
 
     darray3E point, rotated;
-    long ID;
-    int idx;
-    liimap mapID = m_geometry->getMapDataInv();
+    const std::array<dvector1D,3> & vcoords = m_geometry->getVertexCoordsSoA();
     darray3E projected;
     double distance;
     //double sign;
     double rot;
 
-    for (auto vertex : m_geometry->getVertices()){
-        point = vertex.getCoords();
-        ID = vertex.getId();
-        idx = mapID[ID];
+    for (int idx=0; idx<nV; ++idx){
+        point = {{vcoords[0][idx], vcoords[1][idx], vcoords[2][idx]}};
 
         //signed distance from origin
         distance = dotProduct((point-m_origin),m_direction);
@@ -250,14 +246,7 @@ void
 TwistGeometry::apply(){
 
     if (getGeometry() == NULL) return;
-    dvecarr3E vertex = getGeometry()->getVertexCoords();
-    long nv = getGeometry()->getNVertex();
-    nv = long(std::min(int(nv), int(m_displ.size())));
-    livector1D & idmap = getGeometry()->getMapData();
-    for (long i=0; i<nv; i++){
-        vertex[i] += m_displ[i];
-        getGeometry()->modifyVertex(vertex[i], idmap[i]);
-    }
+    getGeometry()->applyDisplacements(m_displ);
 
 }
 
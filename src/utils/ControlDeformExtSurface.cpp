@@ -376,7 +376,7 @@ ControlDeformExtSurface::execute(){
 
         //check constraints properties ******************************
         MimmoObject * local = gg->getGeometry();
-        if(!(local->isBvTreeBuilt()))    local->buildBvTree();
+        local->buildStructure(GeometryStructure::BVTREE);
         bool checkOpen = local->isClosedLoop();
 
         double dist;
@@ -662,7 +662,7 @@ ControlDeformExtSurface::readGeometries(std::vector<std::unique_ptr<MimmoGeometr
         if(geo->getGeometry()->getNVertex() == 0 || geo->getGeometry()->getNCells() == 0 || !geo->getGeometry()->isBvTreeSupported()){
             (*m_log)<<"warning: failed to read geometry in ControlDeformExtSurface::readGeometries. Skipping file..."<<std::endl;
         }else{
-            if (!geo->getGeometry()->areAdjacenciesBuilt()) geo->getGeometry()->getPatch()->buildAdjacencies();
+            geo->getGeometry()->buildStructure(GeometryStructure::ADJACENCIES);
             extGeo[counter] = std::move(geo);
             tols[counter] = geoinfo.second.first;
             ++counter;
@@ -722,7 +722,7 @@ ControlDeformExtSurface::evaluateSignedDistance(darray3E &point, mimmo::MimmoObj
     int kiter = 0;
     bool flag = true;
 
-    if(!geo->isBvTreeBuilt())    geo->buildBvTree();
+    geo->buildStructure(GeometryStructure::BVTREE);
 
     while(flag && kiter < kmax){
         dist = bvTreeUtils::signedDistance(&point, geo->getBvTree(), id, normal, initRadius);
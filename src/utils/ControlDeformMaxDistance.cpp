@@ -30,6 +30,7 @@ namespace mimmo{
  */
 ControlDeformMaxDistance::ControlDeformMaxDistance(){
     m_name = "mimmo.ControlDeformMaxDistance";
+    requireStructure(GeometryStructure::BVTREE);
     m_maxDist= 0.0 ;
 
 };
@@ -41,6 +42,7 @@ ControlDeformMaxDistance::ControlDeformMaxDistance(){
 ControlDeformMaxDistance::ControlDeformMaxDistance(const bitpit::Config::Section & rootXML){
 
     m_name = "mimmo.ControlDeformMaxDistance";
+    requireStructure(GeometryStructure::BVTREE);
     m_maxDist= 0.0 ;
 
     std::string fallback_name = "ClassNONE";
@@ -182,7 +184,7 @@ ControlDeformMaxDistance::execute(){
     m_defField.resize(getGeometry()->getNVertex(),darray3E{{0.0,0.0,0.0}});
     m_violationField.resize(m_defField.size());
 
-    if(!(geo->isBvTreeBuilt()))    geo->buildBvTree();
+    geo->buildStructure(GeometryStructure::BVTREE);
 
     dvecarr3E points = geo->getVertexCoords();
     points+= m_defField;
@@ -194,29 +196,27 @@ ControlDeformMaxDistance::execute(){
         ++count;
     }
 
-    double dist;
-    double radius ;
     double rate = 0.05;
     int kmax = 200;
-    int kiter;
-    bool flag;
-    long id;
-    count = 0;
-
-    for(auto &p : points){
-        dist =1.0E+18;
-        kiter = 0;
-        flag = true;
-        radius = std::fmax(1.0E-8, normDef[count]);
+    int npoints = points.size();
+
+#if MIMMO_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for(int i=0; i<npoints; ++i){
+        double dist =1.0E+18;
+        int kiter = 0;
+        bool flag = true;
+        long id;
+        double radius = std::fmax(1.0E-8, normDef[i]);
         while(flag && kiter < kmax){
-            dist = bvTreeUtils::distance(&p, geo->getBvTree(), id, radius);
+            dist = bvTreeUtils::distance(&points[i], geo->getBvTree(), id, radius);
             flag = (dist == 1.0E+18);
             if(flag)    radius *= (1.0+ rate*((double)flag));
             kiter++;
         }
         if(kiter == kmax)    dist = m_maxDist - dist;
-        m_violationField[count] =  (dist - m_maxDist);
-        count++;
+        m_violationField[i] =  (dist - m_maxDist);
     }
 };
 
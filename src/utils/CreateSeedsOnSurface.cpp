@@ -41,6 +41,8 @@ namespace mimmo{
  */
 CreateSeedsOnSurface::CreateSeedsOnSurface(){
     m_name = "mimmo.CreateSeedsOnSurface";
+    requireStructure(GeometryStructure::BVTREE);
+    requireStructure(GeometryStructure::ADJACENCIES);
     m_nPoints = 0;
     m_minDist = 0.0;
     m_seed = {{0.0,0.0,0.0}};
@@ -59,6 +61,8 @@ CreateSeedsOnSurface::CreateSeedsOnSurface(){
 CreateSeedsOnSurface::CreateSeedsOnSurface(const bitpit::Config::Section & rootXML){
 
     m_name = "mimmo.CreateSeedsOnSurface";
+    requireStructure(GeometryStructure::BVTREE);
+    requireStructure(GeometryStructure::ADJACENCIES);
     m_nPoints = 0;
     m_minDist = 0.0;
     m_seed = {{0.0,0.0,0.0}};
@@ -273,8 +277,6 @@ CreateSeedsOnSurface::setGeometry(MimmoObject * geo){
     if(geo->getType() != 1)    return;
 
     BaseManipulation::setGeometry(geo);
-    if(!geo->isBvTreeBuilt())            getGeometry()->buildBvTree();
-    if(!geo->areAdjacenciesBuilt() )    getGeometry()->buildAdjacencies();
     bbox->setGeometry(geo);
 }
 
@@ -349,6 +351,8 @@ CreateSeedsOnSurface::solve(bool debug){
         return;
     }
     m_points.clear();
+    getGeometry()->buildStructure(GeometryStructure::BVTREE);
+    getGeometry()->buildStructure(GeometryStructure::ADJACENCIES);
     bbox->execute();
     if(m_seedbaricenter)    m_seed = bbox->getOrigin();
     
@@ -406,9 +410,8 @@ CreateSeedsOnSurface::solveLSet(bool debug){
     dvecarr3E initList;
     m_deads.reserve(m_nPoints);
 
-    if(!getGeometry()->areAdjacenciesBuilt() ) getGeometry()->buildAdjacencies();
     //find the nearest point of triagulation to the seed
-    if(!(getGeometry()->isKdTreeBuilt())) getGeometry()->buildKdTree();
+    getGeometry()->buildStructure(GeometryStructure::KDTREE);
 
     bitpit::SurfUnstructured * tri = static_cast<bitpit::SurfUnstructured * >(getGeometry()->getPatch());
     auto map    = getGeometry()->getMapData();
@@ -422,10 +425,9 @@ CreateSeedsOnSurface::solveLSet(bool debug){
 
     livector1D neighs, excl;
     darray3E projSeed = bvTreeUtils::projectPoint(&m_seed, getGeometry()->getBvTree());
-    bitpit::Vertex vertSeed(0, projSeed);
     int nSize = 0;
     while( nSize < 1){
-        getGeometry()->getKdTree()->hNeighbors(&vertSeed, distance, &neighs, & excl );
+        getGeometry()->getKdTree()->hNeighbors(&projSeed, distance, &neighs, & excl );
         nSize = neighs.size();
         distance *= 1.1;
     }
@@ -738,14 +740,9 @@ CreateSeedsOnSurface::decimatePoints(dvecarr3E & list){
         listRefer[j] = (list[j] - list[0])*interpolateSensitivity(list[j]);
     }
 
-    bitpit::KdTree<3,darray3E,long>    kdT;
-    //build a kdtree of points
-    kdT.nodes.resize(listS + kdT.MAXSTK);
-    long label=0;
-    for(auto & val : listRefer ){
-        kdT.insert(&val, label);
-        ++label;
-    }
+    //build a kdtree of points, labeled by their index in the list
+    KdTree    kdT;
+    kdT.buildTree(listRefer);
 
     long candidate = 0; //starting seed;
 
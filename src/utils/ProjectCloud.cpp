@@ -30,6 +30,7 @@ namespace mimmo{
  */
 ProjectCloud::ProjectCloud(){
     m_name = "mimmo.ProjectCloud";
+    requireStructure(GeometryStructure::BVTREE);
 };
 
 /*!
@@ -39,6 +40,7 @@ ProjectCloud::ProjectCloud(){
 ProjectCloud::ProjectCloud(const bitpit::Config::Section & rootXML){
 
     m_name = "mimmo.ProjectCloud";
+    requireStructure(GeometryStructure::BVTREE);
 
     std::string fallback_name = "ClassNONE";
     std::string input = rootXML.get("ClassName", fallback_name);
@@ -124,15 +126,10 @@ ProjectCloud::execute(){
 
     if(getGeometry() == NULL || getGeometry()->isEmpty())    return;
 
-    if(!getGeometry()->isBvTreeBuilt())    getGeometry()->buildBvTree();
+    getGeometry()->buildStructure(GeometryStructure::BVTREE);
 
     //project points on surface.
-    int counter = 0;
-    m_proj.resize(m_points.size());
-    for(auto &val : m_points){
-        m_proj[counter]= bvTreeUtils::projectPoint(&val, getGeometry()->getBvTree());
-        ++counter;
-    }
+    m_proj = bvTreeUtils::projectPoint(&m_points, getGeometry()->getBvTree());
     return;
 };
 
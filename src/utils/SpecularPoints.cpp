@@ -343,14 +343,10 @@ SpecularPoints::execute(){
     m_vectorMirrored.resize(counterProj);
 
     if(project){
-        if(!getGeometry()->isBvTreeBuilt())    getGeometry()->buildBvTree();
+        getGeometry()->buildStructure(GeometryStructure::BVTREE);
 
         //project points on surface.
-        int counter = 0;
-        for(auto &val : m_proj){
-            m_proj[counter]= bvTreeUtils::projectPoint(&val, getGeometry()->getBvTree());
-            ++counter;
-        }
+        m_proj = bvTreeUtils::projectPoint(&m_proj, getGeometry()->getBvTree());
     }
 };
 
@@ -0,0 +1,233 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+
+#include "mimmo_core.hpp"
+#include <random>
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+/*
+ * Test 00005
+ * Testing BvTree (SAH build, refit and selection by patch) against brute force searches
+ */
+
+// =================================================================================== //
+
+/*!
+ * Brute force distance of a point from a triangle (closest point by Voronoi regions).
+ */
+double distanceTriangle(const darray3E & p, const darray3E & a, const darray3E & b, const darray3E & c){
+
+    darray3E ab = b - a, ac = c - a, ap = p - a;
+    double d1 = dotProduct(ab, ap), d2 = dotProduct(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0) return norm2(p - a);
+
+    darray3E bp = p - b;
+    double d3 = dotProduct(ab, bp), d4 = dotProduct(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3) return norm2(p - b);
+
+    double vc = d1*d4 - d3*d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return norm2(p - (a + (d1/(d1 - d3))*ab));
+
+    darray3E cp = p - c;
+    double d5 = dotProduct(ab, cp), d6 = dotProduct(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6) return norm2(p - c);
+
+    double vb = d5*d2 - d1*d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return norm2(p - (a + (d2/(d2 - d6))*ac));
+
+    double va = d3*d6 - d5*d4;
+    if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0){
+        return norm2(p - (b + ((d4 - d3)/((d4 - d3) + (d5 - d6)))*(c - b)));
+    }
+
+    double denom = 1.0/(va + vb + vc);
+    return norm2(p - (a + (vb*denom)*ab + (vc*denom)*ac));
+}
+
+/*!
+ * Brute force distance of a point from a triangulated surface.
+ */
+double distanceSurface(const darray3E & p, MimmoObject * mesh){
+    double dist = 1.0e+18;
+    for (auto & cell : mesh->getCells()){
+        livector1D conn = mesh->getCellConnectivity(cell.getId());
+        PatchKernel * patch = mesh->getPatch();
+        dist = std::min(dist, distanceTriangle(p, patch->getVertexCoords(conn[0]), patch->getVertexCoords(conn[1]), patch->getVertexCoords(conn[2])));
+    }
+    return dist;
+}
+
+/*!
+ * Bounding box of a cell.
+ */
+void cellBox(MimmoObject * mesh, long id, darray3E & pmin, darray3E & pmax){
+    pmin.fill(1.0e+18);
+    pmax.fill(-1.0e+18);
+    for (long v : mesh->getCellConnectivity(id)){
+        darray3E coords = mesh->getPatch()->getVertexCoords(v);
+        for (int k=0; k<3; ++k){
+            pmin[k] = std::min(pmin[k], coords[k]);
+            pmax[k] = std::max(pmax[k], coords[k]);
+        }
+    }
+}
+
+/*!
+ * Create a triangulated wavy surface over [x0,x0+size]x[y0,y0+size], with nc cells per side.
+ */
+MimmoObject * createSurface(int nc, double x0, double y0, double size, double z0){
+    MimmoObject * mesh = new MimmoObject(1);
+    for (int j=0; j<=nc; ++j){
+        for (int i=0; i<=nc; ++i){
+            double x = x0 + size*double(i)/double(nc);
+            double y = y0 + size*double(j)/double(nc);
+            darray3E p = {{x, y, z0 + 0.1*std::sin(2.0*M_PI*x)*std::cos(2.0*M_PI*y)}};
+            mesh->addVertex(p, long(j*(nc+1)+i));
+        }
+    }
+    long id = 0;
+    for (int j=0; j<nc; ++j){
+        for (int i=0; i<nc; ++i){
+            long v0 = j*(nc+1)+i;
+            livector1D conn1 = {v0, v0+1, v0+nc+2};
+            livector1D conn2 = {v0, v0+nc+2, v0+nc+1};
+            mesh->addConnectedCell(conn1, bitpit::ElementInfo::Type::TRIANGLE, 0, id++);
+            mesh->addConnectedCell(conn2, bitpit::ElementInfo::Type::TRIANGLE, 0, id++);
+        }
+    }
+    return mesh;
+}
+
+/*!
+ * Check the distances from a surface computed with its bv-tree against brute force.
+ */
+bool checkDistances(MimmoObject * mesh, const dvecarr3E & points){
+    BvTree * tree = mesh->getBvTree();
+    bool check = true;
+    for (const darray3E & p : points){
+        darray3E point = p;
+        long id = -1;
+        double r = 2.0;
+        double dist = bvTreeUtils::distance(&point, tree, id, r);
+        double exact = distanceSurface(p, mesh);
+        check = check && (std::abs(dist - exact) <= 1.0e-12);
+        if (id >= 0){
+            livector1D conn = mesh->getCellConnectivity(id);
+            PatchKernel * patch = mesh->getPatch();
+            double distId = distanceTriangle(p, patch->getVertexCoords(conn[0]), patch->getVertexCoords(conn[1]), patch->getVertexCoords(conn[2]));
+            check = check && (std::abs(distId - exact) <= 1.0e-12);
+        }else{
+            check = false;
+        }
+    }
+    return check;
+}
+
+int test5() {
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+    bool check = true;
+
+    //bv-tree built by SAH, then refitted after vertex motion.
+    MimmoObject * mesh = createSurface(24, 0.0, 0.0, 1.0, 0.0);
+    mesh->buildStructure(GeometryStructure::BVTREE);
+
+    dvecarr3E points(200);
+    for (auto & p : points){
+        p = {{-0.2 + 1.4*unif(gen), -0.2 + 1.4*unif(gen), -0.4 + 0.8*unif(gen)}};
+    }
+    bool checkBuild = checkDistances(mesh, points);
+
+    dvecarr3E displ(mesh->getNVertex(), darray3E{{0.0, 0.0, 0.0}});
+    for (auto & vertex : mesh->getVertices()){
+        darray3E coords = vertex.getCoords();
+        int i = mesh->getMapDataInv(vertex.getId());
+        displ[i][0] = 0.02*std::sin(5.0*coords[1]);
+        displ[i][2] = 0.05*std::cos(3.0*coords[0]);
+    }
+    mesh->applyDisplacements(displ);
+    mesh->buildStructure(GeometryStructure::BVTREE);
+    bool checkRefit = checkDistances(mesh, points);
+    check = check && checkBuild && checkRefit;
+
+    //selection of the cells of a target surface near a selection patch.
+    MimmoObject * patch = createSurface(5, 0.3, 0.35, 0.25, 0.02);
+    patch->buildStructure(GeometryStructure::BVTREE);
+    double tol = 0.01;
+    livector1D selected = bvTreeUtils::selectByPatch(patch->getBvTree(), mesh->getBvTree(), tol);
+    std::set<long> selectedSet(selected.begin(), selected.end());
+    bool checkSelect = (selectedSet.size() == selected.size());
+    for (auto & cell : mesh->getCells()){
+        darray3E tmin, tmax;
+        cellBox(mesh, cell.getId(), tmin, tmax);
+        bool inside = false, insideLoose = false;
+        for (auto & scell : patch->getCells()){
+            darray3E smin, smax;
+            cellBox(patch, scell.getId(), smin, smax);
+            inside = inside || CGElem::intersectBoxBox(smin-tol, smax+tol, tmin, tmax);
+            insideLoose = insideLoose || CGElem::intersectBoxBox(smin-(tol+1.0e-6), smax+(tol+1.0e-6), tmin, tmax);
+        }
+        bool found = (selectedSet.count(cell.getId()) > 0);
+        if (inside && !found)       checkSelect = false;
+        if (found && !insideLoose)  checkSelect = false;
+    }
+    check = check && checkSelect;
+
+    std::cout << "bv-tree build: " << checkBuild << ", refit: " << checkRefit << ", selection: " << checkSelect << std::endl;
+
+    delete mesh;
+    delete patch;
+
+    std::cout<<"test passed: "<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test5() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+
+	return val;
+}
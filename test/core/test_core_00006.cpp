@@ -0,0 +1,113 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+
+#include "mimmo_core.hpp"
+#include <random>
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+/*
+ * Test 00006
+ * Testing KdTree nearest, radius and k-nearest queries against brute force searches
+ */
+
+// =================================================================================== //
+
+int test6() {
+
+    std::mt19937 gen(6);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+    MimmoObject * cloud = new MimmoObject(3);
+    dvecarr3E cloudPoints(3000);
+    {
+        long id = 0;
+        for (auto & p : cloudPoints){
+            p = {{unif(gen), unif(gen), unif(gen)}};
+            cloud->addVertex(p, id++);
+        }
+    }
+    cloud->buildStructure(GeometryStructure::KDTREE);
+    KdTree * kdtree = cloud->getKdTree();
+
+    dvecarr3E queries(100);
+    for (auto & p : queries){
+        p = {{-0.1 + 1.2*unif(gen), -0.1 + 1.2*unif(gen), -0.1 + 1.2*unif(gen)}};
+    }
+    std::vector<double> dist;
+    livector1D nearest = kdTreeUtils::nearest(&queries, kdtree, dist);
+    std::vector<livector1D> neighs = kdTreeUtils::hNeighbors(&queries, kdtree, 0.1);
+    std::vector<livector1D> knear;
+    std::vector<std::vector<double> > kdist;
+    kdTreeUtils::kNearest(&queries, kdtree, 5, knear, kdist);
+
+    bool check = (nearest.size() == queries.size()) && (neighs.size() == queries.size()) && (knear.size() == queries.size());
+    for (std::size_t q=0; q<queries.size() && check; ++q){
+        std::vector<double> all(cloudPoints.size());
+        std::size_t inRadius = 0;
+        for (std::size_t i=0; i<cloudPoints.size(); ++i){
+            all[i] = norm2(queries[q] - cloudPoints[i]);
+            if (all[i] <= 0.1) ++inRadius;
+        }
+        std::vector<double> sorted = all;
+        std::sort(sorted.begin(), sorted.end());
+        check = check && (nearest[q] >= 0) && (std::abs(all[nearest[q]] - sorted[0]) <= 1.0e-12);
+        check = check && (neighs[q].size() == inRadius);
+        check = check && (knear[q].size() == 5);
+        for (int k=0; k<5 && check; ++k){
+            check = check && (std::abs(all[knear[q][k]] - sorted[k]) <= 1.0e-12);
+        }
+    }
+
+    delete cloud;
+
+    std::cout<<"test passed :"<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test6() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+
+	return val;
+}
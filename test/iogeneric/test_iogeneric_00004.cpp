@@ -0,0 +1,237 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+
+#include "mimmo_iogeneric.hpp"
+#include <fstream>
+#include <iomanip>
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+/*
+ * Test 00004
+ * Parsing Nastran bulk files with NastranInterface: small, large and free field formats,
+ * continuation lines across the boundaries of the parsed chunks, implicit exponents,
+ * elements on undefined grids and PIDs out of range.
+ */
+
+// =================================================================================== //
+
+/*!
+ * \return value written in a fixed field of given width.
+ */
+std::string nasField(const std::string & value, int width){
+    std::stringstream ss;
+    ss << std::left << std::setw(width) << value;
+    return ss.str();
+}
+
+/*!
+ * Write the bulk data of a structured grid of nx x ny grids and of its elements,
+ * alternating card formats, and fill the expected parsed data.
+ */
+std::string nasBulk(int nx, int ny, dvecarr3E & points, livector1D & connect, std::vector<bitpit::ElementInfo::Type> & types, shivector1D & pids){
+
+    std::stringstream out;
+    points.clear();
+    connect.clear();
+    types.clear();
+    pids.clear();
+
+    //grids, x = ix + 0.25, y = iy + 0.5, z = (i%10 + 0.5)*1e-2 written with implicit or D exponent
+    for (int i=0; i<nx*ny; ++i){
+        std::string id = std::to_string(i+1);
+        std::string x = std::to_string(i%nx) + ".25";
+        std::string y = std::to_string(i/nx) + ".5";
+        std::string z = std::to_string(i%10) + ".5-2";
+        points.push_back(darray3E{{double(i%nx) + 0.25, double(i/nx) + 0.5, double(10*(i%10) + 5)/1000.0}});
+        switch (i%4){
+        case 0:
+            out << "GRID    " << nasField(id, 8) << nasField("", 8) << nasField(x, 8) << nasField(y, 8) << nasField(z, 8) << "\n";
+            break;
+        case 1:
+        case 2:
+            z = std::to_string(i%10) + ".5D-2";
+            out << "GRID*   " << nasField(id, 16) << nasField("", 16) << nasField(x, 16) << nasField(y, 16) << "\n";
+            out << "*       " << nasField(z, 16) << "\n";
+            break;
+        default:
+            out << "GRID," << id << ",," << x << "," << y << "," << z << "\n";
+            break;
+        }
+    }
+
+    //elements: small field CTRIA3, free field CQUAD4, small field CHEXA with continuation
+    long eid = 1;
+    int ncells = 0;
+    for (int cy=0; cy<ny-1; ++cy){
+        for (int cx=0; cx<nx-1; ++cx){
+            long n0 = cy*nx + cx + 1;
+            long n1 = n0 + 1;
+            long n2 = n0 + nx + 1;
+            long n3 = n0 + nx;
+            short pid = 1 + ncells%5;
+            std::string spid = std::to_string(pid);
+            switch (ncells%3){
+            case 0:
+                out << "CTRIA3  " << nasField(std::to_string(eid), 8) << nasField(spid, 8) << nasField(std::to_string(n0), 8)
+                    << nasField(std::to_string(n1), 8) << nasField(std::to_string(n2), 8) << "\n";
+                connect.insert(connect.end(), {n0-1, n1-1, n2-1});
+                types.push_back(bitpit::ElementInfo::TRIANGLE);
+                break;
+            case 1:
+                out << "CQUAD4," << eid << "," << spid << "," << n0 << "," << n1 << "," << n2 << "," << n3 << "\n";
+                connect.insert(connect.end(), {n0-1, n1-1, n2-1, n3-1});
+                types.push_back(bitpit::ElementInfo::QUAD);
+                break;
+            default:
+                out << "CHEXA   " << nasField(std::to_string(eid), 8) << nasField(spid, 8) << nasField(std::to_string(n0), 8)
+                    << nasField(std::to_string(n1), 8) << nasField(std::to_string(n2), 8) << nasField(std::to_string(n3), 8)
+                    << nasField(std::to_string(n0), 8) << nasField(std::to_string(n1), 8) << "\n";
+                if (eid%7 == 0) out << "$ comment between card and continuation\n";
+                out << "+       " << nasField(std::to_string(n2), 8) << nasField(std::to_string(n3), 8) << "\n";
+                connect.insert(connect.end(), {n0-1, n1-1, n2-1, n3-1, n0-1, n1-1, n2-1, n3-1});
+                types.push_back(bitpit::ElementInfo::HEXAHEDRON);
+                break;
+            }
+            pids.push_back(pid);
+            ++eid;
+            ++ncells;
+
+            //element on undefined grid, to be discarded
+            if (ncells == 1000){
+                out << "CTRIA3  " << nasField(std::to_string(eid), 8) << nasField("1", 8) << nasField(std::to_string(n0), 8)
+                    << nasField(std::to_string(n1), 8) << nasField(std::to_string(nx*ny + 1000), 8) << "\n";
+                ++eid;
+            }
+        }
+    }
+    return out.str();
+}
+
+/*!
+ * \return true if the chunk of the file starting after position pos begins after a continuation line,
+ * i.e. if a card is split across the chunk boundary (see NastranInterface::read).
+ */
+bool nasSplitAt(const std::string & content, std::size_t pos){
+    std::size_t next = content.find('\n', pos);
+    if (next == std::string::npos || next + 1 >= content.size())  return false;
+    char c = content[next + 1];
+    return (c == '+' || c == '*');
+}
+
+int test4() {
+
+    //file of 3-4 MB, parsed in three chunks. The header is padded so that both chunk
+    //boundaries fall on continuation lines.
+    dvecarr3E points;
+    livector1D connect;
+    std::vector<bitpit::ElementInfo::Type> types;
+    shivector1D pids;
+    std::string bulk = nasBulk(160, 160, points, connect, types, pids);
+    std::string content;
+    bool split = false;
+    for (int pad=0; pad<2000 && !split; ++pad){
+        content = "$ mimmo nastran parser test" + std::string(pad, ' ') + "\nBEGIN BULK\n" + bulk + "ENDDATA\n";
+        std::size_t size = content.size();
+        split = ((size >> 20) == 3) && nasSplitAt(content, size/3 - 1) && nasSplitAt(content, 2*size/3 - 1);
+    }
+    {
+        std::ofstream out("nastran_00004.nas", std::ios::binary);
+        out << content;
+    }
+
+    NastranInterface nastran;
+    dvecarr3E rpoints;
+    livector1D rconnect;
+    std::vector<bitpit::ElementInfo::Type> rtypes;
+    shivector1D rpids;
+    bool read = nastran.read("nastran_00004.nas", rpoints, rconnect, rtypes, rpids);
+
+    bool checkPoints = (rpoints.size() == points.size());
+    for (std::size_t i=0; checkPoints && i<points.size(); ++i){
+        checkPoints = (norm2(rpoints[i] - points[i]) <= 1.0e-12);
+    }
+    bool checkElements = (rtypes == types) && (rpids == pids) && (rconnect == connect);
+
+    std::cout << "split chunks: " << split << ", read: " << read << ", points: " << checkPoints << ", elements: " << checkElements << std::endl;
+    bool check = split && read && checkPoints && checkElements;
+
+    //PIDs out of the short range are rejected and not wrapped
+    {
+        std::ofstream out("nastran_00004_pid.nas", std::ios::binary);
+        out << "GRID,1,,0.0,0.0,0.0\n" << "GRID,2,,1.0,0.0,0.0\n" << "GRID,3,,0.0,1.0,0.0\n";
+        out << "CTRIA3,1,40000,1,2,3\n" << "CTRIA3,2,7,1,2,3\n";
+    }
+    bool readPid = nastran.read("nastran_00004_pid.nas", rpoints, rconnect, rtypes, rpids);
+    bool checkPid = !readPid && (rtypes.size() == 1) && (rpids.size() == 1) && (rpids[0] == 7);
+    std::cout << "out of range PID rejected: " << checkPid << std::endl;
+    check = check && checkPid;
+
+    //coincident grids with different ids (parts of an assembled deck) are merged on import
+    {
+        std::ofstream out("nastran_00004_parts.nas", std::ios::binary);
+        out << "GRID,1,,0.0,0.0,0.0\n" << "GRID,2,,1.0,0.0,0.0\n" << "GRID,3,,0.0,1.0,0.0\n";
+        out << "GRID,11,,1.0,0.0,0.0\n" << "GRID,12,,0.0,1.0,0.0\n" << "GRID,13,,1.0,1.0,0.0\n";
+        out << "CTRIA3,1,1,1,2,3\n" << "CTRIA3,2,2,11,13,12\n";
+    }
+    MimmoGeometry * reader = new MimmoGeometry();
+    reader->setIOMode(IOMode::READ);
+    reader->setReadDir(".");
+    reader->setReadFilename("nastran_00004_parts");
+    reader->setReadFileType(FileType::NAS);
+    reader->exec();
+    bool checkMerge = (reader->getGeometry()->getNCells() == 2) && (reader->getGeometry()->getNVertex() == 4);
+    delete reader;
+    std::cout << "coincident grids merged: " << checkMerge << std::endl;
+    check = check && checkMerge;
+
+    std::cout<<"test passed :"<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test4() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+
+	return val;
+}
@@ -0,0 +1,164 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+
+#include "mimmo_iogeneric.hpp"
+#include <random>
+#include <sstream>
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+/*
+ * Test 00005
+ * Write and read back a geometry with its search trees in the native geomimmo format.
+ */
+
+// =================================================================================== //
+
+int test5() {
+
+    MimmoGeometry * reader = new MimmoGeometry();
+    reader->setIOMode(IOMode::READ);
+    reader->setReadDir("geodata");
+    reader->setReadFilename("prism");
+    reader->setReadFileType(FileType::STL);
+    reader->exec();
+
+    MimmoObject * mesh = reader->getGeometry();
+    mesh->buildStructure(GeometryStructure::BVTREE);
+    mesh->buildStructure(GeometryStructure::KDTREE);
+
+    GeoMimmoInterface geomimmo;
+    bool check = geomimmo.write("geomimmo_00005.geomimmo", mesh);
+    check = check && (GeoMimmoInterface::readType("geomimmo_00005.geomimmo") == 1);
+
+    //round trip: same vertices, cells and pids, trees restored and usable
+    MimmoObject * read = new MimmoObject(1);
+    check = check && geomimmo.read("geomimmo_00005.geomimmo", read);
+
+    bool checkGeometry = (read->getNVertex() == mesh->getNVertex()) && (read->getNCells() == mesh->getNCells());
+    for (auto & vertex : mesh->getVertices()){
+        long id = vertex.getId();
+        checkGeometry = checkGeometry && read->getPatch()->getVertices().exists(id);
+        checkGeometry = checkGeometry && (norm2(read->getVertexCoords(id) - vertex.getCoords()) == 0.0);
+    }
+    std::unordered_map<long, short> pids = mesh->getPID();
+    std::unordered_map<long, short> rpids = read->getPID();
+    for (auto & cell : mesh->getCells()){
+        long id = cell.getId();
+        checkGeometry = checkGeometry && read->getPatch()->getCells().exists(id);
+        checkGeometry = checkGeometry && (read->getCellConnectivity(id) == mesh->getCellConnectivity(id));
+        checkGeometry = checkGeometry && (rpids[id] == pids[id]);
+    }
+
+    bool checkTrees = read->isBvTreeBuilt() && read->isBvTreeSync() && read->isKdTreeBuilt() && read->isKdTreeSync();
+    std::mt19937 gen(5);
+    darray3E bmin, bmax;
+    mesh->getBoundingBox(bmin, bmax);
+    std::uniform_real_distribution<double> unif(-0.2, 1.2);
+    dvecarr3E points(100);
+    for (auto & p : points){
+        for (int j=0; j<3; ++j)    p[j] = bmin[j] + unif(gen)*(bmax[j] - bmin[j]);
+    }
+    double diag = norm2(bmax - bmin);
+    for (std::size_t i=0; i<points.size() && checkTrees; ++i){
+        long id = -1, rid = -1;
+        double r = 2.0*diag, rr = 2.0*diag;
+        double dist = bvTreeUtils::distance(&points[i], mesh->getBvTree(), id, r);
+        double rdist = bvTreeUtils::distance(&points[i], read->getBvTree(), rid, rr);
+        checkTrees = (dist == rdist) && (id == rid);
+    }
+    std::vector<double> dist, rdist;
+    livector1D nearest = kdTreeUtils::nearest(&points, mesh->getKdTree(), dist);
+    livector1D rnearest = kdTreeUtils::nearest(&points, read->getKdTree(), rdist);
+    checkTrees = checkTrees && (nearest == rnearest) && (dist == rdist);
+
+    //trees are not restored on a different geometry: moved vertices or new vertices
+    bool checkMismatch = false;
+    {
+        std::stringstream stream;
+        checkMismatch = read->dumpStructure(GeometryStructure::KDTREE, stream);
+        long id = read->getVertices().begin()->getId();
+        read->modifyVertex(read->getVertexCoords(id) + darray3E{{0.0, 0.0, 1.0e-3*diag}}, id);
+        checkMismatch = checkMismatch && !read->restoreStructure(GeometryStructure::KDTREE, stream);
+    }
+    {
+        std::stringstream stream;
+        read->buildStructure(GeometryStructure::BVTREE);
+        checkMismatch = checkMismatch && read->dumpStructure(GeometryStructure::BVTREE, stream);
+        read->addVertex(bmax + darray3E{{diag, diag, diag}});
+        checkMismatch = checkMismatch && !read->restoreStructure(GeometryStructure::BVTREE, stream);
+    }
+
+    //geometries of a different type are not read, geomimmo files are checked against the topology
+    MimmoObject * volume = new MimmoObject(2);
+    bool checkType = !geomimmo.read("geomimmo_00005.geomimmo", volume) && (volume->getNVertex() == 0);
+    {
+        MultipleMimmoGeometries * readers = new MultipleMimmoGeometries(2, false);
+        readers->setAddReadFile(".", "geomimmo_00005", FileType::MIMMO);
+        bool thrown = false;
+        try{
+            readers->execute();
+        }catch(std::runtime_error &){
+            thrown = true;
+        }
+        checkType = checkType && thrown;
+        delete readers;
+    }
+
+    std::cout << "geometry: " << checkGeometry << ", trees: " << checkTrees << ", mismatch: " << checkMismatch << ", type: " << checkType << std::endl;
+    check = check && checkGeometry && checkTrees && checkMismatch && checkType;
+
+    delete reader;
+    delete read;
+    delete volume;
+
+    std::cout<<"test passed :"<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test5() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+
+	return val;
+}
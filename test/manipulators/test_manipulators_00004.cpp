@@ -0,0 +1,138 @@
+/*---------------------------------------------------------------------------*\
+ * 
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+
+
+#include "mimmo_manipulators.hpp"
+#include <chrono>
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+
+
+// =================================================================================== //
+/*!
+ * Micro-benchmark of FFDLattice NURBS evaluation: batch evaluator with degree-specialized
+ * kernels (block execution) vs point-wise generic evaluator (apply on a list of points).
+ * Checks also that both give the same deformation.
+ */
+
+int test4() {
+
+    //create a point cloud of nc^3 points inside the unit cube.
+    int nc = 40;
+    MimmoObject * cloud = new MimmoObject(3);
+    dvecarr3E points;
+    points.reserve(nc*nc*nc);
+    long counter = 0;
+    for(int i=0; i<nc; ++i){
+        for(int j=0; j<nc; ++j){
+            for(int k=0; k<nc; ++k){
+                darray3E p = {{0.05+0.9*double(i)/double(nc-1), 0.05+0.9*double(j)/double(nc-1), 0.05+0.9*double(k)/double(nc-1)}};
+                points.push_back(p);
+                cloud->addVertex(p, counter);
+                ++counter;
+            }
+        }
+    }
+
+    darray3E origin = {{0.5, 0.5, 0.5}};
+    darray3E span = {{1.0, 1.0, 1.0}};
+    iarray3E dim = {{8, 8, 8}};
+
+    bool check = true;
+    //degrees 2 and 3 use specialized kernels, degree 4 the generic one.
+    for(int degree = 2; degree <= 4; ++degree){
+
+        iarray3E deg = {{degree, degree, degree}};
+
+        FFDLattice * latt = new FFDLattice();
+        latt->setGeometry(cloud);
+        latt->setLattice(origin, span, ShapeType::CUBE, dim, deg);
+        latt->build();
+
+        int ndof = latt->getNNodes();
+        dvecarr3E displ(ndof, darray3E{{0.0,0.0,0.0}});
+        for(int i=0; i<ndof; ++i){
+            displ[i][0] = 0.01*std::sin(double(i));
+            displ[i][1] = 0.01*std::cos(double(3*i));
+            displ[i][2] = 0.005*std::sin(double(7*i));
+        }
+        latt->setDisplacements(displ);
+
+        std::chrono::time_point<std::chrono::system_clock> start, end;
+
+        start = std::chrono::system_clock::now();
+        latt->exec();
+        end = std::chrono::system_clock::now();
+        double tbatch = std::chrono::duration<double>(end-start).count();
+
+        dvecarr3E batch = latt->getDeformation();
+
+        start = std::chrono::system_clock::now();
+        dvecarr3E pointwise = latt->apply(&points);
+        end = std::chrono::system_clock::now();
+        double tpoint = std::chrono::duration<double>(end-start).count();
+
+        double maxdiff = 0.0;
+        for(long i=0; i<counter; ++i){
+            maxdiff = std::max(maxdiff, norm2(batch[i]-pointwise[i]));
+        }
+        check = check && (maxdiff <= 1.0E-12);
+
+        std::cout<<"degree "<<degree<<" : batch "<<tbatch<<" s, point-wise "<<tpoint<<" s, max difference "<<maxdiff<<std::endl;
+
+        delete latt;
+    }
+
+    delete cloud;
+
+    std::cout<<"test passed: "<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+	
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test4() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+	
+	return val;
+}
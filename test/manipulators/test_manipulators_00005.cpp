@@ -0,0 +1,143 @@
+/*---------------------------------------------------------------------------*\
+ * 
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+
+
+#include "mimmo_manipulators.hpp"
+#include <random>
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+
+
+// =================================================================================== //
+/*!
+ * Testing FFDLattice frozen mode: deformation computed through cached stencils
+ * has to match the one of the standard evaluation, for different control displacements,
+ * and cached stencils have to be invalidated when the lattice is rebuilt.
+ */
+
+/*!
+ * Run a lattice with a set of control displacements depending on a seed.
+ * \return deformation of the linked geometry.
+ */
+dvecarr3E runLattice(FFDLattice * latt, int seed){
+    int ndof = latt->getNNodes();
+    dvecarr3E displ(ndof, darray3E{{0.0,0.0,0.0}});
+    for(int i=0; i<ndof; ++i){
+        displ[i][0] = 0.02*std::sin(double((seed+1)*i));
+        displ[i][1] = 0.01*std::cos(double((seed+2)*i));
+        displ[i][2] = 0.03*std::sin(double((seed+3)*i));
+    }
+    latt->setDisplacements(displ);
+    latt->exec();
+    return latt->getDeformation();
+}
+
+/*!
+ * \return maximum distance between two deformation fields.
+ */
+double maxDifference(const dvecarr3E & res1, const dvecarr3E & res2){
+    double maxdiff = (res1.size() == res2.size()) ? 0.0 : 1.0;
+    for(std::size_t i=0; i<res1.size() && i<res2.size(); ++i){
+        maxdiff = std::max(maxdiff, norm2(res1[i]-res2[i]));
+    }
+    return maxdiff;
+}
+
+int test5() {
+
+    //random point cloud in the unit cube.
+    MimmoObject * cloud = new MimmoObject(3);
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> unif(0.05, 0.95);
+    for(long i=0; i<2000; ++i){
+        cloud->addVertex(darray3E{{unif(gen), unif(gen), unif(gen)}}, i);
+    }
+
+    darray3E origin = {{0.5, 0.5, 0.5}};
+    darray3E span = {{1.0, 1.0, 1.0}};
+    iarray3E dim = {{6, 7, 8}};
+    iarray3E deg = {{2, 3, 2}};
+
+    FFDLattice * latt = new FFDLattice();
+    latt->setGeometry(cloud);
+    latt->setLattice(origin, span, ShapeType::CUBE, dim, deg);
+
+    FFDLattice * frozen = new FFDLattice();
+    frozen->setGeometry(cloud);
+    frozen->setLattice(origin, span, ShapeType::CUBE, dim, deg);
+    frozen->setFrozen(true);
+
+    bool check = true;
+    for(int iter=0; iter<3; ++iter){
+        check = check && (maxDifference(runLattice(latt, iter), runLattice(frozen, iter)) <= 1.0E-12);
+    }
+
+    //move and stretch both lattices keeping the same nodes: stale stencils would have
+    //the same size, but a different deformation.
+    darray3E origin2 = {{0.45, 0.55, 0.5}};
+    darray3E span2 = {{1.1, 1.2, 1.05}};
+    latt->setOrigin(origin2);
+    latt->setSpan(span2);
+    latt->build();
+    frozen->setOrigin(origin2);
+    frozen->setSpan(span2);
+    frozen->build();
+    bool checkRebuild = (maxDifference(runLattice(latt, 3), runLattice(frozen, 3)) <= 1.0E-12);
+    std::cout<<"frozen stencils invalidated on build: "<<checkRebuild<<std::endl;
+    check = check && checkRebuild;
+
+    delete latt;
+    delete frozen;
+    delete cloud;
+
+    std::cout<<"test passed: "<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+	
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test5() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+	
+	return val;
+}
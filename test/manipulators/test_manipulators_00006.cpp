@@ -0,0 +1,191 @@
+/*---------------------------------------------------------------------------*\
+ * 
+ *  mimmo
+ *
+ *  Copyright (C) 2015-2017 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of mimmo.
+ *
+ *  mimmo is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  mimmo is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with mimmo. If not, see <http://www.gnu.org/licenses/>.
+ *
+ \ *---------------------------------------------------------------------------*/
+#include "mimmo_manipulators.hpp"
+using namespace std;
+using namespace bitpit;
+using namespace mimmo;
+
+
+
+// =================================================================================== //
+/*!
+ * Testing deformation operators in CSR format: product of the FFDLattice and MRBF operators
+ * with the control displacements has to match the deformation computed by the blocks.
+ * FFDLattice operators are checked for global displacements and for local displacements
+ * on a lattice whose local reference system is affine (cube).
+ */
+
+/*!
+ * \return maximum distance between the deformation of a block and the product of its operator with the control displacements.
+ */
+double operatorError(const CSRMatrix & op, const dvecarr3E & displ, const dvecarr3E & deformation){
+    dvecarr3E res = op.multiply(displ);
+    double maxdiff = (long(res.size()) == long(deformation.size())) ? 0.0 : 1.0;
+    for(std::size_t i=0; i<res.size() && i<deformation.size(); ++i){
+        maxdiff = std::max(maxdiff, norm2(res[i]-deformation[i]));
+    }
+    return maxdiff;
+}
+
+int test6() {
+
+    //point cloud on a spherical shell inside the unit cube.
+    MimmoObject * cloud = new MimmoObject(3);
+    long counter = 0;
+    for(int i=0; i<24; ++i){
+        double theta = M_PI*(double(i)+0.5)/24.0;
+        for(int j=0; j<48; ++j){
+            double phi = 2.0*M_PI*double(j)/48.0;
+            darray3E p = {{0.5+0.4*std::sin(theta)*std::cos(phi), 0.5+0.4*std::sin(theta)*std::sin(phi), 0.5+0.4*std::cos(theta)}};
+            cloud->addVertex(p, counter);
+            ++counter;
+        }
+    }
+
+    bool check = true;
+
+    //FFD on a cylindrical lattice, to check also merging of periodic nodes.
+    {
+        darray3E origin = {{0.5, 0.5, 0.0}};
+        darray3E span = {{0.8, 2.0*M_PI, 1.2}};
+        iarray3E dim = {{5, 12, 6}};
+        iarray3E deg = {{2, 3, 2}};
+
+        FFDLattice * latt = new FFDLattice();
+        latt->setGeometry(cloud);
+        latt->setLattice(origin, span, ShapeType::CYLINDER, dim, deg);
+        latt->setDisplGlobal(true);
+        latt->build();
+
+        int ndof = latt->getNNodes();
+        dvecarr3E displ(ndof, darray3E{{0.0,0.0,0.0}});
+        for(int i=0; i<ndof; ++i){
+            displ[i][0] = 0.02*std::sin(double(i));
+            displ[i][1] = 0.01*std::cos(double(2*i));
+            displ[i][2] = 0.03*std::sin(double(3*i));
+        }
+        latt->setDisplacements(displ);
+        latt->exec();
+
+        CSRMatrix op = latt->getDeformationOperator();
+        check = check && (op.getNRows() == counter) && (op.getNCols() == ndof);
+        check = check && (operatorError(op, displ, latt->getDeformation()) <= 1.0E-12);
+        delete latt;
+    }
+
+    //FFD on a rotated cube lattice with local displacements: the local reference system
+    //is affine, so the operator is exact also in this case.
+    {
+        darray3E origin = {{0.5, 0.5, 0.5}};
+        darray3E span = {{1.2, 1.0, 1.1}};
+        iarray3E dim = {{5, 6, 4}};
+        iarray3E deg = {{3, 2, 2}};
+
+        FFDLattice * latt = new FFDLattice();
+        latt->setGeometry(cloud);
+        latt->setLattice(origin, span, ShapeType::CUBE, dim, deg);
+        latt->setRefSystem(2, darray3E{{1.0/std::sqrt(2.0), 1.0/std::sqrt(2.0), 0.0}});
+        latt->setDisplGlobal(false);
+        latt->build();
+
+        int ndof = latt->getNNodes();
+        dvecarr3E displ(ndof, darray3E{{0.0,0.0,0.0}});
+        for(int i=0; i<ndof; ++i){
+            displ[i][0] = 0.03*std::cos(double(i));
+            displ[i][1] = 0.02*std::sin(double(5*i));
+            displ[i][2] = 0.01*std::cos(double(2*i));
+        }
+        latt->setDisplacements(displ);
+        latt->exec();
+
+        //local displacements are rotated to the global frame
+        dmatrix33E axes = latt->getRefSystem();
+        dvecarr3E globalDispl(ndof, darray3E{{0.0,0.0,0.0}});
+        for(int i=0; i<ndof; ++i){
+            for(int j=0; j<3; ++j)  globalDispl[i] += displ[i][j]*axes[j];
+        }
+
+        CSRMatrix op = latt->getDeformationOperator();
+        check = check && (op.getNRows() == counter) && (op.getNCols() == ndof);
+        check = check && (operatorError(op, globalDispl, latt->getDeformation()) <= 1.0E-12);
+        delete latt;
+    }
+
+    //MRBF in parameterization mode with a compact support kernel.
+    {
+        dvecarr3E nodes;
+        for(int i=0; i<4; ++i){
+            for(int j=0; j<4; ++j){
+                nodes.push_back(darray3E{{0.2*double(i+1), 0.2*double(j+1), 0.5}});
+            }
+        }
+        dvecarr3E displ(nodes.size(), darray3E{{0.0,0.0,0.0}});
+        for(int i=0; i<(int)nodes.size(); ++i){
+            displ[i][2] = 0.05*std::sin(double(i));
+        }
+
+        MRBF * mrbf = new MRBF();
+        mrbf->setGeometry(cloud);
+        mrbf->setNode(nodes);
+        mrbf->setDisplacements(displ);
+        mrbf->setSupportRadiusValue(0.3);
+        mrbf->exec();
+
+        CSRMatrix op = mrbf->getDeformationOperator();
+        check = check && (op.getNRows() == counter) && (op.getNCols() == (long)nodes.size());
+        check = check && (op.getNNZ() < counter*(long)nodes.size());
+        check = check && (operatorError(op, displ, mrbf->getDisplacements()) <= 1.0E-12);
+        delete mrbf;
+    }
+
+    delete cloud;
+
+    std::cout<<"test passed: "<<check<<std::endl;
+    return int(!check);
+}
+
+// =================================================================================== //
+
+int main( int argc, char *argv[] ) {
+
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+	
+#if ENABLE_MPI==1
+	MPI::Init(argc, argv);
+
+	{
+#endif
+		/**<Calling mimmo Test routines*/
+
+        int val = test6() ;
+
+#if ENABLE_MPI==1
+	}
+
+	MPI::Finalize();
+#endif
+	
+	return val;
+}